@@ -0,0 +1,511 @@
+/**
+ * 	@file 	benchmark_gate.cpp
+ * 	@brief 	Runs the socket benchmarks and fails when they regress against the stored baseline.
+ * 	@details	Every benchmark is repeated several times and compared using the 95% confidence interval of the
+ * 				repetitions, so a result only fails the gate when the whole interval is worse than the baseline by
+ * 				more than the tolerance. Baselines depend on the machine, so regenerate them with --update when the
+ * 				benchmark machine changes.
+ * 	@author James Horner
+ * 	@date 	2023-04-05
+ */
+
+// Standard System Libraries
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Local Libraries
+#include "aead.hpp"
+#include "array_codec.hpp"
+#include "benchmark_gate.hpp"
+#include "delta.hpp"
+#include "header_filter.hpp"
+#include "journal.hpp"
+#include "mac.hpp"
+#include "schema.hpp"
+#include "udp_socket.hpp"
+
+namespace
+{
+	/**
+	 *	@struct	sample_message
+	 * 	@brief 	Struct sample_message is encoded and decoded by the schema benchmarks.
+	 */
+	struct sample_message {
+		/// Identifier written as a fixed field.
+		uint32_t id;
+		/// Sequence number written as a varint.
+		uint64_t sequence;
+		/// Signed value written as a zigzag varint.
+		int32_t offset;
+		/// Samples written as a repeated field.
+		std::vector<float> samples;
+	};
+
+	/// Schema of the sample message.
+	using sample_schema = oo_socket::schema::message<
+		oo_socket::schema::fixed<&sample_message::id>,
+		oo_socket::schema::varint<&sample_message::sequence>,
+		oo_socket::schema::zigzag<&sample_message::offset>,
+		oo_socket::schema::repeated<&sample_message::samples>
+	>;
+
+	/**
+	 *	@struct	benchmark_case
+	 * 	@brief 	Struct benchmark_case is a named benchmark whose operation is created when the benchmark runs.
+	 */
+	struct benchmark_case {
+		/// Name of the benchmark in the baseline.
+		std::string name;
+		/// Creates the sockets and buffers the benchmark needs and returns the operation to time.
+		std::function<std::function<void()>()> setup;
+		/// Number of operations each call performs, such as the datagrams in a batch.
+		size_t operations_per_call = 1;
+	};
+
+	/**
+	 * @brief 	Function receive_sockets creates a receiver and a sender connected to it.
+	 * @param 	port 	port the receiver binds to.
+	 * @return 	std::pair 	sending socket and receiving socket.
+	 */
+	std::pair<std::shared_ptr<oo_socket::udp::socket>, std::shared_ptr<oo_socket::udp::socket>> receive_sockets(unsigned short port) {
+		auto receiver = std::make_shared<oo_socket::udp::socket>(port);
+		// A timeout stops a lost datagram from hanging the gate, a receive that times out fails the run instead.
+		receiver->set_socket_receive_timeout(1000);
+		auto sender = std::make_shared<oo_socket::udp::socket>();
+		sender->configure_remote_host(port);
+		return std::make_pair(sender, receiver);
+	}
+
+	/**
+	 *	@struct	journal_fixture
+	 * 	@brief 	Struct journal_fixture is a log in a temporary directory that is removed with it.
+	 */
+	struct journal_fixture {
+		/// Directory of the log.
+		std::filesystem::path directory;
+		/// Log appended to by the benchmark.
+		std::unique_ptr<oo_socket::journal::segmented_log> log;
+
+		/**
+		 * @brief 	Constructor for the journal_fixture struct.
+		 * @param 	name 	name of the directory under the system temporary directory.
+		 * @param 	options segment size and write back settings of the log.
+		 */
+		journal_fixture(const std::string& name, const oo_socket::journal::journal_options& options) :
+			directory(std::filesystem::temp_directory_path() / name)
+		{
+			std::filesystem::remove_all(directory);
+			log.reset(new oo_socket::journal::segmented_log(directory.string(), options));
+		}
+
+		/**
+		 * 	@brief 	Destructor for the journal_fixture struct.
+		 */
+		~journal_fixture() {
+			log.reset();
+			std::error_code error;
+			std::filesystem::remove_all(directory, error);
+		}
+	};
+
+	/**
+	 * @brief 	Function benchmark_cases returns every benchmark the gate runs.
+	 * @return 	std::vector<benchmark_case> 	benchmarks in the order they run.
+	 */
+	std::vector<benchmark_case> benchmark_cases() {
+		std::vector<benchmark_case> cases;
+
+		cases.push_back({"socket_constructor", []() {
+			return std::function<void()>([]() {
+				oo_socket::udp::socket socket;
+			});
+		}});
+
+		cases.push_back({"send_to_vector_256", []() {
+			auto socket = std::make_shared<oo_socket::udp::socket>();
+			auto buffer = std::make_shared<std::vector<char>>(256, 'T');
+			return std::function<void()>([socket, buffer]() {
+				socket->send_to(*buffer, 10102);
+			});
+		}});
+
+		cases.push_back({"send_vector_256", []() {
+			auto socket = std::make_shared<oo_socket::udp::socket>();
+			socket->configure_remote_host(10103);
+			auto buffer = std::make_shared<std::vector<char>>(256, 'T');
+			return std::function<void()>([socket, buffer]() {
+				socket->send(*buffer);
+			});
+		}});
+
+		cases.push_back({"send_to_char_256", []() {
+			auto socket = std::make_shared<oo_socket::udp::socket>();
+			auto buffer = std::make_shared<std::vector<char>>(256, 'T');
+			return std::function<void()>([socket, buffer]() {
+				socket->send_to(buffer->data(), buffer->size(), 10104);
+			});
+		}});
+
+		cases.push_back({"send_to_endpoint_256", []() {
+			auto socket = std::make_shared<oo_socket::udp::socket>();
+			auto buffer = std::make_shared<std::vector<char>>(256, 'T');
+			return std::function<void()>([socket, buffer]() {
+				using namespace oo_socket::literals;
+				constexpr oo_socket::ipv4_endpoint destination = "127.0.0.1:10104"_ep;
+				socket->send_to(buffer->data(), buffer->size(), destination);
+			});
+		}});
+
+		cases.push_back({"send_char_256", []() {
+			auto socket = std::make_shared<oo_socket::udp::socket>();
+			socket->configure_remote_host(10105);
+			auto buffer = std::make_shared<std::vector<char>>(256, 'T');
+			return std::function<void()>([socket, buffer]() {
+				socket->send(buffer->data(), buffer->size());
+			});
+		}});
+
+		// Receive benchmarks send to a live receiver and then receive, so every datagram is read rather than dropped.
+		unsigned short receive_port = 10110;
+		for (size_t size : {64, 512, 1400}) {
+			for (bool with_source : {false, true}) {
+				const std::string suffix = (with_source ? "_source_" : "_") + std::to_string(size);
+
+				cases.push_back({"receive_vector" + suffix, [size, with_source, receive_port]() {
+					auto sockets = receive_sockets(receive_port);
+					auto buffer = std::make_shared<std::vector<char>>(size, 'T');
+					auto source = std::make_shared<std::pair<std::string, uint16_t>>();
+					return std::function<void()>([sockets, buffer, source, with_source]() {
+						sockets.first->send(*buffer);
+						if (with_source) {
+							sockets.second->receive<char>(&source->first, &source->second);
+						}
+						else {
+							sockets.second->receive<char>();
+						}
+					});
+				}});
+
+				cases.push_back({"receive_char" + suffix, [size, with_source, receive_port]() {
+					auto sockets = receive_sockets(receive_port + 1);
+					auto buffer = std::make_shared<std::vector<char>>(size, 'T');
+					auto receive_buffer = std::make_shared<std::vector<char>>(MAX_RECEIVE_BUFFER_SIZE);
+					auto source = std::make_shared<std::pair<std::string, uint16_t>>();
+					return std::function<void()>([sockets, buffer, receive_buffer, source, with_source]() {
+						sockets.first->send(*buffer);
+						sockets.second->receive(receive_buffer->data(), (uint16_t)receive_buffer->size(),
+							with_source ? &source->first : nullptr, with_source ? &source->second : nullptr);
+					});
+				}});
+
+				// Each call sends and receives a batch of 32, so throughput stays in datagrams per second.
+				cases.push_back({"receive_batch_32" + suffix, [size, with_source, receive_port]() {
+					auto sockets = receive_sockets(receive_port + 2);
+					auto buffer = std::make_shared<std::vector<char>>(size, 'T');
+					auto outgoing = std::make_shared<std::vector<oo_socket::outgoing_datagram>>(32, oo_socket::outgoing_datagram{buffer->data(), buffer->size()});
+					auto receive_buffers = std::make_shared<std::vector<char>>(32 * MAX_RECEIVE_BUFFER_SIZE);
+					auto incoming = std::make_shared<std::vector<oo_socket::incoming_datagram>>();
+					for (size_t i = 0; i < 32; i++) {
+						oo_socket::incoming_datagram datagram{};
+						datagram.buffer = receive_buffers->data() + i * MAX_RECEIVE_BUFFER_SIZE;
+						datagram.capacity = MAX_RECEIVE_BUFFER_SIZE;
+						incoming->push_back(datagram);
+					}
+					return std::function<void()>([sockets, buffer, outgoing, receive_buffers, incoming, with_source]() {
+						sockets.first->send_batch(*outgoing);
+						size_t received = 0;
+						while (received < incoming->size()) {
+							const int result = sockets.second->receive_batch(incoming->data() + received, incoming->size() - received, with_source);
+							if (result <= 0) {
+								throw std::runtime_error("Receive timed out with " + std::to_string(incoming->size() - received) + " of " + std::to_string(incoming->size()) + " datagrams missing.");
+							}
+							received += (size_t)result;
+						}
+					});
+				}, 32});
+				receive_port += 3;
+			}
+		}
+
+		cases.push_back({"schema_encode_64", []() {
+			auto message = std::make_shared<sample_message>(sample_message{7, 1000000, -3, std::vector<float>(64, 1.5f)});
+			auto buffer = std::make_shared<std::vector<char>>();
+			return std::function<void()>([message, buffer]() {
+				sample_schema::encode(*message, *buffer);
+			});
+		}});
+
+		cases.push_back({"schema_decode_64", []() {
+			auto buffer = std::make_shared<std::vector<char>>();
+			sample_schema::encode(sample_message{7, 1000000, -3, std::vector<float>(64, 1.5f)}, *buffer);
+			auto message = std::make_shared<sample_message>();
+			return std::function<void()>([message, buffer]() {
+				sample_schema::decode(*buffer, *message);
+			});
+		}});
+
+		cases.push_back({"schema_view_64", []() {
+			auto buffer = std::make_shared<std::vector<char>>();
+			sample_schema::encode(sample_message{7, 1000000, -3, std::vector<float>(64, 1.5f)}, *buffer);
+			return std::function<void()>([buffer]() {
+				volatile int32_t offset = sample_schema::view(*buffer).get<2>();
+				(void)offset;
+			});
+		}});
+
+		cases.push_back({"array_pack_1024", []() {
+			auto values = std::make_shared<std::vector<int32_t>>(1024);
+			for (size_t i = 0; i < values->size(); i++) {
+				(*values)[i] = 1000 + (int32_t)(i % 200);
+			}
+			auto buffer = std::make_shared<std::vector<char>>();
+			return std::function<void()>([values, buffer]() {
+				oo_socket::array_codec::encode(*values, oo_socket::array_codec::array_encoding(), *buffer);
+			});
+		}});
+
+		cases.push_back({"array_unpack_1024", []() {
+			std::vector<int32_t> values(1024);
+			for (size_t i = 0; i < values.size(); i++) {
+				values[i] = 1000 + (int32_t)(i % 200);
+			}
+			auto buffer = std::make_shared<std::vector<char>>();
+			oo_socket::array_codec::encode(values, oo_socket::array_codec::array_encoding(), *buffer);
+			auto decoded = std::make_shared<std::vector<int32_t>>();
+			return std::function<void()>([buffer, decoded]() {
+				oo_socket::array_codec::decode(buffer->data(), buffer->size(), *decoded);
+			});
+		}});
+
+		cases.push_back({"delta_encode_8k", []() {
+			// 256 entities of 32 bytes where 25 of them moved since the base frame.
+			auto base = std::make_shared<std::vector<char>>(8192);
+			for (size_t i = 0; i < base->size(); i++) {
+				(*base)[i] = (char)(i * 131);
+			}
+			auto frame = std::make_shared<std::vector<char>>(*base);
+			for (size_t entity = 0; entity < 250; entity += 10) {
+				(*frame)[entity * 32] ^= 1;
+			}
+			auto delta = std::make_shared<std::vector<char>>(frame->size());
+			return std::function<void()>([base, frame, delta]() {
+				volatile size_t written = 0;
+				size_t size = 0;
+				oo_socket::delta::encode_delta(base->data(), frame->data(), frame->size(), delta->data(), delta->size(), size);
+				written = size;
+				(void)written;
+			});
+		}});
+
+		cases.push_back({"journal_append_256", []() {
+			// Write back is left to the kernel so the gate measures the append path rather than the disk.
+			oo_socket::journal::journal_options options;
+			options.segment_size = 16 * 1024 * 1024;
+			options.sync_bytes = 0;
+			auto fixture = std::make_shared<journal_fixture>("oo_socket_benchmark_journal", options);
+			auto payload = std::make_shared<std::vector<char>>(256, 'x');
+			return std::function<void()>([fixture, payload]() {
+				const uint64_t sequence = fixture->log->append(payload->data(), payload->size());
+				if (sequence % 65536 == 0) {
+					fixture->log->trim(sequence);
+				}
+			});
+		}});
+
+		cases.push_back({"header_filter_64", []() {
+			// A batch of 64 datagrams where every fourth has a type the filter rejects.
+			auto buffers = std::make_shared<std::vector<std::vector<char>>>(64, std::vector<char>(512, 'x'));
+			auto datagrams = std::make_shared<std::vector<oo_socket::incoming_datagram>>();
+			for (size_t i = 0; i < buffers->size(); i++) {
+				std::memcpy((*buffers)[i].data(), "OOSP", 4);
+				(*buffers)[i][4] = (char)(i % 4);
+				oo_socket::incoming_datagram datagram{};
+				datagram.buffer = (*buffers)[i].data();
+				datagram.capacity = (*buffers)[i].size();
+				datagram.size = (*buffers)[i].size();
+				datagrams->push_back(datagram);
+			}
+			auto filter = std::make_shared<oo_socket::header_filter>();
+			filter->match(0, "OOSP", 4).match_types(4, {0, 1, 2});
+			auto accepted = std::make_shared<std::vector<uint32_t>>(64);
+			return std::function<void()>([buffers, datagrams, filter, accepted]() {
+				volatile size_t kept = filter->filter(datagrams->data(), datagrams->size(), accepted->data());
+				(void)kept;
+			});
+		}});
+
+		cases.push_back({"aead_seal_1400", []() {
+			auto cipher = std::make_shared<oo_socket::aead::aes_gcm>(std::vector<uint8_t>(16, 7));
+			auto plaintext = std::make_shared<std::vector<char>>(1400, 'x');
+			auto ciphertext = std::make_shared<std::vector<char>>(1400 + AEAD_TAG_SIZE);
+			return std::function<void()>([cipher, plaintext, ciphertext]() {
+				const uint8_t nonce[AEAD_NONCE_SIZE] = {};
+				cipher->seal(nonce, "sequence", 8, plaintext->data(), plaintext->size(), ciphertext->data(), ciphertext->data() + 1400);
+			});
+		}});
+
+		cases.push_back({"mac_verify_batch_256", []() {
+			auto signer = std::make_shared<oo_socket::mac::siphash>(std::vector<uint8_t>(MAC_KEY_SIZE, 7));
+			auto buffers = std::make_shared<std::vector<std::vector<char>>>(MAX_BATCH_SIZE, std::vector<char>(256 + MAC_TAG_SIZE, 'x'));
+			auto batch = std::make_shared<std::vector<oo_socket::incoming_datagram>>();
+			for (std::vector<char>& buffer : *buffers) {
+				oo_socket::incoming_datagram datagram{};
+				datagram.buffer = buffer.data();
+				datagram.capacity = buffer.size();
+				datagram.size = signer->sign(buffer.data(), 256);
+				batch->push_back(datagram);
+			}
+			return std::function<void()>([signer, buffers, batch]() {
+				bool authentic[MAX_BATCH_SIZE];
+				for (oo_socket::incoming_datagram& datagram : *batch) {
+					datagram.size = 256 + MAC_TAG_SIZE;
+				}
+				signer->verify_batch(batch->data(), batch->size(), authentic);
+			});
+		}});
+
+		return cases;
+	}
+
+	/**
+	 * @brief 	Function print_usage prints the command line options.
+	 */
+	void print_usage() {
+		std::cerr <<
+			"Usage: benchmark_gate --baseline FILE [options]\n"
+			"  --baseline FILE       baseline JSON to compare against (required)\n"
+			"  --update              write the measured results into the baseline instead of comparing\n"
+			"  --tolerance FRACTION  override the tolerance stored in the baseline\n"
+			"  --repetitions N       independent repetitions per benchmark (default 10)\n"
+			"  --iterations N        operations timed per repetition, batched benchmarks make fewer calls (default 20000)\n"
+			"  --filter TEXT         only run benchmarks whose name contains TEXT\n";
+	}
+}
+
+int main(int argc, char** argv) {
+	std::string baseline_path;
+	std::string filter;
+	bool update = false;
+	double tolerance_override = -1;
+	size_t repetitions = 10;
+	size_t iterations = 20000;
+
+	for (int i = 1; i < argc; i++) {
+		const std::string option = argv[i];
+		if (option == "--update") {
+			update = true;
+			continue;
+		}
+		if (i + 1 >= argc) {
+			print_usage();
+			return 2;
+		}
+		const std::string value = argv[++i];
+		if (option == "--baseline") {
+			baseline_path = value;
+		}
+		else if (option == "--tolerance") {
+			tolerance_override = std::stod(value);
+		}
+		else if (option == "--repetitions") {
+			repetitions = std::stoul(value);
+		}
+		else if (option == "--iterations") {
+			iterations = std::stoul(value);
+		}
+		else if (option == "--filter") {
+			filter = value;
+		}
+		else {
+			print_usage();
+			return 2;
+		}
+	}
+	if (baseline_path.empty() || repetitions < 2 || iterations == 0) {
+		print_usage();
+		return 2;
+	}
+
+	try {
+		oo_socket::benchmark::baseline stored;
+		try {
+			stored = oo_socket::benchmark::read_baseline(baseline_path);
+		}
+		catch (const std::runtime_error&) {
+			// A missing baseline is only an error when comparing, updating creates it with the default tolerance.
+			if (!update) {
+				throw;
+			}
+		}
+		const double tolerance = tolerance_override >= 0 ? tolerance_override : stored.tolerance;
+
+		std::map<std::string, oo_socket::benchmark::result> results;
+		int regressions = 0;
+		for (const benchmark_case& benchmark : benchmark_cases()) {
+			if (!filter.empty() && benchmark.name.find(filter) == std::string::npos) {
+				continue;
+			}
+			const size_t calls = std::max<size_t>(iterations / benchmark.operations_per_call, 1);
+			oo_socket::benchmark::result measured = oo_socket::benchmark::measure(benchmark.setup(), repetitions, calls, benchmark.operations_per_call);
+			results[benchmark.name] = measured;
+			std::cout << benchmark.name << ": " << measured.throughput.mean << " +/- " << measured.throughput.half_width << " ops/s, median call latency "
+				<< measured.latency_ns.mean << " +/- " << measured.latency_ns.half_width << " ns";
+
+			if (update) {
+				std::cout << std::endl;
+				continue;
+			}
+			auto stored_entry = stored.entries.find(benchmark.name);
+			if (stored_entry == stored.entries.end()) {
+				std::cout << " (no baseline)" << std::endl;
+				continue;
+			}
+			std::string reason;
+			// The confidence interval only covers noise within a run, so confirm a regression with a second run
+			// before failing to ride out a busy machine.
+			if (oo_socket::benchmark::is_regression(measured, stored_entry->second, tolerance, reason)) {
+				std::cout << " retrying" << std::endl;
+				measured = oo_socket::benchmark::measure(benchmark.setup(), repetitions, calls, benchmark.operations_per_call);
+				std::cout << benchmark.name << ": " << measured.throughput.mean << " +/- " << measured.throughput.half_width << " ops/s, median call latency "
+					<< measured.latency_ns.mean << " +/- " << measured.latency_ns.half_width << " ns";
+				results[benchmark.name] = measured;
+			}
+			if (oo_socket::benchmark::is_regression(measured, stored_entry->second, tolerance, reason)) {
+				std::cout << " REGRESSION: " << reason << std::endl;
+				regressions++;
+			}
+			else {
+				std::cout << " ok" << std::endl;
+			}
+		}
+
+		if (update) {
+			// Merge into the stored entries so that updating a filtered subset keeps the other benchmarks.
+			stored.tolerance = tolerance;
+			for (const auto& entry : results) {
+				stored.entries[entry.first] = oo_socket::benchmark::baseline_entry{entry.second.throughput.mean, entry.second.latency_ns.mean};
+			}
+			oo_socket::benchmark::write_baseline(baseline_path, stored);
+			std::cout << "Wrote " << results.size() << " results to " << baseline_path << std::endl;
+			return 0;
+		}
+		if (regressions > 0) {
+			std::cout << regressions << " benchmark(s) regressed beyond the tolerance of " << tolerance * 100 << "%." << std::endl;
+			return 1;
+		}
+		return 0;
+	}
+	catch (const std::exception& e) {
+		std::cerr << "benchmark_gate: " << e.what() << std::endl;
+		return 2;
+	}
+}
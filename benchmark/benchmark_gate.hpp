@@ -0,0 +1,378 @@
+/**
+ * 	@file 	benchmark_gate.hpp
+ * 	@brief 	Repeated benchmark runs with confidence intervals, compared against a stored baseline.
+ * 	@author James Horner
+ * 	@date 	2023-04-05
+ */
+
+#ifndef BENCHMARK_GATE_HPP
+#define BENCHMARK_GATE_HPP
+
+// Standard System Libraries
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace oo_socket
+{
+	namespace benchmark
+	{
+		/**
+		 *	@struct	interval
+		 * 	@brief 	Struct interval is the mean of repeated measurements and its 95% confidence interval.
+		 */
+		struct interval {
+			/// Mean of the measurements.
+			double mean = 0;
+			/// Half width of the 95% confidence interval around the mean.
+			double half_width = 0;
+
+			/**
+			 * @brief 	Method lower returns the lower bound of the confidence interval.
+			 * @return 	double 	mean minus the half width.
+			 */
+			double lower() const {
+				return mean - half_width;
+			}
+
+			/**
+			 * @brief 	Method upper returns the upper bound of the confidence interval.
+			 * @return 	double 	mean plus the half width.
+			 */
+			double upper() const {
+				return mean + half_width;
+			}
+		};
+
+		/**
+		 * @brief 	Function t_critical returns the two sided 95% critical value of Student's t distribution.
+		 * @param 	degrees_of_freedom 	number of measurements minus one.
+		 * @return 	double 				critical value, approaching the normal value of 1.96 for large samples.
+		 */
+		inline double t_critical(size_t degrees_of_freedom) {
+			static const double table[] = {
+				12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+				2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+				2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+			};
+			if (degrees_of_freedom == 0) {
+				return INFINITY;
+			}
+			if (degrees_of_freedom <= 30) {
+				return table[degrees_of_freedom - 1];
+			}
+			return degrees_of_freedom <= 60 ? 2.000 : degrees_of_freedom <= 120 ? 1.980 : 1.960;
+		}
+
+		/**
+		 * @brief 	Function summarise returns the mean and 95% confidence interval of a set of measurements.
+		 * @param 	measurements 	measurements from independent repetitions.
+		 * @return 	interval 		mean and confidence interval, with an infinite width for a single measurement.
+		 */
+		inline interval summarise(const std::vector<double>& measurements) {
+			interval summary;
+			if (measurements.empty()) {
+				return summary;
+			}
+			for (double value : measurements) {
+				summary.mean += value;
+			}
+			summary.mean /= (double)measurements.size();
+			double squares = 0;
+			for (double value : measurements) {
+				squares += (value - summary.mean) * (value - summary.mean);
+			}
+			const size_t degrees_of_freedom = measurements.size() - 1;
+			if (degrees_of_freedom == 0) {
+				summary.half_width = INFINITY;
+				return summary;
+			}
+			const double standard_error = std::sqrt(squares / (double)degrees_of_freedom / (double)measurements.size());
+			summary.half_width = t_critical(degrees_of_freedom) * standard_error;
+			return summary;
+		}
+
+		/**
+		 *	@struct	result
+		 * 	@brief 	Struct result holds the throughput and latency measured for one benchmark.
+		 */
+		struct result {
+			/// Operations per second.
+			interval throughput;
+			/// Median latency of a single call in nanoseconds.
+			interval latency_ns;
+		};
+
+		/**
+		 *	@struct	baseline_entry
+		 * 	@brief 	Struct baseline_entry holds the stored throughput and latency of one benchmark.
+		 */
+		struct baseline_entry {
+			/// Operations per second.
+			double throughput = 0;
+			/// Median latency of a single operation in nanoseconds.
+			double latency_ns = 0;
+		};
+
+		/**
+		 *	@struct	baseline
+		 * 	@brief 	Struct baseline is the set of stored results the benchmarks are compared against.
+		 */
+		struct baseline {
+			/// Fraction that a result may be worse than the baseline by before it is a regression.
+			double tolerance = 0.15;
+			/// Stored results by benchmark name.
+			std::map<std::string, baseline_entry> entries;
+		};
+
+		/**
+		 *	@class	json_reader
+		 * 	@brief 	Class json_reader parses the small subset of JSON used by baseline files.
+		 * 	@details	Objects, strings and numbers are supported, which is all the baseline format uses. Values are
+		 * 				flattened into a map keyed by their dotted path, e.g. "benchmarks.send_to.throughput".
+		 */
+		class json_reader {
+		public:
+			/**
+			 * @brief 	Method parse flattens a JSON document into dotted paths.
+			 * @param 	text 	JSON document.
+			 * @return 	std::map<std::string, std::string> 	values by path, numbers are kept as text.
+			 * @throws	std::runtime_error if the document is not valid.
+			 */
+			static std::map<std::string, std::string> parse(const std::string& text) {
+				json_reader reader(text);
+				std::map<std::string, std::string> values;
+				reader.parse_value("", values);
+				reader.skip_whitespace();
+				if (reader.position != text.size()) {
+					throw std::runtime_error("Unexpected content after the JSON document.");
+				}
+				return values;
+			}
+
+		protected:
+			/// Document being parsed.
+			const std::string& text;
+			/// Offset of the next character to parse.
+			size_t position = 0;
+
+			/**
+			 * @brief 	Constructor for the json_reader class.
+			 * @param 	text 	document to parse, which must outlive the reader.
+			 */
+			explicit json_reader(const std::string& text) : text(text) {}
+
+			/**
+			 * @brief 	Method skip_whitespace advances past any whitespace.
+			 */
+			void skip_whitespace() {
+				while (position < text.size() && std::isspace((unsigned char)text[position])) {
+					position++;
+				}
+			}
+
+			/**
+			 * @brief 	Method expect consumes a character after any whitespace.
+			 * @param 	character 	character that must come next.
+			 * @throws	std::runtime_error if a different character comes next.
+			 */
+			void expect(char character) {
+				skip_whitespace();
+				if (position >= text.size() || text[position] != character) {
+					throw std::runtime_error(std::string("Expected '") + character + "' at offset " + std::to_string(position) + ".");
+				}
+				position++;
+			}
+
+			/**
+			 * @brief 	Method parse_string parses a string, keeping escaped characters literally.
+			 * @return 	std::string 	contents of the string.
+			 */
+			std::string parse_string() {
+				expect('"');
+				std::string value;
+				while (position < text.size() && text[position] != '"') {
+					if (text[position] == '\\' && position + 1 < text.size()) {
+						position++;
+					}
+					value += text[position++];
+				}
+				expect('"');
+				return value;
+			}
+
+			/**
+			 * @brief 	Method parse_value parses an object, string or number into the flattened values.
+			 * @param 	path 			dotted path of the value.
+			 * @param 	values[out] 	values by path.
+			 */
+			void parse_value(const std::string& path, std::map<std::string, std::string>& values) {
+				skip_whitespace();
+				if (position >= text.size()) {
+					throw std::runtime_error("Unexpected end of the JSON document.");
+				}
+				if (text[position] == '{') {
+					position++;
+					skip_whitespace();
+					if (position < text.size() && text[position] == '}') {
+						position++;
+						return;
+					}
+					while (true) {
+						const std::string key = parse_string();
+						expect(':');
+						parse_value(path.empty() ? key : path + "." + key, values);
+						skip_whitespace();
+						if (position < text.size() && text[position] == ',') {
+							position++;
+							continue;
+						}
+						expect('}');
+						return;
+					}
+				}
+				if (text[position] == '"') {
+					values[path] = parse_string();
+					return;
+				}
+				const size_t start = position;
+				while (position < text.size() && (std::isalnum((unsigned char)text[position]) || text[position] == '-' || text[position] == '+' || text[position] == '.')) {
+					position++;
+				}
+				if (start == position) {
+					throw std::runtime_error("Unexpected character at offset " + std::to_string(position) + ".");
+				}
+				values[path] = text.substr(start, position - start);
+			}
+		};
+
+		/**
+		 * @brief 	Function read_baseline loads a baseline file.
+		 * @param 	path 		path to the baseline JSON file.
+		 * @return 	baseline 	stored tolerance and results.
+		 * @throws	std::runtime_error if the file cannot be read or parsed.
+		 */
+		inline baseline read_baseline(const std::string& path) {
+			std::ifstream file(path);
+			if (!file) {
+				throw std::runtime_error("Could not open baseline " + path + ".");
+			}
+			std::stringstream contents;
+			contents << file.rdbuf();
+
+			baseline loaded;
+			const std::string prefix = "benchmarks.";
+			for (const auto& value : json_reader::parse(contents.str())) {
+				if (value.first == "tolerance") {
+					loaded.tolerance = std::stod(value.second);
+				}
+				else if (value.first.compare(0, prefix.size(), prefix) == 0) {
+					const size_t dot = value.first.rfind('.');
+					const std::string name = value.first.substr(prefix.size(), dot - prefix.size());
+					const std::string field = value.first.substr(dot + 1);
+					if (field == "throughput") {
+						loaded.entries[name].throughput = std::stod(value.second);
+					}
+					else if (field == "latency_ns") {
+						loaded.entries[name].latency_ns = std::stod(value.second);
+					}
+				}
+			}
+			return loaded;
+		}
+
+		/**
+		 * @brief 	Function write_baseline stores a baseline file.
+		 * @param 	path 		path to the baseline JSON file.
+		 * @param 	stored 		tolerance and results to store.
+		 * @throws	std::runtime_error if the file cannot be written.
+		 */
+		inline void write_baseline(const std::string& path, const baseline& stored) {
+			std::ofstream file(path);
+			if (!file) {
+				throw std::runtime_error("Could not write baseline " + path + ".");
+			}
+			file << std::setprecision(6) << "{\n\t\"tolerance\": " << stored.tolerance << ",\n\t\"benchmarks\": {";
+			bool first = true;
+			for (const auto& entry : stored.entries) {
+				file << (first ? "\n" : ",\n") << "\t\t\"" << entry.first << "\": {\"throughput\": " << std::fixed << std::setprecision(0)
+					<< entry.second.throughput << ", \"latency_ns\": " << entry.second.latency_ns << "}";
+				file.unsetf(std::ios::fixed);
+				file << std::setprecision(6);
+				first = false;
+			}
+			file << "\n\t}\n}\n";
+		}
+
+		/**
+		 * @brief 	Function measure runs an operation repeatedly and summarises its throughput and latency.
+		 * @param 	operation 		operation to measure.
+		 * @param 	repetitions 	number of independent repetitions the confidence intervals are computed from.
+		 * @param 	iterations 		number of times the operation is timed in each repetition.
+		 * @param 	operations_per_call	number of operations each call performs, such as the datagrams in a batch,
+		 * 							which the throughput is scaled by (default 1).
+		 * @return 	result 			mean and confidence interval of the throughput and median latency of a call.
+		 * @details	Each repetition runs a short warm up and then times every operation individually, so the median
+		 * 			latency ignores the occasional scheduler hiccup that would skew a mean.
+		 */
+		inline result measure(const std::function<void()>& operation, size_t repetitions, size_t iterations, size_t operations_per_call = 1) {
+			std::vector<double> throughputs;
+			std::vector<double> latencies;
+			std::vector<double> durations(iterations);
+			for (size_t repetition = 0; repetition < repetitions; repetition++) {
+				for (size_t i = 0; i < iterations / 10 + 1; i++) {
+					operation();
+				}
+				const auto start = std::chrono::steady_clock::now();
+				auto previous = start;
+				for (size_t i = 0; i < iterations; i++) {
+					operation();
+					const auto current = std::chrono::steady_clock::now();
+					durations[i] = std::chrono::duration<double, std::nano>(current - previous).count();
+					previous = current;
+				}
+				const double total_seconds = std::chrono::duration<double>(previous - start).count();
+				throughputs.push_back((double)(iterations * operations_per_call) / total_seconds);
+				std::nth_element(durations.begin(), durations.begin() + iterations / 2, durations.end());
+				latencies.push_back(durations[iterations / 2]);
+			}
+			return result{summarise(throughputs), summarise(latencies)};
+		}
+
+		/**
+		 * @brief 	Function is_regression decides whether a result is significantly worse than its baseline.
+		 * @param 	measured 	measured result.
+		 * @param 	stored 		baseline entry for the benchmark.
+		 * @param 	tolerance 	fraction the result may be worse than the baseline by.
+		 * @param 	reason[out]	description of the regression.
+		 * @return 	bool 		true if the whole confidence interval is beyond the tolerance, so that noise alone does
+		 * 						not fail the gate.
+		 */
+		inline bool is_regression(const result& measured, const baseline_entry& stored, double tolerance, std::string& reason) {
+			std::ostringstream description;
+			bool regressed = false;
+			if (stored.throughput > 0 && measured.throughput.upper() < stored.throughput * (1 - tolerance)) {
+				description << "throughput " << measured.throughput.mean << " ops/s is below baseline " << stored.throughput << " ops/s. ";
+				regressed = true;
+			}
+			if (stored.latency_ns > 0 && measured.latency_ns.lower() > stored.latency_ns * (1 + tolerance)) {
+				description << "latency " << measured.latency_ns.mean << " ns is above baseline " << stored.latency_ns << " ns. ";
+				regressed = true;
+			}
+			reason = description.str();
+			return regressed;
+		}
+	}
+}
+
+#endif /* BENCHMARK_GATE_HPP */
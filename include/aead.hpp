@@ -0,0 +1,1107 @@
+/**
+ * 	@file 	aead.hpp
+ * 	@brief 	Classes encrypting and authenticating datagrams with AES-GCM over a udp::socket.
+ * 	@author James Horner
+ * 	@date 	2023-04-05
+ */
+
+#ifndef AEAD_HPP
+#define AEAD_HPP
+
+// Standard System Libraries
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Platform Specific System Libraries
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <wmmintrin.h>
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#endif
+
+// Local Libraries
+#include "byte_order.hpp"
+#include "datagram.hpp"
+#include "errors.hpp"
+#include "socket_address.hpp"
+#include "udp_socket.hpp"
+
+/// Macro for the number of bytes of an AES block.
+#define AEAD_BLOCK_SIZE 16
+/// Macro for the number of bytes of a GCM nonce.
+#define AEAD_NONCE_SIZE 12
+/// Macro for the number of bytes of the fixed salt at the start of every nonce.
+#define AEAD_SALT_SIZE 4
+/// Macro for the number of bytes of a GCM authentication tag.
+#define AEAD_TAG_SIZE 16
+/// Macro for the number of bytes of the sequence number at the start of every sealed datagram.
+#define AEAD_SEQUENCE_SIZE 8
+/// Macro for the number of bytes sealing adds to a datagram.
+#define AEAD_OVERHEAD (AEAD_SEQUENCE_SIZE + AEAD_TAG_SIZE)
+/// Macro for the default number of sequence numbers behind the newest that can still be accepted once.
+#define AEAD_REPLAY_WINDOW 1024
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+/// Macro for if the AES-NI and PCLMULQDQ kernels are compiled, they are only used when the processor has them.
+#define AEAD_HARDWARE_KERNELS 1
+/// Macro for the instruction sets the AES-NI and PCLMULQDQ kernels are compiled for, whatever the compiler targets.
+#define AEAD_HARDWARE_TARGET __attribute__((target("aes,pclmul,ssse3")))
+#endif
+
+namespace oo_socket
+{
+	/**
+	 *	@namespace	aead
+	 * 	@brief 	Authenticated encryption of datagrams with AES-GCM.
+	 * 	@details	A sealed datagram is [sequence][ciphertext][tag] where the 8 byte sequence number is in network byte
+	 * 				order and authenticated as associated data. The nonce is the 4 byte salt of the sending direction
+	 * 				followed by the sequence number, so a key and salt must only ever be used by one sender.
+	 */
+	namespace aead
+	{
+		/**************************************************************************************************/
+		/* AES Functions				 																  */
+		/**************************************************************************************************/
+		/**
+		 *	@struct	aes_tables
+		 * 	@brief 	Struct aes_tables holds the S-box and the combined SubBytes, ShiftRows and MixColumns tables.
+		 */
+		struct aes_tables {
+			/// Substitution box.
+			uint8_t sbox[256];
+			/// Round tables for each byte position of a column.
+			uint32_t round[4][256];
+
+			/**
+			 * @brief 	Constructor for the aes_tables struct which derives the tables from the field inverse.
+			 */
+			aes_tables() {
+				uint8_t p = 1;
+				uint8_t q = 1;
+				do {
+					// p walks the powers of 3 and q the powers of its inverse, so q is the inverse of p.
+					p = (uint8_t)(p ^ (uint8_t)(p << 1) ^ ((p & 0x80) ? 0x1B : 0));
+					q = (uint8_t)(q ^ (q << 1));
+					q = (uint8_t)(q ^ (q << 2));
+					q = (uint8_t)(q ^ (q << 4));
+					q = (uint8_t)(q ^ ((q & 0x80) ? 0x09 : 0));
+					const uint8_t affine = (uint8_t)(q ^ rotate(q, 1) ^ rotate(q, 2) ^ rotate(q, 3) ^ rotate(q, 4));
+					sbox[p] = (uint8_t)(affine ^ 0x63);
+				} while (p != 1);
+				sbox[0] = 0x63;
+				for (size_t x = 0; x < 256; x++) {
+					const uint32_t s = sbox[x];
+					const uint32_t doubled = (uint32_t)(uint8_t)((s << 1) ^ ((s & 0x80) ? 0x1B : 0));
+					const uint32_t column = (doubled << 24) | (s << 16) | (s << 8) | (doubled ^ s);
+					for (size_t position = 0; position < 4; position++) {
+						round[position][x] = position == 0 ? column : (column >> (8 * position)) | (column << (32 - 8 * position));
+					}
+				}
+			}
+
+			/**
+			 * @brief 	Method rotate rotates a byte left.
+			 * @param 	value 	byte to rotate.
+			 * @param 	shift 	number of bits, from 1 to 7.
+			 * @return 	uint8_t the rotated byte.
+			 */
+			static uint8_t rotate(uint8_t value, int shift) {
+				return (uint8_t)((value << shift) | (value >> (8 - shift)));
+			}
+		};
+
+		/**
+		 * @brief 	Function get_aes_tables returns the tables shared by every key, built on first use.
+		 * @return 	const aes_tables& 	the tables.
+		 */
+		inline const aes_tables& get_aes_tables() {
+			static const aes_tables tables;
+			return tables;
+		}
+
+		/**************************************************************************************************/
+		/* AES-GCM						 																  */
+		/**************************************************************************************************/
+		/**
+		 *	@class	aes_gcm
+		 * 	@brief 	Class aes_gcm encrypts and authenticates buffers with AES-128-GCM or AES-256-GCM.
+		 * 	@details	The key schedule and the powers of the hash key are computed once by the constructor. On x86 with
+		 * 				GCC or Clang, when the processor has AES-NI, PCLMULQDQ and SSSE3 (checked once at run time), eight
+		 * 				counter blocks are encrypted at once and their hash is reduced once per eight blocks. Otherwise a
+		 * 				table driven implementation is used, which is slower and not constant time. A key is immutable once
+		 * 				constructed so one can be shared between threads.
+		 * 	@warning	The table driven implementation indexes its AES and GHASH tables with bytes of the key, the data and
+		 * 				the hash key, so an attacker sharing the processor's caches may recover the key from timing. Only
+		 * 				rely on it where no untrusted code runs on the same machine, or check uses_hardware.
+		 */
+		class aes_gcm {
+		public:
+			/**
+			 * @brief 	Constructor for the aes_gcm class which expands a key.
+			 * @param 	key 		bytes of the key.
+			 * @param 	key_size 	size of the key, 16 for AES-128 or 32 for AES-256.
+			 * @param 	allow_hardware 	false to use the table driven implementation even if the processor has AES-NI
+			 * 							(default true).
+			 * @throws	configuration_error if the key is not 16 or 32 bytes.
+			 */
+			aes_gcm(const uint8_t* key, size_t key_size, bool allow_hardware = true) {
+				if (key_size != 16 && key_size != 32) {
+					throw errors::configuration_error("AES-GCM keys must be 16 or 32 bytes, not " + std::to_string(key_size) + ".");
+				}
+				expand_key(key, key_size);
+				uint8_t zero[AEAD_BLOCK_SIZE] = {};
+				uint8_t hash_key[AEAD_BLOCK_SIZE];
+				encrypt_block(zero, hash_key);
+#if defined(AEAD_HARDWARE_KERNELS)
+				hardware = allow_hardware && hardware_supported();
+				if (hardware) {
+					prepare_hash_powers(hash_key);
+				}
+				else {
+					prepare_hash_tables(hash_key);
+				}
+#else
+				(void)allow_hardware;
+				prepare_hash_tables(hash_key);
+#endif
+			}
+
+			/**
+			 * @brief 	Constructor for the aes_gcm class which expands a key.
+			 * @param 	key 	bytes of the key, 16 for AES-128 or 32 for AES-256.
+			 * @param 	allow_hardware 	false to use the table driven implementation even if the processor has AES-NI
+			 * 							(default true).
+			 * @throws	configuration_error if the key is not 16 or 32 bytes.
+			 */
+			explicit aes_gcm(const std::vector<uint8_t>& key, bool allow_hardware = true) : aes_gcm(key.data(), key.size(), allow_hardware) {}
+
+			/**
+			 * @brief 	Method seal encrypts a buffer and computes its tag.
+			 * @param 	nonce 			AEAD_NONCE_SIZE bytes that must never be repeated with the key.
+			 * @param 	aad 			associated data that is authenticated but not encrypted.
+			 * @param 	aad_size 		size of the associated data in bytes.
+			 * @param 	plaintext 		bytes to encrypt.
+			 * @param 	size 			number of bytes to encrypt.
+			 * @param 	ciphertext[out]	size bytes of ciphertext, which may be the plaintext or start before it.
+			 * @param 	tag[out] 		AEAD_TAG_SIZE bytes of tag.
+			 */
+			void seal(const uint8_t* nonce, const char* aad, size_t aad_size, const char* plaintext, size_t size, char* ciphertext, char* tag) const {
+				uint8_t computed[AEAD_TAG_SIZE];
+				crypt(nonce, aad, aad_size, plaintext, size, ciphertext, true, computed);
+				std::memcpy(tag, computed, AEAD_TAG_SIZE);
+			}
+
+			/**
+			 * @brief 	Method open decrypts a buffer and checks its tag.
+			 * @param 	nonce 			AEAD_NONCE_SIZE bytes the buffer was sealed with.
+			 * @param 	aad 			associated data the buffer was sealed with.
+			 * @param 	aad_size 		size of the associated data in bytes.
+			 * @param 	ciphertext 		bytes to decrypt.
+			 * @param 	size 			number of bytes to decrypt.
+			 * @param 	tag 			AEAD_TAG_SIZE bytes of tag the buffer was sealed with.
+			 * @param 	plaintext[out]	size bytes of plaintext, which may be the ciphertext or start before it.
+			 * @return 	bool 			true if the tag matched, otherwise the plaintext is zeroed.
+			 */
+			bool open(const uint8_t* nonce, const char* aad, size_t aad_size, const char* ciphertext, size_t size, const char* tag, char* plaintext) const {
+				uint8_t expected[AEAD_TAG_SIZE];
+				// The tag may sit just after the ciphertext, where the plaintext is written when it starts before it.
+				std::memcpy(expected, tag, AEAD_TAG_SIZE);
+				uint8_t computed[AEAD_TAG_SIZE];
+				crypt(nonce, aad, aad_size, ciphertext, size, plaintext, false, computed);
+				uint8_t difference = 0;
+				for (size_t i = 0; i < AEAD_TAG_SIZE; i++) {
+					difference |= (uint8_t)(computed[i] ^ expected[i]);
+				}
+				if (difference != 0) {
+					std::memset(plaintext, 0, size);
+					return false;
+				}
+				return true;
+			}
+
+			/**
+			 * @brief 	Method uses_hardware returns whether the AES-NI and PCLMULQDQ kernels seal and open.
+			 * @return 	bool 	true if the constant time hardware kernels are used, false for the table driven implementation.
+			 */
+			bool uses_hardware() const {
+				return hardware;
+			}
+
+		private:
+			/**
+			 * @brief 	Method crypt runs the counter mode and GHASH of GCM with the implementation chosen by the constructor.
+			 * @param 	nonce 		AEAD_NONCE_SIZE bytes of nonce.
+			 * @param 	aad 		associated data.
+			 * @param 	aad_size 	size of the associated data in bytes.
+			 * @param 	input 		bytes to encrypt or decrypt.
+			 * @param 	size 		number of bytes.
+			 * @param 	output 		size bytes of output, which may be the input or start before it.
+			 * @param 	encrypting 	true if the output is the ciphertext, false if the input is.
+			 * @param 	tag 		AEAD_TAG_SIZE bytes of computed tag.
+			 */
+			void crypt(const uint8_t* nonce, const char* aad, size_t aad_size, const char* input, size_t size, char* output, bool encrypting, uint8_t* tag) const {
+#if defined(AEAD_HARDWARE_KERNELS)
+				if (hardware) {
+					crypt_hardware(nonce, aad, aad_size, input, size, output, encrypting, tag);
+					return;
+				}
+#endif
+				crypt_tables(nonce, aad, aad_size, input, size, output, encrypting, tag);
+			}
+
+			/**
+			 * @brief 	Method expand_key computes the round keys.
+			 * @param 	key 		bytes of the key.
+			 * @param 	key_size 	size of the key, 16 or 32.
+			 */
+			void expand_key(const uint8_t* key, size_t key_size) {
+				const aes_tables& tables = get_aes_tables();
+				const size_t key_words = key_size / 4;
+				rounds = key_words + 6;
+				uint32_t words[4 * 15];
+				for (size_t i = 0; i < key_words; i++) {
+					words[i] = ((uint32_t)key[4 * i] << 24) | ((uint32_t)key[4 * i + 1] << 16) | ((uint32_t)key[4 * i + 2] << 8) | key[4 * i + 3];
+				}
+				uint8_t round_constant = 1;
+				for (size_t i = key_words; i < 4 * (rounds + 1); i++) {
+					uint32_t word = words[i - 1];
+					if (i % key_words == 0) {
+						word = (word << 8) | (word >> 24);
+						word = substitute_word(tables, word) ^ ((uint32_t)round_constant << 24);
+						round_constant = (uint8_t)((round_constant << 1) ^ ((round_constant & 0x80) ? 0x1B : 0));
+					}
+					else if (key_words > 6 && i % key_words == 4) {
+						word = substitute_word(tables, word);
+					}
+					words[i] = words[i - key_words] ^ word;
+				}
+				for (size_t i = 0; i < 4 * (rounds + 1); i++) {
+					round_words[i] = words[i];
+					byte_order::write_network(words[i], (char*)round_keys + 4 * i);
+				}
+			}
+
+			/**
+			 * @brief 	Method substitute_word applies the S-box to each byte of a word.
+			 * @param 	tables 	AES tables.
+			 * @param 	word 	word to substitute.
+			 * @return 	uint32_t 	the substituted word.
+			 */
+			static uint32_t substitute_word(const aes_tables& tables, uint32_t word) {
+				return ((uint32_t)tables.sbox[word >> 24] << 24) | ((uint32_t)tables.sbox[(word >> 16) & 0xff] << 16) |
+					((uint32_t)tables.sbox[(word >> 8) & 0xff] << 8) | tables.sbox[word & 0xff];
+			}
+
+			/**
+			 * @brief 	Method encrypt_block encrypts a single block with the table driven implementation.
+			 * @param 	input 	AEAD_BLOCK_SIZE bytes to encrypt.
+			 * @param 	output 	AEAD_BLOCK_SIZE bytes of ciphertext, which may be the input.
+			 */
+			void encrypt_block(const uint8_t* input, uint8_t* output) const {
+				const aes_tables& tables = get_aes_tables();
+				const uint32_t* key = round_words;
+				uint32_t s0 = byte_order::read_network<uint32_t>((const char*)input) ^ key[0];
+				uint32_t s1 = byte_order::read_network<uint32_t>((const char*)input + 4) ^ key[1];
+				uint32_t s2 = byte_order::read_network<uint32_t>((const char*)input + 8) ^ key[2];
+				uint32_t s3 = byte_order::read_network<uint32_t>((const char*)input + 12) ^ key[3];
+				for (size_t round = 1; round < rounds; round++) {
+					key += 4;
+					const uint32_t t0 = mix_column(tables, s0, s1, s2, s3) ^ key[0];
+					const uint32_t t1 = mix_column(tables, s1, s2, s3, s0) ^ key[1];
+					const uint32_t t2 = mix_column(tables, s2, s3, s0, s1) ^ key[2];
+					const uint32_t t3 = mix_column(tables, s3, s0, s1, s2) ^ key[3];
+					s0 = t0;
+					s1 = t1;
+					s2 = t2;
+					s3 = t3;
+				}
+				key += 4;
+				byte_order::write_network(substitute_column(tables, s0, s1, s2, s3) ^ key[0], (char*)output);
+				byte_order::write_network(substitute_column(tables, s1, s2, s3, s0) ^ key[1], (char*)output + 4);
+				byte_order::write_network(substitute_column(tables, s2, s3, s0, s1) ^ key[2], (char*)output + 8);
+				byte_order::write_network(substitute_column(tables, s3, s0, s1, s2) ^ key[3], (char*)output + 12);
+			}
+
+			/**
+			 * @brief 	Method mix_column computes a column of a middle round from the shifted rows of the state.
+			 * @param 	tables 	AES tables.
+			 * @param 	first 	column the first row comes from.
+			 * @param 	second 	column the second row comes from.
+			 * @param 	third 	column the third row comes from.
+			 * @param 	fourth 	column the fourth row comes from.
+			 * @return 	uint32_t 	the new column before the round key is added.
+			 */
+			static uint32_t mix_column(const aes_tables& tables, uint32_t first, uint32_t second, uint32_t third, uint32_t fourth) {
+				return tables.round[0][first >> 24] ^ tables.round[1][(second >> 16) & 0xff] ^
+					tables.round[2][(third >> 8) & 0xff] ^ tables.round[3][fourth & 0xff];
+			}
+
+			/**
+			 * @brief 	Method substitute_column computes a column of the last round, which has no MixColumns.
+			 * @param 	tables 	AES tables.
+			 * @param 	first 	column the first row comes from.
+			 * @param 	second 	column the second row comes from.
+			 * @param 	third 	column the third row comes from.
+			 * @param 	fourth 	column the fourth row comes from.
+			 * @return 	uint32_t 	the new column before the round key is added.
+			 */
+			static uint32_t substitute_column(const aes_tables& tables, uint32_t first, uint32_t second, uint32_t third, uint32_t fourth) {
+				return ((uint32_t)tables.sbox[first >> 24] << 24) | ((uint32_t)tables.sbox[(second >> 16) & 0xff] << 16) |
+					((uint32_t)tables.sbox[(third >> 8) & 0xff] << 8) | tables.sbox[fourth & 0xff];
+			}
+
+#if defined(AEAD_HARDWARE_KERNELS)
+			/**
+			 * @brief 	Method hardware_supported returns whether the processor has AES-NI, PCLMULQDQ and SSSE3.
+			 * @return 	bool 	true if the hardware kernels can run.
+			 */
+			static bool hardware_supported() {
+#if defined(__AES__) && defined(__PCLMUL__) && defined(__SSSE3__)
+				return true;
+#else
+				static const bool supported = __builtin_cpu_supports("aes") && __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("ssse3");
+				return supported;
+#endif
+			}
+
+			/**
+			 * @brief 	Method prepare_hash_powers computes the powers of the hash key used to hash eight blocks at once.
+			 * @param 	hash_key 	encryption of the zero block.
+			 */
+			AEAD_HARDWARE_TARGET void prepare_hash_powers(const uint8_t* hash_key) {
+				const __m128i key = reflect(_mm_loadu_si128((const __m128i*)hash_key));
+				__m128i power = key;
+				for (size_t i = 0; i < 8; i++) {
+					_mm_storeu_si128((__m128i*)hash_powers[i], power);
+					power = multiply(power, key);
+				}
+			}
+
+			/**
+			 * @brief 	Method reflect reverses the bytes of a block so GHASH can use integer shifts.
+			 * @param 	block 	block to reverse.
+			 * @return 	__m128i the reversed block.
+			 */
+			AEAD_HARDWARE_TARGET static __m128i reflect(__m128i block) {
+				return _mm_shuffle_epi8(block, _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+			}
+
+			/**
+			 * @brief 	Method multiply_wide carry-less multiplies two reflected blocks and adds the product to a sum.
+			 * @param 	a 			first block.
+			 * @param 	b 			second block.
+			 * @param 	low[in,out]	low half of the sum.
+			 * @param 	high[in,out]	high half of the sum.
+			 */
+			AEAD_HARDWARE_TARGET static void multiply_wide(__m128i a, __m128i b, __m128i& low, __m128i& high) {
+				const __m128i middle = _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x10), _mm_clmulepi64_si128(a, b, 0x01));
+				low = _mm_xor_si128(low, _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x00), _mm_slli_si128(middle, 8)));
+				high = _mm_xor_si128(high, _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x11), _mm_srli_si128(middle, 8)));
+			}
+
+			/**
+			 * @brief 	Method reduce reduces a 256 bit product modulo the GHASH polynomial.
+			 * @param 	low 	low half of the product.
+			 * @param 	high 	high half of the product.
+			 * @return 	__m128i the reduced block.
+			 */
+			AEAD_HARDWARE_TARGET static __m128i reduce(__m128i low, __m128i high) {
+				// Shift the product left a bit, as the reflected operands leave it one bit short.
+				__m128i low_carry = _mm_srli_epi32(low, 31);
+				__m128i high_carry = _mm_srli_epi32(high, 31);
+				low = _mm_slli_epi32(low, 1);
+				high = _mm_slli_epi32(high, 1);
+				const __m128i crossing = _mm_srli_si128(low_carry, 12);
+				high_carry = _mm_slli_si128(high_carry, 4);
+				low_carry = _mm_slli_si128(low_carry, 4);
+				low = _mm_or_si128(low, low_carry);
+				high = _mm_or_si128(_mm_or_si128(high, high_carry), crossing);
+
+				// Fold the low half into the high half with x^128 = x^7 + x^2 + x + 1.
+				__m128i folded = _mm_xor_si128(_mm_xor_si128(_mm_slli_epi32(low, 31), _mm_slli_epi32(low, 30)), _mm_slli_epi32(low, 25));
+				const __m128i spill = _mm_srli_si128(folded, 4);
+				folded = _mm_slli_si128(folded, 12);
+				low = _mm_xor_si128(low, folded);
+				__m128i shifted = _mm_xor_si128(_mm_xor_si128(_mm_srli_epi32(low, 1), _mm_srli_epi32(low, 2)), _mm_srli_epi32(low, 7));
+				shifted = _mm_xor_si128(shifted, spill);
+				low = _mm_xor_si128(low, shifted);
+				return _mm_xor_si128(high, low);
+			}
+
+			/**
+			 * @brief 	Method multiply multiplies two reflected blocks in GF(2^128).
+			 * @param 	a 	first block.
+			 * @param 	b 	second block.
+			 * @return 	__m128i the product.
+			 */
+			AEAD_HARDWARE_TARGET static __m128i multiply(__m128i a, __m128i b) {
+				__m128i low = _mm_setzero_si128();
+				__m128i high = _mm_setzero_si128();
+				multiply_wide(a, b, low, high);
+				return reduce(low, high);
+			}
+
+			/**
+			 * @brief 	Method hash_bytes adds bytes to a GHASH state, padding the last block with zeros.
+			 * @param 	state 	reflected GHASH state.
+			 * @param 	bytes 	bytes to hash.
+			 * @param 	size 	number of bytes.
+			 * @return 	__m128i the new state.
+			 */
+			AEAD_HARDWARE_TARGET __m128i hash_bytes(__m128i state, const char* bytes, size_t size) const {
+				const __m128i key = _mm_loadu_si128((const __m128i*)hash_powers[0]);
+				for (size_t offset = 0; offset < size; offset += AEAD_BLOCK_SIZE) {
+					uint8_t block[AEAD_BLOCK_SIZE] = {};
+					std::memcpy(block, bytes + offset, std::min((size_t)AEAD_BLOCK_SIZE, size - offset));
+					state = multiply(_mm_xor_si128(state, reflect(_mm_loadu_si128((const __m128i*)block))), key);
+				}
+				return state;
+			}
+
+			/**
+			 * @brief 	Method hash_blocks adds up to eight blocks to a GHASH state, multiplying each by the power of the
+			 * 			hash key it would reach so the sum is reduced only once.
+			 * @param 	state 	reflected GHASH state.
+			 * @param 	blocks 	blocks of ciphertext.
+			 * @param 	count 	number of blocks, from 1 to 8.
+			 * @return 	__m128i the new state.
+			 */
+			AEAD_HARDWARE_TARGET __m128i hash_blocks(__m128i state, const __m128i* blocks, size_t count) const {
+				__m128i low = _mm_setzero_si128();
+				__m128i high = _mm_setzero_si128();
+				multiply_wide(_mm_xor_si128(state, reflect(blocks[0])), _mm_loadu_si128((const __m128i*)hash_powers[count - 1]), low, high);
+				for (size_t i = 1; i < count; i++) {
+					multiply_wide(reflect(blocks[i]), _mm_loadu_si128((const __m128i*)hash_powers[count - 1 - i]), low, high);
+				}
+				return reduce(low, high);
+			}
+
+			/**
+			 * @brief 	Method encrypt_eight encrypts the next eight counter blocks while hashing eight blocks of ciphertext.
+			 * @param 	keys 			round keys.
+			 * @param 	counter[in,out]	reflected counter of the last block encrypted.
+			 * @param 	blocks[out] 	eight blocks of key stream.
+			 * @param 	hashed 			eight blocks of ciphertext to hash, or nullptr for none.
+			 * @param 	state[in,out]	reflected GHASH state.
+			 * @note	One block is multiplied in each of the first eight rounds so the multiplier and the AES unit work
+			 * 			at the same time, and the blocks are named rather than an array so they stay in registers.
+			 */
+			AEAD_HARDWARE_TARGET void encrypt_eight(const __m128i* keys, __m128i& counter, __m128i* blocks, const __m128i* hashed, __m128i& state) const {
+				const __m128i one = _mm_set_epi32(0, 0, 0, 1);
+				__m128i block_0 = _mm_xor_si128(reflect(counter = _mm_add_epi32(counter, one)), keys[0]);
+				__m128i block_1 = _mm_xor_si128(reflect(counter = _mm_add_epi32(counter, one)), keys[0]);
+				__m128i block_2 = _mm_xor_si128(reflect(counter = _mm_add_epi32(counter, one)), keys[0]);
+				__m128i block_3 = _mm_xor_si128(reflect(counter = _mm_add_epi32(counter, one)), keys[0]);
+				__m128i block_4 = _mm_xor_si128(reflect(counter = _mm_add_epi32(counter, one)), keys[0]);
+				__m128i block_5 = _mm_xor_si128(reflect(counter = _mm_add_epi32(counter, one)), keys[0]);
+				__m128i block_6 = _mm_xor_si128(reflect(counter = _mm_add_epi32(counter, one)), keys[0]);
+				__m128i block_7 = _mm_xor_si128(reflect(counter = _mm_add_epi32(counter, one)), keys[0]);
+				size_t round = 1;
+				if (hashed != nullptr) {
+					// There are at least nine middle rounds, so every hashed block gets one.
+					__m128i low = _mm_setzero_si128();
+					__m128i high = _mm_setzero_si128();
+					multiply_wide(_mm_xor_si128(state, reflect(hashed[0])), _mm_loadu_si128((const __m128i*)hash_powers[7]), low, high);
+					for (; round <= 8; round++) {
+						const __m128i key = keys[round];
+						block_0 = _mm_aesenc_si128(block_0, key);
+						block_1 = _mm_aesenc_si128(block_1, key);
+						block_2 = _mm_aesenc_si128(block_2, key);
+						block_3 = _mm_aesenc_si128(block_3, key);
+						block_4 = _mm_aesenc_si128(block_4, key);
+						block_5 = _mm_aesenc_si128(block_5, key);
+						block_6 = _mm_aesenc_si128(block_6, key);
+						block_7 = _mm_aesenc_si128(block_7, key);
+						if (round < 8) {
+							multiply_wide(reflect(hashed[round]), _mm_loadu_si128((const __m128i*)hash_powers[7 - round]), low, high);
+						}
+					}
+					state = reduce(low, high);
+				}
+				for (; round < rounds; round++) {
+					const __m128i key = keys[round];
+					block_0 = _mm_aesenc_si128(block_0, key);
+					block_1 = _mm_aesenc_si128(block_1, key);
+					block_2 = _mm_aesenc_si128(block_2, key);
+					block_3 = _mm_aesenc_si128(block_3, key);
+					block_4 = _mm_aesenc_si128(block_4, key);
+					block_5 = _mm_aesenc_si128(block_5, key);
+					block_6 = _mm_aesenc_si128(block_6, key);
+					block_7 = _mm_aesenc_si128(block_7, key);
+				}
+				blocks[0] = _mm_aesenclast_si128(block_0, keys[rounds]);
+				blocks[1] = _mm_aesenclast_si128(block_1, keys[rounds]);
+				blocks[2] = _mm_aesenclast_si128(block_2, keys[rounds]);
+				blocks[3] = _mm_aesenclast_si128(block_3, keys[rounds]);
+				blocks[4] = _mm_aesenclast_si128(block_4, keys[rounds]);
+				blocks[5] = _mm_aesenclast_si128(block_5, keys[rounds]);
+				blocks[6] = _mm_aesenclast_si128(block_6, keys[rounds]);
+				blocks[7] = _mm_aesenclast_si128(block_7, keys[rounds]);
+			}
+
+			/**
+			 * @brief 	Method crypt_hardware runs the counter mode and GHASH of GCM with AES-NI and PCLMULQDQ.
+			 * @param 	nonce 		AEAD_NONCE_SIZE bytes of nonce.
+			 * @param 	aad 		associated data.
+			 * @param 	aad_size 	size of the associated data in bytes.
+			 * @param 	input 		bytes to encrypt or decrypt.
+			 * @param 	size 		number of bytes.
+			 * @param 	output 		size bytes of output, which may be the input or start before it.
+			 * @param 	encrypting 	true if the output is the ciphertext, false if the input is.
+			 * @param 	tag 		AEAD_TAG_SIZE bytes of computed tag.
+			 */
+			AEAD_HARDWARE_TARGET void crypt_hardware(const uint8_t* nonce, const char* aad, size_t aad_size, const char* input, size_t size, char* output, bool encrypting, uint8_t* tag) const {
+				__m128i keys[15];
+				for (size_t round = 0; round <= rounds; round++) {
+					keys[round] = _mm_loadu_si128((const __m128i*)(round_keys + AEAD_BLOCK_SIZE * round));
+				}
+				uint8_t initial[AEAD_BLOCK_SIZE] = {};
+				std::memcpy(initial, nonce, AEAD_NONCE_SIZE);
+				initial[AEAD_BLOCK_SIZE - 1] = 1;
+				const __m128i first_counter = _mm_loadu_si128((const __m128i*)initial);
+				const __m128i tag_mask = encrypt(keys, first_counter);
+
+				// The counter is kept reflected so its last 32 bits are the lowest lane and increment with one add.
+				__m128i counter = reflect(first_counter);
+				__m128i state = hash_bytes(_mm_setzero_si128(), aad, aad_size);
+
+				__m128i stream[8];
+				__m128i data[8];
+				// Encrypting hashes the previous eight blocks of output, decrypting hashes the input being decrypted.
+				__m128i previous[8];
+				bool pending = false;
+				size_t offset = 0;
+				for (; offset + 8 * AEAD_BLOCK_SIZE <= size; offset += 8 * AEAD_BLOCK_SIZE) {
+					// Every input block is loaded before any output is stored, so the output can start before the input.
+					const __m128i* source = (const __m128i*)(input + offset);
+					__m128i* destination = (__m128i*)(output + offset);
+					for (size_t i = 0; i < 8; i++) {
+						data[i] = _mm_loadu_si128(source + i);
+					}
+					encrypt_eight(keys, counter, stream, encrypting ? (pending ? previous : nullptr) : data, state);
+					for (size_t i = 0; i < 8; i++) {
+						previous[i] = _mm_xor_si128(stream[i], data[i]);
+						_mm_storeu_si128(destination + i, previous[i]);
+					}
+					pending = encrypting;
+				}
+
+				if (offset < size) {
+					// The last blocks are encrypted together and the hashed ciphertext is padded with zeros.
+					const size_t remaining = size - offset;
+					const size_t count = (remaining + AEAD_BLOCK_SIZE - 1) / AEAD_BLOCK_SIZE;
+					uint8_t padded[8 * AEAD_BLOCK_SIZE] = {};
+					std::memcpy(padded, input + offset, remaining);
+					encrypt_eight(keys, counter, stream, pending ? previous : nullptr, state);
+					for (size_t i = 0; i < count; i++) {
+						data[i] = _mm_loadu_si128((const __m128i*)(padded + AEAD_BLOCK_SIZE * i));
+						stream[i] = _mm_xor_si128(stream[i], data[i]);
+					}
+					uint8_t result[8 * AEAD_BLOCK_SIZE];
+					std::memcpy(result, stream, sizeof(result));
+					std::memcpy(output + offset, result, std::min(remaining, sizeof(result)));
+					if (encrypting) {
+						std::memset(result + remaining, 0, sizeof(result) - remaining);
+						std::memcpy(stream, result, sizeof(result));
+					}
+					state = hash_blocks(state, encrypting ? stream : data, count);
+				}
+				else if (pending) {
+					state = hash_blocks(state, previous, 8);
+				}
+
+				const __m128i lengths = _mm_set_epi64x((long long)(aad_size * 8), (long long)(size * 8));
+				state = multiply(_mm_xor_si128(state, lengths), _mm_loadu_si128((const __m128i*)hash_powers[0]));
+				_mm_storeu_si128((__m128i*)tag, _mm_xor_si128(reflect(state), tag_mask));
+			}
+
+			/**
+			 * @brief 	Method encrypt encrypts a single block with AES-NI.
+			 * @param 	keys 	round keys.
+			 * @param 	block 	block to encrypt.
+			 * @return 	__m128i the ciphertext.
+			 */
+			AEAD_HARDWARE_TARGET __m128i encrypt(const __m128i* keys, __m128i block) const {
+				block = _mm_xor_si128(block, keys[0]);
+				for (size_t round = 1; round < rounds; round++) {
+					block = _mm_aesenc_si128(block, keys[round]);
+				}
+				return _mm_aesenclast_si128(block, keys[rounds]);
+			}
+#endif
+
+			/**
+			 * @brief 	Method prepare_hash_tables computes the tables of multiples of the hash key for 4 bit GHASH.
+			 * @param 	hash_key 	encryption of the zero block.
+			 */
+			void prepare_hash_tables(const uint8_t* hash_key) {
+				uint64_t high = byte_order::read_network<uint64_t>((const char*)hash_key);
+				uint64_t low = byte_order::read_network<uint64_t>((const char*)hash_key + 8);
+				hash_high[0] = 0;
+				hash_low[0] = 0;
+				hash_high[8] = high;
+				hash_low[8] = low;
+				for (size_t i = 4; i > 0; i >>= 1) {
+					const uint64_t reduction = (low & 1) ? 0xe100000000000000ULL : 0;
+					low = (high << 63) | (low >> 1);
+					high = (high >> 1) ^ reduction;
+					hash_high[i] = high;
+					hash_low[i] = low;
+				}
+				for (size_t i = 2; i <= 8; i <<= 1) {
+					for (size_t j = 1; j < i; j++) {
+						hash_high[i + j] = hash_high[i] ^ hash_high[j];
+						hash_low[i + j] = hash_low[i] ^ hash_low[j];
+					}
+				}
+			}
+
+			/**
+			 * @brief 	Method multiply multiplies a GHASH state by the hash key 4 bits at a time.
+			 * @param 	state[in,out] 	AEAD_BLOCK_SIZE bytes of state.
+			 */
+			void multiply(uint8_t* state) const {
+				static const uint64_t remainders[16] = {
+					0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+					0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0
+				};
+				uint64_t high = hash_high[state[15] & 0xf];
+				uint64_t low = hash_low[state[15] & 0xf];
+				for (int i = 15; i >= 0; i--) {
+					const uint8_t nibbles[2] = {(uint8_t)(state[i] & 0xf), (uint8_t)(state[i] >> 4)};
+					for (size_t n = (i == 15 ? 1 : 0); n < 2; n++) {
+						const size_t remainder = low & 0xf;
+						low = (high << 60) | (low >> 4);
+						high = (high >> 4) ^ (remainders[remainder] << 48);
+						high ^= hash_high[nibbles[n]];
+						low ^= hash_low[nibbles[n]];
+					}
+				}
+				byte_order::write_network(high, (char*)state);
+				byte_order::write_network(low, (char*)state + 8);
+			}
+
+			/**
+			 * @brief 	Method hash_block adds a block, padded with zeros, to a GHASH state.
+			 * @param 	state 	AEAD_BLOCK_SIZE bytes of state.
+			 * @param 	bytes 	bytes of the block.
+			 * @param 	count 	number of bytes, at most AEAD_BLOCK_SIZE.
+			 */
+			void hash_block(uint8_t* state, const uint8_t* bytes, size_t count) const {
+				for (size_t i = 0; i < count; i++) {
+					state[i] ^= bytes[i];
+				}
+				multiply(state);
+			}
+
+			/**
+			 * @brief 	Method crypt_tables runs the counter mode and GHASH of GCM with the table driven implementation.
+			 * @param 	nonce 		AEAD_NONCE_SIZE bytes of nonce.
+			 * @param 	aad 		associated data.
+			 * @param 	aad_size 	size of the associated data in bytes.
+			 * @param 	input 		bytes to encrypt or decrypt.
+			 * @param 	size 		number of bytes.
+			 * @param 	output 		size bytes of output, which may be the input or start before it.
+			 * @param 	encrypting 	true if the output is the ciphertext, false if the input is.
+			 * @param 	tag 		AEAD_TAG_SIZE bytes of computed tag.
+			 */
+			void crypt_tables(const uint8_t* nonce, const char* aad, size_t aad_size, const char* input, size_t size, char* output, bool encrypting, uint8_t* tag) const {
+				uint8_t counter[AEAD_BLOCK_SIZE] = {};
+				std::memcpy(counter, nonce, AEAD_NONCE_SIZE);
+				counter[AEAD_BLOCK_SIZE - 1] = 1;
+				uint8_t tag_mask[AEAD_BLOCK_SIZE];
+				encrypt_block(counter, tag_mask);
+				uint32_t block_counter = 1;
+
+				uint8_t state[AEAD_BLOCK_SIZE] = {};
+				for (size_t offset = 0; offset < aad_size; offset += AEAD_BLOCK_SIZE) {
+					hash_block(state, (const uint8_t*)aad + offset, std::min((size_t)AEAD_BLOCK_SIZE, aad_size - offset));
+				}
+				for (size_t offset = 0; offset < size; offset += AEAD_BLOCK_SIZE) {
+					const size_t count = std::min((size_t)AEAD_BLOCK_SIZE, size - offset);
+					uint8_t data[AEAD_BLOCK_SIZE];
+					std::memcpy(data, input + offset, count);
+					byte_order::write_network(++block_counter, (char*)counter + AEAD_NONCE_SIZE);
+					uint8_t result[AEAD_BLOCK_SIZE];
+					encrypt_block(counter, result);
+					for (size_t i = 0; i < count; i++) {
+						result[i] ^= data[i];
+					}
+					std::memcpy(output + offset, result, count);
+					hash_block(state, encrypting ? result : data, count);
+				}
+
+				uint8_t lengths[AEAD_BLOCK_SIZE];
+				byte_order::write_network((uint64_t)aad_size * 8, (char*)lengths);
+				byte_order::write_network((uint64_t)size * 8, (char*)lengths + 8);
+				hash_block(state, lengths, AEAD_BLOCK_SIZE);
+				for (size_t i = 0; i < AEAD_TAG_SIZE; i++) {
+					tag[i] = (uint8_t)(state[i] ^ tag_mask[i]);
+				}
+			}
+
+			/// Number of rounds, 10 for AES-128 or 14 for AES-256.
+			size_t rounds = 0;
+			/// Round keys as big endian words for the table driven implementation.
+			uint32_t round_words[4 * 15];
+			/// Round keys as bytes for AES-NI.
+			uint8_t round_keys[AEAD_BLOCK_SIZE * 15];
+			/// Flag for if the AES-NI and PCLMULQDQ kernels are used.
+			bool hardware = false;
+#if defined(AEAD_HARDWARE_KERNELS)
+			/// Reflected hash key raised to the powers 1 to 8, for the hardware kernels.
+			uint8_t hash_powers[8][AEAD_BLOCK_SIZE];
+#endif
+			/// High halves of the multiples of the hash key by each 4 bit value, for the table driven implementation.
+			uint64_t hash_high[16];
+			/// Low halves of the multiples of the hash key by each 4 bit value, for the table driven implementation.
+			uint64_t hash_low[16];
+		};
+
+		/**************************************************************************************************/
+		/* Replay Window				 																  */
+		/**************************************************************************************************/
+		/**
+		 *	@class	replay_window
+		 * 	@brief 	Class replay_window accepts each sequence number at most once, within a window behind the newest.
+		 * 	@details	Sequence numbers are kept in a ring of 64 bit words as in RFC 6479, so moving the window forward
+		 * 				clears whole words rather than shifting a bitmap. Sequence number 0 is never accepted.
+		 */
+		class replay_window {
+		public:
+			/**
+			 * @brief 	Constructor for the replay_window class.
+			 * @param 	size 	number of sequence numbers behind the newest that can still be accepted, rounded up to a
+			 * 					multiple of 64 (default AEAD_REPLAY_WINDOW).
+			 */
+			explicit replay_window(size_t size = AEAD_REPLAY_WINDOW) :
+				bits(std::max<size_t>((size + 63) / 64, 1) + 1, 0),
+				window((bits.size() - 1) * 64)
+			{}
+
+			/**
+			 * @brief 	Method check returns whether a sequence number has not been accepted and is not too old.
+			 * @param 	sequence 	sequence number to check.
+			 * @return 	bool 		true if the sequence number can be accepted.
+			 */
+			bool check(uint64_t sequence) const {
+				if (sequence == 0) {
+					return false;
+				}
+				if (sequence > newest) {
+					return true;
+				}
+				if (newest - sequence >= window) {
+					return false;
+				}
+				return ((bits[(sequence >> 6) % bits.size()] >> (sequence & 63)) & 1) == 0;
+			}
+
+			/**
+			 * @brief 	Method accept records a sequence number, which must have passed check and been authenticated.
+			 * @param 	sequence 	sequence number to record.
+			 */
+			void accept(uint64_t sequence) {
+				if (sequence > newest) {
+					const uint64_t moved = std::min<uint64_t>((sequence >> 6) - (newest >> 6), bits.size());
+					for (uint64_t word = 1; word <= moved; word++) {
+						bits[((newest >> 6) + word) % bits.size()] = 0;
+					}
+					newest = sequence;
+				}
+				bits[(sequence >> 6) % bits.size()] |= 1ULL << (sequence & 63);
+			}
+
+			/**
+			 * @brief 	Method get_newest returns the newest sequence number accepted.
+			 * @return 	uint64_t 	the sequence number, 0 if none have been accepted.
+			 */
+			uint64_t get_newest() const {
+				return newest;
+			}
+
+		private:
+			/// Ring of words with a bit for each sequence number.
+			std::vector<uint64_t> bits;
+			/// Number of sequence numbers behind the newest that can be accepted.
+			uint64_t window;
+			/// Newest sequence number accepted.
+			uint64_t newest = 0;
+		};
+
+		/**************************************************************************************************/
+		/* Channel						 																  */
+		/**************************************************************************************************/
+		/**
+		 *	@struct	session_key
+		 * 	@brief 	Struct session_key is the key and nonce salt of one direction of a channel.
+		 */
+		struct session_key {
+			/// AES key of 16 or 32 bytes.
+			std::vector<uint8_t> key;
+			/// First bytes of every nonce.
+			std::array<uint8_t, AEAD_SALT_SIZE> salt;
+		};
+
+		/**
+		 *	@class	channel
+		 * 	@brief 	Class channel sends and receives sealed datagrams over a udp::socket.
+		 * 	@details	Each direction has its own key and salt, so the send key of one peer is the receive key of the
+		 * 				other and two peers never seal with the same nonce. Sends number datagrams from 1 and a batch is
+		 * 				sealed into one buffer and sent with a single send_batch_to. Received datagrams are opened in place,
+		 * 				and ones that fail authentication or were already received are dropped and counted. Sending and
+		 * 				receiving are each thread safe, and the socket must outlive the channel.
+		 */
+		class channel {
+		public:
+			/**
+			 * @brief 	Constructor for the channel class.
+			 * @param 	channel_socket 	socket that sealed datagrams are sent and received on.
+			 * @param 	send_key 		key and salt datagrams are sealed with.
+			 * @param 	receive_key 	key and salt received datagrams were sealed with by the peer.
+			 * @param 	window 			number of sequence numbers behind the newest still accepted (default AEAD_REPLAY_WINDOW).
+			 * @throws	configuration_error if either key is not 16 or 32 bytes.
+			 */
+			channel(udp::socket& channel_socket, const session_key& send_key, const session_key& receive_key, size_t window = AEAD_REPLAY_WINDOW) :
+				channel_socket(channel_socket),
+				sealer(send_key.key),
+				opener(receive_key.key),
+				send_salt(send_key.salt),
+				receive_salt(receive_key.salt),
+				replays(window)
+			{}
+
+			/**
+			 * @brief 	Method seal seals a datagram with the next sequence number.
+			 * @param 	plaintext 		bytes of the datagram.
+			 * @param 	size 			size of the datagram in bytes.
+			 * @param 	destination 	buffer of at least size + AEAD_OVERHEAD bytes.
+			 * @return 	size_t 			number of bytes written.
+			 * @throws	encode_error if the sequence numbers of the key are used up.
+			 */
+			size_t seal(const char* plaintext, size_t size, char* destination) {
+				std::unique_lock<std::mutex> send_lock(send_mutex);
+				return seal_datagram(plaintext, size, destination);
+			}
+
+			/**
+			 * @brief 	Method open authenticates and decrypts a sealed datagram in place.
+			 * @param 	buffer 			bytes of the datagram, replaced by the plaintext from the start of the buffer.
+			 * @param 	size[in,out] 	size of the datagram, set to the size of the plaintext.
+			 * @return 	bool 			true if the datagram is authentic and has not been received before.
+			 */
+			bool open(char* buffer, size_t& size) {
+				std::unique_lock<std::mutex> receive_lock(receive_mutex);
+				return open_datagram(buffer, size);
+			}
+
+			/**
+			 * @brief 	Method send_to seals and sends a datagram.
+			 * @param 	buffer 		bytes of the datagram.
+			 * @param 	size 		size of the datagram in bytes.
+			 * @param 	destination	address to send the datagram to.
+			 * @return 	int 		number of bytes sent, including the AEAD_OVERHEAD.
+			 * @throws	send_error if an error occurred while sending the data.
+			 */
+			int send_to(const char* buffer, size_t size, const socket_address& destination) {
+				std::unique_lock<std::mutex> send_lock(send_mutex);
+				frames.resize(size + AEAD_OVERHEAD);
+				const size_t sealed = seal_datagram(buffer, size, frames.data());
+				return channel_socket.send_to(frames.data(), sealed, destination);
+			}
+
+			/**
+			 * @brief 	Method send_batch_to seals several datagrams and sends them with one call to send_batch_to.
+			 * @param 	datagrams	pointer to the datagrams to send.
+			 * @param 	count		number of datagrams to send.
+			 * @param 	destination	address to send the datagrams to.
+			 * @return 	int 		number of datagrams sent.
+			 * @throws	send_error if no datagram could be sent.
+			 */
+			int send_batch_to(const outgoing_datagram* datagrams, size_t count, const socket_address& destination) {
+				std::unique_lock<std::mutex> send_lock(send_mutex);
+				size_t total = 0;
+				for (size_t i = 0; i < count; i++) {
+					total += datagrams[i].size + AEAD_OVERHEAD;
+				}
+				frames.resize(total);
+				outgoing.resize(count);
+				size_t offset = 0;
+				for (size_t i = 0; i < count; i++) {
+					const size_t sealed = seal_datagram(datagrams[i].buffer, datagrams[i].size, frames.data() + offset);
+					outgoing[i] = outgoing_datagram{frames.data() + offset, sealed};
+					offset += sealed;
+				}
+				return channel_socket.send_batch_to(outgoing.data(), count, destination);
+			}
+
+			/**
+			 * @brief 	Method send_batch_to seals several datagrams and sends them with one call to send_batch_to.
+			 * @param 	datagrams	vector of datagrams to send.
+			 * @param 	destination	address to send the datagrams to.
+			 * @return 	int 		number of datagrams sent.
+			 * @throws	send_error if no datagram could be sent.
+			 */
+			int send_batch_to(const std::vector<outgoing_datagram>& datagrams, const socket_address& destination) {
+				return send_batch_to(datagrams.data(), datagrams.size(), destination);
+			}
+
+			/**
+			 * @brief 	Method receive_batch receives a batch of datagrams and opens each of them in place.
+			 * @param 	datagrams[in,out]	buffers to receive into, at least AEAD_OVERHEAD bytes larger than the plaintext.
+			 * @param 	count[in]			number of buffers.
+			 * @param 	with_source[in]		true to set the source address and port of each datagram (default false).
+			 * @return 	int					number of authentic datagrams, which are moved to the front of the batch in
+			 * 								the order they were received with their size set to the size of the plaintext,
+			 * 								0 if the receive timed out or only forgeries and replays arrived.
+			 * @throws	receive_error if an error occurred while receiving the data.
+			 * @details	Only one batch is received per call, so datagrams without the key cannot hold the caller past the
+			 * 			socket's receive timeout. Callers that wait for authentic datagrams should check the failure
+			 * 			counts or their own deadline rather than treating 0 as a timeout.
+			 */
+			int receive_batch(incoming_datagram* datagrams, size_t count, bool with_source = false) {
+				size_t kept = 0;
+				const int received = channel_socket.receive_batch(datagrams, count, with_source);
+				std::unique_lock<std::mutex> receive_lock(receive_mutex);
+				for (size_t i = 0; i < (size_t)received; i++) {
+					if (open_datagram(datagrams[i].buffer, datagrams[i].size)) {
+						if (kept != i) {
+							std::swap(datagrams[kept], datagrams[i]);
+						}
+						kept++;
+					}
+				}
+				return (int)kept;
+			}
+
+			/**
+			 * @brief 	Method receive_batch receives up to datagrams.size() datagrams and opens each of them in place.
+			 * @param 	datagrams[in,out]	buffers to receive into, at least AEAD_OVERHEAD bytes larger than the plaintext.
+			 * @param 	with_source[in]		true to set the source address and port of each datagram (default false).
+			 * @return 	int					number of authentic datagrams, which are moved to the front of the batch, 0 if
+			 * 								the receive timed out or only forgeries and replays arrived.
+			 * @throws	receive_error if an error occurred while receiving the data.
+			 */
+			int receive_batch(std::vector<incoming_datagram>& datagrams, bool with_source = false) {
+				return receive_batch(datagrams.data(), datagrams.size(), with_source);
+			}
+
+			/**
+			 * @brief 	Method get_authentication_failures returns the number of datagrams that were too short or failed
+			 * 			authentication.
+			 * @return 	uint64_t 	number of datagrams.
+			 */
+			uint64_t get_authentication_failures() {
+				std::unique_lock<std::mutex> receive_lock(receive_mutex);
+				return authentication_failures;
+			}
+
+			/**
+			 * @brief 	Method get_replays returns the number of datagrams dropped because their sequence number was
+			 * 			already received or too far behind the newest.
+			 * @return 	uint64_t 	number of datagrams.
+			 */
+			uint64_t get_replays() {
+				std::unique_lock<std::mutex> receive_lock(receive_mutex);
+				return replayed;
+			}
+
+		private:
+			/**
+			 * @brief 	Method seal_datagram seals a datagram, with the send mutex held.
+			 * @param 	plaintext 		bytes of the datagram.
+			 * @param 	size 			size of the datagram in bytes.
+			 * @param 	destination 	buffer of at least size + AEAD_OVERHEAD bytes.
+			 * @return 	size_t 			number of bytes written.
+			 * @throws	encode_error if the sequence numbers of the key are used up.
+			 */
+			size_t seal_datagram(const char* plaintext, size_t size, char* destination) {
+				if (next_sequence == UINT64_MAX) {
+					throw errors::encode_error("The sequence numbers of the AES-GCM key are used up, a new key is needed.");
+				}
+				const uint64_t sequence = next_sequence++;
+				uint8_t nonce[AEAD_NONCE_SIZE];
+				make_nonce(send_salt, sequence, nonce);
+				byte_order::write_network(sequence, destination);
+				sealer.seal(nonce, destination, AEAD_SEQUENCE_SIZE, plaintext, size, destination + AEAD_SEQUENCE_SIZE, destination + AEAD_SEQUENCE_SIZE + size);
+				return size + AEAD_OVERHEAD;
+			}
+
+			/**
+			 * @brief 	Method open_datagram opens a datagram in place, with the receive mutex held.
+			 * @param 	buffer 			bytes of the datagram.
+			 * @param 	size[in,out] 	size of the datagram, set to the size of the plaintext.
+			 * @return 	bool 			true if the datagram is authentic and has not been received before.
+			 */
+			bool open_datagram(char* buffer, size_t& size) {
+				if (size < AEAD_OVERHEAD) {
+					authentication_failures++;
+					return false;
+				}
+				char header[AEAD_SEQUENCE_SIZE];
+				std::memcpy(header, buffer, AEAD_SEQUENCE_SIZE);
+				const uint64_t sequence = byte_order::read_network<uint64_t>(header);
+				// The window is checked first so replays are dropped without decrypting them.
+				if (!replays.check(sequence)) {
+					replayed++;
+					return false;
+				}
+				const size_t plaintext_size = size - AEAD_OVERHEAD;
+				uint8_t nonce[AEAD_NONCE_SIZE];
+				make_nonce(receive_salt, sequence, nonce);
+				if (!opener.open(nonce, header, AEAD_SEQUENCE_SIZE, buffer + AEAD_SEQUENCE_SIZE, plaintext_size, buffer + AEAD_SEQUENCE_SIZE + plaintext_size, buffer)) {
+					authentication_failures++;
+					return false;
+				}
+				replays.accept(sequence);
+				size = plaintext_size;
+				return true;
+			}
+
+			/**
+			 * @brief 	Method make_nonce builds the nonce of a sequence number.
+			 * @param 	salt 		salt of the direction.
+			 * @param 	sequence 	sequence number.
+			 * @param 	nonce[out]	AEAD_NONCE_SIZE bytes of nonce.
+			 */
+			static void make_nonce(const std::array<uint8_t, AEAD_SALT_SIZE>& salt, uint64_t sequence, uint8_t* nonce) {
+				std::memcpy(nonce, salt.data(), AEAD_SALT_SIZE);
+				byte_order::write_network(sequence, (char*)nonce + AEAD_SALT_SIZE);
+			}
+
+			/// Socket sealed datagrams are sent and received on.
+			udp::socket& channel_socket;
+			/// Key datagrams are sealed with.
+			const aes_gcm sealer;
+			/// Key received datagrams are opened with.
+			const aes_gcm opener;
+			/// Salt of the nonces of sent datagrams.
+			const std::array<uint8_t, AEAD_SALT_SIZE> send_salt;
+			/// Salt of the nonces of received datagrams.
+			const std::array<uint8_t, AEAD_SALT_SIZE> receive_salt;
+			/// Mutex protecting the sequence number and buffers of sends.
+			std::mutex send_mutex;
+			/// Mutex protecting the replay window and counters of receives.
+			std::mutex receive_mutex;
+			/// Sequence number of the next datagram sent.
+			uint64_t next_sequence = 1;
+			/// Sealed datagrams of the batch being sent.
+			std::vector<char> frames;
+			/// Datagrams of the batch being sent.
+			std::vector<outgoing_datagram> outgoing;
+			/// Sequence numbers already received.
+			replay_window replays;
+			/// Number of datagrams that were too short or failed authentication.
+			uint64_t authentication_failures = 0;
+			/// Number of datagrams that were replayed or too old.
+			uint64_t replayed = 0;
+		};
+	}
+}
+
+#endif /* AEAD_HPP */
@@ -0,0 +1,912 @@
+/**
+ * 	@file 	array_codec.hpp
+ * 	@brief 	Functions encoding numeric arrays with frame-of-reference bit packing, quantization or XOR compression.
+ * 	@author James Horner
+ * 	@date 	2023-04-05
+ */
+
+#ifndef ARRAY_CODEC_HPP
+#define ARRAY_CODEC_HPP
+
+// Standard System Libraries
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Platform Specific System Libraries
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#include <arm_neon.h>
+#endif
+
+// Local Libraries
+#include "byte_order.hpp"
+#include "errors.hpp"
+#include "schema.hpp"
+
+/// Macro for the first byte of every encoded array.
+#define ARRAY_CODEC_MAGIC 0xAC
+/// Macro for the largest number of values an array may hold, one per bit of the largest UDP payload, so a corrupt or
+/// hostile count in a small packet of constant values cannot make the decoder allocate more than a few megabytes.
+#define ARRAY_CODEC_MAX_COUNT (65507 * 8)
+/// Macro for the number of values bit packed together by the SIMD kernels, 8 lanes of 32 rows.
+#define ARRAY_CODEC_BLOCK_SIZE 256
+
+namespace oo_socket
+{
+	/**
+	 *	@namespace	array_codec
+	 * 	@brief 		Opt-in encodings of int32_t, uint32_t, float and double arrays that are smaller than the raw bytes.
+	 * 	@details	Every encoded array starts with ARRAY_CODEC_MAGIC, the method, the element type and a varint count.
+	 * 				Frame-of-reference arrays then hold the minimum and the bit width, followed by blocks of 256 values
+	 * 				packed as 8 interleaved lanes of little endian 32 bit words (so SIMD kernels pack a whole row with
+	 * 				one shift) and a bit stream for the remaining values. Quantized arrays hold the step as a double and
+	 * 				then the quantized integers as a frame-of-reference array. XOR arrays are a Gorilla bit stream of
+	 * 				the XOR of each value with the previous one. Arrays that do not shrink are sent raw.
+	 */
+	namespace array_codec
+	{
+		/**
+		 *	@enum	method
+		 * 	@brief 	Enum method names how an array is encoded.
+		 */
+		enum method : uint8_t
+		{
+			/// Values in network byte order.
+			RAW = 0,
+			/// Integers as offsets from the minimum packed into as few bits as the largest offset needs.
+			FRAME_OF_REFERENCE,
+			/// Floating point values rounded to a multiple of a step and packed as integers, which is lossy.
+			QUANTIZED,
+			/// Floating point values as the Gorilla encoding of the XOR with the previous value, which is lossless.
+			XOR,
+		};
+
+		/**
+		 *	@struct	array_encoding
+		 * 	@brief 	Struct array_encoding chooses the methods used for integer and floating point arrays.
+		 */
+		struct array_encoding {
+			/// Method used for int32_t and uint32_t arrays, RAW or FRAME_OF_REFERENCE.
+			method integer_method = FRAME_OF_REFERENCE;
+			/// Method used for float and double arrays, RAW, QUANTIZED or XOR.
+			method floating_method = XOR;
+			/// Step floating point values are rounded to by QUANTIZED, the largest error is half the step.
+			double quantization_step = 0.001;
+		};
+
+		/**
+		 *	@struct	element_type
+		 * 	@brief 	Struct element_type names the code written for each supported element type.
+		 */
+		template <typename T> struct element_type { static constexpr uint8_t code = 0; };
+		template <> struct element_type<int32_t> { static constexpr uint8_t code = 1; };
+		template <> struct element_type<uint32_t> { static constexpr uint8_t code = 2; };
+		template <> struct element_type<float> { static constexpr uint8_t code = 3; };
+		template <> struct element_type<double> { static constexpr uint8_t code = 4; };
+
+		/**
+		 *	@struct	is_supported
+		 * 	@brief 	Struct is_supported is true for the element types the codec can encode.
+		 */
+		template <typename T> struct is_supported : std::integral_constant<bool, element_type<T>::code != 0> {};
+
+		/**************************************************************************************************/
+		/* Bit Streams					 																  */
+		/**************************************************************************************************/
+		/**
+		 *	@class	bit_writer
+		 * 	@brief 	Class bit_writer appends values of up to 32 bits to a buffer, least significant bit first.
+		 */
+		class bit_writer {
+		public:
+			/**
+			 * @brief 	Constructor for the bit_writer class.
+			 * @param 	destination 	buffer large enough for every bit written, rounded up to a whole byte.
+			 */
+			bit_writer(char* destination) : position(destination) {}
+
+			/**
+			 * @brief 	Method write appends the low bits of a value.
+			 * @param 	value 	value to append, bits above count must be zero.
+			 * @param 	count 	number of bits, 0 to 32.
+			 */
+			void write(uint64_t value, unsigned count) {
+				accumulator |= value << pending;
+				pending += count;
+				while (pending >= 8) {
+					*position++ = (char)accumulator;
+					accumulator >>= 8;
+					pending -= 8;
+				}
+			}
+
+			/**
+			 * @brief 	Method write_wide appends the low bits of a value of up to 64 bits.
+			 * @param 	value 	value to append, bits above count must be zero.
+			 * @param 	count 	number of bits, 0 to 64.
+			 */
+			void write_wide(uint64_t value, unsigned count) {
+				if (count > 32) {
+					write(value & 0xffffffff, 32);
+					write(value >> 32, count - 32);
+				}
+				else {
+					write(value, count);
+				}
+			}
+
+			/**
+			 * @brief 	Method finish writes the last partial byte.
+			 * @return 	char* 	position after the last byte written.
+			 */
+			char* finish() {
+				if (pending > 0) {
+					*position++ = (char)accumulator;
+					accumulator = 0;
+					pending = 0;
+				}
+				return position;
+			}
+
+		protected:
+			/// Position of the next whole byte.
+			char* position;
+			/// Bits written but not yet stored.
+			uint64_t accumulator = 0;
+			/// Number of bits in the accumulator.
+			unsigned pending = 0;
+		};
+
+		/**
+		 *	@class	bit_reader
+		 * 	@brief 	Class bit_reader reads values written by a bit_writer.
+		 */
+		class bit_reader {
+		public:
+			/**
+			 * @brief 	Constructor for the bit_reader class.
+			 * @param 	source 	first byte of the stream.
+			 * @param 	end 	end of the buffer holding the stream.
+			 */
+			bit_reader(const char* source, const char* end) : position(source), end(end) {}
+
+			/**
+			 * @brief 	Method read reads a value.
+			 * @param 	count 		number of bits, 0 to 32.
+			 * @return 	uint64_t 	value read.
+			 * @throws	decode_error if the stream runs past the end of the buffer.
+			 */
+			uint64_t read(unsigned count) {
+				while (available < count) {
+					if (position == end) {
+						throw errors::decode_error("Bit stream runs past the end of the buffer.");
+					}
+					accumulator |= (uint64_t)(uint8_t)*position++ << available;
+					available += 8;
+				}
+				const uint64_t value = count == 0 ? 0 : accumulator & (~0ULL >> (64 - count));
+				accumulator = count == 64 ? 0 : accumulator >> count;
+				available -= count;
+				return value;
+			}
+
+			/**
+			 * @brief 	Method read_wide reads a value of up to 64 bits.
+			 * @param 	count 		number of bits, 0 to 64.
+			 * @return 	uint64_t 	value read.
+			 * @throws	decode_error if the stream runs past the end of the buffer.
+			 */
+			uint64_t read_wide(unsigned count) {
+				if (count > 32) {
+					const uint64_t low = read(32);
+					return low | (read(count - 32) << 32);
+				}
+				return read(count);
+			}
+
+			/**
+			 * @brief 	Method finish returns the position after the last byte the stream used.
+			 * @return 	const char* 	position after the stream.
+			 */
+			const char* finish() const {
+				return position;
+			}
+
+		protected:
+			/// Position of the next byte to load.
+			const char* position;
+			/// End of the buffer.
+			const char* end;
+			/// Bits loaded but not yet read.
+			uint64_t accumulator = 0;
+			/// Number of bits in the accumulator.
+			unsigned available = 0;
+		};
+
+		/**************************************************************************************************/
+		/* Bit Packing Kernels			 																  */
+		/**************************************************************************************************/
+		/**
+		 *	@struct	row
+		 * 	@brief 	Struct row holds one 32 byte row of 8 lanes of 32 bit values, in an AVX2 register, two SSE2 or NEON
+		 * 			registers, or an array when the compiler targets none of them.
+		 * @details	Loads and stores treat the lanes as little endian words, minimum and maximum compare them as signed.
+		 */
+#if defined(__AVX2__)
+		struct row {
+			__m256i lanes;
+			static row load(const void* source) { return {_mm256_loadu_si256((const __m256i*)source)}; }
+			static row broadcast(uint32_t value) { return {_mm256_set1_epi32((int)value)}; }
+			static row zero() { return {_mm256_setzero_si256()}; }
+			void store(void* destination) const { _mm256_storeu_si256((__m256i*)destination, lanes); }
+			row operator+(const row& other) const { return {_mm256_add_epi32(lanes, other.lanes)}; }
+			row operator-(const row& other) const { return {_mm256_sub_epi32(lanes, other.lanes)}; }
+			row operator&(const row& other) const { return {_mm256_and_si256(lanes, other.lanes)}; }
+			row operator|(const row& other) const { return {_mm256_or_si256(lanes, other.lanes)}; }
+			row operator<<(unsigned shift) const { return {_mm256_sll_epi32(lanes, _mm_cvtsi32_si128((int)shift))}; }
+			row operator>>(unsigned shift) const { return {_mm256_srl_epi32(lanes, _mm_cvtsi32_si128((int)shift))}; }
+			row operator^(const row& other) const { return {_mm256_xor_si256(lanes, other.lanes)}; }
+			row minimum(const row& other) const { return {_mm256_min_epi32(lanes, other.lanes)}; }
+			row maximum(const row& other) const { return {_mm256_max_epi32(lanes, other.lanes)}; }
+		};
+#elif defined(__SSE2__)
+		struct row {
+			__m128i low;
+			__m128i high;
+			static row load(const void* source) { return {_mm_loadu_si128((const __m128i*)source), _mm_loadu_si128((const __m128i*)source + 1)}; }
+			static row broadcast(uint32_t value) { return {_mm_set1_epi32((int)value), _mm_set1_epi32((int)value)}; }
+			static row zero() { return {_mm_setzero_si128(), _mm_setzero_si128()}; }
+			void store(void* destination) const { _mm_storeu_si128((__m128i*)destination, low); _mm_storeu_si128((__m128i*)destination + 1, high); }
+			row operator+(const row& other) const { return {_mm_add_epi32(low, other.low), _mm_add_epi32(high, other.high)}; }
+			row operator-(const row& other) const { return {_mm_sub_epi32(low, other.low), _mm_sub_epi32(high, other.high)}; }
+			row operator&(const row& other) const { return {_mm_and_si128(low, other.low), _mm_and_si128(high, other.high)}; }
+			row operator|(const row& other) const { return {_mm_or_si128(low, other.low), _mm_or_si128(high, other.high)}; }
+			row operator<<(unsigned shift) const { const __m128i count = _mm_cvtsi32_si128((int)shift); return {_mm_sll_epi32(low, count), _mm_sll_epi32(high, count)}; }
+			row operator>>(unsigned shift) const { const __m128i count = _mm_cvtsi32_si128((int)shift); return {_mm_srl_epi32(low, count), _mm_srl_epi32(high, count)}; }
+			row operator^(const row& other) const { return {_mm_xor_si128(low, other.low), _mm_xor_si128(high, other.high)}; }
+			static __m128i select(__m128i mask, __m128i chosen, __m128i other) { return _mm_or_si128(_mm_and_si128(mask, chosen), _mm_andnot_si128(mask, other)); }
+			row minimum(const row& other) const { return {select(_mm_cmpgt_epi32(low, other.low), other.low, low), select(_mm_cmpgt_epi32(high, other.high), other.high, high)}; }
+			row maximum(const row& other) const { return {select(_mm_cmpgt_epi32(low, other.low), low, other.low), select(_mm_cmpgt_epi32(high, other.high), high, other.high)}; }
+		};
+#elif defined(__ARM_NEON) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+		struct row {
+			uint32x4_t low;
+			uint32x4_t high;
+			static row load(const void* source) { return {vld1q_u32((const uint32_t*)source), vld1q_u32((const uint32_t*)source + 4)}; }
+			static row broadcast(uint32_t value) { return {vdupq_n_u32(value), vdupq_n_u32(value)}; }
+			static row zero() { return broadcast(0); }
+			void store(void* destination) const { vst1q_u32((uint32_t*)destination, low); vst1q_u32((uint32_t*)destination + 4, high); }
+			row operator+(const row& other) const { return {vaddq_u32(low, other.low), vaddq_u32(high, other.high)}; }
+			row operator-(const row& other) const { return {vsubq_u32(low, other.low), vsubq_u32(high, other.high)}; }
+			row operator&(const row& other) const { return {vandq_u32(low, other.low), vandq_u32(high, other.high)}; }
+			row operator|(const row& other) const { return {vorrq_u32(low, other.low), vorrq_u32(high, other.high)}; }
+			row operator<<(unsigned shift) const { return shift >= 32 ? zero() : row{vshlq_u32(low, vdupq_n_s32((int)shift)), vshlq_u32(high, vdupq_n_s32((int)shift))}; }
+			row operator>>(unsigned shift) const { return shift >= 32 ? zero() : row{vshlq_u32(low, vdupq_n_s32(-(int)shift)), vshlq_u32(high, vdupq_n_s32(-(int)shift))}; }
+			row operator^(const row& other) const { return {veorq_u32(low, other.low), veorq_u32(high, other.high)}; }
+			row minimum(const row& other) const {
+				return {vreinterpretq_u32_s32(vminq_s32(vreinterpretq_s32_u32(low), vreinterpretq_s32_u32(other.low))),
+					vreinterpretq_u32_s32(vminq_s32(vreinterpretq_s32_u32(high), vreinterpretq_s32_u32(other.high)))};
+			}
+			row maximum(const row& other) const {
+				return {vreinterpretq_u32_s32(vmaxq_s32(vreinterpretq_s32_u32(low), vreinterpretq_s32_u32(other.low))),
+					vreinterpretq_u32_s32(vmaxq_s32(vreinterpretq_s32_u32(high), vreinterpretq_s32_u32(other.high)))};
+			}
+		};
+#else
+		struct row {
+			uint32_t lanes[8];
+			static row load(const void* source) {
+				row loaded;
+				::memcpy(loaded.lanes, source, sizeof(loaded.lanes));
+				if constexpr (!byte_order::HOST_IS_LITTLE_ENDIAN) {
+					for (uint32_t& lane : loaded.lanes) {
+						lane = byte_order::swap_bytes(lane);
+					}
+				}
+				return loaded;
+			}
+			static row broadcast(uint32_t value) { row result; for (uint32_t& lane : result.lanes) { lane = value; } return result; }
+			static row zero() { return broadcast(0); }
+			void store(void* destination) const {
+				row stored = *this;
+				if constexpr (!byte_order::HOST_IS_LITTLE_ENDIAN) {
+					for (uint32_t& lane : stored.lanes) {
+						lane = byte_order::swap_bytes(lane);
+					}
+				}
+				::memcpy(destination, stored.lanes, sizeof(stored.lanes));
+			}
+			template <typename operation_t>
+			row combine(const row& other, operation_t operation) const { row result; for (int i = 0; i < 8; i++) { result.lanes[i] = operation(lanes[i], other.lanes[i]); } return result; }
+			row operator+(const row& other) const { return combine(other, [](uint32_t a, uint32_t b) { return a + b; }); }
+			row operator-(const row& other) const { return combine(other, [](uint32_t a, uint32_t b) { return a - b; }); }
+			row operator&(const row& other) const { return combine(other, [](uint32_t a, uint32_t b) { return a & b; }); }
+			row operator|(const row& other) const { return combine(other, [](uint32_t a, uint32_t b) { return a | b; }); }
+			row operator<<(unsigned shift) const { row result; for (int i = 0; i < 8; i++) { result.lanes[i] = shift >= 32 ? 0 : lanes[i] << shift; } return result; }
+			row operator>>(unsigned shift) const { row result; for (int i = 0; i < 8; i++) { result.lanes[i] = shift >= 32 ? 0 : lanes[i] >> shift; } return result; }
+			row operator^(const row& other) const { return combine(other, [](uint32_t a, uint32_t b) { return a ^ b; }); }
+			row minimum(const row& other) const { return combine(other, [](uint32_t a, uint32_t b) { return (int32_t)a < (int32_t)b ? a : b; }); }
+			row maximum(const row& other) const { return combine(other, [](uint32_t a, uint32_t b) { return (int32_t)a > (int32_t)b ? a : b; }); }
+		};
+#endif
+
+		/**
+		 * @brief 	Function pack_row shifts row j of a block into the current row of words, storing the words once full.
+		 * @details	Value j * 8 + lane goes to the lane's stream of words, so each row of 8 values is shifted into the
+		 * 			current row of words with a single shift whose count is known at compile time.
+		 * @tparam 	width 		number of bits of each offset.
+		 * @tparam 	j 			index of the row.
+		 * @param 	values 		values of the block.
+		 * @param 	base 		minimum broadcast to every lane.
+		 * @param 	word[in,out]	row of words being filled.
+		 * @param 	destination buffer of the block's packed words.
+		 */
+		template <unsigned width, size_t j>
+		inline void pack_row(const uint32_t* values, const row& base, row& word, char* destination) {
+			constexpr unsigned shift = (unsigned)((j * width) % 32);
+			constexpr size_t word_index = (j * width) / 32;
+			const row value = row::load(values + j * 8) - base;
+			if constexpr (shift == 0) {
+				word = value;
+			}
+			else {
+				word = word | (value << shift);
+			}
+			if constexpr (shift + width >= 32) {
+				word.store(destination + word_index * 32);
+				if constexpr (shift + width > 32) {
+					word = value >> (32 - shift);
+				}
+			}
+		}
+
+		/**
+		 * @brief 	Function unpack_row extracts row j of a block from the packed words.
+		 * @tparam 	width 		number of bits of each offset.
+		 * @tparam 	j 			index of the row.
+		 * @param 	source 		packed words of the block.
+		 * @param 	base 		minimum broadcast to every lane.
+		 * @param 	mask 		low width bits set in every lane.
+		 * @param 	values 		buffer for the values of the block.
+		 */
+		template <unsigned width, size_t j>
+		inline void unpack_row(const char* source, const row& base, const row& mask, uint32_t* values) {
+			constexpr unsigned shift = (unsigned)((j * width) % 32);
+			constexpr size_t word_index = (j * width) / 32;
+			row value = row::load(source + word_index * 32) >> shift;
+			if constexpr (shift + width > 32) {
+				// The value continues in the next row of words.
+				value = value | (row::load(source + (word_index + 1) * 32) << (32 - shift));
+			}
+			// Only a value ending exactly at the top of its word has no higher bits to clear.
+			if constexpr (shift + width != 32) {
+				value = value & mask;
+			}
+			(value + base).store(values + j * 8);
+		}
+
+		/**
+		 * @brief 	Function pack_rows packs every row of a block, unrolled so each shift is a constant.
+		 * @tparam 	width 		number of bits of each offset.
+		 * @param 	values 		ARRAY_CODEC_BLOCK_SIZE values, none smaller than the minimum.
+		 * @param 	minimum 	value subtracted from every value.
+		 * @param 	destination buffer of width * 32 bytes.
+		 */
+		template <unsigned width, size_t... rows>
+		inline void pack_rows(const uint32_t* values, uint32_t minimum, char* destination, std::index_sequence<rows...>) {
+			const row base = row::broadcast(minimum);
+			row word = row::zero();
+			(pack_row<width, rows>(values, base, word, destination), ...);
+		}
+
+		/**
+		 * @brief 	Function unpack_rows unpacks every row of a block, unrolled so each shift is a constant.
+		 * @tparam 	width 		number of bits of each offset.
+		 * @param 	source 		width * 32 bytes of packed offsets.
+		 * @param 	minimum 	value added to every offset.
+		 * @param 	values 		buffer for ARRAY_CODEC_BLOCK_SIZE values.
+		 */
+		template <unsigned width, size_t... rows>
+		inline void unpack_rows(const char* source, uint32_t minimum, uint32_t* values, std::index_sequence<rows...>) {
+			const row base = row::broadcast(minimum);
+			const row mask = row::broadcast(width == 32 ? 0xffffffff : (uint32_t)((1ULL << width) - 1));
+			(unpack_row<width, rows>(source, base, mask, values), ...);
+		}
+
+		/// Function pointer type of the block kernels specialised for one width.
+		using pack_kernel = void (*)(const uint32_t*, uint32_t, char*);
+		/// Function pointer type of the unpacking block kernels specialised for one width.
+		using unpack_kernel = void (*)(const char*, uint32_t, uint32_t*);
+
+		/**
+		 * @brief 	Function pack_kernels builds the table of packing kernels indexed by width, entry 0 is unused.
+		 * @return 	std::array<pack_kernel, 33> 	kernel for each width.
+		 */
+		template <size_t... widths>
+		constexpr std::array<pack_kernel, sizeof...(widths)> pack_kernels(std::index_sequence<widths...>) {
+			return {{[](const uint32_t* values, uint32_t minimum, char* destination) {
+				pack_rows<(unsigned)widths>(values, minimum, destination, std::make_index_sequence<ARRAY_CODEC_BLOCK_SIZE / 8>());
+			}...}};
+		}
+
+		/**
+		 * @brief 	Function unpack_kernels builds the table of unpacking kernels indexed by width, entry 0 is unused.
+		 * @return 	std::array<unpack_kernel, 33> 	kernel for each width.
+		 */
+		template <size_t... widths>
+		constexpr std::array<unpack_kernel, sizeof...(widths)> unpack_kernels(std::index_sequence<widths...>) {
+			return {{[](const char* source, uint32_t minimum, uint32_t* values) {
+				unpack_rows<(unsigned)widths>(source, minimum, values, std::make_index_sequence<ARRAY_CODEC_BLOCK_SIZE / 8>());
+			}...}};
+		}
+
+		/**
+		 * @brief 	Function pack_block packs 256 values as offsets from a minimum, 8 lanes at a time.
+		 * @param 	values 		ARRAY_CODEC_BLOCK_SIZE values, none smaller than the minimum.
+		 * @param 	minimum 	value subtracted from every value.
+		 * @param 	width 		number of bits of each offset, 1 to 32.
+		 * @param 	destination buffer of width * 32 bytes, the block takes exactly width rows of 32 bytes.
+		 */
+		inline void pack_block(const uint32_t* values, uint32_t minimum, unsigned width, char* destination) {
+			static constexpr std::array<pack_kernel, 33> kernels = pack_kernels(std::make_index_sequence<33>());
+			kernels[width](values, minimum, destination);
+		}
+
+		/**
+		 * @brief 	Function unpack_block unpacks 256 values packed by pack_block.
+		 * @param 	source 		width * 32 bytes of packed offsets.
+		 * @param 	minimum 	value added to every offset.
+		 * @param 	width 		number of bits of each offset, 1 to 32.
+		 * @param 	values 		buffer for ARRAY_CODEC_BLOCK_SIZE values.
+		 */
+		inline void unpack_block(const char* source, uint32_t minimum, unsigned width, uint32_t* values) {
+			static constexpr std::array<unpack_kernel, 33> kernels = unpack_kernels(std::make_index_sequence<33>());
+			kernels[width](source, minimum, values);
+		}
+
+		/**************************************************************************************************/
+		/* Frame Of Reference			 																  */
+		/**************************************************************************************************/
+		/**
+		 * @brief 	Function bit_width returns the number of bits needed to hold a value.
+		 * @param 	value 		value to measure.
+		 * @return 	unsigned 	0 for 0, otherwise the position of the highest set bit plus one.
+		 */
+		inline unsigned bit_width(uint32_t value) {
+			return value == 0 ? 0 : 32 - (unsigned)__builtin_clz(value);
+		}
+
+		/**
+		 * @brief 	Function value_range finds the smallest and largest of an array of 32 bit values, a row at a time.
+		 * @param 	values 		values to search.
+		 * @param 	count 		number of values, at least 1.
+		 * @param 	bias 		0x80000000 for unsigned values and 0 for signed ones, XORed into each value so that both
+		 * 						order correctly under a signed comparison.
+		 * @param 	minimum[out]	smallest value.
+		 * @param 	maximum[out]	largest value.
+		 */
+		inline void value_range(const uint32_t* values, size_t count, uint32_t bias, uint32_t& minimum, uint32_t& maximum) {
+			const row flip = row::broadcast(bias);
+			// Two independent accumulators per bound halve the dependency chain of the comparisons.
+			row first_minimum = row::broadcast(values[0]) ^ flip;
+			row first_maximum = first_minimum;
+			row second_minimum = first_minimum;
+			row second_maximum = first_minimum;
+			const size_t whole_rows = count / 8;
+			size_t index = 0;
+			for (; index + 2 <= whole_rows; index += 2) {
+				const row first = row::load(values + index * 8) ^ flip;
+				const row second = row::load(values + index * 8 + 8) ^ flip;
+				first_minimum = first_minimum.minimum(first);
+				first_maximum = first_maximum.maximum(first);
+				second_minimum = second_minimum.minimum(second);
+				second_maximum = second_maximum.maximum(second);
+			}
+			if (index < whole_rows) {
+				const row first = row::load(values + index * 8) ^ flip;
+				first_minimum = first_minimum.minimum(first);
+				first_maximum = first_maximum.maximum(first);
+			}
+			uint32_t lanes_minimum[8];
+			uint32_t lanes_maximum[8];
+			first_minimum.minimum(second_minimum).store(lanes_minimum);
+			first_maximum.maximum(second_maximum).store(lanes_maximum);
+			int32_t smallest = (int32_t)lanes_minimum[0];
+			int32_t largest = (int32_t)lanes_maximum[0];
+			for (int lane = 1; lane < 8; lane++) {
+				smallest = std::min(smallest, (int32_t)lanes_minimum[lane]);
+				largest = std::max(largest, (int32_t)lanes_maximum[lane]);
+			}
+			for (size_t index = whole_rows * 8; index < count; index++) {
+				smallest = std::min(smallest, (int32_t)(values[index] ^ bias));
+				largest = std::max(largest, (int32_t)(values[index] ^ bias));
+			}
+			minimum = (uint32_t)smallest ^ bias;
+			maximum = (uint32_t)largest ^ bias;
+		}
+
+
+		/**
+		 * @brief 	Function frame_of_reference_size returns the largest number of bytes a packed array can take.
+		 * @param 	count 	number of values.
+		 * @return 	size_t 	bytes of the minimum, the width and the packed values at 32 bits each.
+		 */
+		constexpr size_t frame_of_reference_size(size_t count) {
+			return 5 + count * 4;
+		}
+
+		/**
+		 * @brief 	Function encode_frame_of_reference writes the minimum, the bit width and the packed offsets of values.
+		 * @param 	values 		32 bit values, reinterpreted as unsigned.
+		 * @param 	count 		number of values.
+		 * @param 	is_signed 	true if the values are int32_t, which changes which value is the minimum.
+		 * @param 	destination buffer of at least frame_of_reference_size(count) bytes.
+		 * @return 	char* 		position after the packed values.
+		 */
+		inline char* encode_frame_of_reference(const uint32_t* values, size_t count, bool is_signed, char* destination) {
+			uint32_t minimum = 0;
+			uint32_t maximum = 0;
+			if (count > 0) {
+				value_range(values, count, is_signed ? 0 : 0x80000000u, minimum, maximum);
+			}
+			const unsigned width = bit_width(maximum - minimum);
+			byte_order::write_network(minimum, destination);
+			destination[4] = (char)width;
+			destination += 5;
+			if (width == 0) {
+				return destination;
+			}
+			const size_t blocks = count / ARRAY_CODEC_BLOCK_SIZE;
+			for (size_t block = 0; block < blocks; block++) {
+				pack_block(values + block * ARRAY_CODEC_BLOCK_SIZE, minimum, width, destination);
+				destination += width * 32;
+			}
+			bit_writer writer(destination);
+			for (size_t index = blocks * ARRAY_CODEC_BLOCK_SIZE; index < count; index++) {
+				writer.write(values[index] - minimum, width);
+			}
+			return writer.finish();
+		}
+
+		/**
+		 * @brief 	Function decode_frame_of_reference reads values written by encode_frame_of_reference.
+		 * @param 	source 		position of the minimum.
+		 * @param 	end 		end of the buffer.
+		 * @param 	count 		number of values.
+		 * @param 	values 		buffer for the values.
+		 * @return 	const char* position after the packed values.
+		 * @throws	decode_error if the width is invalid or the values run past the end of the buffer.
+		 */
+		inline const char* decode_frame_of_reference(const char* source, const char* end, size_t count, uint32_t* values) {
+			if (end - source < 5) {
+				throw errors::decode_error("Frame of reference header runs past the end of the buffer.");
+			}
+			const uint32_t minimum = byte_order::read_network<uint32_t>(source);
+			const unsigned width = (uint8_t)source[4];
+			source += 5;
+			if (width > 32) {
+				throw errors::decode_error("Frame of reference width is larger than 32 bits.");
+			}
+			if (width == 0) {
+				std::fill(values, values + count, minimum);
+				return source;
+			}
+			const size_t blocks = count / ARRAY_CODEC_BLOCK_SIZE;
+			if ((size_t)(end - source) < blocks * width * 32) {
+				throw errors::decode_error("Packed values run past the end of the buffer.");
+			}
+			size_t index = 0;
+			for (; index < blocks * ARRAY_CODEC_BLOCK_SIZE; index += ARRAY_CODEC_BLOCK_SIZE) {
+				unpack_block(source, minimum, width, values + index);
+				source += width * 32;
+			}
+			bit_reader reader(source, end);
+			for (; index < count; index++) {
+				values[index] = (uint32_t)reader.read(width) + minimum;
+			}
+			return reader.finish();
+		}
+
+		/**************************************************************************************************/
+		/* XOR Compression				 																  */
+		/**************************************************************************************************/
+		/**
+		 * @brief 	Function xor_size returns the largest number of bytes an XOR compressed array can take.
+		 * @tparam 	T 		float or double.
+		 * @param 	count 	number of values.
+		 * @return 	size_t 	bytes of the first value and the worst case control bits of the others.
+		 */
+		template <typename T>
+		constexpr size_t xor_size(size_t count) {
+			constexpr size_t bits = sizeof(T) * 8;
+			constexpr size_t field_bits = sizeof(T) == 4 ? 5 : 6;
+			return (count * (bits + 2 + 2 * field_bits) + 7) / 8;
+		}
+
+		/**
+		 * @brief 	Function encode_xor writes the Gorilla encoding of floating point values.
+		 * @details	Each value after the first is XORed with the previous one. An XOR of zero is a single 0 bit, an XOR
+		 * 			whose meaningful bits fit in the previous window is 10 followed by those bits, and any other XOR is
+		 * 			11 followed by its count of leading zeros, its count of meaningful bits and the bits themselves.
+		 * 			Each value depends on the previous one, so unlike bit packing this does not vectorize.
+		 * @tparam 	T 		float or double.
+		 * @param 	values 		values to encode.
+		 * @param 	count 		number of values.
+		 * @param 	destination buffer of at least xor_size<T>(count) bytes.
+		 * @return 	char* 		position after the encoded values.
+		 */
+		template <typename T>
+		inline char* encode_xor(const T* values, size_t count, char* destination) {
+			using bits_type = typename byte_order::unsigned_of_size<sizeof(T)>::type;
+			constexpr unsigned bits = sizeof(T) * 8;
+			constexpr unsigned field_bits = sizeof(T) == 4 ? 5 : 6;
+			bit_writer writer(destination);
+			bits_type previous = 0;
+			unsigned window_leading = bits;
+			unsigned window_trailing = 0;
+			for (size_t i = 0; i < count; i++) {
+				bits_type current;
+				::memcpy(&current, values + i, sizeof(current));
+				if (i == 0) {
+					writer.write_wide(current, bits);
+					previous = current;
+					continue;
+				}
+				const bits_type difference = current ^ previous;
+				previous = current;
+				if (difference == 0) {
+					writer.write(0, 1);
+					continue;
+				}
+				const unsigned leading = (unsigned)(sizeof(T) == 4 ? __builtin_clz((uint32_t)difference) : __builtin_clzll((uint64_t)difference));
+				const unsigned trailing = (unsigned)(sizeof(T) == 4 ? __builtin_ctz((uint32_t)difference) : __builtin_ctzll((uint64_t)difference));
+				if (leading >= window_leading && trailing >= window_trailing) {
+					writer.write(1, 2);
+					writer.write_wide((uint64_t)(difference >> window_trailing), bits - window_leading - window_trailing);
+				}
+				else {
+					const unsigned meaningful = bits - leading - trailing;
+					writer.write(3, 2);
+					writer.write(leading, field_bits);
+					writer.write(meaningful - 1, field_bits);
+					writer.write_wide((uint64_t)(difference >> trailing), meaningful);
+					window_leading = leading;
+					window_trailing = trailing;
+				}
+			}
+			return writer.finish();
+		}
+
+		/**
+		 * @brief 	Function decode_xor reads values written by encode_xor.
+		 * @tparam 	T 		float or double.
+		 * @param 	source 		position of the bit stream.
+		 * @param 	end 		end of the buffer.
+		 * @param 	count 		number of values.
+		 * @param 	values 		buffer for the values.
+		 * @return 	const char* position after the bit stream.
+		 * @throws	decode_error if the stream is invalid or runs past the end of the buffer.
+		 */
+		template <typename T>
+		inline const char* decode_xor(const char* source, const char* end, size_t count, T* values) {
+			using bits_type = typename byte_order::unsigned_of_size<sizeof(T)>::type;
+			constexpr unsigned bits = sizeof(T) * 8;
+			constexpr unsigned field_bits = sizeof(T) == 4 ? 5 : 6;
+			bit_reader reader(source, end);
+			bits_type previous = 0;
+			unsigned window_leading = bits;
+			unsigned window_trailing = 0;
+			for (size_t i = 0; i < count; i++) {
+				if (i == 0) {
+					previous = (bits_type)reader.read_wide(bits);
+				}
+				else if (reader.read(1) == 1) {
+					if (reader.read(1) == 1) {
+						window_leading = (unsigned)reader.read(field_bits);
+						const unsigned meaningful = (unsigned)reader.read(field_bits) + 1;
+						if (window_leading + meaningful > bits) {
+							throw errors::decode_error("XOR window is wider than the value.");
+						}
+						window_trailing = bits - window_leading - meaningful;
+					}
+					else if (window_leading == bits) {
+						throw errors::decode_error("XOR value reuses a window before one was set.");
+					}
+					previous ^= (bits_type)(reader.read_wide(bits - window_leading - window_trailing) << window_trailing);
+				}
+				::memcpy(values + i, &previous, sizeof(previous));
+			}
+			return reader.finish();
+		}
+
+		/**************************************************************************************************/
+		/* Array Functions				 																  */
+		/**************************************************************************************************/
+		/**
+		 * @brief 	Function encode encodes an array with the method chosen for its element type.
+		 * @details	Arrays that the chosen method would not shrink are written raw, so the result is never more than the
+		 * 			header larger than the values.
+		 * @tparam 	T 			int32_t, uint32_t, float or double.
+		 * @param 	values 		values to encode.
+		 * @param 	count 		number of values.
+		 * @param 	encoding 	methods to use.
+		 * @param 	destination vector resized to hold the encoded array.
+		 * @return 	size_t 		size of the encoded array in bytes.
+		 * @throws	encode_error if there are more than ARRAY_CODEC_MAX_COUNT values or a value cannot be quantized with the
+		 * 			configured step.
+		 */
+		template <typename T>
+		size_t encode(const T* values, size_t count, const array_encoding& encoding, std::vector<char>& destination) {
+			static_assert(is_supported<T>::value, "Only int32_t, uint32_t, float and double arrays can be encoded.");
+			if (count > ARRAY_CODEC_MAX_COUNT) {
+				throw errors::encode_error("Arrays of more than " + std::to_string(ARRAY_CODEC_MAX_COUNT) + " values cannot be decoded.");
+			}
+			const size_t header_size = 3 + schema::varint_size(count);
+			const size_t raw_size = count * sizeof(T);
+			method chosen = std::is_integral<T>::value ? encoding.integer_method : encoding.floating_method;
+			size_t capacity = raw_size;
+			if (chosen == FRAME_OF_REFERENCE && std::is_integral<T>::value) {
+				capacity = frame_of_reference_size(count);
+			}
+			else if (chosen == QUANTIZED && std::is_floating_point<T>::value) {
+				if (!(encoding.quantization_step > 0) || !std::isfinite(encoding.quantization_step)) {
+					throw errors::encode_error("Quantization step must be a positive finite number.");
+				}
+				capacity = 8 + frame_of_reference_size(count);
+			}
+			else if (chosen == XOR && std::is_floating_point<T>::value) {
+				capacity = xor_size<T>(count);
+			}
+			else {
+				chosen = RAW;
+			}
+			destination.resize(header_size + std::max(capacity, raw_size));
+			char* position = destination.data();
+			position[0] = (char)ARRAY_CODEC_MAGIC;
+			position[2] = (char)element_type<T>::code;
+			position = schema::write_varint(count, position + 3);
+			char* const payload = position;
+
+			if constexpr (std::is_integral<T>::value) {
+				if (chosen == FRAME_OF_REFERENCE) {
+					position = encode_frame_of_reference(reinterpret_cast<const uint32_t*>(values), count, std::is_signed<T>::value, position);
+				}
+			}
+			else {
+				if (chosen == QUANTIZED) {
+					std::vector<uint32_t> quantized(count);
+					for (size_t i = 0; i < count; i++) {
+						const double scaled = std::nearbyint((double)values[i] / encoding.quantization_step);
+						if (!(scaled >= -2147483648.0 && scaled <= 2147483647.0)) {
+							throw errors::encode_error("Value " + std::to_string((double)values[i]) + " cannot be quantized with step " +
+								std::to_string(encoding.quantization_step) + ".");
+						}
+						quantized[i] = (uint32_t)(int32_t)scaled;
+					}
+					byte_order::write_network(encoding.quantization_step, position);
+					position = encode_frame_of_reference(quantized.data(), count, true, position + 8);
+				}
+				else if (chosen == XOR) {
+					position = encode_xor(values, count, position);
+				}
+			}
+			// Fall back to the raw values when the method did not shrink the array.
+			if (chosen == RAW || (size_t)(position - payload) >= raw_size) {
+				chosen = RAW;
+				byte_order::write_network_array(values, count, payload);
+				position = payload + raw_size;
+			}
+			destination[1] = (char)chosen;
+			destination.resize((size_t)(position - destination.data()));
+			return destination.size();
+		}
+
+		/**
+		 * @brief 	Function encode encodes a vector with the method chosen for its element type.
+		 * @tparam 	T 			int32_t, uint32_t, float or double.
+		 * @param 	values 		values to encode.
+		 * @param 	encoding 	methods to use.
+		 * @param 	destination vector resized to hold the encoded array.
+		 * @return 	size_t 		size of the encoded array in bytes.
+		 * @throws	encode_error if there are more than ARRAY_CODEC_MAX_COUNT values or a value cannot be quantized with the
+		 * 			configured step.
+		 */
+		template <typename T>
+		size_t encode(const std::vector<T>& values, const array_encoding& encoding, std::vector<char>& destination) {
+			return encode(values.data(), values.size(), encoding, destination);
+		}
+
+		/**
+		 * @brief 	Function decode decodes an array written by encode, whatever method it was written with.
+		 * @tparam 	T 		element type the array was encoded with.
+		 * @param 	source 	bytes of the encoded array.
+		 * @param 	size 	size of the encoded array in bytes.
+		 * @param 	values 	vector resized to hold the values.
+		 * @param 	max_count 	largest number of values accepted, lower it to what the caller expects so a corrupt count
+		 * 						is rejected before the vector is resized (default ARRAY_CODEC_MAX_COUNT).
+		 * @return 	size_t 	number of bytes read.
+		 * @throws	decode_error if the bytes are not an array of T, are truncated or hold more than max_count values.
+		 */
+		template <typename T>
+		size_t decode(const char* source, size_t size, std::vector<T>& values, size_t max_count = ARRAY_CODEC_MAX_COUNT) {
+			static_assert(is_supported<T>::value, "Only int32_t, uint32_t, float and double arrays can be decoded.");
+			const char* end = source + size;
+			if (size < 4 || (uint8_t)source[0] != ARRAY_CODEC_MAGIC) {
+				throw errors::decode_error("Buffer is not an encoded array.");
+			}
+			if ((uint8_t)source[2] != element_type<T>::code) {
+				throw errors::decode_error("Encoded array holds a different element type.");
+			}
+			const uint8_t chosen = (uint8_t)source[1];
+			const char* position = source + 3;
+			const uint64_t count = schema::read_varint(position, end);
+			if (count > std::min<uint64_t>(max_count, ARRAY_CODEC_MAX_COUNT)) {
+				throw errors::decode_error("Encoded array holds " + std::to_string(count) + " values, more than the limit of " +
+					std::to_string(std::min<uint64_t>(max_count, ARRAY_CODEC_MAX_COUNT)) + ".");
+			}
+			values.resize((size_t)count);
+
+			if (chosen == RAW) {
+				if ((size_t)(end - position) < count * sizeof(T)) {
+					throw errors::decode_error("Raw array runs past the end of the buffer.");
+				}
+				byte_order::read_network_array(position, (size_t)count, values.data());
+				position += count * sizeof(T);
+			}
+			else if constexpr (std::is_integral<T>::value) {
+				if (chosen != FRAME_OF_REFERENCE) {
+					throw errors::decode_error("Integer arrays cannot be encoded with method " + std::to_string(chosen) + ".");
+				}
+				position = decode_frame_of_reference(position, end, (size_t)count, reinterpret_cast<uint32_t*>(values.data()));
+			}
+			else {
+				if (chosen == QUANTIZED) {
+					if (end - position < 8) {
+						throw errors::decode_error("Quantization step runs past the end of the buffer.");
+					}
+					const double step = byte_order::read_network<double>(position);
+					std::vector<uint32_t> quantized((size_t)count);
+					position = decode_frame_of_reference(position + 8, end, (size_t)count, quantized.data());
+					for (size_t i = 0; i < count; i++) {
+						values[i] = (T)((double)(int32_t)quantized[i] * step);
+					}
+				}
+				else if (chosen == XOR) {
+					position = decode_xor(position, end, (size_t)count, values.data());
+				}
+				else {
+					throw errors::decode_error("Floating point arrays cannot be encoded with method " + std::to_string(chosen) + ".");
+				}
+			}
+			return (size_t)(position - source);
+		}
+
+		/**
+		 * @brief 	Function decode decodes an array written by encode.
+		 * @tparam 	T 		element type the array was encoded with.
+		 * @param 	source 	bytes of the encoded array.
+		 * @param 	size 	size of the encoded array in bytes.
+		 * @param 	max_count 	largest number of values accepted (default ARRAY_CODEC_MAX_COUNT).
+		 * @return 	std::vector<T> 	decoded values.
+		 * @throws	decode_error if the bytes are not an array of T, are truncated or hold more than max_count values.
+		 */
+		template <typename T>
+		std::vector<T> decode(const char* source, size_t size, size_t max_count = ARRAY_CODEC_MAX_COUNT) {
+			std::vector<T> values;
+			decode(source, size, values, max_count);
+			return values;
+		}
+	}
+}
+
+#endif /* ARRAY_CODEC_HPP */
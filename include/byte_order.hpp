@@ -0,0 +1,218 @@
+/**
+ * 	@file 	byte_order.hpp
+ * 	@brief 	Functions converting values and arrays between host and network byte order.
+ * 	@author James Horner
+ * 	@date 	2023-04-05
+ */
+
+#ifndef BYTE_ORDER_HPP
+#define BYTE_ORDER_HPP
+
+// Standard System Libraries
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Platform Specific System Libraries
+#if defined(__AVX2__) || defined(__SSSE3__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace oo_socket
+{
+	namespace byte_order
+	{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+		/// Flag for if the host stores the least significant byte first, the opposite of network byte order.
+		constexpr bool HOST_IS_LITTLE_ENDIAN = false;
+#else
+		/// Flag for if the host stores the least significant byte first, the opposite of network byte order.
+		constexpr bool HOST_IS_LITTLE_ENDIAN = true;
+#endif
+
+		/**
+		 * @brief 	Function swap_bytes reverses the bytes of a value, which compilers reduce to a single instruction.
+		 * @param 	value 		value to reverse.
+		 * @return 	uint16_t 	value with its bytes reversed.
+		 */
+		constexpr uint16_t swap_bytes(uint16_t value) {
+			return (uint16_t)((value << 8) | (value >> 8));
+		}
+
+		/**
+		 * @brief 	Function swap_bytes reverses the bytes of a value, which compilers reduce to a single instruction.
+		 * @param 	value 		value to reverse.
+		 * @return 	uint32_t 	value with its bytes reversed.
+		 */
+		constexpr uint32_t swap_bytes(uint32_t value) {
+			return ((value & 0xff) << 24) | ((value & 0xff00) << 8) | ((value >> 8) & 0xff00) | (value >> 24);
+		}
+
+		/**
+		 * @brief 	Function swap_bytes reverses the bytes of a value, which compilers reduce to a single instruction.
+		 * @param 	value 		value to reverse.
+		 * @return 	uint64_t 	value with its bytes reversed.
+		 */
+		constexpr uint64_t swap_bytes(uint64_t value) {
+			return ((uint64_t)swap_bytes((uint32_t)value) << 32) | swap_bytes((uint32_t)(value >> 32));
+		}
+
+		/**
+		 *	@struct	unsigned_of_size
+		 * 	@brief 	Struct unsigned_of_size names the unsigned integer with the same size as a value type.
+		 */
+		template <size_t size> struct unsigned_of_size;
+		template <> struct unsigned_of_size<1> { using type = uint8_t; };
+		template <> struct unsigned_of_size<2> { using type = uint16_t; };
+		template <> struct unsigned_of_size<4> { using type = uint32_t; };
+		template <> struct unsigned_of_size<8> { using type = uint64_t; };
+
+		/**
+		 * @brief 	Function write_network stores a value in network byte order.
+		 * @tparam 	T 				arithmetic or enumeration type of 1, 2, 4 or 8 bytes.
+		 * @param 	value 			value to store.
+		 * @param 	destination 	buffer of at least sizeof(T) bytes, which need not be aligned.
+		 */
+		template <typename T>
+		inline void write_network(T value, char* destination) {
+			static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "Only arithmetic and enumeration values have a byte order.");
+			using bits_type = typename unsigned_of_size<sizeof(T)>::type;
+			bits_type bits;
+			::memcpy(&bits, &value, sizeof(bits));
+			if constexpr (HOST_IS_LITTLE_ENDIAN && sizeof(T) > 1) {
+				bits = swap_bytes(bits);
+			}
+			::memcpy(destination, &bits, sizeof(bits));
+		}
+
+		/**
+		 * @brief 	Function read_network loads a value stored in network byte order.
+		 * @tparam 	T 		arithmetic or enumeration type of 1, 2, 4 or 8 bytes.
+		 * @param 	source 	buffer of at least sizeof(T) bytes, which need not be aligned.
+		 * @return 	T 		value in host byte order.
+		 */
+		template <typename T>
+		inline T read_network(const char* source) {
+			static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "Only arithmetic and enumeration values have a byte order.");
+			using bits_type = typename unsigned_of_size<sizeof(T)>::type;
+			bits_type bits;
+			::memcpy(&bits, source, sizeof(bits));
+			if constexpr (HOST_IS_LITTLE_ENDIAN && sizeof(T) > 1) {
+				bits = swap_bytes(bits);
+			}
+			if constexpr (std::is_same<T, bool>::value) {
+				return bits != 0;
+			}
+			else {
+				T value;
+				::memcpy(&value, &bits, sizeof(value));
+				return value;
+			}
+		}
+
+		/**
+		 * @brief 	Function swap_array reverses the bytes of every element of an array.
+		 * @details	Elements are swapped 32 bytes at a time with AVX2, or 16 at a time with SSSE3 or NEON, when the
+		 * 			compiler targets those instruction sets (e.g. -mavx2), and one at a time otherwise.
+		 * @param 	source 			elements to swap, which need not be aligned.
+		 * @param 	destination 	buffer for the swapped elements, which may be the source.
+		 * @param 	count 			number of elements.
+		 * @param 	element_size 	size of each element, 1, 2, 4 or 8 bytes.
+		 */
+		inline void swap_array(const char* source, char* destination, size_t count, size_t element_size) {
+			const size_t total = count * element_size;
+			if (element_size == 1) {
+				if (source != destination) {
+					::memmove(destination, source, total);
+				}
+				return;
+			}
+			size_t position = 0;
+#if defined(__AVX2__) || defined(__SSSE3__)
+			// Shuffle masks reversing the bytes within each 2, 4 and 8 byte lane.
+			const __m128i mask = element_size == 2 ? _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14) :
+				element_size == 4 ? _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12) :
+				_mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+#if defined(__AVX2__)
+			const __m256i wide_mask = _mm256_broadcastsi128_si256(mask);
+			for (; position + 32 <= total; position += 32) {
+				const __m256i block = _mm256_loadu_si256((const __m256i*)(source + position));
+				_mm256_storeu_si256((__m256i*)(destination + position), _mm256_shuffle_epi8(block, wide_mask));
+			}
+#endif
+			for (; position + 16 <= total; position += 16) {
+				const __m128i block = _mm_loadu_si128((const __m128i*)(source + position));
+				_mm_storeu_si128((__m128i*)(destination + position), _mm_shuffle_epi8(block, mask));
+			}
+#elif defined(__ARM_NEON)
+			for (; position + 16 <= total; position += 16) {
+				const uint8x16_t block = vld1q_u8((const uint8_t*)(source + position));
+				const uint8x16_t swapped = element_size == 2 ? vrev16q_u8(block) : element_size == 4 ? vrev32q_u8(block) : vrev64q_u8(block);
+				vst1q_u8((uint8_t*)(destination + position), swapped);
+			}
+#endif
+			// Swap the remaining elements one at a time.
+			for (; position < total; position += element_size) {
+				if (element_size == 2) {
+					uint16_t value;
+					::memcpy(&value, source + position, sizeof(value));
+					value = swap_bytes(value);
+					::memcpy(destination + position, &value, sizeof(value));
+				}
+				else if (element_size == 4) {
+					uint32_t value;
+					::memcpy(&value, source + position, sizeof(value));
+					value = swap_bytes(value);
+					::memcpy(destination + position, &value, sizeof(value));
+				}
+				else {
+					uint64_t value;
+					::memcpy(&value, source + position, sizeof(value));
+					value = swap_bytes(value);
+					::memcpy(destination + position, &value, sizeof(value));
+				}
+			}
+		}
+
+		/**
+		 * @brief 	Function write_network_array stores an array of values in network byte order.
+		 * @tparam 	T 				arithmetic type of 1, 2, 4 or 8 bytes.
+		 * @param 	values 			values to store.
+		 * @param 	count 			number of values.
+		 * @param 	destination 	buffer of at least count * sizeof(T) bytes, which need not be aligned.
+		 */
+		template <typename T>
+		inline void write_network_array(const T* values, size_t count, char* destination) {
+			static_assert(std::is_arithmetic<T>::value && !std::is_same<T, bool>::value, "Only arithmetic arrays have a byte order.");
+			if constexpr (HOST_IS_LITTLE_ENDIAN && sizeof(T) > 1) {
+				swap_array((const char*)values, destination, count, sizeof(T));
+			}
+			else if (count > 0) {
+				::memcpy(destination, values, count * sizeof(T));
+			}
+		}
+
+		/**
+		 * @brief 	Function read_network_array loads an array of values stored in network byte order.
+		 * @tparam 	T 		arithmetic type of 1, 2, 4 or 8 bytes.
+		 * @param 	source 	buffer of at least count * sizeof(T) bytes, which need not be aligned.
+		 * @param 	count 	number of values.
+		 * @param 	values 	array to store the values in host byte order.
+		 */
+		template <typename T>
+		inline void read_network_array(const char* source, size_t count, T* values) {
+			static_assert(std::is_arithmetic<T>::value && !std::is_same<T, bool>::value, "Only arithmetic arrays have a byte order.");
+			if constexpr (HOST_IS_LITTLE_ENDIAN && sizeof(T) > 1) {
+				swap_array(source, (char*)values, count, sizeof(T));
+			}
+			else if (count > 0) {
+				::memcpy(values, source, count * sizeof(T));
+			}
+		}
+	}
+}
+
+#endif /* BYTE_ORDER_HPP */
@@ -0,0 +1,643 @@
+/**
+ * 	@file 	clock_sync.hpp
+ * 	@brief 	Classes estimating the clock offset and drift between peers and measuring one-way latency.
+ * 	@author James Horner
+ * 	@date 	2023-04-05
+ */
+
+#ifndef CLOCK_SYNC_HPP
+#define CLOCK_SYNC_HPP
+
+// Standard System Libraries
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Local Libraries
+#include "byte_order.hpp"
+#include "datagram.hpp"
+#include "errors.hpp"
+#include "rate_limiter.hpp"
+#include "socket_address.hpp"
+#include "statistics.hpp"
+#include "udp_socket.hpp"
+
+/// Macro for the number of bytes in a synchronization request.
+#define CLOCK_SYNC_REQUEST_SIZE 9
+/// Macro for the number of bytes in a synchronization response.
+#define CLOCK_SYNC_RESPONSE_SIZE 25
+/// Macro for the number of bytes in a send time stamped into a message.
+#define CLOCK_SYNC_STAMP_SIZE 8
+/// Macro for the largest drift believed in parts per million, as in NTP, beyond which the estimate is clamped.
+#define CLOCK_SYNC_MAX_DRIFT_PPM 500
+/// Macro for the shortest time in nanoseconds the accepted samples must span before drift is estimated.
+#define CLOCK_SYNC_MIN_DRIFT_SPAN_NS 1000000000LL
+/// Macro for the least delay in nanoseconds a sample may exceed the minimum delay by and still be accepted.
+#define CLOCK_SYNC_DELAY_TOLERANCE_NS 20000LL
+/// Macro for the largest number of peers a synchronizer tracks.
+#define CLOCK_SYNC_MAX_PEERS 4096
+/// Macro for the number of unanswered requests remembered per peer, older ones are forgotten.
+#define CLOCK_SYNC_MAX_OUTSTANDING 8
+
+namespace oo_socket
+{
+	/**
+	 *	@namespace	clock_sync
+	 * 	@brief 		NTP style clock synchronization between peers for measuring one-way latency without PTP hardware.
+	 * 	@details	A request carries the time it was sent (t1) and its response carries t1 with the times the peer received
+	 * 				the request (t2) and sent the response (t3), so with the time the response arrived (t4) the offset of
+	 * 				the peer's clock is ((t2 - t1) + (t3 - t4)) / 2 and the round trip delay is (t4 - t1) - (t3 - t2).
+	 * 				Times are nanoseconds since the Unix epoch on the system clock, the clock the kernel stamps received
+	 * 				datagrams with, in network byte order. Every packet starts with a kind byte so it can share a socket
+	 * 				with application traffic that does not start with the same bytes.
+	 */
+	namespace clock_sync
+	{
+		/**
+		 *	@enum	packet_kind
+		 * 	@brief 	Enum packet_kind is the first byte of every synchronization packet.
+		 */
+		enum packet_kind : uint8_t
+		{
+			REQUEST = 0xC5,
+			RESPONSE,
+		};
+
+		/**************************************************************************************************/
+		/* Time Functions				 																  */
+		/**************************************************************************************************/
+		/**
+		 * @brief 	Function wall_clock_ns returns the current time of the system clock.
+		 * @return 	uint64_t 	nanoseconds since the Unix epoch.
+		 */
+		inline uint64_t wall_clock_ns() {
+			return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+		}
+
+		/**
+		 * @brief 	Function receive_time_ns returns when a datagram arrived.
+		 * @param 	datagram 	datagram returned by receive_batch.
+		 * @return 	uint64_t 	kernel receive timestamp if the socket has receive timestamps enabled, the current time otherwise.
+		 */
+		inline uint64_t receive_time_ns(const incoming_datagram& datagram) {
+			return datagram.receive_timestamp_ns != 0 ? datagram.receive_timestamp_ns : wall_clock_ns();
+		}
+
+		/**
+		 * @brief 	Function write_stamp stamps a message with the time it is sent.
+		 * @param 	destination 	buffer of at least CLOCK_SYNC_STAMP_SIZE bytes.
+		 * @param 	sent_ns 		send time in nanoseconds since the Unix epoch (default now).
+		 */
+		inline void write_stamp(char* destination, uint64_t sent_ns = wall_clock_ns()) {
+			byte_order::write_network(sent_ns, destination);
+		}
+
+		/**
+		 * @brief 	Function read_stamp reads the send time written by write_stamp.
+		 * @param 	source 		buffer of at least CLOCK_SYNC_STAMP_SIZE bytes.
+		 * @return 	uint64_t 	send time on the sender's clock.
+		 */
+		inline uint64_t read_stamp(const char* source) {
+			return byte_order::read_network<uint64_t>(source);
+		}
+
+		/**************************************************************************************************/
+		/* Packet Functions				 																  */
+		/**************************************************************************************************/
+		/**
+		 * @brief 	Function write_request writes a synchronization request.
+		 * @param 	sent_ns 		time the request is sent (t1).
+		 * @param 	destination 	buffer of at least CLOCK_SYNC_REQUEST_SIZE bytes.
+		 */
+		inline void write_request(uint64_t sent_ns, char* destination) {
+			destination[0] = (char)REQUEST;
+			byte_order::write_network(sent_ns, destination + 1);
+		}
+
+		/**
+		 * @brief 	Function read_request reads a request written by write_request.
+		 * @param 	source 		bytes of the packet.
+		 * @param 	size 		size of the packet in bytes.
+		 * @param 	sent_ns[out]	time the request was sent on the requester's clock (t1).
+		 * @return 	bool 		true if the packet is a request.
+		 */
+		inline bool read_request(const char* source, size_t size, uint64_t& sent_ns) {
+			if (size != CLOCK_SYNC_REQUEST_SIZE || (uint8_t)source[0] != REQUEST) {
+				return false;
+			}
+			sent_ns = byte_order::read_network<uint64_t>(source + 1);
+			return true;
+		}
+
+		/**
+		 * @brief 	Function write_response writes the response to a request.
+		 * @param 	request_sent_ns 	time the request was sent on the requester's clock (t1).
+		 * @param 	request_received_ns time the request was received (t2).
+		 * @param 	response_sent_ns 	time the response is sent (t3).
+		 * @param 	destination 		buffer of at least CLOCK_SYNC_RESPONSE_SIZE bytes.
+		 */
+		inline void write_response(uint64_t request_sent_ns, uint64_t request_received_ns, uint64_t response_sent_ns, char* destination) {
+			destination[0] = (char)RESPONSE;
+			byte_order::write_network(request_sent_ns, destination + 1);
+			byte_order::write_network(request_received_ns, destination + 9);
+			byte_order::write_network(response_sent_ns, destination + 17);
+		}
+
+		/**
+		 * @brief 	Function read_response reads a response written by write_response.
+		 * @param 	source 		bytes of the packet.
+		 * @param 	size 		size of the packet in bytes.
+		 * @param 	request_sent_ns[out]		t1 on the requester's clock.
+		 * @param 	request_received_ns[out]	t2 on the responder's clock.
+		 * @param 	response_sent_ns[out]		t3 on the responder's clock.
+		 * @return 	bool 		true if the packet is a response.
+		 */
+		inline bool read_response(const char* source, size_t size, uint64_t& request_sent_ns, uint64_t& request_received_ns, uint64_t& response_sent_ns) {
+			if (size != CLOCK_SYNC_RESPONSE_SIZE || (uint8_t)source[0] != RESPONSE) {
+				return false;
+			}
+			request_sent_ns = byte_order::read_network<uint64_t>(source + 1);
+			request_received_ns = byte_order::read_network<uint64_t>(source + 9);
+			response_sent_ns = byte_order::read_network<uint64_t>(source + 17);
+			return true;
+		}
+
+		/**************************************************************************************************/
+		/* Clock Estimator				 																  */
+		/**************************************************************************************************/
+		/**
+		 *	@struct	sync_sample
+		 * 	@brief 	Struct sync_sample is the result of one request and response exchange.
+		 */
+		struct sync_sample {
+			/// Local time halfway between sending the request and receiving the response.
+			uint64_t local_ns = 0;
+			/// Peer clock minus local clock in nanoseconds.
+			int64_t offset_ns = 0;
+			/// Round trip delay in nanoseconds, excluding the time the peer held the request.
+			int64_t delay_ns = 0;
+		};
+
+		/**
+		 *	@class	clock_estimator
+		 * 	@brief 	Class clock_estimator estimates the offset and drift of a peer's clock from recent exchanges.
+		 * 	@details	The offset of a sample is only wrong by half the difference between the two directions' delays,
+		 * 				so samples delayed by queueing are the least trustworthy. As in NTP's clock filter only samples
+		 * 				close to the minimum delay of the window are used: those delayed by at most the minimum plus the
+		 * 				larger of CLOCK_SYNC_DELAY_TOLERANCE_NS and the minimum itself, so up to twice the minimum on slow
+		 * 				paths. The allowance grows with the path because its jitter does, and a fixed 20 microseconds
+		 * 				would keep a single sample on a path of several milliseconds and so never estimate drift, while
+		 * 				an accepted sample's offset can only be wrong by half the minimum delay more than the best one's.
+		 * 				A least squares line through their offsets gives the offset at any local time and its slope gives
+		 * 				the drift, which is only estimated once the samples span CLOCK_SYNC_MIN_DRIFT_SPAN_NS. The
+		 * 				estimator is not thread safe.
+		 */
+		class clock_estimator {
+		public:
+			/**
+			 * @brief 	Constructor for the clock_estimator class.
+			 * @param 	window 	number of most recent samples kept (default 16, at least 1).
+			 */
+			clock_estimator(size_t window = 16) :
+				window_size(window > 0 ? window : 1)
+			{}
+
+			/**
+			 * @brief 	Method add_sample adds the four timestamps of an exchange and updates the estimate.
+			 * @param 	request_sent_ns 		t1, when the request was sent on the local clock.
+			 * @param 	request_received_ns 	t2, when the peer received the request on its clock.
+			 * @param 	response_sent_ns 		t3, when the peer sent the response on its clock.
+			 * @param 	response_received_ns 	t4, when the response was received on the local clock.
+			 * @return 	sync_sample 			offset and delay measured by the exchange.
+			 */
+			sync_sample add_sample(uint64_t request_sent_ns, uint64_t request_received_ns, uint64_t response_sent_ns, uint64_t response_received_ns) {
+				sync_sample sample;
+				const int64_t outbound = (int64_t)(request_received_ns - request_sent_ns);
+				const int64_t inbound = (int64_t)(response_sent_ns - response_received_ns);
+				sample.local_ns = request_sent_ns + (response_received_ns - request_sent_ns) / 2;
+				sample.offset_ns = outbound / 2 + inbound / 2;
+				// A clock stepped during the exchange can give a negative delay, which is still the smallest possible.
+				sample.delay_ns = std::max<int64_t>((int64_t)(response_received_ns - request_sent_ns) - (int64_t)(response_sent_ns - request_received_ns), 0);
+				if (samples.size() < window_size) {
+					samples.push_back(sample);
+				}
+				else {
+					samples[next_sample] = sample;
+				}
+				next_sample = (next_sample + 1) % window_size;
+				fit();
+				return sample;
+			}
+
+			/**
+			 * @brief 	Method is_synchronized returns whether any exchange has completed.
+			 * @return 	bool 	true once a sample has been added.
+			 */
+			bool is_synchronized() const {
+				return !samples.empty();
+			}
+
+			/**
+			 * @brief 	Method offset_ns returns the estimated offset of the peer's clock.
+			 * @param 	local_ns 	local time to estimate the offset at (default now).
+			 * @return 	int64_t 	peer clock minus local clock in nanoseconds, 0 before the first sample.
+			 */
+			int64_t offset_ns(uint64_t local_ns = wall_clock_ns()) const {
+				return (int64_t)std::llround(reference_offset + drift * (double)(int64_t)(local_ns - reference_ns));
+			}
+
+			/**
+			 * @brief 	Method drift_ppm returns how fast the peer's clock gains on the local clock.
+			 * @return 	double 	drift in parts per million, 0 until the samples span long enough.
+			 */
+			double drift_ppm() const {
+				return drift * 1e6;
+			}
+
+			/**
+			 * @brief 	Method delay_ns returns the smallest round trip delay in the window.
+			 * @return 	int64_t 	delay in nanoseconds, 0 before the first sample.
+			 */
+			int64_t delay_ns() const {
+				return minimum_delay;
+			}
+
+			/**
+			 * @brief 	Method to_local converts a time on the peer's clock to the local clock.
+			 * @param 	remote_ns 	time on the peer's clock.
+			 * @return 	uint64_t 	same instant on the local clock.
+			 */
+			uint64_t to_local(uint64_t remote_ns) const {
+				// The offset is a function of local time, so refine the first guess once.
+				const uint64_t guess = remote_ns - (uint64_t)offset_ns(remote_ns);
+				return remote_ns - (uint64_t)offset_ns(guess);
+			}
+
+			/**
+			 * @brief 	Method sample_count returns the number of samples in the window.
+			 * @return 	size_t 	number of samples.
+			 */
+			size_t sample_count() const {
+				return samples.size();
+			}
+
+		private:
+			/// Largest number of samples kept.
+			size_t window_size;
+			/// Most recent samples, used as a ring once full.
+			std::vector<sync_sample> samples;
+			/// Slot the next sample replaces once the ring is full.
+			size_t next_sample = 0;
+			/// Local time the reference offset applies at.
+			uint64_t reference_ns = 0;
+			/// Offset at the reference time in nanoseconds.
+			double reference_offset = 0;
+			/// Drift in nanoseconds gained per nanosecond.
+			double drift = 0;
+			/// Smallest delay in the window.
+			int64_t minimum_delay = 0;
+
+			/**
+			 * @brief 	Method fit fits the offset and drift to the samples with the smallest delays.
+			 */
+			void fit() {
+				minimum_delay = samples.front().delay_ns;
+				for (const sync_sample& sample : samples) {
+					minimum_delay = std::min(minimum_delay, sample.delay_ns);
+				}
+				// The allowance scales with the minimum delay on long paths, see the class description.
+				const int64_t accepted_delay = minimum_delay + std::max<int64_t>(minimum_delay, CLOCK_SYNC_DELAY_TOLERANCE_NS);
+
+				// Fit relative to an accepted sample so the doubles keep nanosecond precision.
+				uint64_t base_ns = 0;
+				uint64_t earliest_ns = 0;
+				uint64_t latest_ns = 0;
+				size_t accepted = 0;
+				double mean_x = 0;
+				double mean_y = 0;
+				for (const sync_sample& sample : samples) {
+					if (sample.delay_ns > accepted_delay) {
+						continue;
+					}
+					if (accepted == 0) {
+						base_ns = earliest_ns = latest_ns = sample.local_ns;
+					}
+					earliest_ns = (int64_t)(sample.local_ns - earliest_ns) < 0 ? sample.local_ns : earliest_ns;
+					latest_ns = (int64_t)(sample.local_ns - latest_ns) > 0 ? sample.local_ns : latest_ns;
+					accepted++;
+					mean_x += ((double)(int64_t)(sample.local_ns - base_ns) - mean_x) / (double)accepted;
+					mean_y += ((double)sample.offset_ns - mean_y) / (double)accepted;
+				}
+				double covariance = 0;
+				double variance = 0;
+				for (const sync_sample& sample : samples) {
+					if (sample.delay_ns <= accepted_delay) {
+						const double x = (double)(int64_t)(sample.local_ns - base_ns) - mean_x;
+						covariance += x * ((double)sample.offset_ns - mean_y);
+						variance += x * x;
+					}
+				}
+				reference_ns = base_ns + (uint64_t)(int64_t)std::llround(mean_x);
+				reference_offset = mean_y;
+				drift = 0;
+				if ((int64_t)(latest_ns - earliest_ns) >= CLOCK_SYNC_MIN_DRIFT_SPAN_NS && variance > 0) {
+					const double limit = CLOCK_SYNC_MAX_DRIFT_PPM * 1e-6;
+					drift = std::min(std::max(covariance / variance, -limit), limit);
+				}
+			}
+		};
+
+		/**************************************************************************************************/
+		/* Synchronizer					 																  */
+		/**************************************************************************************************/
+		/**
+		 *	@class	synchronizer
+		 * 	@brief 	Class synchronizer runs clock synchronization with the peers of a socket and records the one-way
+		 * 			latency of stamped messages in a histogram per peer.
+		 * 	@details	The synchronizer does not receive by itself. The application calls request periodically for each
+		 * 				peer, passes every datagram it receives to handle, which answers requests and consumes responses,
+		 * 				and passes the stamped messages it wants measured to observe. Enabling receive timestamps on the
+		 * 				socket moves t2, t4 and the receive time of messages to when the kernel received them, so queueing
+		 * 				in the socket and scheduling delays do not count as latency. Send times are read from the system
+		 * 				clock just before the send call. Peers are only tracked once a request has been sent to them, and
+		 * 				a response is only used if it echoes the send time of one of the peer's recent requests, so
+		 * 				datagrams from unknown or spoofed sources cannot add peers or samples. Requests are only answered
+		 * 				for tracked peers unless enable_responder is called, and then only at its rate, so a synchronizer
+		 * 				cannot be used to reflect larger responses at spoofed sources. The synchronizer is thread safe and
+		 * 				the socket must outlive it.
+		 */
+		class synchronizer {
+		public:
+			/**
+			 * @brief 	Constructor for the synchronizer class.
+			 * @param 	inner 	socket that requests and responses are sent with.
+			 * @param 	window 	number of recent samples each peer's estimator keeps (default 16).
+			 */
+			synchronizer(udp::socket& inner, size_t window = 16) :
+				inner_socket(inner),
+				window_size(window)
+			{}
+
+			/**
+			 * @brief 	Method enable_responder answers the requests of sources that are not tracked peers, such as clients
+			 * 			of a time server that is never sent requests itself.
+			 * @param 	rate 	responses to untracked sources per second, more requests are not answered.
+			 * @param 	burst 	responses that can be sent at once after a quiet period.
+			 * @throws	configuration_error if the rate is not positive.
+			 */
+			void enable_responder(double rate, double burst) {
+				if (rate <= 0) {
+					throw errors::configuration_error("The responder rate must be positive so responses are limited.");
+				}
+				std::unique_lock<std::mutex> access_lock(peers_mutex);
+				responder.reset(new token_bucket(rate, burst));
+			}
+
+			/**
+			 * @brief 	Method request sends a synchronization request to a peer.
+			 * @param 	peer 	address and port of the peer.
+			 * @throws	send_error if the request could not be sent.
+			 * @throws	configuration_error if the peer is new and CLOCK_SYNC_MAX_PEERS peers are already tracked.
+			 */
+			void request(const socket_address& peer) {
+				char packet[CLOCK_SYNC_REQUEST_SIZE];
+				const uint64_t sent_ns = wall_clock_ns();
+				write_request(sent_ns, packet);
+				{
+					std::unique_lock<std::mutex> access_lock(peers_mutex);
+					const socket_address key = peer.to_ipv4();
+					auto found = peers.find(key);
+					if (found == peers.end()) {
+						if (peers.size() >= CLOCK_SYNC_MAX_PEERS) {
+							throw errors::configuration_error("Cannot synchronize with more than " + std::to_string(CLOCK_SYNC_MAX_PEERS) + " peers.");
+						}
+						found = peers.emplace(key, peer_state{clock_estimator(window_size)}).first;
+					}
+					std::vector<uint64_t>& outstanding = found->second.outstanding;
+					if (outstanding.size() >= CLOCK_SYNC_MAX_OUTSTANDING) {
+						outstanding.erase(outstanding.begin());
+					}
+					outstanding.push_back(sent_ns);
+				}
+				inner_socket.send_to(packet, sizeof(packet), peer);
+			}
+
+			/**
+			 * @brief 	Method handle answers a request or adds the sample of a response.
+			 * @details	Requests from sources that are not tracked peers are consumed but only answered within the rate
+			 * 			of enable_responder, and the rest are counted, see get_unanswered. Responses that could not be
+			 * 			sent are counted rather than thrown, see get_failed_responses. Responses that do not match an
+			 * 			outstanding request to their source are consumed but dropped and counted, see get_rejected.
+			 * @param 	buffer 		bytes of the datagram.
+			 * @param 	size 		size of the datagram in bytes.
+			 * @param 	source 		address and port the datagram came from.
+			 * @param 	received_ns time the datagram was received on the local clock.
+			 * @return 	bool 		true if the datagram was a synchronization packet, false if it belongs to the application.
+			 */
+			bool handle(const char* buffer, size_t size, const socket_address& source, uint64_t received_ns) {
+				uint64_t request_sent_ns;
+				uint64_t request_received_ns;
+				uint64_t response_sent_ns;
+				if (read_request(buffer, size, request_sent_ns)) {
+					{
+						std::unique_lock<std::mutex> access_lock(peers_mutex);
+						if (find_peer(source) == nullptr && (responder == nullptr || !responder->try_consume())) {
+							unanswered++;
+							return true;
+						}
+					}
+					char packet[CLOCK_SYNC_RESPONSE_SIZE];
+					write_response(request_sent_ns, received_ns, wall_clock_ns(), packet);
+					try {
+						inner_socket.send_to(packet, sizeof(packet), source);
+					}
+					catch (const errors::send_error&) {
+						// The source may be spoofed or unreachable, which is no reason to interrupt the receive loop.
+						std::unique_lock<std::mutex> access_lock(peers_mutex);
+						failed_responses++;
+					}
+					return true;
+				}
+				if (read_response(buffer, size, request_sent_ns, request_received_ns, response_sent_ns)) {
+					std::unique_lock<std::mutex> access_lock(peers_mutex);
+					peer_state* state = find_peer(source);
+					if (state == nullptr) {
+						rejected++;
+						return true;
+					}
+					// Each request is answered once, so a duplicated or replayed response finds nothing to match.
+					auto outstanding = std::find(state->outstanding.begin(), state->outstanding.end(), request_sent_ns);
+					if (outstanding == state->outstanding.end()) {
+						rejected++;
+						return true;
+					}
+					state->outstanding.erase(outstanding);
+					state->estimator.add_sample(request_sent_ns, request_received_ns, response_sent_ns, received_ns);
+					return true;
+				}
+				return false;
+			}
+
+			/**
+			 * @brief 	Method handle answers a request or adds the sample of a response received with receive_batch.
+			 * @param 	datagram 	datagram received with its source.
+			 * @return 	bool 		true if the datagram was a synchronization packet, false if it belongs to the application.
+			 * @throws	configuration_error if the datagram was received without its source.
+			 */
+			bool handle(const incoming_datagram& datagram) {
+				if (datagram.size != CLOCK_SYNC_REQUEST_SIZE && datagram.size != CLOCK_SYNC_RESPONSE_SIZE) {
+					return false;
+				}
+				return handle(datagram.buffer, datagram.size, socket_address::parse(datagram.source_address, datagram.source_port), receive_time_ns(datagram));
+			}
+
+			/**
+			 * @brief 	Method observe records the one-way latency of a message stamped by a peer.
+			 * @param 	peer 		address and port of the peer that sent the message.
+			 * @param 	sent_ns 	send time stamped by the peer on its clock.
+			 * @param 	received_ns time the message was received on the local clock.
+			 * @return 	int64_t 	latency in nanoseconds corrected for the clock offset, which can come out slightly
+			 * 						negative when the delay is below the accuracy of the offset.
+			 * @details	Messages from peers that no response has been received from are not recorded since their latency
+			 * 			would include the whole difference between the clocks, and the uncorrected latency is returned.
+			 */
+			int64_t observe(const socket_address& peer, uint64_t sent_ns, uint64_t received_ns) {
+				std::unique_lock<std::mutex> access_lock(peers_mutex);
+				peer_state* state = find_peer(peer);
+				if (state == nullptr || !state->estimator.is_synchronized()) {
+					return (int64_t)(received_ns - sent_ns);
+				}
+				const int64_t latency = (int64_t)(received_ns - state->estimator.to_local(sent_ns));
+				state->latency->observe((uint64_t)std::max<int64_t>(latency, 0));
+				return latency;
+			}
+
+			/**
+			 * @brief 	Method observe records the one-way latency of a stamped message received with receive_batch.
+			 * @param 	datagram 		datagram received with its source.
+			 * @param 	stamp_offset 	position of the stamp written by write_stamp in the datagram (default 0).
+			 * @return 	int64_t 		latency in nanoseconds corrected for the clock offset.
+			 * @throws	decode_error if the datagram is too small to hold the stamp.
+			 * @throws	configuration_error if the datagram was received without its source.
+			 */
+			int64_t observe(const incoming_datagram& datagram, size_t stamp_offset = 0) {
+				if (datagram.size < CLOCK_SYNC_STAMP_SIZE || stamp_offset > datagram.size - CLOCK_SYNC_STAMP_SIZE) {
+					throw errors::decode_error("Datagram is too small to hold a send time stamp.");
+				}
+				const uint64_t received_ns = receive_time_ns(datagram);
+				return observe(socket_address::parse(datagram.source_address, datagram.source_port), read_stamp(datagram.buffer + stamp_offset), received_ns);
+			}
+
+			/**
+			 * @brief 	Method get_estimator returns a copy of the clock estimate for a peer.
+			 * @param 	peer 				address and port of the peer.
+			 * @return 	clock_estimator 	estimate, unsynchronized if no response has been received from the peer.
+			 */
+			clock_estimator get_estimator(const socket_address& peer) {
+				std::unique_lock<std::mutex> access_lock(peers_mutex);
+				const peer_state* state = find_peer(peer);
+				return state != nullptr ? state->estimator : clock_estimator(window_size);
+			}
+
+			/**
+			 * @brief 	Method get_latency returns the histogram of one-way latencies in nanoseconds from a peer.
+			 * @param 	peer 	address and port of the peer.
+			 * @return 	std::shared_ptr<const statistics::histogram> 	histogram that keeps filling as messages are observed,
+			 * 															or nullptr if no request has been sent to the peer.
+			 */
+			std::shared_ptr<const statistics::histogram> get_latency(const socket_address& peer) {
+				std::unique_lock<std::mutex> access_lock(peers_mutex);
+				const peer_state* state = find_peer(peer);
+				return state != nullptr ? state->latency : nullptr;
+			}
+
+			/**
+			 * @brief 	Method get_rejected returns the number of responses dropped because they matched no outstanding request.
+			 * @return 	uint64_t 	number of rejected responses.
+			 */
+			uint64_t get_rejected() {
+				std::unique_lock<std::mutex> access_lock(peers_mutex);
+				return rejected;
+			}
+
+			/**
+			 * @brief 	Method get_unanswered returns the number of requests not answered because their source is not a
+			 * 			tracked peer and the responder was disabled or out of tokens.
+			 * @return 	uint64_t 	number of unanswered requests.
+			 */
+			uint64_t get_unanswered() {
+				std::unique_lock<std::mutex> access_lock(peers_mutex);
+				return unanswered;
+			}
+
+			/**
+			 * @brief 	Method get_failed_responses returns the number of responses to requests that could not be sent.
+			 * @return 	uint64_t 	number of failed responses.
+			 */
+			uint64_t get_failed_responses() {
+				std::unique_lock<std::mutex> access_lock(peers_mutex);
+				return failed_responses;
+			}
+
+			/**
+			 * @brief 	Method remove forgets a peer's clock estimate and latency histogram.
+			 * @param 	peer 	address and port of the peer.
+			 */
+			void remove(const socket_address& peer) {
+				std::unique_lock<std::mutex> access_lock(peers_mutex);
+				peers.erase(peer.to_ipv4());
+			}
+
+		private:
+			/**
+			 *	@struct	peer_state
+			 * 	@brief 	Struct peer_state holds what is known about one peer.
+			 */
+			struct peer_state {
+				/// Estimate of the peer's clock.
+				clock_estimator estimator;
+				/// One-way latencies of the peer's messages in nanoseconds.
+				std::shared_ptr<statistics::histogram> latency = std::make_shared<statistics::histogram>();
+				/// Send times of the requests to the peer that have not been answered, oldest first.
+				std::vector<uint64_t> outstanding = {};
+			};
+
+			/// Socket the requests and responses are sent with.
+			udp::socket& inner_socket;
+			/// Number of samples each estimator keeps.
+			size_t window_size;
+			/// Mutex to control access to the peers.
+			std::mutex peers_mutex;
+			/// State of each peer, with IPv4 mapped peers stored as plain IPv4.
+			std::unordered_map<socket_address, peer_state, socket_address::hash> peers;
+			/// Number of responses that matched no outstanding request.
+			uint64_t rejected = 0;
+			/// Pacing of responses to sources that are not tracked peers, nullptr while they are not answered.
+			std::unique_ptr<token_bucket> responder;
+			/// Number of requests that were not answered.
+			uint64_t unanswered = 0;
+			/// Number of responses that could not be sent.
+			uint64_t failed_responses = 0;
+
+			/**
+			 * @brief 	Method find_peer returns the state of a peer without adding it.
+			 * @param 	peer 			address and port of the peer.
+			 * @return 	peer_state* 	state of the peer, or nullptr if no request has been sent to it.
+			 * @note	The caller must hold the peers mutex.
+			 */
+			peer_state* find_peer(const socket_address& peer) {
+				auto found = peers.find(peer.to_ipv4());
+				return found != peers.end() ? &found->second : nullptr;
+			}
+		};
+	}
+}
+
+#endif /* CLOCK_SYNC_HPP */
@@ -0,0 +1,103 @@
+/**
+ * 	@file 	datagram.hpp
+ * 	@brief 	Structs describing the datagrams passed to and from the batch send and receive methods.
+ * 	@author James Horner
+ * 	@date 	2023-04-05
+ */
+
+#ifndef DATAGRAM_HPP
+#define DATAGRAM_HPP
+
+// Standard System Libraries
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/// Macro for the largest number of datagrams passed to the kernel in a single batch system call.
+#define MAX_BATCH_SIZE 64
+
+namespace oo_socket
+{
+	/**
+	 *	@enum	ecn_codepoint
+	 * 	@brief 	Enum ecn_codepoint is the Explicit Congestion Notification field in the low two bits of the IPv4 TOS or
+	 * 			IPv6 traffic class byte (RFC 3168).
+	 */
+	enum ecn_codepoint : uint8_t
+	{
+		NOT_ECT = 0,
+		ECT_1 = 1,
+		ECT_0 = 2,
+		CE = 3,
+	};
+
+	/**
+	 *	@struct	traffic_class
+	 * 	@brief 	Struct traffic_class marks datagrams for preferential or deferred treatment by the host and the network.
+	 */
+	struct traffic_class {
+		/// Differentiated services codepoint (0 to 63) in the upper six bits of the IPv4 TOS or IPv6 traffic class, -1 to leave it unchanged.
+		int dscp = -1;
+		/// Socket priority that selects the band of the host's queueing discipline (SO_PRIORITY), -1 to leave it unchanged.
+		/// Priorities above 6 need CAP_NET_ADMIN.
+		int priority = -1;
+	};
+
+	/**
+	 *	@namespace	traffic_classes
+	 * 	@brief 		Presets pairing the DSCP of common classes of traffic (RFC 4594) with the Linux priority that
+	 * 				pfifo_fast and the default priority maps queue them by.
+	 */
+	namespace traffic_classes
+	{
+		/// Default forwarding (CS0) in the middle band.
+		constexpr traffic_class BEST_EFFORT{0, 0};
+		/// Bulk transfers that should yield to everything else (CS1, TC_PRIO_BULK).
+		constexpr traffic_class BULK{8, 2};
+		/// Interactive media such as video that tolerates little delay (AF41, TC_PRIO_INTERACTIVE_BULK).
+		constexpr traffic_class INTERACTIVE{34, 4};
+		/// Latency critical traffic such as control loops and voice (EF, TC_PRIO_INTERACTIVE).
+		constexpr traffic_class LOW_LATENCY{46, 6};
+		/// Routing and control plane traffic (CS6, TC_PRIO_CONTROL), whose priority needs CAP_NET_ADMIN.
+		constexpr traffic_class NETWORK_CONTROL{48, 7};
+	}
+
+	/**
+	 *	@struct	outgoing_datagram
+	 * 	@brief 	Struct outgoing_datagram points at the contents of a datagram to be sent in a batch.
+	 */
+	struct outgoing_datagram {
+		/// Pointer to the bytes of the datagram.
+		const char* buffer;
+		/// Number of bytes in the datagram.
+		size_t size;
+	};
+
+	/**
+	 *	@struct	incoming_datagram
+	 * 	@brief 	Struct incoming_datagram describes a buffer to receive a datagram into as part of a batch.
+	 */
+	struct incoming_datagram {
+		/// Buffer that will store the incoming datagram.
+		char* buffer;
+		/// Size of the buffer in bytes.
+		size_t capacity;
+		/// Number of bytes received into the buffer.
+		size_t size;
+		/// Source address of the datagram, only set when the source is requested.
+		std::string source_address;
+		/// Source port of the datagram, only set when the source is requested.
+		uint16_t source_port;
+		/// Local address the datagram was sent to, only set when packet info is enabled on the socket.
+		std::string destination_address;
+		/// Index of the interface the datagram arrived on, only set when packet info is enabled on the socket.
+		uint32_t interface_index;
+		/// Time the kernel received the datagram in nanoseconds since the Unix epoch, only set when receive timestamps
+		/// are enabled on the socket and 0 if the kernel did not provide one.
+		uint64_t receive_timestamp_ns;
+		/// ECN codepoint of the datagram, only set when ECN is enabled on the socket.
+		uint8_t ecn;
+	};
+}
+
+#endif /* DATAGRAM_HPP */
@@ -0,0 +1,606 @@
+/**
+ * 	@file 	delta.hpp
+ * 	@brief 	Classes encoding successive state frames as differences from the last frame each receiver acknowledged.
+ * 	@author James Horner
+ * 	@date 	2023-04-05
+ */
+
+#ifndef DELTA_HPP
+#define DELTA_HPP
+
+// Standard System Libraries
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+// Platform Specific System Libraries
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+// Local Libraries
+#include "byte_order.hpp"
+#include "errors.hpp"
+#include "schema.hpp"
+#include "socket_address.hpp"
+
+/// Macro for the number of bytes in the header of every delta packet.
+#define DELTA_HEADER_SIZE 13
+/// Macro for the number of bytes in an acknowledgement packet.
+#define DELTA_ACK_SIZE 5
+
+namespace oo_socket
+{
+	/**
+	 *	@namespace	delta
+	 * 	@brief 		Delta encoding of state frames that are sent repeatedly with few changes between them.
+	 * 	@details	Frames are compared 4 byte word at a time. A delta packet lists runs of changed words, each as a
+	 * 				varint count of unchanged words to skip, a varint count of changed words and then the changed words
+	 * 				XORed with the base frame. Every packet starts with a header of a kind byte and the sequence, base
+	 * 				sequence and size of the frame as 32 bit integers in network byte order. A keyframe packet carries
+	 * 				the whole frame instead of the runs.
+	 */
+	namespace delta
+	{
+		/**
+		 *	@enum	packet_kind
+		 * 	@brief 	Enum packet_kind is the first byte of every packet exchanged by the encoder and decoder.
+		 */
+		enum packet_kind : uint8_t
+		{
+			KEYFRAME = 1,
+			DELTA,
+			ACK,
+		};
+
+		/**************************************************************************************************/
+		/* Word Functions				 																  */
+		/**************************************************************************************************/
+		/**
+		 * @brief 	Function load_word loads a word of a frame, zero padding the last word if the size is not a multiple of 4.
+		 * @param 	frame 		bytes of the frame.
+		 * @param 	index 		index of the word.
+		 * @param 	size 		size of the frame in bytes.
+		 * @return 	uint32_t 	bytes of the word in memory order.
+		 */
+		inline uint32_t load_word(const char* frame, size_t index, size_t size) {
+			uint32_t word = 0;
+			const size_t offset = index * 4;
+			::memcpy(&word, frame + offset, size - offset < 4 ? size - offset : 4);
+			return word;
+		}
+
+		/**
+		 * @brief 	Function changed_mask compares 8 whole words of two frames.
+		 * @details	Words are compared 8 at a time with AVX2, or 4 at a time with SSE2 or NEON, when the compiler targets
+		 * 			those instruction sets, and one at a time otherwise.
+		 * @param 	base 		bytes of the base frame.
+		 * @param 	frame 		bytes of the new frame.
+		 * @param 	index 		index of the first word, the 8 words must lie inside both frames.
+		 * @return 	uint32_t 	mask with bit i set if word index + i differs.
+		 */
+		inline uint32_t changed_mask(const char* base, const char* frame, size_t index) {
+			const char* old_words = base + index * 4;
+			const char* new_words = frame + index * 4;
+#if defined(__AVX2__)
+			const __m256i equal = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)old_words), _mm256_loadu_si256((const __m256i*)new_words));
+			return ~(uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(equal)) & 0xff;
+#elif defined(__SSE2__)
+			const __m128i low = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)old_words), _mm_loadu_si128((const __m128i*)new_words));
+			const __m128i high = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(old_words + 16)), _mm_loadu_si128((const __m128i*)(new_words + 16)));
+			const uint32_t equal = (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(low)) | ((uint32_t)_mm_movemask_ps(_mm_castsi128_ps(high)) << 4);
+			return ~equal & 0xff;
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+			const uint32x4_t bits = {1, 2, 4, 8};
+			const uint32x4_t low = vceqq_u32(vld1q_u32((const uint32_t*)old_words), vld1q_u32((const uint32_t*)new_words));
+			const uint32x4_t high = vceqq_u32(vld1q_u32((const uint32_t*)(old_words + 16)), vld1q_u32((const uint32_t*)(new_words + 16)));
+			const uint32_t equal = vaddvq_u32(vandq_u32(low, bits)) | (vaddvq_u32(vandq_u32(high, bits)) << 4);
+			return ~equal & 0xff;
+#else
+			uint32_t mask = 0;
+			for (size_t i = 0; i < 8; i++) {
+				if (::memcmp(old_words + i * 4, new_words + i * 4, 4) != 0) {
+					mask |= 1u << i;
+				}
+			}
+			return mask;
+#endif
+		}
+
+		/**
+		 * @brief 	Function find_word finds the next word that has, or has not, changed between two frames.
+		 * @param 	base 		bytes of the base frame.
+		 * @param 	frame 		bytes of the new frame.
+		 * @param 	size 		size of both frames in bytes.
+		 * @param 	index 		index of the word to start from.
+		 * @param 	changed 	true to find the next changed word, false to find the next unchanged word.
+		 * @return 	size_t 		index of the word found, or the number of words if there is none.
+		 */
+		inline size_t find_word(const char* base, const char* frame, size_t size, size_t index, bool changed) {
+			const size_t whole_words = size / 4;
+			for (; index + 8 <= whole_words; index += 8) {
+				const uint32_t mask = changed ? changed_mask(base, frame, index) : ~changed_mask(base, frame, index) & 0xff;
+				if (mask != 0) {
+					return index + (size_t)__builtin_ctz(mask);
+				}
+			}
+			const size_t words = (size + 3) / 4;
+			for (; index < words; index++) {
+				if ((load_word(base, index, size) != load_word(frame, index, size)) == changed) {
+					return index;
+				}
+			}
+			return words;
+		}
+
+		/**
+		 * @brief 	Function xor_bytes XORs two byte arrays.
+		 * @details	Bytes are combined 32 at a time with AVX2, or 16 at a time with SSE2 or NEON, when the compiler targets
+		 * 			those instruction sets, and one at a time otherwise.
+		 * @param 	first 		first array.
+		 * @param 	second 		second array.
+		 * @param 	destination buffer for the result, which may be either array.
+		 * @param 	count 		number of bytes.
+		 */
+		inline void xor_bytes(const char* first, const char* second, char* destination, size_t count) {
+			size_t position = 0;
+#if defined(__AVX2__)
+			for (; position + 32 <= count; position += 32) {
+				const __m256i result = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(first + position)), _mm256_loadu_si256((const __m256i*)(second + position)));
+				_mm256_storeu_si256((__m256i*)(destination + position), result);
+			}
+#endif
+#if defined(__AVX2__) || defined(__SSE2__)
+			for (; position + 16 <= count; position += 16) {
+				const __m128i result = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(first + position)), _mm_loadu_si128((const __m128i*)(second + position)));
+				_mm_storeu_si128((__m128i*)(destination + position), result);
+			}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+			for (; position + 16 <= count; position += 16) {
+				vst1q_u8((uint8_t*)(destination + position), veorq_u8(vld1q_u8((const uint8_t*)(first + position)), vld1q_u8((const uint8_t*)(second + position))));
+			}
+#endif
+			for (; position < count; position++) {
+				destination[position] = (char)(first[position] ^ second[position]);
+			}
+		}
+
+		/**************************************************************************************************/
+		/* Delta Functions				 																  */
+		/**************************************************************************************************/
+		/**
+		 * @brief 	Function encode_delta writes the runs of words that differ between two frames of the same size.
+		 * @param 	base 		bytes of the frame the receiver already has.
+		 * @param 	frame 		bytes of the new frame.
+		 * @param 	size 		size of both frames in bytes.
+		 * @param 	destination buffer for the runs.
+		 * @param 	capacity 	size of the buffer in bytes.
+		 * @param 	written[out]	number of bytes written, 0 if the frames are identical.
+		 * @return 	bool 		true if the runs fit in the buffer, false if they did not, in which case sending the whole
+		 * 						frame is cheaper.
+		 */
+		inline bool encode_delta(const char* base, const char* frame, size_t size, char* destination, size_t capacity, size_t& written) {
+			const size_t words = (size + 3) / 4;
+			char* position = destination;
+			const char* end = destination + capacity;
+			size_t index = 0;
+			while (true) {
+				const size_t first_changed = find_word(base, frame, size, index, true);
+				if (first_changed == words) {
+					break;
+				}
+				const size_t next_unchanged = find_word(base, frame, size, first_changed + 1, false);
+				const size_t start_byte = first_changed * 4;
+				const size_t run_bytes = (next_unchanged * 4 < size ? next_unchanged * 4 : size) - start_byte;
+				const size_t skip = first_changed - index;
+				const size_t count = next_unchanged - first_changed;
+				if ((size_t)(end - position) < schema::varint_size(skip) + schema::varint_size(count) + run_bytes) {
+					return false;
+				}
+				position = schema::write_varint(skip, position);
+				position = schema::write_varint(count, position);
+				xor_bytes(base + start_byte, frame + start_byte, position, run_bytes);
+				position += run_bytes;
+				index = next_unchanged;
+			}
+			written = (size_t)(position - destination);
+			return true;
+		}
+
+		/**
+		 * @brief 	Function apply_delta applies runs written by encode_delta to a copy of the base frame.
+		 * @param 	source 		bytes of the runs.
+		 * @param 	source_size size of the runs in bytes.
+		 * @param 	frame 		base frame, which is changed into the new frame.
+		 * @param 	size 		size of the frame in bytes.
+		 * @throws	decode_error if a run lies outside the frame or the runs are truncated.
+		 */
+		inline void apply_delta(const char* source, size_t source_size, char* frame, size_t size) {
+			const char* position = source;
+			const char* end = source + source_size;
+			const size_t words = (size + 3) / 4;
+			size_t index = 0;
+			while (position < end) {
+				const uint64_t skip = schema::read_varint(position, end);
+				const uint64_t count = schema::read_varint(position, end);
+				if (count == 0 || skip > words - index || count > words - index - skip) {
+					throw errors::decode_error("Delta run lies outside the frame.");
+				}
+				index += (size_t)skip;
+				const size_t start_byte = index * 4;
+				index += (size_t)count;
+				const size_t run_bytes = (index * 4 < size ? index * 4 : size) - start_byte;
+				if ((size_t)(end - position) < run_bytes) {
+					throw errors::decode_error("Delta run runs past the end of the packet.");
+				}
+				xor_bytes(frame + start_byte, position, frame + start_byte, run_bytes);
+				position += run_bytes;
+			}
+		}
+
+		/**
+		 * @brief 	Function write_ack writes an acknowledgement of a decoded frame.
+		 * @param 	sequence 	sequence of the frame.
+		 * @param 	destination buffer of at least DELTA_ACK_SIZE bytes.
+		 */
+		inline void write_ack(uint32_t sequence, char* destination) {
+			destination[0] = (char)ACK;
+			byte_order::write_network(sequence, destination + 1);
+		}
+
+		/**
+		 * @brief 	Function read_ack reads an acknowledgement written by write_ack.
+		 * @param 	source 		bytes of the packet.
+		 * @param 	size 		size of the packet in bytes.
+		 * @param 	sequence[out]	sequence of the acknowledged frame.
+		 * @return 	bool 		true if the packet is an acknowledgement.
+		 */
+		inline bool read_ack(const char* source, size_t size, uint32_t& sequence) {
+			if (size != DELTA_ACK_SIZE || (uint8_t)source[0] != ACK) {
+				return false;
+			}
+			sequence = byte_order::read_network<uint32_t>(source + 1);
+			return true;
+		}
+
+		/**
+		 *	@struct	delta_statistics
+		 * 	@brief 	Struct delta_statistics counts the packets an encoder produced and the bytes they saved.
+		 */
+		struct delta_statistics {
+			/// Number of keyframe packets.
+			uint64_t keyframes = 0;
+			/// Number of delta packets.
+			uint64_t deltas = 0;
+			/// Number of bytes the frames would have taken if sent whole.
+			uint64_t frame_bytes = 0;
+			/// Number of bytes of the packets actually produced, including headers.
+			uint64_t packet_bytes = 0;
+		};
+
+		/**************************************************************************************************/
+		/* Encoder						 																  */
+		/**************************************************************************************************/
+		/**
+		 *	@class	encoder
+		 * 	@brief 	Class encoder encodes the latest frame for each receiver against the last frame it acknowledged.
+		 * 	@details	The encoder keeps the most recent frames in a ring so any of them can serve as a base. A receiver
+		 * 				gets a keyframe until it has acknowledged a frame still in the ring, when the frame size changes,
+		 * 				when the delta would be no smaller than the frame, and every keyframe_interval frames so a
+		 * 				receiver whose acknowledgements are lost still recovers. The encoder is not thread safe.
+		 */
+		class encoder {
+		public:
+			/**
+			 * @brief 	Constructor for the encoder class.
+			 * @param 	history_size 		number of recent frames kept as bases (default 32, at least 1).
+			 * @param 	keyframe_interval 	largest number of frames between keyframes to a receiver, 0 for no limit
+			 * 								(default 64).
+			 */
+			encoder(size_t history_size = 32, uint32_t keyframe_interval = 64) :
+				history(history_size > 0 ? history_size : 1),
+				history_sequences(history.size()),
+				keyframe_interval(keyframe_interval)
+			{}
+
+			/**
+			 * @brief 	Method update stores the next frame of the stream.
+			 * @param 	frame 		bytes of the frame.
+			 * @param 	size 		size of the frame in bytes.
+			 * @return 	uint32_t 	sequence of the frame.
+			 */
+			uint32_t update(const char* frame, size_t size) {
+				if (frame_count > 0) {
+					current_sequence++;
+				}
+				const size_t slot = current_sequence % history.size();
+				history[slot].assign(frame, frame + size);
+				history_sequences[slot] = current_sequence;
+				frame_count++;
+				return current_sequence;
+			}
+
+			/**
+			 * @brief 	Method update stores the next frame of the stream.
+			 * @param 	frame 		vector of the frame's values.
+			 * @return 	uint32_t 	sequence of the frame.
+			 */
+			template <typename T>
+			uint32_t update(const std::vector<T>& frame) {
+				return update(reinterpret_cast<const char*>(frame.data()), frame.size() * sizeof(T));
+			}
+
+			/**
+			 * @brief 	Method encode encodes the latest frame for a receiver.
+			 * @param 	receiver 	address of the receiver.
+			 * @param 	packet[out]	vector resized to hold the packet, which can be passed to send_to.
+			 * @return 	size_t 		size of the packet in bytes.
+			 * @throws	encode_error if no frame has been stored yet.
+			 */
+			size_t encode(const socket_address& receiver, std::vector<char>& packet) {
+				if (frame_count == 0) {
+					throw errors::encode_error("Delta encoder has no frame to encode.");
+				}
+				const std::vector<char>& frame = history[current_sequence % history.size()];
+				receiver_state& state = receivers[receiver];
+				packet.resize(DELTA_HEADER_SIZE + frame.size());
+				packet[0] = (char)KEYFRAME;
+				byte_order::write_network(current_sequence, packet.data() + 1);
+				byte_order::write_network((uint32_t)frame.size(), packet.data() + 9);
+
+				// Diff against the acknowledged frame unless a keyframe is due or the receiver has no usable base.
+				const std::vector<char>* base = acknowledged_frame(state);
+				const bool keyframe_due = !state.keyframe_sent || (keyframe_interval > 0 && current_sequence - state.keyframe_sequence >= keyframe_interval);
+				size_t delta_size = 0;
+				if (base != nullptr && !keyframe_due && base->size() == frame.size() &&
+					encode_delta(base->data(), frame.data(), frame.size(), packet.data() + DELTA_HEADER_SIZE, frame.size(), delta_size)) {
+					packet[0] = (char)DELTA;
+					byte_order::write_network(state.acknowledged_sequence, packet.data() + 5);
+					packet.resize(DELTA_HEADER_SIZE + delta_size);
+					statistics.deltas++;
+				}
+				else {
+					byte_order::write_network(current_sequence, packet.data() + 5);
+					if (!frame.empty()) {
+						::memcpy(packet.data() + DELTA_HEADER_SIZE, frame.data(), frame.size());
+					}
+					state.keyframe_sent = true;
+					state.keyframe_sequence = current_sequence;
+					statistics.keyframes++;
+				}
+				statistics.frame_bytes += frame.size();
+				statistics.packet_bytes += packet.size();
+				return packet.size();
+			}
+
+			/**
+			 * @brief 	Method acknowledge records that a receiver has decoded a frame, making it the receiver's base.
+			 * @param 	receiver 	address of the receiver.
+			 * @param 	sequence 	sequence of the frame, older acknowledgements than the current base are ignored.
+			 */
+			void acknowledge(const socket_address& receiver, uint32_t sequence) {
+				receiver_state& state = receivers[receiver];
+				if (!state.acknowledged || (int32_t)(sequence - state.acknowledged_sequence) > 0) {
+					state.acknowledged = true;
+					state.acknowledged_sequence = sequence;
+				}
+			}
+
+			/**
+			 * @brief 	Method handle_ack records an acknowledgement packet received from a receiver.
+			 * @param 	receiver 	address the packet came from.
+			 * @param 	packet 		bytes of the packet.
+			 * @param 	size 		size of the packet in bytes.
+			 * @return 	bool 		true if the packet was an acknowledgement.
+			 */
+			bool handle_ack(const socket_address& receiver, const char* packet, size_t size) {
+				uint32_t sequence;
+				if (!read_ack(packet, size, sequence)) {
+					return false;
+				}
+				acknowledge(receiver, sequence);
+				return true;
+			}
+
+			/**
+			 * @brief 	Method remove forgets a receiver, so it is sent a keyframe if it returns.
+			 * @param 	receiver 	address of the receiver.
+			 */
+			void remove(const socket_address& receiver) {
+				receivers.erase(receiver);
+			}
+
+			/**
+			 * @brief 	Method get_sequence returns the sequence of the latest frame.
+			 * @return 	uint32_t 	sequence of the latest frame.
+			 */
+			uint32_t get_sequence() const {
+				return current_sequence;
+			}
+
+			/**
+			 * @brief 	Method get_statistics returns the counts of the packets produced so far.
+			 * @return 	delta_statistics 	copy of the counts.
+			 */
+			delta_statistics get_statistics() const {
+				return statistics;
+			}
+
+		protected:
+			/**
+			 *	@struct	receiver_state
+			 * 	@brief 	Struct receiver_state tracks what one receiver is known to hold.
+			 */
+			struct receiver_state {
+				/// Flag for if the receiver has acknowledged a frame.
+				bool acknowledged = false;
+				/// Sequence of the newest frame the receiver acknowledged.
+				uint32_t acknowledged_sequence = 0;
+				/// Flag for if the receiver has been sent a keyframe.
+				bool keyframe_sent = false;
+				/// Sequence of the last keyframe sent to the receiver.
+				uint32_t keyframe_sequence = 0;
+			};
+
+			/// Ring of the most recent frames.
+			std::vector<std::vector<char>> history;
+			/// Sequence of the frame held in each slot of the ring.
+			std::vector<uint32_t> history_sequences;
+			/// Largest number of frames between keyframes to a receiver, 0 for no limit.
+			uint32_t keyframe_interval;
+			/// Sequence of the latest frame.
+			uint32_t current_sequence = 0;
+			/// Number of frames stored so far.
+			uint64_t frame_count = 0;
+			/// What each receiver is known to hold.
+			std::unordered_map<socket_address, receiver_state, socket_address::hash> receivers;
+			/// Counts of the packets produced.
+			delta_statistics statistics;
+
+			/**
+			 * @brief 	Method acknowledged_frame finds the frame a receiver acknowledged in the ring.
+			 * @param 	state 	state of the receiver.
+			 * @return 	const std::vector<char>* 	frame, or nullptr if there is none or it has left the ring.
+			 */
+			const std::vector<char>* acknowledged_frame(const receiver_state& state) const {
+				if (!state.acknowledged || current_sequence - state.acknowledged_sequence >= history.size() ||
+					(uint64_t)(current_sequence - state.acknowledged_sequence) >= frame_count) {
+					return nullptr;
+				}
+				const size_t slot = state.acknowledged_sequence % history.size();
+				return history_sequences[slot] == state.acknowledged_sequence ? &history[slot] : nullptr;
+			}
+		};
+
+		/**************************************************************************************************/
+		/* Decoder						 																  */
+		/**************************************************************************************************/
+		/**
+		 *	@class	decoder
+		 * 	@brief 	Class decoder rebuilds the frames of one stream from the keyframes and deltas sent by an encoder.
+		 * 	@details	The decoder keeps the most recent frames it decoded in a ring, since a delta is based on the last
+		 * 				frame the encoder saw acknowledged, which may be older than the latest frame decoded. Frames older
+		 * 				than the latest are ignored. The decoder is not thread safe.
+		 */
+		class decoder {
+		public:
+			/**
+			 * @brief 	Constructor for the decoder class.
+			 * @param 	history_size 	number of recent frames kept as bases (default 32, at least 1).
+			 */
+			decoder(size_t history_size = 32) :
+				history(history_size > 0 ? history_size : 1),
+				history_sequences(history.size())
+			{}
+
+			/**
+			 * @brief 	Method decode decodes a packet produced by an encoder.
+			 * @param 	packet 		bytes of the packet.
+			 * @param 	size 		size of the packet in bytes.
+			 * @return 	bool 		true if the packet produced a new latest frame, false if it was older than the latest
+			 * 						frame or its base is no longer held, in which case the next keyframe recovers.
+			 * @throws	decode_error if the packet is malformed.
+			 */
+			bool decode(const char* packet, size_t size) {
+				if (size < DELTA_HEADER_SIZE || ((uint8_t)packet[0] != KEYFRAME && (uint8_t)packet[0] != DELTA)) {
+					throw errors::decode_error("Packet is not a delta encoded frame.");
+				}
+				const uint32_t sequence = byte_order::read_network<uint32_t>(packet + 1);
+				const uint32_t base_sequence = byte_order::read_network<uint32_t>(packet + 5);
+				const uint32_t frame_size = byte_order::read_network<uint32_t>(packet + 9);
+				if (has_frame && (int32_t)(sequence - current_sequence) <= 0) {
+					return false;
+				}
+				const char* payload = packet + DELTA_HEADER_SIZE;
+				const size_t payload_size = size - DELTA_HEADER_SIZE;
+				const size_t slot = sequence % history.size();
+				if ((uint8_t)packet[0] == KEYFRAME) {
+					if (payload_size != frame_size) {
+						throw errors::decode_error("Keyframe size does not match its header.");
+					}
+					history[slot].assign(payload, payload + payload_size);
+				}
+				else {
+					const size_t base_slot = base_sequence % history.size();
+					if (!has_frame || history_sequences[base_slot] != base_sequence || history[base_slot].size() != frame_size ||
+						(int32_t)(current_sequence - base_sequence) < 0) {
+						return false;
+					}
+					// Apply the runs to a scratch copy so a malformed delta leaves the held frames untouched.
+					scratch = history[base_slot];
+					apply_delta(payload, payload_size, scratch.data(), scratch.size());
+					history[slot].swap(scratch);
+				}
+				history_sequences[slot] = sequence;
+				current_sequence = sequence;
+				has_frame = true;
+				return true;
+			}
+
+			/**
+			 * @brief 	Method decode decodes a packet produced by an encoder.
+			 * @param 	packet 		vector of the packet's bytes.
+			 * @return 	bool 		true if the packet produced a new latest frame.
+			 * @throws	decode_error if the packet is malformed.
+			 */
+			bool decode(const std::vector<char>& packet) {
+				return decode(packet.data(), packet.size());
+			}
+
+			/**
+			 * @brief 	Method frame returns the latest decoded frame.
+			 * @return 	const std::vector<char>& 	bytes of the frame, empty before the first frame.
+			 */
+			const std::vector<char>& frame() const {
+				static const std::vector<char> empty;
+				return has_frame ? history[current_sequence % history.size()] : empty;
+			}
+
+			/**
+			 * @brief 	Method get_sequence returns the sequence of the latest decoded frame.
+			 * @return 	uint32_t 	sequence of the latest frame.
+			 */
+			uint32_t get_sequence() const {
+				return current_sequence;
+			}
+
+			/**
+			 * @brief 	Method has_decoded returns if any frame has been decoded.
+			 * @return 	bool 	true once a keyframe has been decoded.
+			 */
+			bool has_decoded() const {
+				return has_frame;
+			}
+
+			/**
+			 * @brief 	Method acknowledgement builds the acknowledgement of the latest frame to send back to the encoder.
+			 * @return 	std::vector<char> 	acknowledgement packet of DELTA_ACK_SIZE bytes.
+			 */
+			std::vector<char> acknowledgement() const {
+				std::vector<char> packet(DELTA_ACK_SIZE);
+				write_ack(current_sequence, packet.data());
+				return packet;
+			}
+
+		protected:
+			/// Ring of the most recently decoded frames.
+			std::vector<std::vector<char>> history;
+			/// Sequence of the frame held in each slot of the ring.
+			std::vector<uint32_t> history_sequences;
+			/// Sequence of the latest frame.
+			uint32_t current_sequence = 0;
+			/// Flag for if a frame has been decoded.
+			bool has_frame = false;
+			/// Buffer deltas are applied in before they replace a slot of the ring.
+			std::vector<char> scratch;
+		};
+	}
+}
+
+#endif /* DELTA_HPP */
@@ -0,0 +1,140 @@
+/**
+ * 	@file 	endpoint.hpp
+ * 	@brief 	Struct ipv4_endpoint is an IPv4 address and port that can be parsed at compile time.
+ * 	@author James Horner
+ * 	@date 	2023-04-05
+ */
+
+#ifndef ENDPOINT_HPP
+#define ENDPOINT_HPP
+
+// Standard System Libraries
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Local Libraries
+#include "errors.hpp"
+
+namespace oo_socket
+{
+	/**
+	 *	@struct	ipv4_endpoint
+	 * 	@brief 	Struct ipv4_endpoint is an IPv4 address and port held in host byte order.
+	 * 	@details	Endpoints are literal types so they can be parsed once at compile time and then passed to the send
+	 * 				methods of the socket without any further parsing.
+	 */
+	struct ipv4_endpoint {
+		/// Address in host byte order, e.g. 0x7f000001 for 127.0.0.1.
+		uint32_t address = 0;
+		/// Port in host byte order.
+		uint16_t port = 0;
+
+		/**
+		 * @brief 	Method parse parses an endpoint of the form "a.b.c.d:port".
+		 * @param 	text 			characters of the endpoint.
+		 * @param 	length 			number of characters.
+		 * @return 	ipv4_endpoint 	parsed endpoint.
+		 * @throws	configuration_error if the endpoint is invalid. In a constant expression this is a compile error.
+		 */
+		static constexpr ipv4_endpoint parse(const char* text, size_t length) {
+			ipv4_endpoint parsed;
+			size_t position = 0;
+			for (int octet = 0; octet < 4; octet++) {
+				const uint32_t value = parse_number(text, length, position, 3);
+				if (value > 255) {
+					throw errors::configuration_error("Endpoint address octet is larger than 255.");
+				}
+				parsed.address = (parsed.address << 8) | value;
+				const char separator = octet < 3 ? '.' : ':';
+				if (position >= length || text[position] != separator) {
+					throw errors::configuration_error("Endpoint must have the form a.b.c.d:port.");
+				}
+				position++;
+			}
+			const uint32_t port = parse_number(text, length, position, 5);
+			if (port == 0 || port > 65535 || position != length) {
+				throw errors::configuration_error("Endpoint port must be between 1 and 65535.");
+			}
+			parsed.port = (uint16_t)port;
+			return parsed;
+		}
+
+		/**
+		 * @brief 	Method address_string formats the address in dotted decimal notation.
+		 * @return 	std::string 	formatted address, e.g. "127.0.0.1".
+		 */
+		std::string address_string() const {
+			return std::to_string((address >> 24) & 0xff) + "." + std::to_string((address >> 16) & 0xff) + "." +
+				std::to_string((address >> 8) & 0xff) + "." + std::to_string(address & 0xff);
+		}
+
+		/**
+		 * @brief 	Method to_string formats the endpoint.
+		 * @return 	std::string 	formatted endpoint, e.g. "127.0.0.1:5000".
+		 */
+		std::string to_string() const {
+			return address_string() + ":" + std::to_string(port);
+		}
+
+		/**
+		 * @brief 	Operator == compares two endpoints.
+		 * @param 	other 	endpoint to compare with.
+		 * @return 	bool 	true if the address and port are equal.
+		 */
+		constexpr bool operator==(const ipv4_endpoint& other) const {
+			return address == other.address && port == other.port;
+		}
+
+		/**
+		 * @brief 	Operator != compares two endpoints.
+		 * @param 	other 	endpoint to compare with.
+		 * @return 	bool 	true if the address or port differ.
+		 */
+		constexpr bool operator!=(const ipv4_endpoint& other) const {
+			return !(*this == other);
+		}
+
+	private:
+		/**
+		 * @brief 	Method parse_number parses a run of decimal digits.
+		 * @param 	text 			characters being parsed.
+		 * @param 	length 			number of characters.
+		 * @param 	position[in,out]	offset of the first digit, advanced past the digits.
+		 * @param 	max_digits 		largest number of digits allowed.
+		 * @return 	uint32_t 		parsed number.
+		 * @throws	configuration_error if there are no digits or too many.
+		 */
+		static constexpr uint32_t parse_number(const char* text, size_t length, size_t& position, size_t max_digits) {
+			const size_t start = position;
+			uint32_t value = 0;
+			while (position < length && text[position] >= '0' && text[position] <= '9') {
+				if (position - start == max_digits) {
+					throw errors::configuration_error("Endpoint contains a number with too many digits.");
+				}
+				value = value * 10 + (uint32_t)(text[position] - '0');
+				position++;
+			}
+			if (position == start) {
+				throw errors::configuration_error("Endpoint must have the form a.b.c.d:port.");
+			}
+			return value;
+		}
+	};
+
+	namespace literals
+	{
+		/**
+		 * @brief 	Literal operator _ep parses an IPv4 endpoint, e.g. "10.0.0.1:5000"_ep.
+		 * @details	Assign the literal to a constexpr variable (or use it where a constant is required) to guarantee the
+		 * 			endpoint is parsed at compile time, in which case an invalid endpoint fails to compile.
+		 * @return 	ipv4_endpoint 	parsed endpoint.
+		 * @throws	configuration_error if the endpoint is invalid and the literal is evaluated at run time.
+		 */
+		constexpr ipv4_endpoint operator""_ep(const char* text, size_t length) {
+			return ipv4_endpoint::parse(text, length);
+		}
+	}
+}
+
+#endif /* ENDPOINT_HPP */
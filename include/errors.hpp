@@ -2,6 +2,7 @@
 #define SOCKET_ERRORS_HPP
 
 // C++ Standard Library Headers
+#include <cstdint>
 #include <exception>
 #include <map>
 #include <string>
@@ -15,6 +16,9 @@ namespace oo_socket {
 			CONFIGURATION_ERROR,
 			RECEIVE_ERROR,
 			SEND_ERROR,
+			ENCODE_ERROR,
+			DECODE_ERROR,
+			JOURNAL_ERROR,
 		};
 
 		class socket_error : public std::exception {
@@ -63,6 +67,33 @@ namespace oo_socket {
 			}
 			virtual const codes code() override {return codes::SEND_ERROR;}
 		};
+
+		class encode_error : public socket_error {
+		public:
+			encode_error(std::string additional_message = "")
+			{
+				message = "Could not encode message:\n" + additional_message;
+			}
+			virtual const codes code() override {return codes::ENCODE_ERROR;}
+		};
+
+		class decode_error : public socket_error {
+		public:
+			decode_error(std::string additional_message = "")
+			{
+				message = "Could not decode message:\n" + additional_message;
+			}
+			virtual const codes code() override {return codes::DECODE_ERROR;}
+		};
+
+		class journal_error : public socket_error {
+		public:
+			journal_error(std::string additional_message = "")
+			{
+				message = "Error occurred in journal:\n" + additional_message;
+			}
+			virtual const codes code() override {return codes::JOURNAL_ERROR;}
+		};
 	}
 }
 
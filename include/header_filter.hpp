@@ -0,0 +1,304 @@
+/**
+ * 	@file 	header_filter.hpp
+ * 	@brief 	Class header_filter accepts or rejects a batch of received datagrams by the first bytes of each.
+ * 	@author James Horner
+ * 	@date 	2023-04-05
+ */
+
+#ifndef HEADER_FILTER_HPP
+#define HEADER_FILTER_HPP
+
+// Standard System Libraries
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Platform Specific System Libraries
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+// Local Libraries
+#include "byte_order.hpp"
+#include "datagram.hpp"
+#include "errors.hpp"
+
+/// Macro for the number of leading bytes of each datagram the filter can match on.
+#define HEADER_FILTER_SIZE 16
+
+namespace oo_socket
+{
+	/**
+	 *	@class	header_filter
+	 * 	@brief 	Class header_filter matches the first HEADER_FILTER_SIZE bytes of received datagrams against fixed
+	 * 			values, such as a magic number and version, and a set of allowed message types.
+	 * 	@details	The fixed values are held as a 16 byte value and mask so every datagram is checked with one masked
+	 * 				compare, two datagrams at a time with AVX2, or one at a time with SSE2 or NEON, when the compiler
+	 * 				targets those instruction sets, and as two 64 bit compares otherwise. The allowed types are a 256 bit
+	 * 				set looked up by the type byte. filter writes the indices of the accepted datagrams without
+	 * 				branching on the result, so a batch of rejections costs no mispredictions. Datagrams shorter than
+	 * 				the last byte matched are rejected. Configure the filter before sharing it, filtering is const and
+	 * 				thread safe.
+	 */
+	class header_filter {
+	public:
+		/**
+		 * @brief 	Constructor for the header_filter class which accepts every datagram until rules are added.
+		 */
+		header_filter() {
+			std::memset(value, 0, sizeof(value));
+			std::memset(mask, 0, sizeof(mask));
+			std::memset(allowed_types, 0xff, sizeof(allowed_types));
+		}
+
+		/**
+		 * @brief 	Method match requires bytes of the header to equal the given bytes, adding to earlier rules for them.
+		 * @details	The selected bits take the new values, and bits that earlier rules selected but these do not stay
+		 * 			required, so rules on different bits of a byte combine.
+		 * @param 	offset 	position of the first byte in the datagram.
+		 * @param 	bytes 	bytes the header must hold.
+		 * @param 	count 	number of bytes.
+		 * @param 	bits 	mask of the bits of each byte that must match, nullptr for every bit (default nullptr).
+		 * @return 	header_filter& 	the filter, so rules can be chained.
+		 * @throws	configuration_error if the bytes extend past HEADER_FILTER_SIZE.
+		 */
+		header_filter& match(size_t offset, const char* bytes, size_t count, const char* bits = nullptr) {
+			check_extent(offset, count);
+			uint8_t* masked = mask + offset;
+			uint8_t* required = value + offset;
+			for (size_t i = 0; i < count; i++) {
+				const uint8_t selected = bits == nullptr ? 0xff : (uint8_t)bits[i];
+				masked[i] |= selected;
+				required[i] = (uint8_t)((required[i] & ~selected) | ((uint8_t)bytes[i] & selected));
+			}
+			update_required_size();
+			return *this;
+		}
+
+		/**
+		 * @brief 	Method match_value requires an integer field of the header to equal a value in network byte order.
+		 * @param 	offset 	position of the field in the datagram.
+		 * @param 	field 	value of the field, whose type sets its size.
+		 * @return 	header_filter& 	the filter, so rules can be chained.
+		 * @throws	configuration_error if the field extends past HEADER_FILTER_SIZE.
+		 */
+		template <typename T>
+		header_filter& match_value(size_t offset, T field) {
+			static_assert(std::is_integral<T>::value, "Header fields are matched as integers.");
+			char bytes[sizeof(T)];
+			byte_order::write_network(field, bytes);
+			return match(offset, bytes, sizeof(T));
+		}
+
+		/**
+		 * @brief 	Method match_types requires a byte of the header, such as a message type, to be one of a set of values.
+		 * @param 	offset 	position of the byte in the datagram.
+		 * @param 	types 	values the byte may hold.
+		 * @return 	header_filter& 	the filter, so rules can be chained.
+		 * @throws	configuration_error if the byte is past HEADER_FILTER_SIZE.
+		 * @note	Only one byte can be matched against a set, a later call replaces the earlier set.
+		 */
+		header_filter& match_types(size_t offset, std::initializer_list<uint8_t> types) {
+			return match_types(offset, std::vector<uint8_t>(types));
+		}
+
+		/**
+		 * @brief 	Method match_types requires a byte of the header, such as a message type, to be one of a set of values.
+		 * @param 	offset 	position of the byte in the datagram.
+		 * @param 	types 	values the byte may hold.
+		 * @return 	header_filter& 	the filter, so rules can be chained.
+		 * @throws	configuration_error if the byte is past HEADER_FILTER_SIZE.
+		 * @note	Only one byte can be matched against a set, a later call replaces the earlier set.
+		 */
+		header_filter& match_types(size_t offset, const std::vector<uint8_t>& types) {
+			check_extent(offset, 1);
+			type_offset = offset;
+			std::memset(allowed_types, 0, sizeof(allowed_types));
+			for (uint8_t type : types) {
+				allowed_types[type >> 6] |= 1ULL << (type & 63);
+			}
+			update_required_size();
+			return *this;
+		}
+
+		/**
+		 * @brief 	Method set_minimum_size rejects datagrams shorter than a size, even if they hold every byte matched.
+		 * @param 	size 	smallest size accepted in bytes.
+		 * @return 	header_filter& 	the filter, so rules can be chained.
+		 */
+		header_filter& set_minimum_size(size_t size) {
+			minimum_size = size;
+			update_required_size();
+			return *this;
+		}
+
+		/**
+		 * @brief 	Method accepts checks a single datagram.
+		 * @param 	datagram 	bytes of the datagram.
+		 * @param 	size 		size of the datagram in bytes.
+		 * @return 	bool 		true if the datagram passes every rule.
+		 */
+		bool accepts(const char* datagram, size_t size) const {
+			uint8_t header[HEADER_FILTER_SIZE] = {};
+			std::memcpy(header, datagram, size < HEADER_FILTER_SIZE ? size : HEADER_FILTER_SIZE);
+			for (size_t i = 0; i < HEADER_FILTER_SIZE; i++) {
+				if ((header[i] & mask[i]) != value[i]) {
+					return false;
+				}
+			}
+			return size >= required_size && type_allowed(header);
+		}
+
+		/**
+		 * @brief 	Method filter checks a batch of received datagrams and lists the accepted ones.
+		 * @param 	datagrams 		datagrams filled by udp::socket::receive_batch.
+		 * @param 	count 			number of datagrams that were received.
+		 * @param 	accepted[out] 	indices of the accepted datagrams in order, with room for count indices.
+		 * @return 	size_t 			number of datagrams accepted.
+		 */
+		size_t filter(const incoming_datagram* datagrams, size_t count, uint32_t* accepted) const {
+			const size_t required = required_size;
+			size_t kept = 0;
+			size_t index = 0;
+#if defined(__AVX2__)
+			const __m256i masks = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)mask));
+			const __m256i values = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)value));
+			uint8_t padded[2][HEADER_FILTER_SIZE];
+			for (; index + 2 <= count; index += 2) {
+				const uint8_t* first = header_of(datagrams[index], padded[0]);
+				const uint8_t* second = header_of(datagrams[index + 1], padded[1]);
+				const __m256i headers = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)first)), _mm_loadu_si128((const __m128i*)second), 1);
+				const uint32_t equal = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(headers, masks), values));
+				accepted[kept] = (uint32_t)index;
+				kept += (size_t)((equal & 0xffff) == 0xffff) & (size_t)(datagrams[index].size >= required) & (size_t)type_allowed(first);
+				accepted[kept] = (uint32_t)(index + 1);
+				kept += (size_t)((equal >> 16) == 0xffff) & (size_t)(datagrams[index + 1].size >= required) & (size_t)type_allowed(second);
+			}
+#endif
+			uint8_t padded_single[HEADER_FILTER_SIZE];
+			for (; index < count; index++) {
+				const uint8_t* header = header_of(datagrams[index], padded_single);
+				accepted[kept] = (uint32_t)index;
+				kept += (size_t)header_matches(header) & (size_t)(datagrams[index].size >= required) & (size_t)type_allowed(header);
+			}
+			return kept;
+		}
+
+		/**
+		 * @brief 	Method filter checks a batch of received datagrams and lists the accepted ones.
+		 * @param 	datagrams 		datagrams filled by udp::socket::receive_batch.
+		 * @param 	count 			number of datagrams that were received.
+		 * @param 	accepted[out] 	indices of the accepted datagrams in order, resized to the number accepted.
+		 * @return 	size_t 			number of datagrams accepted.
+		 */
+		size_t filter(const std::vector<incoming_datagram>& datagrams, size_t count, std::vector<uint32_t>& accepted) const {
+			count = count < datagrams.size() ? count : datagrams.size();
+			accepted.resize(count);
+			const size_t kept = filter(datagrams.data(), count, accepted.data());
+			accepted.resize(kept);
+			return kept;
+		}
+
+	private:
+		/// Bytes the masked header must equal.
+		alignas(16) uint8_t value[HEADER_FILTER_SIZE];
+		/// Bits of each header byte that are matched.
+		alignas(16) uint8_t mask[HEADER_FILTER_SIZE];
+		/// Set of values allowed at the type offset, every value until match_types is called.
+		uint64_t allowed_types[4];
+		/// Position of the byte matched against the allowed types.
+		size_t type_offset = 0;
+		/// Smallest size accepted in bytes, in addition to the bytes matched.
+		size_t minimum_size = 0;
+		/// Larger of the minimum size and the end of the last byte matched.
+		size_t required_size = 0;
+
+		/**
+		 * @brief 	Method check_extent throws if bytes of a rule extend past the matched header.
+		 * @param 	offset 	position of the first byte.
+		 * @param 	count 	number of bytes.
+		 * @throws	configuration_error if the bytes extend past HEADER_FILTER_SIZE.
+		 */
+		static void check_extent(size_t offset, size_t count) {
+			if (offset > HEADER_FILTER_SIZE || count > HEADER_FILTER_SIZE - offset) {
+				throw errors::configuration_error("Header filters match the first " + std::to_string(HEADER_FILTER_SIZE) + " bytes of a datagram.");
+			}
+		}
+
+		/**
+		 * @brief 	Method update_required_size finds the smallest size a datagram must have to be accepted.
+		 */
+		void update_required_size() {
+			size_t required = minimum_size;
+			for (size_t i = 0; i < HEADER_FILTER_SIZE; i++) {
+				if (mask[i] != 0 && i + 1 > required) {
+					required = i + 1;
+				}
+			}
+			if (allowed_types[0] != ~0ULL || allowed_types[1] != ~0ULL || allowed_types[2] != ~0ULL || allowed_types[3] != ~0ULL) {
+				required = type_offset + 1 > required ? type_offset + 1 : required;
+			}
+			required_size = required;
+		}
+
+		/**
+		 * @brief 	Method header_of returns the header of a datagram, copied into a padded buffer if the datagram's
+		 * 			buffer is too small to load HEADER_FILTER_SIZE bytes from.
+		 * @param 	datagram 	received datagram.
+		 * @param 	padded 		buffer of HEADER_FILTER_SIZE bytes to copy short buffers into.
+		 * @return 	const uint8_t* 	HEADER_FILTER_SIZE readable bytes, those past the datagram's size are never accepted
+		 * 							since the required size covers every matched byte.
+		 */
+		static const uint8_t* header_of(const incoming_datagram& datagram, uint8_t* padded) {
+			if (datagram.capacity >= HEADER_FILTER_SIZE) {
+				return (const uint8_t*)datagram.buffer;
+			}
+			std::memset(padded, 0, HEADER_FILTER_SIZE);
+			std::memcpy(padded, datagram.buffer, datagram.size < HEADER_FILTER_SIZE ? datagram.size : HEADER_FILTER_SIZE);
+			return padded;
+		}
+
+		/**
+		 * @brief 	Method header_matches compares a header against the masked value.
+		 * @param 	header 	HEADER_FILTER_SIZE bytes of the header.
+		 * @return 	bool 	true if every masked bit matches.
+		 */
+		bool header_matches(const uint8_t* header) const {
+#if defined(__AVX2__) || defined(__SSE2__)
+			const __m128i masked = _mm_and_si128(_mm_loadu_si128((const __m128i*)header), _mm_load_si128((const __m128i*)mask));
+			return _mm_movemask_epi8(_mm_cmpeq_epi8(masked, _mm_load_si128((const __m128i*)value))) == 0xffff;
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+			const uint8x16_t masked = vandq_u8(vld1q_u8(header), vld1q_u8(mask));
+			return vminvq_u8(vceqq_u8(masked, vld1q_u8(value))) == 0xff;
+#else
+			uint64_t words[2];
+			uint64_t masks[2];
+			uint64_t values[2];
+			std::memcpy(words, header, sizeof(words));
+			std::memcpy(masks, mask, sizeof(masks));
+			std::memcpy(values, value, sizeof(values));
+			return ((words[0] & masks[0]) == values[0]) & ((words[1] & masks[1]) == values[1]);
+#endif
+		}
+
+		/**
+		 * @brief 	Method type_allowed looks up the type byte of a header in the allowed set.
+		 * @param 	header 	HEADER_FILTER_SIZE bytes of the header.
+		 * @return 	bool 	true if the type is allowed.
+		 */
+		bool type_allowed(const uint8_t* header) const {
+			const uint8_t type = header[type_offset];
+			return (allowed_types[type >> 6] >> (type & 63)) & 1;
+		}
+	};
+}
+
+#endif /* HEADER_FILTER_HPP */
@@ -0,0 +1,81 @@
+/**
+ * 	@file 	icmp_error.hpp
+ * 	@brief 	Structs describing ICMP errors read from a socket's error queue.
+ * 	@author James Horner
+ * 	@date 	2023-04-05
+ */
+
+#ifndef ICMP_ERROR_HPP
+#define ICMP_ERROR_HPP
+
+// Standard System Libraries
+#include <cstdint>
+#include <string>
+
+namespace oo_socket
+{
+	/// Classification of an error reported for a datagram that was sent.
+	enum class icmp_error_type : uint8_t
+	{
+		NETWORK_UNREACHABLE = 0,
+		HOST_UNREACHABLE,
+		PROTOCOL_UNREACHABLE,
+		PORT_UNREACHABLE,
+		FRAGMENTATION_NEEDED,
+		ADMINISTRATIVELY_PROHIBITED,
+		TIME_EXCEEDED,
+		LOCAL_ERROR,
+		OTHER,
+	};
+
+	/**
+	 *	@struct	icmp_error
+	 * 	@brief 	Struct icmp_error holds a single error read from the socket error queue.
+	 */
+	struct icmp_error {
+		/// Classification of the error.
+		icmp_error_type type;
+		/// ICMP type of the message, 0 for errors raised locally.
+		uint8_t icmp_type;
+		/// ICMP code of the message, 0 for errors raised locally.
+		uint8_t icmp_code;
+		/// Error number the kernel associates with the error.
+		int error_code;
+		/// Address the failed datagram was sent to.
+		std::string destination_address;
+		/// Port the failed datagram was sent to.
+		uint16_t destination_port;
+		/// Address of the host that reported the error, empty for errors raised locally.
+		std::string reporter_address;
+		/// Next hop MTU for fragmentation needed errors, 0 otherwise.
+		uint32_t mtu;
+		/// Time the error was read from the queue in nanoseconds on the steady clock.
+		uint64_t timestamp_ns;
+	};
+
+	/**
+	 *	@struct	destination_health
+	 * 	@brief 	Struct destination_health summarizes the errors reported for a single destination.
+	 */
+	struct destination_health {
+		/// Number of errors reported for the destination.
+		uint64_t error_count;
+		/// Most recent error reported for the destination.
+		icmp_error last_error;
+		/// Flag for if the last error means datagrams cannot currently reach the destination.
+		bool unreachable;
+	};
+
+	/**
+	 * @brief 	Function is_unreachable returns whether an error means datagrams cannot reach their destination.
+	 * @param 	type 	classification of the error.
+	 * @return 	bool 	true for unreachable and prohibited destinations, false for transient errors.
+	 */
+	inline bool is_unreachable(icmp_error_type type) {
+		return type == icmp_error_type::NETWORK_UNREACHABLE || type == icmp_error_type::HOST_UNREACHABLE ||
+			type == icmp_error_type::PROTOCOL_UNREACHABLE || type == icmp_error_type::PORT_UNREACHABLE ||
+			type == icmp_error_type::ADMINISTRATIVELY_PROHIBITED;
+	}
+}
+
+#endif /* ICMP_ERROR_HPP */
@@ -0,0 +1,566 @@
+/**
+ * 	@file 	impairment.hpp
+ * 	@brief 	Class impaired_socket wraps a UDP socket and injects loss, delay, duplication and reordering.
+ * 	@author James Horner
+ * 	@date 	2023-04-05
+ */
+
+#ifndef IMPAIRMENT_HPP
+#define IMPAIRMENT_HPP
+
+// Standard System Libraries
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Platform Specific System Libraries
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <poll.h>
+#endif
+
+#include "errors.hpp"
+#include "trace.hpp"
+#include "udp_socket.hpp"
+
+namespace oo_socket
+{
+	/**
+	 *	@struct	impairment_profile
+	 * 	@brief 	Struct impairment_profile configures the impairments applied to one direction of traffic.
+	 * 	@details	Loss is applied first, then each surviving datagram is delayed by the base delay plus a uniformly
+	 * 				distributed jitter, plus the reorder delay if it is chosen for reordering, and finally queued
+	 * 				behind earlier datagrams if the bandwidth cap is exceeded. Duplicates follow the same path.
+	 */
+	struct impairment_profile {
+		/// Probability of dropping each datagram (Bernoulli loss), used when gilbert_elliott is false.
+		double loss_probability = 0.0;
+
+		/// Flag for if the two state Gilbert-Elliott loss model is used instead of Bernoulli loss.
+		bool gilbert_elliott = false;
+		/// Probability of moving from the good state to the bad state before each datagram.
+		double good_to_bad_probability = 0.0;
+		/// Probability of moving from the bad state to the good state before each datagram.
+		double bad_to_good_probability = 1.0;
+		/// Probability of dropping a datagram in the good state.
+		double good_loss_probability = 0.0;
+		/// Probability of dropping a datagram in the bad state.
+		double bad_loss_probability = 1.0;
+
+		/// Delay added to every datagram in microseconds.
+		uint64_t delay_us = 0;
+		/// Maximum jitter in microseconds, each datagram's delay is changed by a uniform value in [-jitter, +jitter].
+		uint64_t jitter_us = 0;
+
+		/// Probability of sending a second copy of each datagram.
+		double duplicate_probability = 0.0;
+
+		/// Probability of holding a datagram back so that later datagrams overtake it.
+		double reorder_probability = 0.0;
+		/// Additional delay in microseconds applied to datagrams that are reordered.
+		uint64_t reorder_delay_us = 1000;
+
+		/// Maximum throughput in bits per second, 0 for no limit.
+		uint64_t bandwidth_bps = 0;
+
+		/// Maximum number of datagrams held back at once, further delayed datagrams are dropped as if the link queue
+		/// overflowed.
+		size_t queue_limit = 4096;
+	};
+
+	/**
+	 *	@struct	impairment_statistics
+	 * 	@brief 	Struct impairment_statistics counts what the impairments did to one direction of traffic.
+	 */
+	struct impairment_statistics {
+		/// Number of datagrams offered to the impairments.
+		uint64_t packets = 0;
+		/// Number of datagrams dropped.
+		uint64_t dropped = 0;
+		/// Number of duplicate datagrams created.
+		uint64_t duplicated = 0;
+		/// Number of datagrams held back for reordering.
+		uint64_t reordered = 0;
+		/// Number of datagrams that were delayed by the delay, jitter or bandwidth cap.
+		uint64_t delayed = 0;
+		/// Number of delayed sends that failed on the underlying socket.
+		uint64_t send_errors = 0;
+		/// Number of datagrams dropped because queue_limit datagrams were already held.
+		uint64_t overflowed = 0;
+	};
+
+	/**
+	 *	@class	impaired_socket
+	 * 	@brief 	Class impaired_socket wraps a UDP socket and injects loss, delay, duplication and reordering.
+	 * 	@details	Impairments are applied independently to sent and received datagrams, each direction driven by its own
+	 * 				seeded random number generator so that runs are reproducible regardless of how sends and receives
+	 * 				interleave. Delayed sends are released by a background thread, delayed receives are held until
+	 * 				they are due by the receiving thread. The wrapped socket must outlive the impaired socket.
+	 */
+	class impaired_socket {
+	public:
+		/**************************************************************************************************/
+		/* Non-Static Methods			 																  */
+		/**************************************************************************************************/
+
+		/**
+		 * @brief 	Constructor for the impaired_socket class.
+		 * @param 	inner 			socket that datagrams are sent and received with.
+		 * @param 	send_profile 	impairments applied to sent datagrams.
+		 * @param 	receive_profile impairments applied to received datagrams.
+		 * @param 	seed 			seed of the random number generators (default 1).
+		 */
+		impaired_socket(udp::socket& inner, impairment_profile send_profile, impairment_profile receive_profile, uint64_t seed = 1) :
+			inner_socket(inner),
+			send_direction(send_profile, seed),
+			receive_direction(receive_profile, seed ^ 0x9E3779B97F4A7C15ULL)
+		{
+			release_thread = std::thread([this]() { release_sends(); });
+		}
+
+		/**
+		 * 	@brief 	Destructor for the impaired_socket class which discards any datagrams still delayed.
+		 */
+		~impaired_socket() {
+			{
+				std::unique_lock<std::mutex> send_lock(send_mutex);
+				stopping = true;
+			}
+			send_condition.notify_all();
+			release_thread.join();
+		}
+
+		/**************************************************************************************************/
+		/* Send/Receive Methods			 																  */
+		/**************************************************************************************************/
+		/**
+		 * @brief 	Method send_to sends a buffer of bytes to a specified remote host through the impairments.
+		 * @param 	buffer		pointer to buffer of bytes to send to the remote host.
+		 * @param 	buffer_size	size of buffer in bytes.
+		 * @param 	port 		unsigned short port number to send the packet to.
+		 * @param 	address 	string representation of the address of the remote host (default loopback).
+		 * @return 	int 		number of bytes accepted, which is the buffer size even if the datagram is dropped.
+		 * @throws	send_error if a datagram sent without delay could not be sent.
+		 */
+		int send_to(const char* buffer, const size_t buffer_size, const unsigned short port, const std::string address = "127.0.0.1") {
+			return impair_send(buffer, buffer_size, port, address, false);
+		}
+
+		/**
+		 * @brief 	Method send_to sends a vector to a specified remote host through the impairments.
+		 * @param 	buffer	vector of bytes to send to the remote host.
+		 * @param 	port 	unsigned short port number to send the packet to.
+		 * @param 	address string representation of the address of the remote host (default loopback).
+		 * @return 	int 	number of bytes accepted.
+		 * @throws	send_error if a datagram sent without delay could not be sent.
+		 */
+		template <typename T>
+		int send_to(const std::vector<T>& buffer, const unsigned short port, const std::string address = "127.0.0.1") {
+			return impair_send(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(T), port, address, false);
+		}
+
+		/**
+		 * @brief 	Method send sends a buffer of bytes to the remote host pre-configured on the wrapped socket.
+		 * @param 	buffer		pointer to buffer of bytes to send to the remote host.
+		 * @param 	buffer_size	size of buffer in bytes.
+		 * @return 	int 		number of bytes accepted.
+		 * @throws	send_error if a datagram sent without delay could not be sent.
+		 */
+		int send(const char* buffer, const size_t buffer_size) {
+			return impair_send(buffer, buffer_size, 0, std::string(), true);
+		}
+
+		/**
+		 * @brief 	Method send sends a vector to the remote host pre-configured on the wrapped socket.
+		 * @param 	buffer	vector of bytes to send to the remote host.
+		 * @return 	int 	number of bytes accepted.
+		 * @throws	send_error if a datagram sent without delay could not be sent.
+		 */
+		template <typename T>
+		int send(const std::vector<T>& buffer) {
+			return impair_send(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(T), 0, std::string(), true);
+		}
+
+		/**
+		 * @brief 	Method receive receives a datagram that has passed through the impairments.
+		 * @param 	buffer[out] 			buffer that will store the incoming packet.
+		 * @param 	buffer_size[in]			size of the buffer.
+		 * @param 	source_address[out] 	pointer to string to store the source address of the packet (default nullptr).
+		 * @param 	source_port[out]		pointer to uint16_t to store the source port of the packet (default nullptr).
+		 * @return 	int						number of bytes received, 0 if the wrapped socket's receive timed out.
+		 * @throws	receive_error if an error occurred while receiving the data.
+		 */
+		int receive(char* buffer, const uint16_t buffer_size, std::string* source_address = nullptr, uint16_t* source_port = nullptr) {
+			std::unique_lock<std::mutex> receive_lock(receive_mutex);
+			char incoming[MAX_RECEIVE_BUFFER_SIZE];
+			while (true) {
+				// Deliver the earliest held datagram once it is due.
+				const uint64_t now = trace::now_ns();
+				if (!held_receives.empty() && held_receives.top().release_ns <= now) {
+					const held_datagram& due = held_receives.top();
+					const int copy_size = (int)std::min(due.data.size(), (size_t)buffer_size);
+					::memcpy(buffer, due.data.data(), copy_size);
+					if (source_address != nullptr && source_port != nullptr) {
+						*source_address = due.address;
+						*source_port = due.port;
+					}
+					held_receives.pop();
+					return copy_size;
+				}
+
+				// When datagrams are held only wait until the earliest is due, otherwise use the socket's own timeout.
+				if (!held_receives.empty() && !wait_readable(held_receives.top().release_ns - now)) {
+					continue;
+				}
+
+				std::string address;
+				uint16_t port = 0;
+				int receive_size = inner_socket.receive(incoming, sizeof(incoming), &address, &port);
+				if (receive_size == 0 && held_receives.empty()) {
+					return 0;
+				}
+				if (receive_size > 0) {
+					impair_receive(incoming, (size_t)receive_size, address, port);
+				}
+			}
+		}
+
+		/**
+		 * @brief 	Method receive receives a datagram that has passed through the impairments as a vector.
+		 * @param 	source_address[out] 	pointer to string to store the source address of the packet (default nullptr).
+		 * @param 	source_port[out]		pointer to uint16_t to store the source port of the packet (default nullptr).
+		 * @return 	std::vector<T>			bytes that were received, empty if the wrapped socket's receive timed out.
+		 * @throws	receive_error if an error occurred while receiving the data or its size is not a whole number of T.
+		 */
+		template <typename T = char>
+		std::vector<T> receive(std::string* source_address = nullptr, uint16_t* source_port = nullptr) {
+			char buffer[MAX_RECEIVE_BUFFER_SIZE];
+			int receive_size = receive(buffer, sizeof(buffer), source_address, source_port);
+			if (receive_size % sizeof(T) != 0) {
+				throw errors::receive_error("Received " + std::to_string(receive_size) + " bytes which is not a multiple of the " + std::to_string(sizeof(T)) + " byte element size.");
+			}
+			std::vector<T> data(receive_size / sizeof(T));
+			::memcpy(data.data(), buffer, data.size() * sizeof(T));
+			return data;
+		}
+
+		/**************************************************************************************************/
+		/* Configuration Methods		 																  */
+		/**************************************************************************************************/
+		/**
+		 * @brief 	Method flush waits until every delayed send has been released.
+		 */
+		void flush() {
+			std::unique_lock<std::mutex> send_lock(send_mutex);
+			send_condition.wait(send_lock, [this]() { return (held_sends.empty() && releasing == 0) || stopping; });
+		}
+
+		/**
+		 * @brief 	Method get_send_statistics returns what the impairments have done to sent datagrams.
+		 * @return 	impairment_statistics 	counts for the send direction.
+		 */
+		impairment_statistics get_send_statistics() {
+			std::unique_lock<std::mutex> send_lock(send_mutex);
+			return send_direction.counts;
+		}
+
+		/**
+		 * @brief 	Method get_receive_statistics returns what the impairments have done to received datagrams.
+		 * @return 	impairment_statistics 	counts for the receive direction.
+		 */
+		impairment_statistics get_receive_statistics() {
+			std::unique_lock<std::mutex> receive_lock(receive_mutex);
+			return receive_direction.counts;
+		}
+
+	protected:
+		/**
+		 *	@struct	held_datagram
+		 * 	@brief 	Struct held_datagram holds a datagram until its release time.
+		 */
+		struct held_datagram {
+			/// Time the datagram should be released.
+			uint64_t release_ns;
+			/// Order the datagram was held in, so datagrams with equal release times keep their order.
+			uint64_t order;
+			/// Contents of the datagram.
+			std::vector<char> data;
+			/// Address of the remote host.
+			std::string address;
+			/// Port of the remote host.
+			uint16_t port;
+			/// Flag for if the datagram is sent to the wrapped socket's pre-configured remote host.
+			bool use_remote;
+
+			/// Comparison that makes the priority queue return the earliest datagram first.
+			bool operator>(const held_datagram& other) const {
+				return release_ns != other.release_ns ? release_ns > other.release_ns : order > other.order;
+			}
+		};
+
+		/// Queue of held datagrams ordered by release time.
+		using held_queue = std::priority_queue<held_datagram, std::vector<held_datagram>, std::greater<held_datagram>>;
+
+		/**
+		 *	@struct	direction
+		 * 	@brief 	Struct direction holds the configuration and state of the impairments for one direction.
+		 */
+		struct direction {
+			direction(const impairment_profile& configuration, uint64_t seed) : profile(configuration), generator(seed) {}
+
+			/// Impairments applied to the direction.
+			impairment_profile profile;
+			/// Random number generator of the direction.
+			std::mt19937_64 generator;
+			/// Flag for if the Gilbert-Elliott model is in the bad state.
+			bool bad_state = false;
+			/// Time the bandwidth cap allows the next datagram to leave.
+			uint64_t next_free_ns = 0;
+			/// Counter used to order held datagrams.
+			uint64_t next_order = 0;
+			/// Counts of what the impairments did.
+			impairment_statistics counts;
+
+			/**
+			 * @brief 	Method uniform returns a uniform value in [0, 1) computed the same way on every platform.
+			 * @return 	double 	random value.
+			 */
+			double uniform() {
+				return (double)(generator() >> 11) * (1.0 / 9007199254740992.0);
+			}
+
+			/**
+			 * @brief 	Method should_drop decides whether the next datagram is lost.
+			 * @return 	bool 	true if the datagram should be dropped.
+			 */
+			bool should_drop() {
+				if (!profile.gilbert_elliott) {
+					return profile.loss_probability > 0.0 && uniform() < profile.loss_probability;
+				}
+				// Move between states before deciding the loss so bursts start with the transition.
+				if (bad_state) {
+					bad_state = uniform() >= profile.bad_to_good_probability;
+				}
+				else {
+					bad_state = uniform() < profile.good_to_bad_probability;
+				}
+				return uniform() < (bad_state ? profile.bad_loss_probability : profile.good_loss_probability);
+			}
+
+			/**
+			 * @brief 	Method release_time decides when a datagram leaves the impairments.
+			 * @param 	now_ns 		current time.
+			 * @param 	size 		size of the datagram in bytes.
+			 * @return 	uint64_t 	time the datagram should be released.
+			 */
+			uint64_t release_time(uint64_t now_ns, size_t size) {
+				int64_t delay_ns = (int64_t)profile.delay_us * 1000;
+				if (profile.jitter_us > 0) {
+					delay_ns += (int64_t)((uniform() * 2.0 - 1.0) * (double)profile.jitter_us * 1000.0);
+				}
+				if (profile.reorder_probability > 0.0 && uniform() < profile.reorder_probability) {
+					delay_ns += (int64_t)profile.reorder_delay_us * 1000;
+					counts.reordered++;
+				}
+				uint64_t release_ns = now_ns + (uint64_t)std::max<int64_t>(delay_ns, 0);
+
+				// The bandwidth cap serializes datagrams, each occupying the link for its transmission time.
+				if (profile.bandwidth_bps > 0) {
+					const uint64_t start_ns = std::max(release_ns, next_free_ns);
+					next_free_ns = start_ns + (uint64_t)((double)size * 8.0 * 1e9 / (double)profile.bandwidth_bps);
+					release_ns = start_ns;
+				}
+				if (release_ns > now_ns) {
+					counts.delayed++;
+				}
+				return release_ns;
+			}
+		};
+
+		/// Socket that datagrams are sent and received with.
+		udp::socket& inner_socket;
+
+		/// Impairments of sent datagrams.
+		direction send_direction;
+		/// Sent datagrams waiting to be released.
+		held_queue held_sends;
+		/// Mutex to control access to the send direction.
+		std::mutex send_mutex;
+		/// Condition used to wake the release thread.
+		std::condition_variable send_condition;
+		/// Thread that releases delayed sends.
+		std::thread release_thread;
+		/// Flag for if the release thread should stop.
+		bool stopping = false;
+		/// Number of due datagrams taken from the queue by the release thread that are still being sent.
+		size_t releasing = 0;
+
+		/// Impairments of received datagrams.
+		direction receive_direction;
+		/// Received datagrams waiting to be delivered.
+		held_queue held_receives;
+		/// Mutex to control access to the receive direction.
+		std::mutex receive_mutex;
+
+		/**
+		 * @brief 	Method impair_send applies the send impairments to a datagram.
+		 * @param 	buffer		pointer to buffer of bytes to send.
+		 * @param 	buffer_size	size of buffer in bytes.
+		 * @param 	port 		port of the remote host.
+		 * @param 	address 	address of the remote host.
+		 * @param 	use_remote 	true to send to the wrapped socket's pre-configured remote host.
+		 * @return 	int 		number of bytes accepted.
+		 * @throws	send_error if a datagram sent without delay could not be sent.
+		 */
+		int impair_send(const char* buffer, const size_t buffer_size, const unsigned short port, const std::string& address, bool use_remote) {
+			int immediate = 0;
+			{
+				std::unique_lock<std::mutex> send_lock(send_mutex);
+				send_direction.counts.packets++;
+				if (send_direction.should_drop()) {
+					send_direction.counts.dropped++;
+					return (int)buffer_size;
+				}
+
+				const int copies = send_direction.profile.duplicate_probability > 0.0 && send_direction.uniform() < send_direction.profile.duplicate_probability ? 2 : 1;
+				send_direction.counts.duplicated += copies - 1;
+				const uint64_t now = trace::now_ns();
+				for (int copy = 0; copy < copies; copy++) {
+					const uint64_t release_ns = send_direction.release_time(now, buffer_size);
+					// Datagrams that are not delayed skip the queue and are sent on the calling thread.
+					if (release_ns <= now) {
+						immediate++;
+					}
+					else if (held_sends.size() >= send_direction.profile.queue_limit) {
+						send_direction.counts.overflowed++;
+					}
+					else {
+						held_sends.push(held_datagram{release_ns, send_direction.next_order++, std::vector<char>(buffer, buffer + buffer_size), address, port, use_remote});
+					}
+				}
+			}
+			send_condition.notify_all();
+
+			// The real sends happen without the lock so they never stall the release thread or other senders.
+			for (int copy = 0; copy < immediate; copy++) {
+				send_datagram(buffer, buffer_size, port, address, use_remote);
+			}
+			return (int)buffer_size;
+		}
+
+		/**
+		 * @brief 	Method send_datagram sends a datagram with the wrapped socket.
+		 * @param 	buffer		pointer to buffer of bytes to send.
+		 * @param 	buffer_size	size of buffer in bytes.
+		 * @param 	port 		port of the remote host.
+		 * @param 	address 	address of the remote host.
+		 * @param 	use_remote 	true to send to the wrapped socket's pre-configured remote host.
+		 * @throws	send_error if the datagram could not be sent.
+		 */
+		void send_datagram(const char* buffer, const size_t buffer_size, const unsigned short port, const std::string& address, bool use_remote) {
+			if (use_remote) {
+				inner_socket.send(buffer, buffer_size);
+			}
+			else {
+				inner_socket.send_to(buffer, buffer_size, port, address);
+			}
+		}
+
+		/**
+		 * @brief 	Method impair_receive applies the receive impairments to a datagram and holds the survivors.
+		 * @param 	buffer		pointer to the received bytes.
+		 * @param 	buffer_size	number of bytes received.
+		 * @param 	address 	address of the source.
+		 * @param 	port 		port of the source.
+		 * @note	The caller must hold the receive mutex.
+		 */
+		void impair_receive(const char* buffer, const size_t buffer_size, const std::string& address, uint16_t port) {
+			receive_direction.counts.packets++;
+			if (receive_direction.should_drop()) {
+				receive_direction.counts.dropped++;
+				return;
+			}
+			const int copies = receive_direction.profile.duplicate_probability > 0.0 && receive_direction.uniform() < receive_direction.profile.duplicate_probability ? 2 : 1;
+			receive_direction.counts.duplicated += copies - 1;
+			const uint64_t now = trace::now_ns();
+			for (int copy = 0; copy < copies; copy++) {
+				if (held_receives.size() >= receive_direction.profile.queue_limit) {
+					receive_direction.counts.overflowed++;
+					continue;
+				}
+				held_receives.push(held_datagram{receive_direction.release_time(now, buffer_size), receive_direction.next_order++, std::vector<char>(buffer, buffer + buffer_size), address, port, false});
+			}
+		}
+
+		/**
+		 * @brief 	Method release_sends sends held datagrams once they are due until the socket is destroyed.
+		 */
+		void release_sends() {
+			std::unique_lock<std::mutex> send_lock(send_mutex);
+			while (!stopping) {
+				if (held_sends.empty()) {
+					send_condition.wait(send_lock);
+					continue;
+				}
+				const uint64_t now = trace::now_ns();
+				if (held_sends.top().release_ns > now) {
+					send_condition.wait_for(send_lock, std::chrono::nanoseconds(held_sends.top().release_ns - now));
+					continue;
+				}
+				held_datagram due = held_sends.top();
+				held_sends.pop();
+				releasing++;
+				// Send without the lock so callers of send are not blocked behind the system call.
+				send_lock.unlock();
+				bool failed = false;
+				try {
+					send_datagram(due.data.data(), due.data.size(), due.port, due.address, due.use_remote);
+				}
+				catch (errors::send_error&) {
+					failed = true;
+				}
+				send_lock.lock();
+				releasing--;
+				if (failed) {
+					send_direction.counts.send_errors++;
+				}
+				if (held_sends.empty()) {
+					send_condition.notify_all();
+				}
+			}
+		}
+
+		/**
+		 * @brief 	Method wait_readable waits until the wrapped socket is readable or a timeout expires.
+		 * @param 	timeout_ns 	maximum time to wait in nanoseconds.
+		 * @return 	bool 		true if the socket is readable.
+		 */
+		bool wait_readable(uint64_t timeout_ns) {
+			// poll has no limit on descriptor values, unlike select and FD_SETSIZE. The timeout is rounded up to a
+			// whole millisecond so a datagram due in under a millisecond does not spin.
+			const int timeout_ms = (int)std::min<uint64_t>((timeout_ns + 999999ULL) / 1000000ULL, (uint64_t)INT32_MAX);
+#ifdef _WIN32
+			WSAPOLLFD descriptor{};
+			descriptor.fd = (SOCKET)inner_socket.get_socket_file_descriptor();
+			descriptor.events = POLLRDNORM;
+			return ::WSAPoll(&descriptor, 1, timeout_ms) > 0;
+#else
+			pollfd descriptor{};
+			descriptor.fd = (int)inner_socket.get_socket_file_descriptor();
+			descriptor.events = POLLIN;
+			return ::poll(&descriptor, 1, timeout_ms) > 0;
+#endif
+		}
+	};
+}
+
+#endif /* IMPAIRMENT_HPP */
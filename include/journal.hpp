@@ -0,0 +1,1199 @@
+/**
+ * 	@file 	journal.hpp
+ * 	@brief 	Classes keeping datagrams in a memory-mapped segmented log so they can be replayed.
+ * 	@author James Horner
+ * 	@date 	2023-04-05
+ */
+
+#ifndef JOURNAL_HPP
+#define JOURNAL_HPP
+
+// Standard System Libraries
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+// Platform Specific System Libraries
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Local Libraries
+#include "byte_order.hpp"
+#include "clock_sync.hpp"
+#include "datagram.hpp"
+#include "errors.hpp"
+#include "ring_buffer.hpp"
+#include "socket_address.hpp"
+#include "udp_socket.hpp"
+
+/// Macro for the first four bytes of every segment file ("OOJL").
+#define JOURNAL_MAGIC 0x4F4F4A4CU
+/// Macro for the version of the segment format.
+#define JOURNAL_VERSION 1
+/// Macro for the number of bytes before the first record of a segment.
+#define JOURNAL_SEGMENT_HEADER_SIZE 64
+/// Macro for the number of bytes before the payload of a record.
+#define JOURNAL_RECORD_HEADER_SIZE 16
+/// Macro for the number of bytes of the sequence number in front of every journaled datagram.
+#define JOURNAL_SEQUENCE_SIZE 8
+/// Macro for the smallest segment size accepted.
+#define JOURNAL_MIN_SEGMENT_SIZE 4096
+/// Macro for the default number of received datagrams that can wait to be journaled.
+#define JOURNAL_RING_CAPACITY 4096
+/// Macro for the default largest received datagram that can be journaled.
+#define JOURNAL_SLOT_SIZE 2048
+/// Macro for the default number of records between entries of the inbound index.
+#define JOURNAL_INDEX_INTERVAL 256
+
+namespace oo_socket
+{
+	/**
+	 *	@namespace	journal
+	 * 	@brief 		Memory-mapped segmented logs of datagrams with sequence numbers.
+	 * 	@details	A log is a directory of segment files named after the sequence number of their first record. Each
+	 * 				segment has a header of the magic, version and first sequence, followed by records aligned to 8 bytes.
+	 * 				A record holds its payload size plus one, which is written last so a zero marks a record still being
+	 * 				written or the end of the segment, a checksum, its sequence number in network byte order and its
+	 * 				payload. The sequence and payload together are the frame sent for the record. Sequences start at 1.
+	 */
+	namespace journal
+	{
+		/**
+		 *	@struct	journal_options
+		 * 	@brief 	Struct journal_options configures the segments of a log and how often they are written back.
+		 */
+		struct journal_options {
+			/// Size of each segment file in bytes, which also bounds the largest record.
+			size_t segment_size = 64 * 1024 * 1024;
+			/// Bytes appended between automatic write backs, 0 to only write back when sync is called.
+			size_t sync_bytes = 1024 * 1024;
+			/// Flag for if write backs wait for the disk (MS_SYNC) rather than only scheduling the writes (MS_ASYNC).
+			bool synchronous = true;
+			/// Flag for if the log is only read, such as by another process, which opens the records present at the time.
+			bool read_only = false;
+		};
+
+		/**
+		 *	@struct	position
+		 * 	@brief 	Struct position locates a record within its segment so reads can start there without scanning.
+		 */
+		struct position {
+			/// Sequence number of the record, 0 for no position.
+			uint64_t sequence = 0;
+			/// Offset of the record from the start of its segment.
+			uint64_t offset = 0;
+		};
+
+		/**
+		 *	@struct	record
+		 * 	@brief 	Struct record points at a record held in a log.
+		 */
+		struct record {
+			/// Sequence number of the record.
+			uint64_t sequence;
+			/// Payload of the record, inside the mapping of its segment.
+			const char* payload;
+			/// Size of the payload in bytes.
+			size_t size;
+			/// Offset of the record from the start of its segment.
+			uint64_t offset;
+
+			/**
+			 * @brief 	Method frame returns the sequence number and payload as they are sent.
+			 * @return 	const char* 	JOURNAL_SEQUENCE_SIZE bytes of the sequence in network byte order followed by the payload.
+			 */
+			const char* frame() const {
+				return payload - JOURNAL_SEQUENCE_SIZE;
+			}
+
+			/**
+			 * @brief 	Method frame_size returns the size of the frame.
+			 * @return 	size_t 	size of the payload plus JOURNAL_SEQUENCE_SIZE.
+			 */
+			size_t frame_size() const {
+				return size + JOURNAL_SEQUENCE_SIZE;
+			}
+		};
+
+		/**
+		 * @brief 	Function read_sequence reads the sequence number in front of a journaled datagram.
+		 * @param 	datagram 	bytes of the datagram, at least JOURNAL_SEQUENCE_SIZE of them.
+		 * @return 	uint64_t 	sequence number of the datagram, whose payload follows it.
+		 */
+		inline uint64_t read_sequence(const char* datagram) {
+			return byte_order::read_network<uint64_t>(datagram);
+		}
+
+		/**
+		 * @brief 	Function frame_checksum hashes the frame of a record so torn writes are found when a log is opened.
+		 * @param 	frame 		sequence number and payload of the record.
+		 * @param 	size 		size of the frame in bytes.
+		 * @return 	uint32_t 	checksum of the frame.
+		 */
+		inline uint32_t frame_checksum(const char* frame, size_t size) {
+			uint64_t hash = 0xcbf29ce484222325ULL ^ size;
+			size_t position = 0;
+			for (; position + sizeof(uint64_t) <= size; position += sizeof(uint64_t)) {
+				uint64_t word;
+				::memcpy(&word, frame + position, sizeof(word));
+				hash = (hash ^ word) * 0x9E3779B97F4A7C15ULL;
+				hash ^= hash >> 29;
+			}
+			uint64_t tail = 0;
+			::memcpy(&tail, frame + position, size - position);
+			hash = (hash ^ tail) * 0x9E3779B97F4A7C15ULL;
+			return (uint32_t)(hash ^ (hash >> 32));
+		}
+
+		/**
+		 * @brief 	Function record_size returns the bytes a record takes in a segment.
+		 * @param 	payload_size 	size of the payload in bytes.
+		 * @return 	uint64_t 		size of the header and payload rounded up to 8 bytes.
+		 */
+		inline uint64_t record_size(size_t payload_size) {
+			return ((uint64_t)JOURNAL_RECORD_HEADER_SIZE + payload_size + 7) & ~(uint64_t)7;
+		}
+
+		/**************************************************************************************************/
+		/* Segmented Log				 																  */
+		/**************************************************************************************************/
+		/**
+		 *	@class	segmented_log
+		 * 	@brief 	Class segmented_log appends records to memory-mapped segment files and reads them back in order.
+		 * 	@details	Appends reserve space in the active segment with a single compare and swap of its offset and record
+		 * 				count, so threads append concurrently without locks and only take a mutex to start the next
+		 * 				segment once the active one is full. Pages are written back in batches with msync every
+		 * 				sync_bytes, or when sync is called, rather than on every append. Opening a log recovers the records
+		 * 				of its segments up to the first one that is incomplete or fails its checksum. A log opened read only,
+		 * 				such as by another process, holds the records present when it was opened and cannot be appended to
+		 * 				or trimmed. Only supported on POSIX systems.
+		 */
+		class segmented_log {
+		public:
+			/**
+			 * @brief 	Constructor for the segmented_log class which opens or creates the log in a directory.
+			 * @param 	directory 	directory holding the segment files, created if it does not exist.
+			 * @param 	options 	segment size and write back settings.
+			 * @throws	journal_error if the options are invalid or the segments could not be created, opened or mapped.
+			 */
+			segmented_log(const std::string& directory, const journal_options& options = journal_options()) :
+				directory_path(directory),
+				options(options)
+			{
+#ifdef _WIN32
+				throw errors::journal_error("Journals are only supported on POSIX systems.");
+#else
+				page_size = (uint64_t)::sysconf(_SC_PAGESIZE);
+#endif
+				if (options.segment_size < JOURNAL_MIN_SEGMENT_SIZE || options.segment_size > 0xffffffffULL) {
+					throw errors::journal_error("Segment size must be between " + std::to_string(JOURNAL_MIN_SEGMENT_SIZE) + " bytes and 4 GiB.");
+				}
+				std::error_code error;
+				if (!options.read_only) {
+					std::filesystem::create_directories(directory_path, error);
+				}
+				if (error || !std::filesystem::is_directory(directory_path)) {
+					throw errors::journal_error("Could not open the journal directory " + directory + ".");
+				}
+
+				std::vector<uint64_t> bases;
+				for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(directory_path, error)) {
+					const std::string stem = entry.path().stem().string();
+					if (entry.path().extension() == ".journal" && !stem.empty() && stem.find_first_not_of("0123456789") == std::string::npos) {
+						bases.push_back(std::stoull(stem));
+					}
+				}
+				std::sort(bases.begin(), bases.end());
+				for (uint64_t base : bases) {
+					segments.push_back(open_segment(base));
+				}
+				if (segments.empty()) {
+					if (options.read_only) {
+						throw errors::journal_error("Journal " + directory + " has no segments to read.");
+					}
+					segments.push_back(create_segment(1));
+				}
+				// Only the newest segment takes appends, the others are sealed by moving their offset to the end.
+				for (size_t i = 0; i + 1 < segments.size(); i++) {
+					segment& sealed = *segments[i];
+					sealed.state.store(((uint64_t)sealed.capacity << 32) | (sealed.state.load() & 0xffffffff));
+				}
+				active.store(segments.back().get());
+			}
+
+			/**
+			 * 	@brief 	Destructor for the segmented_log class which writes back and unmaps the segments.
+			 */
+			~segmented_log() {
+				try {
+					if (!options.read_only) {
+						sync();
+					}
+				}
+				catch (const errors::journal_error&) {
+					// Nothing can be done about a failed write back while closing.
+				}
+				for (std::unique_ptr<segment>& open : segments) {
+					unmap_segment(*open);
+				}
+			}
+
+			/**
+			 * @brief 	Method append adds a record to the end of the log.
+			 * @param 	payload 	bytes of the record.
+			 * @param 	size 		size of the record in bytes.
+			 * @param 	frame[out]	set to the sequence number and payload inside the mapping if not nullptr, valid until
+			 * 						the record is trimmed (default nullptr).
+			 * @param 	stored[out]	set to the position of the record if not nullptr, for starting reads there (default nullptr).
+			 * @return 	uint64_t 	sequence number of the record.
+			 * @throws	journal_error if the log is read only, the record does not fit in a segment or the next segment
+			 * 			could not be created.
+			 */
+			uint64_t append(const char* payload, size_t size, const char** frame = nullptr, position* stored = nullptr) {
+				if (options.read_only) {
+					throw errors::journal_error("Journal " + directory_path.string() + " was opened read only.");
+				}
+				const uint64_t needed = record_size(size);
+				while (true) {
+					segment* current = active.load(std::memory_order_acquire);
+					if (needed > (uint64_t)current->capacity - JOURNAL_SEGMENT_HEADER_SIZE) {
+						throw errors::journal_error("Record of " + std::to_string(size) + " bytes does not fit in a segment.");
+					}
+					uint64_t state = current->state.load(std::memory_order_relaxed);
+					const uint64_t offset = state >> 32;
+					if (offset + needed > current->capacity) {
+						roll_over(current);
+						continue;
+					}
+					if (!current->state.compare_exchange_weak(state, ((offset + needed) << 32) | ((state & 0xffffffff) + 1), std::memory_order_relaxed)) {
+						continue;
+					}
+
+					const uint64_t sequence = current->base_sequence + (state & 0xffffffff);
+					char* written = current->data + offset;
+					byte_order::write_network(sequence, written + 8);
+					::memcpy(written + JOURNAL_RECORD_HEADER_SIZE, payload, size);
+					const uint32_t checksum = frame_checksum(written + 8, size + JOURNAL_SEQUENCE_SIZE);
+					::memcpy(written + 4, &checksum, sizeof(checksum));
+					// The size is stored last, and with release ordering, so readers never see a partial record.
+					commit_word(written).store((uint32_t)size + 1, std::memory_order_release);
+					current->committed.fetch_add(1, std::memory_order_release);
+					if (frame != nullptr) {
+						*frame = written + 8;
+					}
+					if (stored != nullptr) {
+						*stored = position{sequence, offset};
+					}
+
+					if (options.sync_bytes > 0 && unsynced_bytes.fetch_add(needed, std::memory_order_relaxed) + needed >= options.sync_bytes) {
+						// One appender writes back for everyone, the others carry on.
+						std::unique_lock<std::mutex> sync_lock(sync_mutex, std::try_to_lock);
+						if (sync_lock.owns_lock()) {
+							sync_segments();
+						}
+					}
+					return sequence;
+				}
+			}
+
+			/**
+			 * @brief 	Method for_each visits the records from a sequence number onwards in order.
+			 * @param 	from_sequence 	first sequence number to visit.
+			 * @param 	visit 			function taking a const record& and returning true to continue.
+			 * @param 	hint 			position of a record at or before from_sequence to start scanning its segment from,
+			 * 							ignored if the record is no longer in the log (default none).
+			 * @return 	uint64_t 		sequence number after the last record visited, or from_sequence if none were.
+			 * @details	Visiting stops at a record that is still being written so records are never skipped. Rolling over
+			 * 			to a new segment waits for the visit to finish, so long visits should be avoided while appending.
+			 */
+			template <typename visitor>
+			uint64_t for_each(uint64_t from_sequence, visitor&& visit, const position& hint = position()) {
+				std::unique_lock<std::mutex> segments_lock(segments_mutex);
+				uint64_t next = from_sequence;
+				for (std::unique_ptr<segment>& current : segments) {
+					const uint64_t count = current->state.load(std::memory_order_acquire) & 0xffffffff;
+					if (current->base_sequence + count <= next) {
+						continue;
+					}
+					uint64_t first = 0;
+					uint64_t offset = JOURNAL_SEGMENT_HEADER_SIZE;
+					if (hint.sequence >= current->base_sequence && hint.sequence < current->base_sequence + count && hint.sequence <= next) {
+						first = hint.sequence - current->base_sequence;
+						offset = hint.offset;
+					}
+					for (uint64_t i = first; i < count; i++) {
+						const char* stored = current->data + offset;
+						const uint32_t committed = commit_word(stored).load(std::memory_order_acquire);
+						if (committed == 0) {
+							return next;
+						}
+						const record visited{current->base_sequence + i, stored + JOURNAL_RECORD_HEADER_SIZE, (size_t)committed - 1, offset};
+						if (visited.sequence >= next) {
+							next = visited.sequence + 1;
+							if (!visit(visited)) {
+								return next;
+							}
+						}
+						offset += record_size(visited.size);
+					}
+				}
+				return next;
+			}
+
+			/**
+			 * @brief 	Method sync writes the committed records back to the segment files.
+			 * @throws	journal_error if msync failed.
+			 */
+			void sync() {
+				if (options.read_only) {
+					return;
+				}
+				std::unique_lock<std::mutex> sync_lock(sync_mutex);
+				sync_segments();
+			}
+
+			/**
+			 * @brief 	Method trim deletes the oldest segments once every record in them is older than a sequence number.
+			 * @param 	before_sequence 	sequence number of the oldest record that must be kept.
+			 * @return 	size_t 				number of segments deleted. The active segment is never deleted.
+			 * @throws	journal_error if the log is read only.
+			 */
+			size_t trim(uint64_t before_sequence) {
+				if (options.read_only) {
+					throw errors::journal_error("Journal " + directory_path.string() + " was opened read only.");
+				}
+				std::unique_lock<std::mutex> segments_lock(segments_mutex);
+				size_t removed = 0;
+				while (segments.size() > 1) {
+					segment& oldest = *segments.front();
+					const uint64_t count = oldest.state.load(std::memory_order_acquire) & 0xffffffff;
+					if (oldest.base_sequence + count > before_sequence || oldest.committed.load(std::memory_order_acquire) != count) {
+						break;
+					}
+					unmap_segment(oldest);
+					std::error_code error;
+					std::filesystem::remove(oldest.path, error);
+					// Appenders may still hold a pointer to a sealed segment, so its bookkeeping outlives the mapping.
+					retired.push_back(std::move(segments.front()));
+					segments.erase(segments.begin());
+					removed++;
+				}
+				return removed;
+			}
+
+			/**
+			 * @brief 	Method first_sequence returns the sequence number of the oldest record kept.
+			 * @return 	uint64_t 	sequence number, equal to next_sequence when the log is empty.
+			 */
+			uint64_t first_sequence() {
+				std::unique_lock<std::mutex> segments_lock(segments_mutex);
+				return segments.front()->base_sequence;
+			}
+
+			/**
+			 * @brief 	Method next_sequence returns the sequence number the next record will get.
+			 * @return 	uint64_t 	sequence number.
+			 */
+			uint64_t next_sequence() const {
+				const segment* current = active.load(std::memory_order_acquire);
+				return current->base_sequence + (current->state.load(std::memory_order_acquire) & 0xffffffff);
+			}
+
+			/**
+			 * @brief 	Method segment_count returns the number of segment files in the log.
+			 * @return 	size_t 	number of segments.
+			 */
+			size_t segment_count() {
+				std::unique_lock<std::mutex> segments_lock(segments_mutex);
+				return segments.size();
+			}
+
+		private:
+			/**
+			 *	@struct	segment
+			 * 	@brief 	Struct segment is the bookkeeping of one mapped segment file.
+			 */
+			struct segment {
+				/// Sequence number of the first record.
+				uint64_t base_sequence = 0;
+				/// Path of the segment file.
+				std::filesystem::path path;
+				/// Mapping of the file.
+				char* data = nullptr;
+				/// Size of the file in bytes.
+				uint32_t capacity = 0;
+				/// File descriptor of the file.
+				int file = -1;
+				/// Offset of the next record in the upper 32 bits and number of records in the lower 32 bits.
+				std::atomic<uint64_t> state{0};
+				/// Number of records whose size has been stored.
+				std::atomic<uint32_t> committed{0};
+				/// Offset up to which the records have been written back, guarded by the sync mutex.
+				uint64_t synced_offset = JOURNAL_SEGMENT_HEADER_SIZE;
+				/// Number of records written back, guarded by the sync mutex.
+				uint64_t synced_count = 0;
+			};
+
+			/// Directory holding the segment files.
+			std::filesystem::path directory_path;
+			/// Segment size and write back settings.
+			journal_options options;
+			/// Size of a memory page, which write backs are aligned to.
+			uint64_t page_size = 4096;
+			/// Mutex to control access to the list of segments.
+			std::mutex segments_mutex;
+			/// Segments from oldest to newest, the last of which is active.
+			std::vector<std::unique_ptr<segment>> segments;
+			/// Segments that have been trimmed, kept so appenders that loaded them before they were sealed stay valid.
+			std::vector<std::unique_ptr<segment>> retired;
+			/// Segment that records are appended to.
+			std::atomic<segment*> active{nullptr};
+			/// Mutex allowing one write back at a time.
+			std::mutex sync_mutex;
+			/// Bytes appended since the last write back.
+			std::atomic<uint64_t> unsynced_bytes{0};
+
+			/**
+			 * @brief 	Method commit_word views the size at the start of a record as an atomic.
+			 * @param 	stored 	start of the record in a mapping.
+			 * @return 	std::atomic<uint32_t>& 	size of the payload plus one, 0 while the record is being written.
+			 */
+			static std::atomic<uint32_t>& commit_word(const char* stored) {
+				static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "Records store their size as a lock free 32 bit atomic.");
+				return *reinterpret_cast<std::atomic<uint32_t>*>(const_cast<char*>(stored));
+			}
+
+			/**
+			 * @brief 	Method segment_path returns the path of the segment starting at a sequence number.
+			 * @param 	base_sequence 	sequence number of the first record.
+			 * @return 	std::filesystem::path 	path of the file, named with the zero padded sequence number.
+			 */
+			std::filesystem::path segment_path(uint64_t base_sequence) const {
+				char name[32];
+				std::snprintf(name, sizeof(name), "%020llu.journal", (unsigned long long)base_sequence);
+				return directory_path / name;
+			}
+
+			/**
+			 * @brief 	Method create_segment creates and maps an empty segment file.
+			 * @param 	base_sequence 	sequence number of the first record.
+			 * @return 	std::unique_ptr<segment> 	mapped segment.
+			 * @throws	journal_error if the file could not be created, sized or mapped.
+			 */
+			std::unique_ptr<segment> create_segment(uint64_t base_sequence) {
+				std::unique_ptr<segment> created(new segment());
+				created->base_sequence = base_sequence;
+				created->path = segment_path(base_sequence);
+				created->capacity = (uint32_t)options.segment_size;
+				map_segment(*created, true);
+				byte_order::write_network((uint32_t)JOURNAL_MAGIC, created->data);
+				byte_order::write_network((uint32_t)JOURNAL_VERSION, created->data + 4);
+				byte_order::write_network(base_sequence, created->data + 8);
+				created->state.store((uint64_t)JOURNAL_SEGMENT_HEADER_SIZE << 32);
+				return created;
+			}
+
+			/**
+			 * @brief 	Method open_segment maps an existing segment file and recovers its records.
+			 * @param 	base_sequence 	sequence number of the first record, from the name of the file.
+			 * @return 	std::unique_ptr<segment> 	mapped segment holding the records up to the first incomplete one.
+			 * @throws	journal_error if the file could not be mapped or is not a segment.
+			 */
+			std::unique_ptr<segment> open_segment(uint64_t base_sequence) {
+				std::unique_ptr<segment> opened(new segment());
+				opened->base_sequence = base_sequence;
+				opened->path = segment_path(base_sequence);
+				std::error_code error;
+				const uintmax_t file_size = std::filesystem::file_size(opened->path, error);
+				if (error || file_size < JOURNAL_MIN_SEGMENT_SIZE || file_size > 0xffffffffULL) {
+					throw errors::journal_error("Segment " + opened->path.string() + " has an invalid size.");
+				}
+				opened->capacity = (uint32_t)file_size;
+				map_segment(*opened, false);
+				if (byte_order::read_network<uint32_t>(opened->data) != JOURNAL_MAGIC ||
+					byte_order::read_network<uint32_t>(opened->data + 4) != JOURNAL_VERSION ||
+					byte_order::read_network<uint64_t>(opened->data + 8) != base_sequence) {
+					unmap_segment(*opened);
+					throw errors::journal_error("Segment " + opened->path.string() + " is not a journal segment of this version.");
+				}
+
+				uint64_t offset = JOURNAL_SEGMENT_HEADER_SIZE;
+				uint64_t count = 0;
+				while (offset + JOURNAL_RECORD_HEADER_SIZE <= opened->capacity) {
+					const char* stored = opened->data + offset;
+					uint32_t committed;
+					uint32_t checksum;
+					::memcpy(&committed, stored, sizeof(committed));
+					::memcpy(&checksum, stored + 4, sizeof(checksum));
+					if (committed == 0 || record_size(committed - 1) > opened->capacity - offset ||
+						byte_order::read_network<uint64_t>(stored + 8) != base_sequence + count ||
+						frame_checksum(stored + 8, (size_t)committed - 1 + JOURNAL_SEQUENCE_SIZE) != checksum) {
+						break;
+					}
+					offset += record_size(committed - 1);
+					count++;
+				}
+				// Clear whatever a torn write left behind so it cannot be mistaken for a record later.
+				for (uint64_t page = offset; !options.read_only && page < opened->capacity; page = (page / page_size + 1) * page_size) {
+					const uint64_t end = std::min<uint64_t>((page / page_size + 1) * page_size, opened->capacity);
+					if (std::any_of(opened->data + page, opened->data + end, [](char byte) { return byte != 0; })) {
+						::memset(opened->data + page, 0, end - page);
+					}
+				}
+				opened->state.store((offset << 32) | count);
+				opened->committed.store((uint32_t)count);
+				opened->synced_offset = offset;
+				opened->synced_count = count;
+				return opened;
+			}
+
+			/**
+			 * @brief 	Method roll_over seals a full segment and makes a new segment active.
+			 * @param 	full 	segment that a record did not fit in.
+			 * @throws	journal_error if the new segment could not be created.
+			 */
+			void roll_over(segment* full) {
+				// Moving the offset to the end makes every later reservation in the segment fail.
+				uint64_t state = full->state.load(std::memory_order_relaxed);
+				while ((state >> 32) != full->capacity &&
+					!full->state.compare_exchange_weak(state, ((uint64_t)full->capacity << 32) | (state & 0xffffffff), std::memory_order_relaxed)) {
+				}
+				std::unique_lock<std::mutex> segments_lock(segments_mutex);
+				if (active.load(std::memory_order_relaxed) != full) {
+					return;
+				}
+				const uint64_t count = full->state.load(std::memory_order_relaxed) & 0xffffffff;
+				segments.push_back(create_segment(full->base_sequence + count));
+				active.store(segments.back().get(), std::memory_order_release);
+			}
+
+			/**
+			 * @brief 	Method sync_segments writes back the records committed since the last write back.
+			 * @throws	journal_error if msync failed.
+			 * @note	The caller must hold the sync mutex.
+			 */
+			void sync_segments() {
+				unsynced_bytes.store(0, std::memory_order_relaxed);
+				std::unique_lock<std::mutex> segments_lock(segments_mutex);
+				for (std::unique_ptr<segment>& current : segments) {
+					// Only the committed prefix is written back, a record still being written is picked up next time.
+					const uint64_t count = current->state.load(std::memory_order_acquire) & 0xffffffff;
+					uint64_t offset = current->synced_offset;
+					uint64_t synced = current->synced_count;
+					while (synced < count) {
+						const uint32_t committed = commit_word(current->data + offset).load(std::memory_order_acquire);
+						if (committed == 0) {
+							break;
+						}
+						offset += record_size(committed - 1);
+						synced++;
+					}
+					if (offset > current->synced_offset || current->synced_count == 0) {
+						sync_range(*current, current->synced_offset, offset);
+					}
+					current->synced_offset = offset;
+					current->synced_count = synced;
+				}
+			}
+
+			/**************************************************************************************************/
+			/* Platform Methods				 																  */
+			/**************************************************************************************************/
+			/**
+			 * @brief 	Method map_segment opens and maps the file of a segment.
+			 * @param 	mapped 	segment whose path and capacity are set.
+			 * @param 	create 	true to create the file and reserve its blocks, false to open an existing file.
+			 * @throws	journal_error if the file could not be opened, sized or mapped.
+			 */
+			void map_segment(segment& mapped, bool create) {
+#ifndef _WIN32
+				const int access = options.read_only ? O_RDONLY : O_RDWR;
+				mapped.file = ::open(mapped.path.c_str(), create ? access | O_CREAT | O_TRUNC : access, 0644);
+				if (mapped.file < 0) {
+					throw errors::journal_error("Could not open " + mapped.path.string() + ": " + std::to_string(errno));
+				}
+				if (create) {
+#ifdef __linux__
+					// Reserving the blocks up front turns a full disk into an error here rather than SIGBUS on a later write.
+					const int result = ::posix_fallocate(mapped.file, 0, (off_t)mapped.capacity);
+#else
+					const int result = ::ftruncate(mapped.file, (off_t)mapped.capacity) == 0 ? 0 : errno;
+#endif
+					if (result != 0) {
+						::close(mapped.file);
+						std::error_code error;
+						std::filesystem::remove(mapped.path, error);
+						throw errors::journal_error("Could not size " + mapped.path.string() + ": " + std::to_string(result));
+					}
+				}
+				void* address = ::mmap(nullptr, mapped.capacity, options.read_only ? PROT_READ : PROT_READ | PROT_WRITE, MAP_SHARED, mapped.file, 0);
+				if (address == MAP_FAILED) {
+					const int error_code = errno;
+					::close(mapped.file);
+					throw errors::journal_error("Could not map " + mapped.path.string() + ": " + std::to_string(error_code));
+				}
+				mapped.data = (char*)address;
+#else
+				(void)mapped;
+				(void)create;
+				throw errors::journal_error("Journals are only supported on POSIX systems.");
+#endif
+			}
+
+			/**
+			 * @brief 	Method unmap_segment unmaps and closes the file of a segment.
+			 * @param 	mapped 	segment to unmap, which may already be unmapped.
+			 */
+			static void unmap_segment(segment& mapped) {
+#ifndef _WIN32
+				if (mapped.data != nullptr) {
+					::munmap(mapped.data, mapped.capacity);
+					::close(mapped.file);
+					mapped.data = nullptr;
+					mapped.file = -1;
+				}
+#else
+				(void)mapped;
+#endif
+			}
+
+			/**
+			 * @brief 	Method sync_range writes back part of a segment.
+			 * @param 	mapped 	segment to write back.
+			 * @param 	begin 	offset of the first byte.
+			 * @param 	end 	offset after the last byte.
+			 * @throws	journal_error if msync failed.
+			 */
+			void sync_range(segment& mapped, uint64_t begin, uint64_t end) {
+#ifndef _WIN32
+				// msync needs a page aligned start, the length is rounded up to whole pages by the kernel.
+				const uint64_t aligned = begin / page_size * page_size;
+				if (end > aligned && ::msync(mapped.data + aligned, end - aligned, options.synchronous ? MS_SYNC : MS_ASYNC)) {
+					throw errors::journal_error("Could not write back " + mapped.path.string() + ": " + std::to_string(errno));
+				}
+#else
+				(void)mapped;
+				(void)begin;
+				(void)end;
+#endif
+			}
+		};
+
+		/**************************************************************************************************/
+		/* Outbound Journal				 																  */
+		/**************************************************************************************************/
+		/**
+		 *	@class	outbound_journal
+		 * 	@brief 	Class outbound_journal journals every message sent to a peer so it can be replayed once the peer returns.
+		 * 	@details	Each message is appended to a segmented log and then sent straight from the mapping with its
+		 * 				sequence number in front, which the peer reads with read_sequence to acknowledge what it received
+		 * 				and to drop replayed duplicates. A failed send leaves the message in the log. Messages are kept until
+		 * 				acknowledged, and whole segments are deleted once all their messages are. After a restart the
+		 * 				messages of the oldest segment are replayed again since acknowledgements are not journaled. The
+		 * 				journal is thread safe and the socket must outlive it.
+		 */
+		class outbound_journal {
+		public:
+			/**
+			 * @brief 	Constructor for the outbound_journal class.
+			 * @param 	inner 		socket that messages are sent with.
+			 * @param 	destination address and port of the peer.
+			 * @param 	directory 	directory of the log, created if it does not exist and recovered if it does.
+			 * @param 	options 	segment size and write back settings.
+			 * @throws	journal_error if the log could not be opened.
+			 */
+			outbound_journal(udp::socket& inner, const socket_address& destination, const std::string& directory, const journal_options& options = journal_options()) :
+				inner_socket(inner),
+				peer(destination),
+				log(directory, options)
+			{
+				acknowledged.store(log.first_sequence() - 1);
+			}
+
+			/**
+			 * @brief 	Method send journals a message and sends it to the peer.
+			 * @param 	buffer 		pointer to buffer of bytes to send.
+			 * @param 	buffer_size size of buffer in bytes.
+			 * @param 	flags 		any flags that the packet should be sent with (default 0).
+			 * @return 	uint64_t 	sequence number of the message.
+			 * @throws	journal_error if the message could not be journaled, in which case it is not sent.
+			 */
+			uint64_t send(const char* buffer, const size_t buffer_size, const int flags = 0) {
+				const char* frame = nullptr;
+				const uint64_t sequence = log.append(buffer, buffer_size, &frame);
+				try {
+					inner_socket.send_to(frame, buffer_size + JOURNAL_SEQUENCE_SIZE, peer, flags);
+				}
+				catch (const errors::send_error&) {
+					// The message stays in the journal until it is replayed.
+					failed_sends.fetch_add(1, std::memory_order_relaxed);
+				}
+				return sequence;
+			}
+
+			/**
+			 * @brief 	Method send journals a vector of bytes and sends it to the peer.
+			 * @param 	buffer 		vector of bytes to send.
+			 * @param 	flags 		any flags that the packet should be sent with (default 0).
+			 * @return 	uint64_t 	sequence number of the message.
+			 * @throws	journal_error if the message could not be journaled, in which case it is not sent.
+			 */
+			template <typename T>
+			uint64_t send(const std::vector<T>& buffer, const int flags = 0) {
+				return send(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(T), flags);
+			}
+
+			/**
+			 * @brief 	Method replay sends the unacknowledged messages again, oldest first.
+			 * @param 	from_sequence 	first sequence number to send, raised to the oldest unacknowledged message (default 0).
+			 * @param 	flags 			any flags that the packets should be sent with (default 0).
+			 * @return 	size_t 			number of messages sent, stopping at the first send that fails.
+			 */
+			size_t replay(uint64_t from_sequence = 0, const int flags = 0) {
+				size_t sent = 0;
+				log.for_each(std::max(from_sequence, acknowledged.load(std::memory_order_acquire) + 1), [&](const record& journaled) {
+					try {
+						inner_socket.send_to(journaled.frame(), journaled.frame_size(), peer, flags);
+					}
+					catch (const errors::send_error&) {
+						failed_sends.fetch_add(1, std::memory_order_relaxed);
+						return false;
+					}
+					sent++;
+					return true;
+				});
+				return sent;
+			}
+
+			/**
+			 * @brief 	Method acknowledge records that the peer has every message up to a sequence number, deleting the
+			 * 			segments that only hold acknowledged messages.
+			 * @param 	sequence 	sequence number of the newest message the peer has, with every message before it.
+			 */
+			void acknowledge(uint64_t sequence) {
+				uint64_t current = acknowledged.load(std::memory_order_relaxed);
+				while (sequence > current && !acknowledged.compare_exchange_weak(current, sequence, std::memory_order_acq_rel)) {
+				}
+				log.trim(acknowledged.load(std::memory_order_acquire) + 1);
+			}
+
+			/**
+			 * @brief 	Method get_acknowledged returns the newest sequence number acknowledged by the peer.
+			 * @return 	uint64_t 	sequence number, 0 if nothing has been acknowledged.
+			 */
+			uint64_t get_acknowledged() const {
+				return acknowledged.load(std::memory_order_acquire);
+			}
+
+			/**
+			 * @brief 	Method get_failed_sends returns the number of sends and replays that failed.
+			 * @return 	uint64_t 	number of failures.
+			 */
+			uint64_t get_failed_sends() const {
+				return failed_sends.load(std::memory_order_relaxed);
+			}
+
+			/**
+			 * @brief 	Method get_log returns the log the messages are journaled in.
+			 * @return 	segmented_log& 	log of the journal.
+			 */
+			segmented_log& get_log() {
+				return log;
+			}
+
+		private:
+			/// Socket the messages are sent with.
+			udp::socket& inner_socket;
+			/// Address and port of the peer.
+			socket_address peer;
+			/// Log of the messages.
+			segmented_log log;
+			/// Newest sequence number the peer has acknowledged.
+			std::atomic<uint64_t> acknowledged{0};
+			/// Number of sends and replays that failed.
+			std::atomic<uint64_t> failed_sends{0};
+		};
+
+		/**************************************************************************************************/
+		/* Inbound Journal				 																  */
+		/**************************************************************************************************/
+		/**
+		 *	@struct	inbound_record
+		 * 	@brief 	Struct inbound_record is a received datagram read back from an inbound journal.
+		 */
+		struct inbound_record {
+			/// Sequence number of the datagram in the journal, in the order it was recorded.
+			uint64_t sequence;
+			/// Time the datagram was received in nanoseconds since the Unix epoch.
+			uint64_t received_ns;
+			/// Bytes of the datagram, inside the mapping of its segment.
+			const char* data;
+			/// Size of the datagram in bytes.
+			size_t size;
+		};
+
+		/**
+		 *	@class	inbound_journal
+		 * 	@brief 	Class inbound_journal records received datagrams in a segmented log with a sparse sequence and time
+		 * 			index so any range can be replayed from memory.
+		 * 	@details	The receive thread calls record, which copies the datagram into a preallocated slot and hands it
+		 * 				to a writer thread through a ring buffer, so the receive thread never touches the log. Datagrams
+		 * 				are dropped and counted rather than blocking when every slot is waiting to be written or when they
+		 * 				are larger than a slot. The writer appends each datagram with its receive time, made non decreasing
+		 * 				so time ranges can be searched, and indexes the position of every index_interval'th record. Replays
+		 * 				start from the nearest index entry and read straight from the mappings. Opening the journal with
+		 * 				journal_options::read_only, such as from a late joining process, replays what had been written when
+		 * 				it was opened and starts no writer. record must only be called from one thread at a time, while
+		 * 				replays may run on any thread.
+		 */
+		class inbound_journal {
+		public:
+			/**
+			 * @brief 	Constructor for the inbound_journal class which opens the log, rebuilds its index and starts the writer.
+			 * @param 	directory 		directory of the log, created if it does not exist and recovered if it does.
+			 * @param 	options 		segment size, write back and read only settings.
+			 * @param 	ring_capacity 	number of datagrams that can wait to be written (default JOURNAL_RING_CAPACITY).
+			 * @param 	slot_size 		largest datagram that can be recorded in bytes (default JOURNAL_SLOT_SIZE).
+			 * @param 	index_interval 	number of records between index entries (default JOURNAL_INDEX_INTERVAL).
+			 * @throws	journal_error if the log could not be opened.
+			 */
+			inbound_journal(
+				const std::string& directory,
+				const journal_options& options = journal_options(),
+				size_t ring_capacity = JOURNAL_RING_CAPACITY,
+				size_t slot_size = JOURNAL_SLOT_SIZE,
+				size_t index_interval = JOURNAL_INDEX_INTERVAL) :
+				log(directory, options),
+				filled_slots(options.read_only ? 1 : ring_capacity),
+				free_slots(filled_slots.capacity()),
+				slot_size(slot_size),
+				index_interval(std::max<size_t>(index_interval, 1))
+			{
+				// Rebuild the index, which is not stored, from the records that were recovered.
+				log.for_each(log.first_sequence(), [this](const journal::record& stored) {
+					index_record(stored.sequence, read_received(stored), stored.offset);
+					return true;
+				});
+				if (options.read_only) {
+					return;
+				}
+				slot_stride = (JOURNAL_SEQUENCE_SIZE + slot_size + 7) & ~(size_t)7;
+				arena.resize(free_slots.capacity() * slot_stride);
+				slot_sizes.resize(free_slots.capacity());
+				for (size_t slot = 0; slot < free_slots.capacity(); slot++) {
+					free_slots.push(slot);
+				}
+				writer_thread = std::thread([this]() { write_records(); });
+			}
+
+			/**
+			 * 	@brief 	Destructor for the inbound_journal class which writes the remaining datagrams and stops the writer.
+			 */
+			~inbound_journal() {
+				if (writer_thread.joinable()) {
+					{
+						std::unique_lock<std::mutex> wake_lock(wake_mutex);
+						stopping = true;
+					}
+					wake_condition.notify_all();
+					writer_thread.join();
+				}
+			}
+
+			/**
+			 * @brief 	Method record queues a received datagram to be journaled.
+			 * @param 	buffer 		bytes of the datagram.
+			 * @param 	size 		size of the datagram in bytes.
+			 * @param 	received_ns time the datagram was received in nanoseconds since the Unix epoch, 0 for now (default 0).
+			 * @return 	bool 		true if the datagram was queued, false if it was dropped.
+			 * @throws	journal_error if the journal was opened read only.
+			 */
+			bool record(const char* buffer, size_t size, uint64_t received_ns = 0) {
+				if (!writer_thread.joinable()) {
+					throw errors::journal_error("Inbound journal was opened read only.");
+				}
+				size_t slot;
+				if (size > slot_size || !free_slots.pop(slot)) {
+					dropped.fetch_add(1, std::memory_order_relaxed);
+					return false;
+				}
+				char* bytes = arena.data() + slot * slot_stride;
+				byte_order::write_network(received_ns != 0 ? received_ns : clock_sync::wall_clock_ns(), bytes);
+				::memcpy(bytes + JOURNAL_SEQUENCE_SIZE, buffer, size);
+				slot_sizes[slot] = size;
+				// Every slot fits in the filled ring, so this push cannot fail.
+				filled_slots.push(slot);
+				recorded.fetch_add(1, std::memory_order_release);
+				if (writer_idle.load(std::memory_order_acquire)) {
+					wake_condition.notify_one();
+				}
+				return true;
+			}
+
+			/**
+			 * @brief 	Method record queues a batch of received datagrams to be journaled.
+			 * @param 	datagrams 	datagrams filled by udp::socket::receive_batch.
+			 * @param 	count 		number of datagrams that were received.
+			 * @return 	size_t 		number of datagrams queued.
+			 * @throws	journal_error if the journal was opened read only.
+			 * @note	The kernel receive times are used when the socket has receive timestamps enabled.
+			 */
+			size_t record(const std::vector<incoming_datagram>& datagrams, size_t count) {
+				size_t queued = 0;
+				for (size_t i = 0; i < count && i < datagrams.size(); i++) {
+					queued += record(datagrams[i].buffer, datagrams[i].size, datagrams[i].receive_timestamp_ns) ? 1 : 0;
+				}
+				return queued;
+			}
+
+			/**
+			 * @brief 	Method flush waits until every queued datagram has been appended to the log.
+			 * @note	Appended datagrams can be replayed straight away, use get_log().sync() to also write them to disk.
+			 */
+			void flush() {
+				const uint64_t target = recorded.load(std::memory_order_acquire);
+				std::unique_lock<std::mutex> wake_lock(wake_mutex);
+				wake_condition.notify_all();
+				// The writer only signals when the ring empties, so waits are bounded for a ring that never does.
+				while (written.load(std::memory_order_acquire) < target) {
+					written_condition.wait_for(wake_lock, std::chrono::milliseconds(1));
+				}
+			}
+
+			/**
+			 * @brief 	Method replay visits the journaled datagrams in a range of sequence numbers.
+			 * @param 	from_sequence 	first sequence number to visit.
+			 * @param 	to_sequence 	last sequence number to visit.
+			 * @param 	visit 			function taking a const inbound_record& and returning true to continue.
+			 * @return 	size_t 			number of datagrams visited.
+			 */
+			template <typename visitor>
+			size_t replay(uint64_t from_sequence, uint64_t to_sequence, visitor&& visit) {
+				size_t visited = 0;
+				log.for_each(from_sequence, [&](const journal::record& stored) {
+					if (stored.sequence > to_sequence) {
+						return false;
+					}
+					visited++;
+					return (bool)visit(inbound_record{stored.sequence, read_received(stored), stored.payload + JOURNAL_SEQUENCE_SIZE, stored.size - JOURNAL_SEQUENCE_SIZE});
+				}, seek([from_sequence](const index_entry& entry) { return entry.sequence <= from_sequence; }));
+				return visited;
+			}
+
+			/**
+			 * @brief 	Method replay_time visits the journaled datagrams received in a range of times.
+			 * @param 	from_ns 	earliest receive time to visit in nanoseconds since the Unix epoch.
+			 * @param 	to_ns 		latest receive time to visit in nanoseconds since the Unix epoch.
+			 * @param 	visit 		function taking a const inbound_record& and returning true to continue.
+			 * @return 	size_t 		number of datagrams visited.
+			 */
+			template <typename visitor>
+			size_t replay_time(uint64_t from_ns, uint64_t to_ns, visitor&& visit) {
+				size_t visited = 0;
+				const position start = seek([from_ns](const index_entry& entry) { return entry.received_ns < from_ns; });
+				log.for_each(start.sequence, [&](const journal::record& stored) {
+					const uint64_t received_ns = read_received(stored);
+					if (received_ns > to_ns) {
+						return false;
+					}
+					if (received_ns < from_ns) {
+						return true;
+					}
+					visited++;
+					return (bool)visit(inbound_record{stored.sequence, received_ns, stored.payload + JOURNAL_SEQUENCE_SIZE, stored.size - JOURNAL_SEQUENCE_SIZE});
+				}, start);
+				return visited;
+			}
+
+			/**
+			 * @brief 	Method trim deletes the oldest segments once every datagram in them is older than a sequence number.
+			 * @param 	before_sequence 	sequence number of the oldest datagram that must be kept.
+			 * @return 	size_t 				number of segments deleted.
+			 * @throws	journal_error if the journal was opened read only.
+			 */
+			size_t trim(uint64_t before_sequence) {
+				const size_t removed = log.trim(before_sequence);
+				const uint64_t first = log.first_sequence();
+				std::unique_lock<std::mutex> index_lock(index_mutex);
+				index.erase(index.begin(), std::lower_bound(index.begin(), index.end(), first,
+					[](const index_entry& entry, uint64_t sequence) { return entry.sequence < sequence; }));
+				return removed;
+			}
+
+			/**
+			 * @brief 	Method get_dropped returns the number of datagrams that were not journaled.
+			 * @return 	uint64_t 	datagrams dropped because no slot was free, they were too large or the append failed.
+			 */
+			uint64_t get_dropped() const {
+				return dropped.load(std::memory_order_relaxed);
+			}
+
+			/**
+			 * @brief 	Method get_index_size returns the number of entries in the sparse index.
+			 * @return 	size_t 	number of index entries.
+			 */
+			size_t get_index_size() {
+				std::unique_lock<std::mutex> index_lock(index_mutex);
+				return index.size();
+			}
+
+			/**
+			 * @brief 	Method get_log returns the log the datagrams are journaled in, each prefixed with its receive time.
+			 * @return 	segmented_log& 	log of the journal.
+			 */
+			segmented_log& get_log() {
+				return log;
+			}
+
+		private:
+			/**
+			 *	@struct	index_entry
+			 * 	@brief 	Struct index_entry is the position and receive time of an indexed record.
+			 */
+			struct index_entry {
+				/// Sequence number of the record.
+				uint64_t sequence;
+				/// Receive time of the record.
+				uint64_t received_ns;
+				/// Offset of the record from the start of its segment.
+				uint64_t offset;
+			};
+
+			/// Log of the datagrams.
+			segmented_log log;
+			/// Slots filled by record and waiting for the writer.
+			ring_buffer<size_t> filled_slots;
+			/// Slots written by the writer and free for record.
+			ring_buffer<size_t> free_slots;
+			/// Largest datagram a slot holds.
+			size_t slot_size;
+			/// Bytes between the starts of slots, which hold the receive time and the datagram.
+			size_t slot_stride = 0;
+			/// Storage of the slots.
+			std::vector<char> arena;
+			/// Size of the datagram in each slot.
+			std::vector<size_t> slot_sizes;
+			/// Number of records between index entries.
+			size_t index_interval;
+			/// Records appended since the last index entry, used by the writer.
+			size_t since_index = 0;
+			/// Receive time of the newest record, used by the writer.
+			uint64_t last_received_ns = 0;
+			/// Sparse index of the records, ordered by sequence and receive time.
+			std::vector<index_entry> index;
+			/// Mutex to control access to the index.
+			std::mutex index_mutex;
+			/// Number of datagrams queued by record.
+			std::atomic<uint64_t> recorded{0};
+			/// Number of queued datagrams the writer has finished with.
+			std::atomic<uint64_t> written{0};
+			/// Number of datagrams that were not journaled.
+			std::atomic<uint64_t> dropped{0};
+			/// Flag for if the writer is waiting for datagrams.
+			std::atomic<bool> writer_idle{false};
+			/// Flag for if the writer should stop once the ring is empty.
+			bool stopping = false;
+			/// Mutex protecting the stopping flag and the conditions.
+			std::mutex wake_mutex;
+			/// Condition used to wake the writer.
+			std::condition_variable wake_condition;
+			/// Condition used to wake flush once datagrams are written.
+			std::condition_variable written_condition;
+			/// Thread appending the queued datagrams to the log.
+			std::thread writer_thread;
+
+			/**
+			 * @brief 	Method read_received reads the receive time in front of a journaled datagram.
+			 * @param 	stored 	record of the datagram.
+			 * @return 	uint64_t 	receive time in nanoseconds since the Unix epoch, 0 for a record too short to hold one.
+			 */
+			static uint64_t read_received(const journal::record& stored) {
+				return stored.size < JOURNAL_SEQUENCE_SIZE ? 0 : byte_order::read_network<uint64_t>(stored.payload);
+			}
+
+			/**
+			 * @brief 	Method index_record adds a record to the index if it is due an entry.
+			 * @param 	sequence 	sequence number of the record.
+			 * @param 	received_ns receive time of the record.
+			 * @param 	offset 		offset of the record from the start of its segment.
+			 */
+			void index_record(uint64_t sequence, uint64_t received_ns, uint64_t offset) {
+				last_received_ns = std::max(last_received_ns, received_ns);
+				if (since_index++ % index_interval == 0) {
+					std::unique_lock<std::mutex> index_lock(index_mutex);
+					index.push_back(index_entry{sequence, received_ns, offset});
+				}
+			}
+
+			/**
+			 * @brief 	Method seek finds the last index entry before the start of a replay.
+			 * @param 	before 	predicate true for the entries at or before the start, which come first in the index.
+			 * @return 	position 	position of the entry, or no position if no entry qualifies.
+			 */
+			template <typename predicate>
+			position seek(predicate&& before) {
+				std::unique_lock<std::mutex> index_lock(index_mutex);
+				const std::vector<index_entry>::iterator after = std::partition_point(index.begin(), index.end(), before);
+				if (after == index.begin()) {
+					// Records older than the first entry may remain after a trim, so start from the beginning of the log.
+					return position();
+				}
+				return position{std::prev(after)->sequence, std::prev(after)->offset};
+			}
+
+			/**
+			 * @brief 	Method write_records appends queued datagrams to the log until the journal is destroyed.
+			 */
+			void write_records() {
+				while (true) {
+					size_t slot;
+					if (filled_slots.pop(slot)) {
+						char* bytes = arena.data() + slot * slot_stride;
+						// Receive times never go backwards in the log so time ranges can be found by binary search.
+						const uint64_t received_ns = std::max(byte_order::read_network<uint64_t>(bytes), last_received_ns);
+						byte_order::write_network(received_ns, bytes);
+						try {
+							position stored;
+							log.append(bytes, JOURNAL_SEQUENCE_SIZE + slot_sizes[slot], nullptr, &stored);
+							index_record(stored.sequence, received_ns, stored.offset);
+						}
+						catch (const errors::journal_error&) {
+							dropped.fetch_add(1, std::memory_order_relaxed);
+						}
+						free_slots.push(slot);
+						written.fetch_add(1, std::memory_order_release);
+						continue;
+					}
+
+					std::unique_lock<std::mutex> wake_lock(wake_mutex);
+					written_condition.notify_all();
+					if (stopping) {
+						return;
+					}
+					// A wake up missed between the check and the wait is covered by the timeout.
+					writer_idle.store(true, std::memory_order_release);
+					wake_condition.wait_for(wake_lock, std::chrono::milliseconds(1), [this]() { return stopping || filled_slots.size() > 0; });
+					writer_idle.store(false, std::memory_order_relaxed);
+				}
+			}
+		};
+	}
+}
+
+#endif /* JOURNAL_HPP */
@@ -0,0 +1,48 @@
+/**
+ * 	@file 	kernel_diagnostics.hpp
+ * 	@brief 	Struct kernel_diagnostics holds the kernel's view of the health of a socket.
+ * 	@author James Horner
+ * 	@date 	2023-04-05
+ */
+
+#ifndef KERNEL_DIAGNOSTICS_HPP
+#define KERNEL_DIAGNOSTICS_HPP
+
+// Standard System Libraries
+#include <cstdint>
+
+namespace oo_socket
+{
+	/**
+	 *	@struct	kernel_diagnostics
+	 * 	@brief 	Struct kernel_diagnostics holds the kernel's view of the health of a socket.
+	 * 	@details	Comparing the kernel drop counters with the user space receive counters shows whether missing
+	 * 				datagrams were dropped by the kernel (the application is not keeping up) or never arrived.
+	 */
+	struct kernel_diagnostics {
+		/// Flag for if the memory information (SO_MEMINFO) was available, only true on Linux.
+		bool memory_information_available;
+		/// Bytes of datagrams waiting in the receive queue.
+		uint32_t receive_queue_bytes;
+		/// Size of the receive buffer in bytes.
+		uint32_t receive_buffer_bytes;
+		/// Bytes of datagrams waiting in the send queue.
+		uint32_t send_queue_bytes;
+		/// Size of the send buffer in bytes.
+		uint32_t send_buffer_bytes;
+		/// Bytes allocated ahead of time for the socket.
+		uint32_t forward_allocated_bytes;
+		/// Bytes used for socket options and ancillary data.
+		uint32_t option_memory_bytes;
+		/// Bytes of datagrams waiting in the socket backlog.
+		uint32_t backlog_bytes;
+		/// Total datagrams dropped by the kernel for any reason.
+		uint32_t drops;
+		/// Total datagrams dropped because the receive buffer was full, as of the last receive (SO_RXQ_OVFL).
+		uint64_t receive_queue_overflows;
+		/// Number of ICMP errors read from the socket error queue (IP_RECVERR).
+		uint64_t icmp_errors;
+	};
+}
+
+#endif /* KERNEL_DIAGNOSTICS_HPP */
@@ -0,0 +1,650 @@
+/**
+ * 	@file 	mac.hpp
+ * 	@brief 	Classes appending and verifying SipHash-2-4 message authentication codes on datagrams over a udp::socket.
+ * 	@author James Horner
+ * 	@date 	2023-04-05
+ */
+
+#ifndef MAC_HPP
+#define MAC_HPP
+
+// Standard System Libraries
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Platform Specific System Libraries
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#endif
+
+// Local Libraries
+#include "byte_order.hpp"
+#include "datagram.hpp"
+#include "errors.hpp"
+#include "socket_address.hpp"
+#include "udp_socket.hpp"
+
+/// Macro for the number of bytes of a SipHash key.
+#define MAC_KEY_SIZE 16
+/// Macro for the number of bytes of the tag appended to every datagram.
+#define MAC_TAG_SIZE 8
+/// Macro for the number of datagrams verified together by siphash::verify_batch.
+#define MAC_BATCH_LANES 4
+/// Macro for the maximum number of source addresses whose verification failures are counted separately.
+#define MAC_MAX_SOURCES 4096
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+/// Macro for if the AVX2 batch kernel is compiled, it is only used when the processor has AVX2.
+#define MAC_AVX2_KERNELS 1
+/// Macro for the instruction set the AVX2 batch kernel is compiled for, whatever the compiler targets.
+#define MAC_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+namespace oo_socket
+{
+	/**
+	 *	@namespace	mac
+	 * 	@brief 	Authentication of datagrams with a SipHash-2-4 tag.
+	 * 	@details	A signed datagram is [payload][tag] where the 8 byte tag is the SipHash-2-4 of the payload in little
+	 * 				endian byte order, as SipHash defines it. The tag is a trailer so a verified payload stays where it
+	 * 				was received and is never copied. SipHash only authenticates, it does not encrypt or stop replays,
+	 * 				so links that need either should use aead::channel instead.
+	 */
+	namespace mac
+	{
+		/**
+		 * @brief 	Function load_little loads a 64 bit value stored least significant byte first.
+		 * @param 	source 		pointer to the 8 bytes.
+		 * @return 	uint64_t 	value in host byte order.
+		 */
+		inline uint64_t load_little(const char* source) {
+			uint64_t value;
+			std::memcpy(&value, source, sizeof(value));
+			return byte_order::HOST_IS_LITTLE_ENDIAN ? value : byte_order::swap_bytes(value);
+		}
+
+		/**
+		 * @brief 	Function rotate rotates a value left.
+		 * @param 	value 		value to rotate.
+		 * @param 	bits 		number of bits to rotate by, between 1 and 63.
+		 * @return 	uint64_t 	rotated value.
+		 */
+		constexpr uint64_t rotate(uint64_t value, int bits) {
+			return (value << bits) | (value >> (64 - bits));
+		}
+
+		/**
+		 *	@struct	sip_state
+		 * 	@brief 	Struct sip_state holds the four state words of SipHash.
+		 */
+		struct sip_state {
+			uint64_t v0;
+			uint64_t v1;
+			uint64_t v2;
+			uint64_t v3;
+
+			/**
+			 * @brief 	Method round applies one SipRound.
+			 */
+			inline void round() {
+				v0 += v1;
+				v1 = rotate(v1, 13);
+				v1 ^= v0;
+				v0 = rotate(v0, 32);
+				v2 += v3;
+				v3 = rotate(v3, 16);
+				v3 ^= v2;
+				v0 += v3;
+				v3 = rotate(v3, 21);
+				v3 ^= v0;
+				v2 += v1;
+				v1 = rotate(v1, 17);
+				v1 ^= v2;
+				v2 = rotate(v2, 32);
+			}
+
+			/**
+			 * @brief 	Method compress absorbs one 8 byte word with two SipRounds.
+			 * @param 	word 	word to absorb.
+			 */
+			inline void compress(uint64_t word) {
+				v3 ^= word;
+				round();
+				round();
+				v0 ^= word;
+			}
+		};
+
+		/**
+		 *	@class	siphash
+		 * 	@brief 	Class siphash computes SipHash-2-4 with a 128 bit key.
+		 * 	@details	SipHash is a pseudorandom function designed for short inputs, so a tag over a typical datagram costs
+		 * 				a few tens of nanoseconds, far less than decoding a forged datagram would. A key is immutable once
+		 * 				constructed so one can be shared between threads.
+		 */
+		class siphash {
+		public:
+			/**
+			 * @brief 	Constructor for the siphash class.
+			 * @param 	key 		bytes of the key.
+			 * @param 	key_size 	size of the key, which must be MAC_KEY_SIZE.
+			 * @param 	allow_avx2 	whether verify_batch may use the AVX2 kernel when the processor has it.
+			 * @throws	configuration_error if the key is not MAC_KEY_SIZE bytes.
+			 */
+			siphash(const uint8_t* key, size_t key_size, bool allow_avx2 = true) {
+				if (key_size != MAC_KEY_SIZE) {
+					throw errors::configuration_error("SipHash keys must be 16 bytes, not " + std::to_string(key_size) + ".");
+				}
+				key0 = load_little((const char*)key);
+				key1 = load_little((const char*)key + 8);
+#if defined(MAC_AVX2_KERNELS)
+				avx2 = allow_avx2 && avx2_supported();
+#else
+				(void)allow_avx2;
+#endif
+			}
+
+			/**
+			 * @brief 	Constructor for the siphash class.
+			 * @param 	key 		bytes of the key, which must be MAC_KEY_SIZE.
+			 * @param 	allow_avx2 	whether verify_batch may use the AVX2 kernel when the processor has it.
+			 * @throws	configuration_error if the key is not MAC_KEY_SIZE bytes.
+			 */
+			explicit siphash(const std::vector<uint8_t>& key, bool allow_avx2 = true) : siphash(key.data(), key.size(), allow_avx2) {}
+
+			/**
+			 * @brief 	Method uses_avx2 returns whether verify_batch hashes datagrams with the AVX2 kernel.
+			 * @return 	bool 	true if the AVX2 kernel is used.
+			 */
+			bool uses_avx2() const {
+				return avx2;
+			}
+
+			/**
+			 * @brief 	Method hash computes the SipHash-2-4 of a buffer.
+			 * @param 	data 		bytes to hash.
+			 * @param 	size 		number of bytes.
+			 * @return 	uint64_t 	64 bit hash.
+			 */
+			uint64_t hash(const char* data, size_t size) const {
+				sip_state state = initial_state();
+				const char* end = data + (size & ~(size_t)7);
+				for (; data != end; data += 8) {
+					state.compress(load_little(data));
+				}
+				return finish(state, data, size);
+			}
+
+			/**
+			 * @brief 	Method sign appends the tag of a buffer to it.
+			 * @param 	buffer 		bytes of the datagram, with room for MAC_TAG_SIZE more bytes after them.
+			 * @param 	size 		size of the datagram in bytes.
+			 * @return 	size_t 		size of the signed datagram, size + MAC_TAG_SIZE.
+			 */
+			size_t sign(char* buffer, size_t size) const {
+				uint64_t tag = hash(buffer, size);
+				if (!byte_order::HOST_IS_LITTLE_ENDIAN) {
+					tag = byte_order::swap_bytes(tag);
+				}
+				std::memcpy(buffer + size, &tag, MAC_TAG_SIZE);
+				return size + MAC_TAG_SIZE;
+			}
+
+			/**
+			 * @brief 	Method verify checks the tag at the end of a signed datagram and removes it.
+			 * @param 	buffer 			bytes of the signed datagram.
+			 * @param 	size[in,out] 	size of the signed datagram, set to the size of the payload if it is authentic.
+			 * @return 	bool 			true if the datagram is authentic.
+			 */
+			bool verify(const char* buffer, size_t& size) const {
+				if (size < MAC_TAG_SIZE) {
+					return false;
+				}
+				const size_t payload_size = size - MAC_TAG_SIZE;
+				if (!matches(hash(buffer, payload_size), buffer + payload_size)) {
+					return false;
+				}
+				size = payload_size;
+				return true;
+			}
+
+			/**
+			 * @brief 	Method verify_batch checks the tags of a batch of received datagrams and removes them.
+			 * @details	When the processor has AVX2 (checked once at run time on x86 with GCC or Clang) the datagrams are
+			 * 				hashed MAC_BATCH_LANES at a time, one in each 64 bit lane, for as many words as the shortest of
+			 * 				them has, which more than halves the cost of each datagram when a stream's datagrams are similar
+			 * 				in size. Otherwise each datagram is verified on its own.
+			 * @param 	datagrams 		datagrams from receive_batch, the size of each authentic one is set to the size
+			 * 							of its payload.
+			 * @param 	count 			number of datagrams.
+			 * @param 	authentic[out] 	count flags set to true for the datagrams that are authentic.
+			 * @return 	size_t 			number of authentic datagrams.
+			 */
+			size_t verify_batch(incoming_datagram* datagrams, size_t count, bool* authentic) const {
+				size_t verified = 0;
+				size_t i = 0;
+#if defined(MAC_AVX2_KERNELS)
+				for (; avx2 && i + MAC_BATCH_LANES <= count; i += MAC_BATCH_LANES) {
+					const char* data[MAC_BATCH_LANES];
+					size_t sizes[MAC_BATCH_LANES];
+					bool long_enough = true;
+					for (size_t lane = 0; lane < MAC_BATCH_LANES; lane++) {
+						data[lane] = datagrams[i + lane].buffer;
+						sizes[lane] = datagrams[i + lane].size - MAC_TAG_SIZE;
+						long_enough &= datagrams[i + lane].size >= MAC_TAG_SIZE;
+					}
+					if (!long_enough) {
+						// A datagram too short to carry a tag sends the group through the single datagram path.
+						for (size_t lane = 0; lane < MAC_BATCH_LANES; lane++) {
+							authentic[i + lane] = verify(datagrams[i + lane].buffer, datagrams[i + lane].size);
+							verified += authentic[i + lane];
+						}
+						continue;
+					}
+					uint64_t hashes[MAC_BATCH_LANES];
+					hash_lanes(data, sizes, hashes);
+					for (size_t lane = 0; lane < MAC_BATCH_LANES; lane++) {
+						authentic[i + lane] = matches(hashes[lane], data[lane] + sizes[lane]);
+						if (authentic[i + lane]) {
+							datagrams[i + lane].size = sizes[lane];
+							verified++;
+						}
+					}
+				}
+#endif
+				for (; i < count; i++) {
+					authentic[i] = verify(datagrams[i].buffer, datagrams[i].size);
+					verified += authentic[i];
+				}
+				return verified;
+			}
+
+		private:
+			/**
+			 * @brief 	Method initial_state returns the state of SipHash before any bytes are absorbed.
+			 * @return 	sip_state 	state initialised from the key.
+			 */
+			sip_state initial_state() const {
+				return sip_state{key0 ^ 0x736f6d6570736575ull, key1 ^ 0x646f72616e646f6dull, key0 ^ 0x6c7967656e657261ull, key1 ^ 0x7465646279746573ull};
+			}
+
+			/**
+			 * @brief 	Method finish absorbs the last partial word of a message and finalises the hash.
+			 * @param 	state 		state after absorbing every whole word.
+			 * @param 	tail 		bytes after the last whole word, fewer than 8.
+			 * @param 	size 		size of the whole message in bytes.
+			 * @return 	uint64_t 	64 bit hash.
+			 */
+			static uint64_t finish(sip_state state, const char* tail, size_t size) {
+				// The last word holds the remaining bytes with the length of the message in its top byte.
+				uint64_t last = (uint64_t)size << 56;
+				const size_t remaining = size & 7;
+				for (size_t i = 0; i < remaining; i++) {
+					last |= (uint64_t)(uint8_t)tail[i] << (8 * i);
+				}
+				state.compress(last);
+				state.v2 ^= 0xff;
+				state.round();
+				state.round();
+				state.round();
+				state.round();
+				return state.v0 ^ state.v1 ^ state.v2 ^ state.v3;
+			}
+
+			/**
+			 * @brief 	Method matches compares a computed hash with a received tag.
+			 * @param 	expected 	hash of the payload.
+			 * @param 	tag 		MAC_TAG_SIZE bytes of received tag.
+			 * @return 	bool 		true if they are equal.
+			 */
+			static bool matches(uint64_t expected, const char* tag) {
+				// The whole tag is compared at once so the time taken does not depend on where it differs.
+				return (expected ^ load_little(tag)) == 0;
+			}
+
+#if defined(MAC_AVX2_KERNELS)
+			/**
+			 * @brief 	Method avx2_supported returns whether the processor has AVX2.
+			 * @return 	bool 	true if the batch kernel can run.
+			 */
+			static bool avx2_supported() {
+#if defined(__AVX2__)
+				return true;
+#else
+				static const bool supported = __builtin_cpu_supports("avx2");
+				return supported;
+#endif
+			}
+
+			/**
+			 * @brief 	Method rotate_lanes rotates each 64 bit lane left.
+			 * @param 	value 	lanes to rotate.
+			 * @param 	bits 	number of bits to rotate by.
+			 * @return 	__m256i the rotated lanes.
+			 */
+			MAC_AVX2_TARGET static __m256i rotate_lanes(__m256i value, int bits) {
+				return _mm256_or_si256(_mm256_slli_epi64(value, bits), _mm256_srli_epi64(value, 64 - bits));
+			}
+
+			/**
+			 * @brief 	Method round_lanes applies a SipRound to each 64 bit lane of the states.
+			 * @param 	v0[in,out] 	first words of the states.
+			 * @param 	v1[in,out] 	second words of the states.
+			 * @param 	v2[in,out] 	third words of the states.
+			 * @param 	v3[in,out] 	fourth words of the states.
+			 */
+			MAC_AVX2_TARGET static void round_lanes(__m256i& v0, __m256i& v1, __m256i& v2, __m256i& v3) {
+				// Rotations by 16 and 32 bits move whole bytes, so they are a single shuffle.
+				const __m256i rotate_16 = _mm256_setr_epi8(6, 7, 0, 1, 2, 3, 4, 5, 14, 15, 8, 9, 10, 11, 12, 13, 6, 7, 0, 1, 2, 3, 4, 5, 14, 15, 8, 9, 10, 11, 12, 13);
+				v0 = _mm256_add_epi64(v0, v1);
+				v1 = _mm256_xor_si256(rotate_lanes(v1, 13), v0);
+				v0 = _mm256_shuffle_epi32(v0, 0xb1);
+				v2 = _mm256_add_epi64(v2, v3);
+				v3 = _mm256_xor_si256(_mm256_shuffle_epi8(v3, rotate_16), v2);
+				v0 = _mm256_add_epi64(v0, v3);
+				v3 = _mm256_xor_si256(rotate_lanes(v3, 21), v0);
+				v2 = _mm256_add_epi64(v2, v1);
+				v1 = _mm256_xor_si256(rotate_lanes(v1, 17), v2);
+				v2 = _mm256_shuffle_epi32(v2, 0xb1);
+			}
+
+			/**
+			 * @brief 	Method hash_lanes computes the SipHash-2-4 of MAC_BATCH_LANES buffers together.
+			 * @param 	data 		bytes of each buffer.
+			 * @param 	sizes 		size of each buffer in bytes.
+			 * @param 	hashes[out]	hash of each buffer.
+			 */
+			MAC_AVX2_TARGET void hash_lanes(const char* const* data, const size_t* sizes, uint64_t* hashes) const {
+				const sip_state start = initial_state();
+				__m256i v0 = _mm256_set1_epi64x((long long)start.v0);
+				__m256i v1 = _mm256_set1_epi64x((long long)start.v1);
+				__m256i v2 = _mm256_set1_epi64x((long long)start.v2);
+				__m256i v3 = _mm256_set1_epi64x((long long)start.v3);
+
+				const size_t words = std::min(std::min(sizes[0], sizes[1]), std::min(sizes[2], sizes[3])) / 8;
+				for (size_t word = 0; word < words; word++) {
+					const size_t offset = word * 8;
+					const __m256i message = _mm256_set_epi64x((long long)load_little(data[3] + offset), (long long)load_little(data[2] + offset), (long long)load_little(data[1] + offset), (long long)load_little(data[0] + offset));
+					v3 = _mm256_xor_si256(v3, message);
+					round_lanes(v0, v1, v2, v3);
+					round_lanes(v0, v1, v2, v3);
+					v0 = _mm256_xor_si256(v0, message);
+				}
+
+				if (sizes[0] == sizes[1] && sizes[0] == sizes[2] && sizes[0] == sizes[3]) {
+					// Buffers of the same size, the usual case within a stream, are also finalised together.
+					uint64_t last[MAC_BATCH_LANES];
+					for (size_t lane = 0; lane < MAC_BATCH_LANES; lane++) {
+						last[lane] = (uint64_t)sizes[lane] << 56;
+						for (size_t i = 0; i < (sizes[lane] & 7); i++) {
+							last[lane] |= (uint64_t)(uint8_t)data[lane][words * 8 + i] << (8 * i);
+						}
+					}
+					const __m256i message = _mm256_loadu_si256((const __m256i*)last);
+					v3 = _mm256_xor_si256(v3, message);
+					round_lanes(v0, v1, v2, v3);
+					round_lanes(v0, v1, v2, v3);
+					v0 = _mm256_xor_si256(v0, message);
+					v2 = _mm256_xor_si256(v2, _mm256_set1_epi64x(0xff));
+					round_lanes(v0, v1, v2, v3);
+					round_lanes(v0, v1, v2, v3);
+					round_lanes(v0, v1, v2, v3);
+					round_lanes(v0, v1, v2, v3);
+					_mm256_storeu_si256((__m256i*)hashes, _mm256_xor_si256(_mm256_xor_si256(v0, v1), _mm256_xor_si256(v2, v3)));
+					return;
+				}
+
+				// Otherwise each lane finishes on its own from where the shortest buffer ran out of whole words.
+				alignas(32) uint64_t lanes[4][MAC_BATCH_LANES];
+				_mm256_store_si256((__m256i*)lanes[0], v0);
+				_mm256_store_si256((__m256i*)lanes[1], v1);
+				_mm256_store_si256((__m256i*)lanes[2], v2);
+				_mm256_store_si256((__m256i*)lanes[3], v3);
+				for (size_t lane = 0; lane < MAC_BATCH_LANES; lane++) {
+					sip_state state{lanes[0][lane], lanes[1][lane], lanes[2][lane], lanes[3][lane]};
+					const char* position = data[lane] + words * 8;
+					const char* end = data[lane] + (sizes[lane] & ~(size_t)7);
+					for (; position != end; position += 8) {
+						state.compress(load_little(position));
+					}
+					hashes[lane] = finish(state, position, sizes[lane]);
+				}
+			}
+#endif
+
+			/// First half of the key, loaded little endian.
+			uint64_t key0;
+			/// Second half of the key, loaded little endian.
+			uint64_t key1;
+			/// Flag for if verify_batch uses the AVX2 kernel.
+			bool avx2 = false;
+		};
+
+		/**
+		 *	@class	channel
+		 * 	@brief 	Class channel signs the datagrams sent through a socket and drops received datagrams that are not
+		 * 			signed with the shared key.
+		 * 	@details	Received datagrams are verified where the socket received them, before the application sees or
+		 * 				copies them, so spoofed and corrupt datagrams cost one hash rather than a decode. Failures are
+		 * 				counted for each source address, ignoring the port so one host cycling through ports takes a single
+		 * 				entry, up to MAC_MAX_SOURCES addresses so a flood of spoofed addresses cannot grow the counts
+		 * 				without bound.
+		 */
+		class channel {
+		public:
+			/**
+			 * @brief 	Constructor for the channel class.
+			 * @param 	channel_socket 	socket that signed datagrams are sent and received on.
+			 * @param 	key 			MAC_KEY_SIZE byte key shared with the peer.
+			 * @throws	configuration_error if the key is not MAC_KEY_SIZE bytes.
+			 */
+			channel(udp::socket& channel_socket, const std::vector<uint8_t>& key) :
+				channel_socket(channel_socket),
+				signer(key)
+			{}
+
+			/**
+			 * @brief 	Method send_to signs and sends a datagram.
+			 * @param 	buffer 		bytes of the datagram.
+			 * @param 	size 		size of the datagram in bytes.
+			 * @param 	destination	address to send the datagram to.
+			 * @return 	int 		number of bytes sent, including the MAC_TAG_SIZE.
+			 * @throws	send_error if an error occurred while sending the data.
+			 */
+			int send_to(const char* buffer, size_t size, const socket_address& destination) {
+				std::unique_lock<std::mutex> send_lock(send_mutex);
+				frames.resize(size + MAC_TAG_SIZE);
+				std::memcpy(frames.data(), buffer, size);
+				const size_t signed_size = signer.sign(frames.data(), size);
+				return channel_socket.send_to(frames.data(), signed_size, destination);
+			}
+
+			/**
+			 * @brief 	Method send_batch_to signs several datagrams and sends them with one call to send_batch_to.
+			 * @param 	datagrams	pointer to the datagrams to send.
+			 * @param 	count		number of datagrams to send.
+			 * @param 	destination	address to send the datagrams to.
+			 * @return 	int 		number of datagrams sent.
+			 * @throws	send_error if no datagram could be sent.
+			 */
+			int send_batch_to(const outgoing_datagram* datagrams, size_t count, const socket_address& destination) {
+				std::unique_lock<std::mutex> send_lock(send_mutex);
+				size_t total = 0;
+				for (size_t i = 0; i < count; i++) {
+					total += datagrams[i].size + MAC_TAG_SIZE;
+				}
+				frames.resize(total);
+				outgoing.resize(count);
+				size_t offset = 0;
+				for (size_t i = 0; i < count; i++) {
+					std::memcpy(frames.data() + offset, datagrams[i].buffer, datagrams[i].size);
+					const size_t signed_size = signer.sign(frames.data() + offset, datagrams[i].size);
+					outgoing[i] = outgoing_datagram{frames.data() + offset, signed_size};
+					offset += signed_size;
+				}
+				return channel_socket.send_batch_to(outgoing.data(), count, destination);
+			}
+
+			/**
+			 * @brief 	Method send_batch_to signs several datagrams and sends them with one call to send_batch_to.
+			 * @param 	datagrams	vector of datagrams to send.
+			 * @param 	destination	address to send the datagrams to.
+			 * @return 	int 		number of datagrams sent.
+			 * @throws	send_error if no datagram could be sent.
+			 */
+			int send_batch_to(const std::vector<outgoing_datagram>& datagrams, const socket_address& destination) {
+				return send_batch_to(datagrams.data(), datagrams.size(), destination);
+			}
+
+			/**
+			 * @brief 	Method receive_batch receives a batch of datagrams and verifies each of them in place.
+			 * @param 	datagrams[in,out]	buffers to receive into, at least MAC_TAG_SIZE bytes larger than the payload.
+			 * @param 	count[in]			number of buffers.
+			 * @param 	with_source[in]		true to set the source address and port of each datagram, which is needed
+			 * 								to count failures for each source (default true).
+			 * @return 	int					number of authentic datagrams, which are moved to the front of the batch in
+			 * 								the order they were received with their size set to the size of the payload,
+			 * 								0 if the receive timed out or only forgeries arrived.
+			 * @throws	receive_error if an error occurred while receiving the data.
+			 * @details	Only one batch is received per call, so datagrams without the key cannot hold the caller past the
+			 * 			socket's receive timeout. Callers that wait for authentic datagrams should check get_failures or
+			 * 			their own deadline rather than treating 0 as a timeout.
+			 */
+			int receive_batch(incoming_datagram* datagrams, size_t count, bool with_source = true) {
+				size_t kept = 0;
+				const int received = channel_socket.receive_batch(datagrams, count, with_source);
+				// Datagrams are verified in chunks of at most MAX_BATCH_SIZE, the most one system call receives.
+				bool authentic[MAX_BATCH_SIZE];
+				for (size_t chunk = 0; chunk < (size_t)received; chunk += MAX_BATCH_SIZE) {
+					const size_t chunk_size = std::min((size_t)received - chunk, (size_t)MAX_BATCH_SIZE);
+					signer.verify_batch(datagrams + chunk, chunk_size, authentic);
+					for (size_t i = chunk; i < chunk + chunk_size; i++) {
+						if (!authentic[i - chunk]) {
+							record_failure(datagrams[i], with_source);
+							continue;
+						}
+						if (kept != i) {
+							std::swap(datagrams[kept], datagrams[i]);
+						}
+						kept++;
+					}
+				}
+				return (int)kept;
+			}
+
+			/**
+			 * @brief 	Method receive_batch receives up to datagrams.size() datagrams and verifies each of them in place.
+			 * @param 	datagrams[in,out]	buffers to receive into, at least MAC_TAG_SIZE bytes larger than the payload.
+			 * @param 	with_source[in]		true to set the source address and port of each datagram, which is needed
+			 * 								to count failures for each source (default true).
+			 * @return 	int					number of authentic datagrams, which are moved to the front of the batch, 0 if
+			 * 								the receive timed out or only forgeries arrived.
+			 * @throws	receive_error if an error occurred while receiving the data.
+			 */
+			int receive_batch(std::vector<incoming_datagram>& datagrams, bool with_source = true) {
+				return receive_batch(datagrams.data(), datagrams.size(), with_source);
+			}
+
+			/**
+			 * @brief 	Method get_failures returns the number of datagrams that were too short or failed verification.
+			 * @return 	uint64_t 	number of datagrams.
+			 */
+			uint64_t get_failures() {
+				std::unique_lock<std::mutex> failure_lock(failure_mutex);
+				return failures;
+			}
+
+			/**
+			 * @brief 	Method get_failures returns the number of datagrams from a source address that failed verification.
+			 * @param 	source 		address of the source, its port is ignored.
+			 * @return 	uint64_t 	number of datagrams from any port of the address, 0 if the address is not counted
+			 * 						separately.
+			 */
+			uint64_t get_failures(const socket_address& source) {
+				const socket_address key = source_key(source);
+				std::unique_lock<std::mutex> failure_lock(failure_mutex);
+				auto found = source_failures.find(key);
+				return found == source_failures.end() ? 0 : found->second;
+			}
+
+			/**
+			 * @brief 	Method get_failure_sources returns the failures counted for each source.
+			 * @return 	std::unordered_map<socket_address, uint64_t, socket_address::hash> 	number of datagrams from each
+			 * 			source address with port 0, IPv4 mapped addresses as plain IPv4, and failures received without
+			 * 			their source under an empty address.
+			 */
+			std::unordered_map<socket_address, uint64_t, socket_address::hash> get_failure_sources() {
+				std::unique_lock<std::mutex> failure_lock(failure_mutex);
+				return source_failures;
+			}
+
+		private:
+			/**
+			 * @brief 	Method source_key returns the address failures from a source are counted under.
+			 * @param 	source 			address of the source.
+			 * @return 	socket_address 	the address as plain IPv4 if it is IPv4 mapped, with port 0.
+			 */
+			static socket_address source_key(const socket_address& source) {
+				socket_address key = source.is_ipv4_mapped() ? source.to_ipv4() : source;
+				if (key.family() == AF_INET) {
+					key.ipv4().sin_port = 0;
+				}
+				else if (key.family() == AF_INET6) {
+					key.ipv6().sin6_port = 0;
+				}
+				return key;
+			}
+
+			/**
+			 * @brief 	Method record_failure counts a datagram that failed verification against its source address.
+			 * @param 	datagram 		datagram that failed.
+			 * @param 	with_source 	true if the source of the datagram was set by the receive.
+			 */
+			void record_failure(const incoming_datagram& datagram, bool with_source) {
+				socket_address source;
+				// Without the source the datagram still holds whatever source an earlier receive set.
+				if (with_source && !datagram.source_address.empty()) {
+					try {
+						source = source_key(socket_address::parse(datagram.source_address, 0));
+					}
+					catch (const errors::configuration_error&) {
+						source = socket_address();
+					}
+				}
+				std::unique_lock<std::mutex> failure_lock(failure_mutex);
+				failures++;
+				auto found = source_failures.find(source);
+				if (found != source_failures.end()) {
+					found->second++;
+				}
+				else if (source_failures.size() < MAC_MAX_SOURCES) {
+					source_failures.emplace(source, 1);
+				}
+			}
+
+			/// Socket signed datagrams are sent and received on.
+			udp::socket& channel_socket;
+			/// Key datagrams are signed and verified with.
+			const siphash signer;
+			/// Mutex protecting the buffers of sends.
+			std::mutex send_mutex;
+			/// Signed datagrams of the batch being sent.
+			std::vector<char> frames;
+			/// Datagrams of the batch being sent.
+			std::vector<outgoing_datagram> outgoing;
+			/// Mutex protecting the failure counts.
+			std::mutex failure_mutex;
+			/// Number of datagrams that failed verification.
+			uint64_t failures = 0;
+			/// Number of datagrams that failed verification from each source address.
+			std::unordered_map<socket_address, uint64_t, socket_address::hash> source_failures;
+		};
+	}
+}
+
+#endif /* MAC_HPP */
@@ -0,0 +1,538 @@
+/**
+ * 	@file 	prometheus.hpp
+ * 	@brief 	Class exporter serializes socket statistics into the Prometheus text exposition format.
+ * 	@author James Horner
+ * 	@date 	2023-04-05
+ */
+
+#ifndef PROMETHEUS_HPP
+#define PROMETHEUS_HPP
+
+// Standard System Libraries
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "errors.hpp"
+#include "statistics.hpp"
+#include "udp_socket.hpp"
+
+/// Macro for the time in milliseconds a scrape client has to send its request or take the response before it is dropped.
+#define PROMETHEUS_CLIENT_TIMEOUT_MS 1000
+
+namespace oo_socket
+{
+	namespace prometheus
+	{
+		/**
+		 *	@class	exporter
+		 * 	@brief 	Class exporter serializes socket statistics into the Prometheus text exposition format.
+		 * 	@details	Statistics are read with relaxed atomic loads so rendering never blocks a socket. The output string
+		 * 				is reused between renders so that steady state rendering does not allocate. The rendered text can
+		 * 				be served over HTTP on a local port or written periodically to a file, for example for the node
+		 * 				exporter textfile collector.
+		 */
+		class exporter {
+		public:
+			/**
+			 * @brief 	Constructor for the exporter class.
+			 * @param 	metric_prefix 	prefix added to every metric name (default "oo_socket").
+			 */
+			explicit exporter(std::string metric_prefix = "oo_socket") : prefix(std::move(metric_prefix)) {}
+
+			/**
+			 * @brief 	Destructor for the exporter class which stops the HTTP listener and file writer.
+			 */
+			~exporter() {
+				stop();
+			}
+
+			/**
+			 * @brief 	Method add_socket registers the statistics of a socket under a name.
+			 * @param 	name 				value of the socket label for the statistics.
+			 * @param 	socket_statistics 	statistics to export.
+			 */
+			void add_socket(const std::string& name, std::shared_ptr<const statistics::socket_statistics> socket_statistics) {
+				std::unique_lock<std::mutex> registry_lock(registry_mutex);
+				sources.push_back(registration{escape_label(name), std::move(socket_statistics), std::weak_ptr<udp::socket>()});
+			}
+
+			/**
+			 * @brief 	Method add_socket registers the statistics of a socket under a name.
+			 * @param 	name 	value of the socket label for the statistics.
+			 * @param 	source 	socket whose statistics should be exported, which may be destroyed before the exporter.
+			 */
+			void add_socket(const std::string& name, udp::socket& source) {
+				add_socket(name, source.get_statistics());
+			}
+
+			/**
+			 * @brief 	Method add_socket registers a shared socket under a name, refreshing its kernel diagnostics before
+			 * 			every render while the socket is alive.
+			 * @param 	name 	value of the socket label for the statistics.
+			 * @param 	shared 	socket whose statistics should be exported.
+			 */
+			void add_socket(const std::string& name, const std::shared_ptr<udp::socket>& shared) {
+				std::unique_lock<std::mutex> registry_lock(registry_mutex);
+				sources.push_back(registration{escape_label(name), shared->get_statistics(), shared});
+			}
+
+			/**
+			 * @brief 	Method remove_socket stops exporting the statistics registered under a name.
+			 * @param 	name 	value of the socket label used when the statistics were added.
+			 */
+			void remove_socket(const std::string& name) {
+				std::unique_lock<std::mutex> registry_lock(registry_mutex);
+				const std::string escaped_name = escape_label(name);
+				for (auto it = sources.begin(); it != sources.end();) {
+					if (it->label == escaped_name) {
+						it = sources.erase(it);
+					}
+					else {
+						++it;
+					}
+				}
+			}
+
+			/**
+			 * @brief 	Method render writes the exposition text of every registered socket.
+			 * @param 	output[out] 	string that is cleared and filled with the exposition text, reuse it to avoid allocation.
+			 */
+			void render(std::string& output) {
+				std::unique_lock<std::mutex> registry_lock(registry_mutex);
+				output.clear();
+
+				// Refresh the kernel view of every socket that is still alive so it matches the user space counters.
+				for (auto& registered : sources) {
+					if (std::shared_ptr<udp::socket> alive = registered.socket.lock()) {
+						alive->get_kernel_diagnostics();
+					}
+				}
+
+				render_value(output, "packets_sent_total", "Datagrams sent successfully.", "counter", &statistics::socket_statistics::packets_sent);
+				render_value(output, "bytes_sent_total", "Bytes sent successfully.", "counter", &statistics::socket_statistics::bytes_sent);
+				render_value(output, "send_errors_total", "Send calls that failed.", "counter", &statistics::socket_statistics::send_errors);
+				render_value(output, "packets_received_total", "Datagrams received.", "counter", &statistics::socket_statistics::packets_received);
+				render_value(output, "bytes_received_total", "Bytes received.", "counter", &statistics::socket_statistics::bytes_received);
+				render_value(output, "receive_timeouts_total", "Receive calls that timed out.", "counter", &statistics::socket_statistics::receive_timeouts);
+				render_value(output, "receive_errors_total", "Receive calls that failed.", "counter", &statistics::socket_statistics::receive_errors);
+
+				render_value(output, "kernel_receive_queue_overflows_total", "Datagrams dropped by the kernel because the receive buffer was full.", "counter", &statistics::socket_statistics::kernel_receive_queue_overflows);
+				render_value(output, "kernel_drops_total", "Datagrams dropped by the kernel for any reason.", "counter", &statistics::socket_statistics::kernel_drops);
+				render_value(output, "icmp_errors_total", "ICMP errors read from the socket error queue.", "counter", &statistics::socket_statistics::icmp_errors);
+				render_value(output, "ecn_capable_received_total", "Datagrams received with an ECN capable codepoint.", "counter", &statistics::socket_statistics::ecn_capable_received);
+				render_value(output, "ecn_congestion_experienced_total", "Datagrams received marked Congestion Experienced.", "counter", &statistics::socket_statistics::ecn_congestion_experienced);
+				render_value(output, "kernel_receive_queue_bytes", "Bytes waiting in the kernel receive queue.", "gauge", &statistics::socket_statistics::kernel_receive_queue_bytes);
+				render_value(output, "kernel_receive_buffer_bytes", "Size of the kernel receive buffer.", "gauge", &statistics::socket_statistics::kernel_receive_buffer_bytes);
+				render_value(output, "kernel_send_queue_bytes", "Bytes waiting in the kernel send queue.", "gauge", &statistics::socket_statistics::kernel_send_queue_bytes);
+				render_value(output, "kernel_send_buffer_bytes", "Size of the kernel send buffer.", "gauge", &statistics::socket_statistics::kernel_send_buffer_bytes);
+				render_value(output, "kernel_backlog_bytes", "Bytes waiting in the socket backlog.", "gauge", &statistics::socket_statistics::kernel_backlog_bytes);
+
+				render_histogram(output, "send_size_bytes", "Sizes of sent datagrams.", &statistics::socket_statistics::send_size_bytes, 1.0);
+				render_histogram(output, "receive_size_bytes", "Sizes of received datagrams.", &statistics::socket_statistics::receive_size_bytes, 1.0);
+				render_histogram(output, "send_duration_seconds", "Durations of send calls.", &statistics::socket_statistics::send_duration_ns, 1e-9);
+				render_histogram(output, "receive_duration_seconds", "Durations of receive calls that returned data.", &statistics::socket_statistics::receive_duration_ns, 1e-9);
+			}
+
+			/**
+			 * @brief 	Method render returns the exposition text of every registered socket.
+			 * @return 	std::string 	exposition text.
+			 */
+			std::string render() {
+				std::string output;
+				render(output);
+				return output;
+			}
+
+			/**
+			 * @brief 	Method write_file renders the statistics into a file, replacing it atomically.
+			 * @param 	path 	path of the file to write.
+			 * @throws	configuration_error if the file could not be written.
+			 */
+			void write_file(const std::string& path) {
+				std::unique_lock<std::mutex> file_lock(file_mutex);
+				render(file_buffer);
+
+				// Write to a temporary file and rename it so scrapers never read a partially written file.
+				const std::string temporary_path = path + ".tmp";
+				{
+					std::ofstream file(temporary_path, std::ios::out | std::ios::trunc | std::ios::binary);
+					file.write(file_buffer.data(), (std::streamsize)file_buffer.size());
+					if (!file) {
+						throw errors::configuration_error("Could not write metrics file " + temporary_path);
+					}
+				}
+#ifdef _WIN32
+				// Windows cannot rename over an existing file, so the old file is briefly missing there.
+				std::remove(path.c_str());
+#endif
+				// POSIX rename replaces the file atomically, so readers see either the old or the new metrics.
+				if (std::rename(temporary_path.c_str(), path.c_str()) != 0) {
+					throw errors::configuration_error("Could not rename metrics file to " + path);
+				}
+			}
+
+			/**
+			 * @brief 	Method start_file_writer starts a thread that writes the statistics to a file periodically.
+			 * @param 	path 			path of the file to write.
+			 * @param 	interval_ms 	number of milliseconds between writes.
+			 * @throws	configuration_error if a file writer is already running.
+			 */
+			void start_file_writer(const std::string& path, unsigned int interval_ms) {
+				std::unique_lock<std::mutex> thread_lock(thread_mutex);
+				if (file_writer_thread.joinable()) {
+					throw errors::configuration_error("Metrics file writer is already running.");
+				}
+				{
+					std::unique_lock<std::mutex> stop_lock(stop_mutex);
+					stopping = false;
+				}
+				file_writer_thread = std::thread([this, path, interval_ms]() {
+					std::unique_lock<std::mutex> stop_lock(stop_mutex);
+					while (!stopping) {
+						stop_lock.unlock();
+						try {
+							write_file(path);
+						}
+						catch (errors::socket_error&) {
+							// A failed write is retried on the next interval.
+						}
+						stop_lock.lock();
+						stop_condition.wait_for(stop_lock, std::chrono::milliseconds(interval_ms), [this]() { return stopping; });
+					}
+				});
+			}
+
+			/**
+			 * @brief 	Method start_http_listener starts a thread serving the statistics over HTTP.
+			 * @param 	port 	TCP port to listen on, 0 to choose a free port (default 9464).
+			 * @param 	address string address to listen on (default loopback).
+			 * @return 	unsigned short 	port the listener is bound to.
+			 * @throws	initialization_error if the listener could not be created.
+			 */
+			unsigned short start_http_listener(unsigned short port = 9464, const std::string& address = "127.0.0.1") {
+				std::unique_lock<std::mutex> thread_lock(thread_mutex);
+				if (http_thread.joinable()) {
+					throw errors::initialization_error("Metrics HTTP listener is already running.");
+				}
+#ifdef _WIN32
+				WSADATA wsa_data;
+				if (::WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0) {
+					throw errors::initialization_error("WSAStartup failed with error: " + std::to_string(::WSAGetLastError()));
+				}
+#endif
+				sockaddr_in listen_address{};
+				listen_address.sin_family = AF_INET;
+				listen_address.sin_port = htons(port);
+				if (::inet_pton(AF_INET, address.c_str(), &listen_address.sin_addr) != 1) {
+					throw errors::initialization_error("Provided metrics listener address was invalid.");
+				}
+
+				listen_descriptor = ::socket(AF_INET, SOCK_STREAM, 0);
+				if (listen_descriptor < 0) {
+					throw errors::initialization_error("Could not create metrics listener socket.");
+				}
+				int on = 1;
+				::setsockopt(listen_descriptor, SOL_SOCKET, SO_REUSEADDR, (char *)&on, sizeof(on));
+				if (::bind(listen_descriptor, (sockaddr*)&listen_address, sizeof(listen_address)) != 0 || ::listen(listen_descriptor, 16) != 0) {
+					close_descriptor(listen_descriptor);
+					throw errors::initialization_error("Could not bind metrics listener to " + address + ":" + std::to_string(port));
+				}
+
+				// Find the port that was actually bound in case 0 was requested.
+				socklen_t address_size = sizeof(listen_address);
+				::getsockname(listen_descriptor, (sockaddr*)&listen_address, &address_size);
+				http_port = ntohs(listen_address.sin_port);
+
+				{
+					std::unique_lock<std::mutex> stop_lock(stop_mutex);
+					stopping = false;
+				}
+				http_thread = std::thread([this]() { serve_http(); });
+				return http_port;
+			}
+
+			/**
+			 * @brief 	Method stop stops the HTTP listener and file writer if they are running.
+			 */
+			void stop() {
+				std::unique_lock<std::mutex> thread_lock(thread_mutex);
+				{
+					std::unique_lock<std::mutex> stop_lock(stop_mutex);
+					stopping = true;
+				}
+				stop_condition.notify_all();
+				if (file_writer_thread.joinable()) {
+					file_writer_thread.join();
+				}
+				if (http_thread.joinable()) {
+					http_thread.join();
+					close_descriptor(listen_descriptor);
+				}
+			}
+
+		protected:
+#ifdef _WIN32
+			using descriptor_type = SOCKET;
+			using socklen_t = int;
+#else
+			using descriptor_type = int;
+#endif
+			/// Prefix added to every metric name.
+			std::string prefix;
+			/**
+			 *	@struct	registration
+			 * 	@brief 	Struct registration holds a registered set of statistics.
+			 */
+			struct registration {
+				/// Escaped value of the socket label.
+				std::string label;
+				/// Statistics to export.
+				std::shared_ptr<const statistics::socket_statistics> statistics;
+				/// Socket whose kernel diagnostics are refreshed before rendering, empty if registered by statistics.
+				std::weak_ptr<udp::socket> socket;
+			};
+
+			/// Registered statistics.
+			std::vector<registration> sources;
+			/// Mutex to control access to the registered statistics.
+			std::mutex registry_mutex;
+
+			/// Buffer reused by write_file.
+			std::string file_buffer;
+			/// Mutex to control access to the file buffer.
+			std::mutex file_mutex;
+
+			/// Thread that periodically writes the metrics file.
+			std::thread file_writer_thread;
+			/// Thread that serves the metrics over HTTP.
+			std::thread http_thread;
+			/// Mutex to control starting and stopping the threads.
+			std::mutex thread_mutex;
+			/// Flag for if the threads should stop.
+			bool stopping = false;
+			/// Mutex protecting the stopping flag.
+			std::mutex stop_mutex;
+			/// Condition used to wake the file writer when stopping.
+			std::condition_variable stop_condition;
+
+			/// Descriptor of the HTTP listening socket.
+			descriptor_type listen_descriptor = (descriptor_type)-1;
+			/// Port the HTTP listener is bound to.
+			unsigned short http_port = 0;
+
+			/**
+			 * @brief 	Method append_number appends an unsigned integer without allocating.
+			 * @param 	output 	string to append to.
+			 * @param 	value 	value to append.
+			 */
+			static void append_number(std::string& output, uint64_t value) {
+				char digits[24];
+				auto result = std::to_chars(digits, digits + sizeof(digits), value);
+				output.append(digits, result.ptr);
+			}
+
+			/**
+			 * @brief 	Method append_number appends a floating point value without allocating.
+			 * @param 	output 	string to append to.
+			 * @param 	value 	value to append.
+			 */
+			static void append_number(std::string& output, double value) {
+				char digits[32];
+				auto result = std::to_chars(digits, digits + sizeof(digits), value);
+				output.append(digits, result.ptr);
+			}
+
+			/**
+			 * @brief 	Method append_header appends the HELP and TYPE lines of a metric family.
+			 * @param 	output 	string to append to.
+			 * @param 	name 	name of the metric without the prefix.
+			 * @param 	help 	description of the metric.
+			 * @param 	type 	Prometheus type of the metric.
+			 */
+			void append_header(std::string& output, const char* name, const char* help, const char* type) {
+				output.append("# HELP ").append(prefix).append("_").append(name).append(" ").append(help).append("\n");
+				output.append("# TYPE ").append(prefix).append("_").append(name).append(" ").append(type).append("\n");
+			}
+
+			/**
+			 * @brief 	Method render_value appends a counter or gauge family with one sample per registered socket.
+			 * @param 	output 	string to append to.
+			 * @param 	name 	name of the metric without the prefix.
+			 * @param 	help 	description of the metric.
+			 * @param 	type 	Prometheus type of the metric.
+			 * @param 	member 	value within the statistics to export.
+			 */
+			void render_value(std::string& output, const char* name, const char* help, const char* type, std::atomic<uint64_t> statistics::socket_statistics::* member) {
+				append_header(output, name, help, type);
+				for (auto& registered : sources) {
+					output.append(prefix).append("_").append(name).append("{socket=\"").append(registered.label).append("\"} ");
+					append_number(output, ((*registered.statistics).*member).load(std::memory_order_relaxed));
+					output.append("\n");
+				}
+			}
+
+			/**
+			 * @brief 	Method render_histogram appends a histogram family with one set of buckets per registered socket.
+			 * @param 	output 	string to append to.
+			 * @param 	name 	name of the metric without the prefix.
+			 * @param 	help 	description of the metric.
+			 * @param 	member 	histogram within the statistics to export.
+			 * @param 	scale 	factor converting histogram values into the exported unit.
+			 */
+			void render_histogram(std::string& output, const char* name, const char* help, statistics::histogram statistics::socket_statistics::* member, double scale) {
+				append_header(output, name, help, "histogram");
+				for (auto& registered : sources) {
+					const statistics::histogram& values = (*registered.statistics).*member;
+
+					// Buckets are cumulative in the exposition format. The count is read from the buckets so the
+					// +Inf bucket and the count always agree even if observations happen while rendering.
+					uint64_t cumulative = 0;
+					for (size_t i = 0; i < statistics::histogram::BUCKET_COUNT; i++) {
+						cumulative += values.bucket_count(i);
+						output.append(prefix).append("_").append(name).append("_bucket{socket=\"").append(registered.label).append("\",le=\"");
+						if (i + 1 < statistics::histogram::BUCKET_COUNT) {
+							append_number(output, (double)statistics::histogram::bucket_upper_bound(i) * scale);
+						}
+						else {
+							output.append("+Inf");
+						}
+						output.append("\"} ");
+						append_number(output, cumulative);
+						output.append("\n");
+					}
+
+					output.append(prefix).append("_").append(name).append("_sum{socket=\"").append(registered.label).append("\"} ");
+					append_number(output, (double)values.get_sum() * scale);
+					output.append("\n");
+					output.append(prefix).append("_").append(name).append("_count{socket=\"").append(registered.label).append("\"} ");
+					append_number(output, cumulative);
+					output.append("\n");
+				}
+			}
+
+			/**
+			 * @brief 	Method escape_label escapes a label value for the exposition format.
+			 * @param 	value 			raw label value.
+			 * @return 	std::string 	value with backslashes, quotes and newlines escaped.
+			 */
+			static std::string escape_label(const std::string& value) {
+				std::string escaped;
+				for (char character : value) {
+					if (character == '\\' || character == '"') {
+						escaped.push_back('\\');
+						escaped.push_back(character);
+					}
+					else if (character == '\n') {
+						escaped.append("\\n");
+					}
+					else {
+						escaped.push_back(character);
+					}
+				}
+				return escaped;
+			}
+
+			/**
+			 * @brief 	Method serve_http accepts connections and answers each with the rendered metrics until stopped.
+			 */
+			void serve_http() {
+				std::string body;
+				std::string response;
+				char request[4096];
+				while (true) {
+					{
+						std::unique_lock<std::mutex> stop_lock(stop_mutex);
+						if (stopping) {
+							return;
+						}
+					}
+
+					// Wait for a connection with a timeout so that stop is noticed promptly.
+					fd_set read_set;
+					FD_ZERO(&read_set);
+					FD_SET(listen_descriptor, &read_set);
+					timeval timeout{0, 100000};
+					if (::select((int)listen_descriptor + 1, &read_set, nullptr, nullptr, &timeout) <= 0) {
+						continue;
+					}
+					descriptor_type client = ::accept(listen_descriptor, nullptr, nullptr);
+					if (client < 0) {
+						continue;
+					}
+
+					// The only serving thread must not wait forever on a client that never sends or reads, so the
+					// client is dropped when either takes longer than the timeout.
+					set_client_timeouts(client);
+
+					// Only the request line matters, anything other than the metrics path is not found.
+					int request_size = ::recv(client, request, sizeof(request) - 1, 0);
+					if (request_size <= 0) {
+						close_descriptor(client);
+						continue;
+					}
+					request[request_size] = '\0';
+					const std::string request_line(request, std::strcspn(request, "\r\n"));
+					if (request_line.rfind("GET /metrics ", 0) == 0 || request_line.rfind("GET / ", 0) == 0) {
+						render(body);
+						response.assign("HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\nContent-Length: ");
+					}
+					else {
+						body.assign("Not Found\n");
+						response.assign("HTTP/1.1 404 Not Found\r\nContent-Type: text/plain\r\nContent-Length: ");
+					}
+					append_number(response, (uint64_t)body.size());
+					response.append("\r\nConnection: close\r\n\r\n").append(body);
+
+					size_t sent = 0;
+					while (sent < response.size()) {
+						int result = ::send(client, response.data() + sent, (int)(response.size() - sent), 0);
+						if (result <= 0) {
+							break;
+						}
+						sent += (size_t)result;
+					}
+					close_descriptor(client);
+				}
+			}
+
+			/**
+			 * @brief 	Method set_client_timeouts limits how long receives and sends on a client connection can block.
+			 * @param 	client 	descriptor of the accepted connection.
+			 */
+			static void set_client_timeouts(descriptor_type client) {
+#ifdef _WIN32
+				DWORD timeout = PROMETHEUS_CLIENT_TIMEOUT_MS;
+#else
+				timeval timeout{PROMETHEUS_CLIENT_TIMEOUT_MS / 1000, (PROMETHEUS_CLIENT_TIMEOUT_MS % 1000) * 1000};
+#endif
+				::setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, (char*)&timeout, sizeof(timeout));
+				::setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, (char*)&timeout, sizeof(timeout));
+			}
+
+			/**
+			 * @brief 	Method close_descriptor closes a TCP socket descriptor.
+			 * @param 	descriptor 	descriptor to close.
+			 */
+			static void close_descriptor(descriptor_type descriptor) {
+#ifdef _WIN32
+				::closesocket(descriptor);
+#else
+				::close(descriptor);
+#endif
+			}
+		};
+	}
+}
+
+#endif /* PROMETHEUS_HPP */
@@ -0,0 +1,144 @@
+/**
+ * 	@file 	rate_limiter.hpp
+ * 	@brief 	Class token_bucket limits the rate of an operation while allowing short bursts.
+ * 	@author James Horner
+ * 	@date 	2023-04-05
+ */
+
+#ifndef RATE_LIMITER_HPP
+#define RATE_LIMITER_HPP
+
+// Standard System Libraries
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+/// Macro for how close to the deadline, in nanoseconds, consume stops sleeping and spins instead.
+#define RATE_LIMITER_SPIN_NS 50000
+
+namespace oo_socket
+{
+	/**
+	 *	@class	token_bucket
+	 * 	@brief 	Class token_bucket refills tokens at a fixed rate up to a burst size and hands them out on request.
+	 * 	@details	The bucket is not thread safe, each thread that paces traffic should own its own bucket. A rate of
+	 * 				zero or less disables limiting so every request succeeds immediately.
+	 */
+	class token_bucket {
+	public:
+		/**
+		 * @brief 	Constructor for the token_bucket class, the bucket starts full.
+		 * @param 	rate 	tokens added per second.
+		 * @param 	burst 	maximum number of tokens the bucket can hold (at least 1).
+		 */
+		token_bucket(double rate, double burst) :
+			rate(rate),
+			burst(std::max(burst, 1.0)),
+			tokens(std::max(burst, 1.0)),
+			last_refill_ns(now_ns())
+		{}
+
+		/**
+		 * @brief 	Method try_consume takes tokens from the bucket if enough are available.
+		 * @param 	count 	number of tokens to take (default 1).
+		 * @return 	bool 	true if the tokens were taken, false if the bucket did not hold enough.
+		 */
+		bool try_consume(double count = 1) {
+			if (rate <= 0) {
+				return true;
+			}
+			refill(now_ns());
+			if (tokens < count) {
+				return false;
+			}
+			tokens -= count;
+			return true;
+		}
+
+		/**
+		 * @brief 	Method wait_time_ns returns how long until the bucket will hold enough tokens.
+		 * @param 	count 		number of tokens needed (default 1).
+		 * @return 	uint64_t 	nanoseconds until the tokens are available, 0 if they are available now.
+		 */
+		uint64_t wait_time_ns(double count = 1) {
+			if (rate <= 0) {
+				return 0;
+			}
+			refill(now_ns());
+			if (tokens >= count) {
+				return 0;
+			}
+			return (uint64_t)((count - tokens) / rate * 1e9) + 1;
+		}
+
+		/**
+		 * @brief 	Method consume takes tokens from the bucket, blocking until they are available.
+		 * @param 	count 	number of tokens to take (default 1). Counts larger than the burst put the bucket into debt
+		 * 					so the long term rate is still respected.
+		 * @details	The thread sleeps while the wait is long and spins for the last RATE_LIMITER_SPIN_NS nanoseconds,
+		 * 			since sleeps are too coarse to pace high packet rates accurately.
+		 */
+		void consume(double count = 1) {
+			if (rate <= 0) {
+				return;
+			}
+			const double needed = std::min(count, burst);
+			uint64_t wait_ns;
+			while ((wait_ns = wait_time_ns(needed)) > 0) {
+				if (wait_ns > RATE_LIMITER_SPIN_NS) {
+					std::this_thread::sleep_for(std::chrono::nanoseconds(wait_ns - RATE_LIMITER_SPIN_NS));
+				}
+			}
+			tokens -= count;
+		}
+
+		/**
+		 * @brief 	Method set_rate changes the refill rate of the bucket.
+		 * @param 	new_rate 	tokens added per second, zero or less disables limiting.
+		 */
+		void set_rate(double new_rate) {
+			refill(now_ns());
+			rate = new_rate;
+		}
+
+		/**
+		 * @brief 	Method get_rate returns the refill rate of the bucket.
+		 * @return 	double 	tokens added per second.
+		 */
+		double get_rate() const {
+			return rate;
+		}
+
+	protected:
+		/// Tokens added per second.
+		double rate;
+		/// Maximum number of tokens the bucket can hold.
+		double burst;
+		/// Tokens currently in the bucket, negative when a large consume put the bucket into debt.
+		double tokens;
+		/// Time the bucket was last refilled in nanoseconds.
+		uint64_t last_refill_ns;
+
+		/**
+		 * @brief 	Method refill adds the tokens accumulated since the last refill.
+		 * @param 	current_ns 	current time in nanoseconds.
+		 */
+		void refill(uint64_t current_ns) {
+			if (current_ns > last_refill_ns) {
+				tokens = std::min(burst, tokens + (double)(current_ns - last_refill_ns) * rate / 1e9);
+				last_refill_ns = current_ns;
+			}
+		}
+
+		/**
+		 * @brief 	Method now_ns returns the current time of the steady clock.
+		 * @return 	uint64_t 	nanoseconds since the steady clock epoch.
+		 */
+		static uint64_t now_ns() {
+			return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+	};
+}
+
+#endif /* RATE_LIMITER_HPP */
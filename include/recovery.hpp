@@ -0,0 +1,644 @@
+/**
+ * 	@file 	recovery.hpp
+ * 	@brief 	Classes detecting gaps in journaled streams and retransmitting the missing datagrams from the journal.
+ * 	@author James Horner
+ * 	@date 	2023-04-05
+ */
+
+#ifndef RECOVERY_HPP
+#define RECOVERY_HPP
+
+// Standard System Libraries
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <vector>
+
+// Local Libraries
+#include "byte_order.hpp"
+#include "datagram.hpp"
+#include "errors.hpp"
+#include "journal.hpp"
+#include "rate_limiter.hpp"
+#include "socket_address.hpp"
+#include "udp_socket.hpp"
+
+/// Macro for the number of bytes before the ranges of a recovery request.
+#define RECOVERY_REQUEST_HEADER_SIZE 2
+/// Macro for the number of bytes of each range in a recovery request or notice.
+#define RECOVERY_RANGE_SIZE 16
+/// Macro for the most ranges a single recovery request carries.
+#define RECOVERY_MAX_RANGES 64
+/// Macro for the size of a notice that a range is no longer in the journal.
+#define RECOVERY_NOTICE_SIZE (JOURNAL_SEQUENCE_SIZE + RECOVERY_RANGE_SIZE)
+/// Macro for the default most ranges a server keeps waiting to be sent.
+#define RECOVERY_MAX_PENDING 1024
+
+namespace oo_socket
+{
+	/**
+	 *	@namespace	recovery
+	 * 	@brief 	Recovery of datagrams lost from a stream sent through an outbound journal.
+	 * 	@details	Receivers track the journal sequence numbers they have seen and send requests of the form
+	 * 				[0xD1][range count][first, last]... with each sequence number in network byte order. The server
+	 * 				answers on its own socket with the journaled frames, which are identical to the live datagrams, and
+	 * 				with a frame of sequence 0 followed by [first, last] for a range that is no longer in the journal.
+	 * 				Sequence 0 is never used by a journal so the notices cannot be mistaken for data.
+	 */
+	namespace recovery
+	{
+		/// Value of the first byte of a recovery request.
+		constexpr uint8_t REQUEST_KIND = 0xD1;
+
+		/**
+		 *	@struct	sequence_range
+		 * 	@brief 	Struct sequence_range is an inclusive range of sequence numbers.
+		 */
+		struct sequence_range {
+			/// First sequence number of the range.
+			uint64_t first;
+			/// Last sequence number of the range.
+			uint64_t last;
+
+			/**
+			 * @brief 	Operator == compares two ranges.
+			 * @param 	other 	range to compare with.
+			 * @return 	bool 	true if the ranges are the same.
+			 */
+			bool operator==(const sequence_range& other) const {
+				return first == other.first && last == other.last;
+			}
+		};
+
+		/**************************************************************************************************/
+		/* Encoding Functions			 																  */
+		/**************************************************************************************************/
+		/**
+		 * @brief 	Function write_request encodes a recovery request.
+		 * @param 	ranges 		ranges to request.
+		 * @param 	count 		number of ranges, at most RECOVERY_MAX_RANGES.
+		 * @param 	destination buffer of at least RECOVERY_REQUEST_HEADER_SIZE + count * RECOVERY_RANGE_SIZE bytes.
+		 * @return 	size_t 		number of bytes written.
+		 * @throws	encode_error if there are too many ranges.
+		 */
+		inline size_t write_request(const sequence_range* ranges, size_t count, char* destination) {
+			if (count > RECOVERY_MAX_RANGES) {
+				throw errors::encode_error("A recovery request holds at most " + std::to_string(RECOVERY_MAX_RANGES) + " ranges.");
+			}
+			destination[0] = (char)REQUEST_KIND;
+			destination[1] = (char)count;
+			for (size_t i = 0; i < count; i++) {
+				byte_order::write_network(ranges[i].first, destination + RECOVERY_REQUEST_HEADER_SIZE + i * RECOVERY_RANGE_SIZE);
+				byte_order::write_network(ranges[i].last, destination + RECOVERY_REQUEST_HEADER_SIZE + i * RECOVERY_RANGE_SIZE + 8);
+			}
+			return RECOVERY_REQUEST_HEADER_SIZE + count * RECOVERY_RANGE_SIZE;
+		}
+
+		/**
+		 * @brief 	Function read_request decodes a recovery request.
+		 * @param 	buffer 		bytes of the datagram.
+		 * @param 	size 		size of the datagram in bytes.
+		 * @param 	ranges[out]	ranges requested, replacing its contents.
+		 * @return 	bool 		true if the datagram is a well formed request with ranges whose first is not after their last.
+		 */
+		inline bool read_request(const char* buffer, size_t size, std::vector<sequence_range>& ranges) {
+			if (size < RECOVERY_REQUEST_HEADER_SIZE || (uint8_t)buffer[0] != REQUEST_KIND) {
+				return false;
+			}
+			const size_t count = (uint8_t)buffer[1];
+			if (count > RECOVERY_MAX_RANGES || size != RECOVERY_REQUEST_HEADER_SIZE + count * RECOVERY_RANGE_SIZE) {
+				return false;
+			}
+			ranges.resize(count);
+			for (size_t i = 0; i < count; i++) {
+				ranges[i].first = byte_order::read_network<uint64_t>(buffer + RECOVERY_REQUEST_HEADER_SIZE + i * RECOVERY_RANGE_SIZE);
+				ranges[i].last = byte_order::read_network<uint64_t>(buffer + RECOVERY_REQUEST_HEADER_SIZE + i * RECOVERY_RANGE_SIZE + 8);
+				if (ranges[i].first == 0 || ranges[i].first > ranges[i].last) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		/**
+		 * @brief 	Function write_notice encodes a notice that a range is no longer in the journal.
+		 * @param 	range 		range that cannot be recovered.
+		 * @param 	destination buffer of at least RECOVERY_NOTICE_SIZE bytes.
+		 */
+		inline void write_notice(const sequence_range& range, char* destination) {
+			byte_order::write_network((uint64_t)0, destination);
+			byte_order::write_network(range.first, destination + JOURNAL_SEQUENCE_SIZE);
+			byte_order::write_network(range.last, destination + JOURNAL_SEQUENCE_SIZE + 8);
+		}
+
+		/**
+		 * @brief 	Function read_notice decodes a notice that a range is no longer in the journal.
+		 * @param 	buffer 		bytes of the datagram.
+		 * @param 	size 		size of the datagram in bytes.
+		 * @param 	range[out]	range that cannot be recovered.
+		 * @return 	bool 		true if the datagram is a notice.
+		 */
+		inline bool read_notice(const char* buffer, size_t size, sequence_range& range) {
+			if (size != RECOVERY_NOTICE_SIZE || journal::read_sequence(buffer) != 0) {
+				return false;
+			}
+			range.first = byte_order::read_network<uint64_t>(buffer + JOURNAL_SEQUENCE_SIZE);
+			range.last = byte_order::read_network<uint64_t>(buffer + JOURNAL_SEQUENCE_SIZE + 8);
+			return true;
+		}
+
+		/**************************************************************************************************/
+		/* Gap Tracker					 																  */
+		/**************************************************************************************************/
+		/**
+		 *	@class	gap_tracker
+		 * 	@brief 	Class gap_tracker follows the sequence numbers received from a journaled stream and the gaps in them.
+		 * 	@details	Every sequence number from the first expected onwards is tracked, so a jump forward opens a gap
+		 * 				that later arrivals fill in, sequence numbers received twice are reported as duplicates and older
+		 * 				sequence numbers are ignored. The tracker is not thread safe.
+		 */
+		class gap_tracker {
+		public:
+			/**
+			 * @brief 	Constructor for the gap_tracker class.
+			 * @param 	first_expected 	first sequence number to track, later for a receiver that does not want the
+			 * 							history before it joined (default 1).
+			 */
+			explicit gap_tracker(uint64_t first_expected = 1) :
+				next_expected(std::max<uint64_t>(first_expected, 1)),
+				first_tracked(std::max<uint64_t>(first_expected, 1))
+			{}
+
+			/**
+			 * @brief 	Method observe records a received sequence number.
+			 * @param 	sequence 	sequence number of the datagram.
+			 * @return 	bool 		true if the sequence number is new, false if it is a duplicate, 0 or given up on.
+			 */
+			bool observe(uint64_t sequence) {
+				if (sequence == 0) {
+					return false;
+				}
+				if (sequence >= next_expected) {
+					if (sequence > next_expected) {
+						gaps[next_expected] = sequence - 1;
+					}
+					next_expected = sequence + 1;
+					return true;
+				}
+				// Older sequence numbers are only new if they fill part of a gap.
+				if (sequence < first_tracked) {
+					return false;
+				}
+				std::map<uint64_t, uint64_t>::iterator gap = gaps.upper_bound(sequence);
+				if (gap == gaps.begin() || (--gap)->second < sequence) {
+					return false;
+				}
+				const uint64_t first = gap->first;
+				const uint64_t last = gap->second;
+				gaps.erase(gap);
+				if (first < sequence) {
+					gaps[first] = sequence - 1;
+				}
+				if (sequence < last) {
+					gaps[sequence + 1] = last;
+				}
+				return true;
+			}
+
+			/**
+			 * @brief 	Method give_up stops waiting for a range, such as one the sender no longer has.
+			 * @param 	range 	range of sequence numbers that will not arrive.
+			 * @return 	uint64_t 	number of missing sequence numbers given up on.
+			 */
+			uint64_t give_up(const sequence_range& range) {
+				uint64_t abandoned = 0;
+				std::map<uint64_t, uint64_t>::iterator gap = gaps.upper_bound(range.first);
+				if (gap != gaps.begin()) {
+					--gap;
+				}
+				while (gap != gaps.end() && gap->first <= range.last) {
+					const uint64_t first = gap->first;
+					const uint64_t last = gap->second;
+					if (last < range.first) {
+						++gap;
+						continue;
+					}
+					gap = gaps.erase(gap);
+					if (first < range.first) {
+						gaps[first] = range.first - 1;
+					}
+					if (last > range.last) {
+						gaps[range.last + 1] = last;
+					}
+					abandoned += std::min(last, range.last) - std::max(first, range.first) + 1;
+				}
+				// Sequence numbers not received yet are skipped over rather than waited for.
+				if (range.last >= next_expected) {
+					if (range.first > next_expected) {
+						gaps[next_expected] = range.first - 1;
+					}
+					abandoned += range.last + 1 - std::max(range.first, next_expected);
+					next_expected = range.last + 1;
+				}
+				given_up += abandoned;
+				return abandoned;
+			}
+
+			/**
+			 * @brief 	Method missing returns the gaps, oldest first.
+			 * @param 	limit 	most ranges to return (default all).
+			 * @return 	std::vector<sequence_range> 	missing ranges.
+			 */
+			std::vector<sequence_range> missing(size_t limit = SIZE_MAX) const {
+				std::vector<sequence_range> ranges;
+				for (std::map<uint64_t, uint64_t>::const_iterator gap = gaps.begin(); gap != gaps.end() && ranges.size() < limit; ++gap) {
+					ranges.push_back(sequence_range{gap->first, gap->second});
+				}
+				return ranges;
+			}
+
+			/**
+			 * @brief 	Method missing_count returns the number of sequence numbers in the gaps.
+			 * @return 	uint64_t 	sequence numbers still missing.
+			 */
+			uint64_t missing_count() const {
+				uint64_t count = 0;
+				for (const std::pair<const uint64_t, uint64_t>& gap : gaps) {
+					count += gap.second - gap.first + 1;
+				}
+				return count;
+			}
+
+			/**
+			 * @brief 	Method get_next_expected returns the sequence number after the newest received.
+			 * @return 	uint64_t 	next sequence number expected.
+			 */
+			uint64_t get_next_expected() const {
+				return next_expected;
+			}
+
+			/**
+			 * @brief 	Method get_contiguous returns the newest sequence number received with none missing before it,
+			 * 			which is what a receiver acknowledges.
+			 * @return 	uint64_t 	sequence number, one before the first expected if nothing has been received.
+			 */
+			uint64_t get_contiguous() const {
+				return gaps.empty() ? next_expected - 1 : gaps.begin()->first - 1;
+			}
+
+			/**
+			 * @brief 	Method get_given_up returns the number of sequence numbers given up on.
+			 * @return 	uint64_t 	sequence numbers that will not be received.
+			 */
+			uint64_t get_given_up() const {
+				return given_up;
+			}
+
+		private:
+			/// Sequence number after the newest received.
+			uint64_t next_expected;
+			/// First sequence number tracked.
+			uint64_t first_tracked;
+			/// Gaps keyed by their first sequence number with their last as the value.
+			std::map<uint64_t, uint64_t> gaps;
+			/// Number of sequence numbers given up on.
+			uint64_t given_up = 0;
+		};
+
+		/**************************************************************************************************/
+		/* Recovery Client				 																  */
+		/**************************************************************************************************/
+		/**
+		 *	@class	recovery_client
+		 * 	@brief 	Class recovery_client tracks a journaled stream and requests the datagrams missing from it.
+		 * 	@details	Pass every live datagram and every datagram received on the recovery socket to accept, which
+		 * 				returns true for datagrams that should be delivered, and call request periodically while there
+		 * 				are gaps. The client is not thread safe and the socket must outlive it.
+		 */
+		class recovery_client {
+		public:
+			/**
+			 * @brief 	Constructor for the recovery_client class.
+			 * @param 	recovery_socket 	socket that requests are sent and retransmissions received on.
+			 * @param 	server 				address and port of the recovery server.
+			 * @param 	first_expected 		first sequence number to recover (default 1).
+			 */
+			recovery_client(udp::socket& recovery_socket, const socket_address& server, uint64_t first_expected = 1) :
+				recovery_socket(recovery_socket),
+				server(server),
+				tracker(first_expected)
+			{}
+
+			/**
+			 * @brief 	Method accept tracks a journaled datagram from the live stream or the recovery socket.
+			 * @param 	datagram 	bytes of the datagram, starting with its sequence number.
+			 * @param 	size 		size of the datagram in bytes.
+			 * @return 	bool 		true if the payload after the sequence number should be delivered, false for
+			 * 						duplicates, notices and datagrams too short to hold a sequence number.
+			 */
+			bool accept(const char* datagram, size_t size) {
+				if (size < JOURNAL_SEQUENCE_SIZE) {
+					return false;
+				}
+				sequence_range unavailable;
+				if (read_notice(datagram, size, unavailable)) {
+					tracker.give_up(unavailable);
+					return false;
+				}
+				return tracker.observe(journal::read_sequence(datagram));
+			}
+
+			/**
+			 * @brief 	Method request asks the server for every gap, oldest first.
+			 * @param 	limit 	most ranges to request (default RECOVERY_MAX_RANGES, one datagram).
+			 * @return 	size_t 	number of ranges requested.
+			 * @throws	send_error if a request could not be sent.
+			 */
+			size_t request(size_t limit = RECOVERY_MAX_RANGES) {
+				const std::vector<sequence_range> ranges = tracker.missing(limit);
+				char buffer[RECOVERY_REQUEST_HEADER_SIZE + RECOVERY_MAX_RANGES * RECOVERY_RANGE_SIZE];
+				for (size_t sent = 0; sent < ranges.size(); sent += RECOVERY_MAX_RANGES) {
+					const size_t count = std::min(ranges.size() - sent, (size_t)RECOVERY_MAX_RANGES);
+					recovery_socket.send_to(buffer, write_request(ranges.data() + sent, count, buffer), server);
+				}
+				return ranges.size();
+			}
+
+			/**
+			 * @brief 	Method get_tracker returns the sequence numbers and gaps seen so far.
+			 * @return 	const gap_tracker& 	tracker of the stream.
+			 */
+			const gap_tracker& get_tracker() const {
+				return tracker;
+			}
+
+		private:
+			/// Socket requests are sent on.
+			udp::socket& recovery_socket;
+			/// Address and port of the recovery server.
+			socket_address server;
+			/// Sequence numbers and gaps of the stream.
+			gap_tracker tracker;
+		};
+
+		/**************************************************************************************************/
+		/* Recovery Server				 																  */
+		/**************************************************************************************************/
+		/**
+		 *	@class	recovery_server
+		 * 	@brief 	Class recovery_server answers recovery requests with datagrams from a journal.
+		 * 	@details	handle queues the ranges of each request and service sends them, a batch at a time, through its
+		 * 				own socket so retransmissions never queue behind or in front of the live stream. Sends are paced by
+		 * 				a token bucket of datagrams per second so recovery cannot starve the live stream of bandwidth, and
+		 * 				pending ranges take turns so one receiver with a large gap cannot hold up the others. Requests for
+		 * 				the same requester that overlap a pending range are merged into it, and ranges beyond what has been
+		 * 				journaled are cut short. The server is thread safe and the socket and log must outlive it.
+		 */
+		class recovery_server {
+		public:
+			/**
+			 * @brief 	Constructor for the recovery_server class.
+			 * @param 	recovery_socket 	socket that requests are received and retransmissions sent on.
+			 * @param 	log 				journal of the stream, such as outbound_journal::get_log().
+			 * @param 	rate 				datagrams retransmitted per second, 0 or less for no limit.
+			 * @param 	burst 				datagrams that can be retransmitted at once after a quiet period.
+			 * @param 	max_pending 		most ranges waiting to be sent, more are dropped (default RECOVERY_MAX_PENDING).
+			 */
+			recovery_server(udp::socket& recovery_socket, journal::segmented_log& log, double rate, double burst, size_t max_pending = RECOVERY_MAX_PENDING) :
+				recovery_socket(recovery_socket),
+				log(log),
+				pacing(rate, burst),
+				max_pending(max_pending)
+			{}
+
+			/**
+			 * @brief 	Method handle queues the ranges of a recovery request.
+			 * @param 	buffer 		bytes of the datagram.
+			 * @param 	size 		size of the datagram in bytes.
+			 * @param 	requester 	address and port the request came from, where the ranges are sent.
+			 * @return 	bool 		true if the datagram was a recovery request.
+			 */
+			bool handle(const char* buffer, size_t size, const socket_address& requester) {
+				std::unique_lock<std::mutex> server_lock(server_mutex);
+				if (!read_request(buffer, size, request_ranges)) {
+					return false;
+				}
+				for (const sequence_range& range : request_ranges) {
+					bool merged = false;
+					for (pending_range& waiting : pending) {
+						if (waiting.requester == requester && range.first <= waiting.range.last + 1 && waiting.range.first <= range.last + 1) {
+							waiting.range.first = std::min(waiting.range.first, range.first);
+							waiting.range.last = std::max(waiting.range.last, range.last);
+							merged = true;
+							break;
+						}
+					}
+					if (!merged && pending.size() < max_pending) {
+						pending.push_back(pending_range{requester, range});
+					}
+					else if (!merged) {
+						dropped_ranges++;
+					}
+				}
+				return true;
+			}
+
+			/**
+			 * @brief 	Method handle queues the ranges of a recovery request received with receive_batch.
+			 * @param 	datagram 	datagram received with its source.
+			 * @return 	bool 		true if the datagram was a recovery request.
+			 * @throws	configuration_error if the source address of the datagram could not be parsed.
+			 */
+			bool handle(const incoming_datagram& datagram) {
+				if (datagram.size < RECOVERY_REQUEST_HEADER_SIZE || (uint8_t)datagram.buffer[0] != REQUEST_KIND) {
+					return false;
+				}
+				return handle(datagram.buffer, datagram.size, socket_address::parse(datagram.source_address, datagram.source_port));
+			}
+
+			/**
+			 * @brief 	Method service sends as many pending datagrams as the rate limit allows.
+			 * @return 	size_t 	number of datagrams and notices sent.
+			 */
+			size_t service() {
+				std::unique_lock<std::mutex> server_lock(server_mutex);
+				size_t sent = 0;
+				// Each pending range gets a turn of at most one batch, and a range that is not finished goes to the back.
+				const size_t turns = pending.size();
+				for (size_t turn = 0; turn < turns && !pending.empty(); turn++) {
+					pending_range current = pending.front();
+					pending.pop_front();
+
+					const uint64_t first_kept = log.first_sequence();
+					const uint64_t last_journaled = log.next_sequence() - 1;
+					if (current.range.first < first_kept) {
+						const sequence_range unavailable{current.range.first, std::min(current.range.last, first_kept - 1)};
+						if (!pacing.try_consume()) {
+							pending.push_front(current);
+							break;
+						}
+						char notice[RECOVERY_NOTICE_SIZE];
+						write_notice(unavailable, notice);
+						try {
+							recovery_socket.send_to(notice, sizeof(notice), current.requester);
+							sent++;
+							unavailable_ranges++;
+						}
+						catch (const errors::send_error&) {
+							failed_sends++;
+						}
+						current.range.first = unavailable.last + 1;
+					}
+					current.range.last = std::min(current.range.last, last_journaled);
+					if (current.range.first > current.range.last) {
+						continue;
+					}
+
+					const size_t batch = gather(current.range, current.resume);
+					if (batch == 0) {
+						// The bucket is empty or the records are still being written, so keep the turn for the next call.
+						pending.push_front(current);
+						break;
+					}
+					try {
+						const int batch_sent = recovery_socket.send_batch_to(outgoing.data(), batch, current.requester);
+						sent += (size_t)batch_sent;
+						retransmitted += (uint64_t)batch_sent;
+						current.range.first += (uint64_t)batch_sent;
+						if (batch_sent > 0) {
+							current.resume = frame_positions[(size_t)batch_sent - 1];
+						}
+					}
+					catch (const errors::send_error&) {
+						failed_sends++;
+						current.range.first += batch;
+						current.resume = frame_positions[batch - 1];
+					}
+					if (current.range.first <= current.range.last) {
+						pending.push_back(current);
+					}
+					if (batch < MAX_BATCH_SIZE && current.range.first <= current.range.last) {
+						// The bucket ran dry part way through the batch.
+						break;
+					}
+				}
+				return sent;
+			}
+
+			/**
+			 * @brief 	Method get_pending returns the number of ranges waiting to be sent.
+			 * @return 	size_t 	number of pending ranges.
+			 */
+			size_t get_pending() {
+				std::unique_lock<std::mutex> server_lock(server_mutex);
+				return pending.size();
+			}
+
+			/**
+			 * @brief 	Method get_retransmitted returns the number of datagrams retransmitted.
+			 * @return 	uint64_t 	number of datagrams.
+			 */
+			uint64_t get_retransmitted() {
+				std::unique_lock<std::mutex> server_lock(server_mutex);
+				return retransmitted;
+			}
+
+			/**
+			 * @brief 	Method get_unavailable returns the number of notices sent for ranges no longer journaled.
+			 * @return 	uint64_t 	number of notices.
+			 */
+			uint64_t get_unavailable() {
+				std::unique_lock<std::mutex> server_lock(server_mutex);
+				return unavailable_ranges;
+			}
+
+			/**
+			 * @brief 	Method get_dropped_ranges returns the number of requested ranges dropped because too many were pending.
+			 * @return 	uint64_t 	number of ranges.
+			 */
+			uint64_t get_dropped_ranges() {
+				std::unique_lock<std::mutex> server_lock(server_mutex);
+				return dropped_ranges;
+			}
+
+		private:
+			/**
+			 *	@struct	pending_range
+			 * 	@brief 	Struct pending_range is a range waiting to be sent to a requester.
+			 */
+			struct pending_range {
+				/// Address and port to send the range to.
+				socket_address requester;
+				/// Sequence numbers still to send.
+				sequence_range range;
+				/// Position of the last record sent from the range, where the next batch starts scanning its segment.
+				journal::position resume;
+			};
+
+			/// Socket retransmissions are sent on.
+			udp::socket& recovery_socket;
+			/// Journal of the stream.
+			journal::segmented_log& log;
+			/// Pacing of retransmissions.
+			token_bucket pacing;
+			/// Most ranges waiting to be sent.
+			size_t max_pending;
+			/// Ranges waiting to be sent, in turn order.
+			std::deque<pending_range> pending;
+			/// Ranges of the request being handled.
+			std::vector<sequence_range> request_ranges;
+			/// Copies of the frames of the batch being sent, so the log is not locked while sending.
+			std::vector<char> frames;
+			/// Sizes of the frames of the batch being sent.
+			std::vector<size_t> frame_sizes;
+			/// Positions in the log of the frames of the batch being sent.
+			std::vector<journal::position> frame_positions;
+			/// Datagrams of the batch being sent.
+			std::vector<outgoing_datagram> outgoing = std::vector<outgoing_datagram>(MAX_BATCH_SIZE);
+			/// Number of datagrams retransmitted.
+			uint64_t retransmitted = 0;
+			/// Number of notices sent for ranges no longer journaled.
+			uint64_t unavailable_ranges = 0;
+			/// Number of requested ranges dropped.
+			uint64_t dropped_ranges = 0;
+			/// Number of sends that failed.
+			uint64_t failed_sends = 0;
+			/// Mutex to control access to the pending ranges and counters.
+			std::mutex server_mutex;
+
+			/**
+			 * @brief 	Method gather copies the next batch of a range out of the log, taking a token for each datagram.
+			 * @param 	range 	range to send, which must be within the log.
+			 * @param 	resume 	position of a record at or before the start of the range, so the scan of its segment does
+			 * 					not restart from the segment header on every batch.
+			 * @return 	size_t 	number of datagrams in the batch, described by the first entries of outgoing and
+			 * 					frame_positions.
+			 */
+			size_t gather(const sequence_range& range, const journal::position& resume) {
+				frames.clear();
+				frame_sizes.clear();
+				frame_positions.clear();
+				log.for_each(range.first, [&](const journal::record& stored) {
+					if (stored.sequence > range.last || frame_sizes.size() == MAX_BATCH_SIZE || !pacing.try_consume()) {
+						return false;
+					}
+					frames.insert(frames.end(), stored.frame(), stored.frame() + stored.frame_size());
+					frame_sizes.push_back(stored.frame_size());
+					frame_positions.push_back(journal::position{stored.sequence, stored.offset});
+					return true;
+				}, resume);
+				size_t offset = 0;
+				for (size_t i = 0; i < frame_sizes.size(); i++) {
+					outgoing[i] = outgoing_datagram{frames.data() + offset, frame_sizes[i]};
+					offset += frame_sizes[i];
+				}
+				return frame_sizes.size();
+			}
+		};
+	}
+}
+
+#endif /* RECOVERY_HPP */
@@ -0,0 +1,111 @@
+/**
+ * 	@file 	ring_buffer.hpp
+ * 	@brief 	Class ring_buffer is a bounded single producer single consumer queue that does not use locks.
+ * 	@author James Horner
+ * 	@date 	2023-04-05
+ */
+
+#ifndef RING_BUFFER_HPP
+#define RING_BUFFER_HPP
+
+// Standard System Libraries
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace oo_socket
+{
+	/**
+	 *	@class	ring_buffer
+	 * 	@brief 	Class ring_buffer is a bounded single producer single consumer queue that does not use locks.
+	 * 	@details	One thread may call push and one (possibly different) thread may call pop concurrently. The
+	 * 				capacity is rounded up to the next power of two so that indices can be wrapped with a mask.
+	 */
+	template <typename T>
+	class ring_buffer {
+	public:
+		/**
+		 * @brief 	Constructor for the ring_buffer class.
+		 * @param 	capacity 	minimum number of elements the buffer can hold (rounded up to a power of two).
+		 */
+		explicit ring_buffer(size_t capacity) {
+			size_t rounded_capacity = 1;
+			while (rounded_capacity < capacity) {
+				rounded_capacity <<= 1;
+			}
+			slots.resize(rounded_capacity);
+			mask = rounded_capacity - 1;
+		}
+
+		/**
+		 * @brief 	Method push appends an element to the back of the buffer (producer only).
+		 * @param 	value 	element to copy into the buffer.
+		 * @return 	bool 	true if the element was added, false if the buffer was full.
+		 */
+		bool push(const T& value) {
+			const size_t current_tail = tail.load(std::memory_order_relaxed);
+			// Use the cached head first so that the consumer's cache line is only touched when the buffer looks full.
+			if (current_tail - cached_head > mask) {
+				cached_head = head.load(std::memory_order_acquire);
+				if (current_tail - cached_head > mask) {
+					return false;
+				}
+			}
+			slots[current_tail & mask] = value;
+			tail.store(current_tail + 1, std::memory_order_release);
+			return true;
+		}
+
+		/**
+		 * @brief 	Method pop removes an element from the front of the buffer (consumer only).
+		 * @param 	value[out] 	element removed from the buffer.
+		 * @return 	bool 		true if an element was removed, false if the buffer was empty.
+		 */
+		bool pop(T& value) {
+			const size_t current_head = head.load(std::memory_order_relaxed);
+			if (current_head == cached_tail) {
+				cached_tail = tail.load(std::memory_order_acquire);
+				if (current_head == cached_tail) {
+					return false;
+				}
+			}
+			value = slots[current_head & mask];
+			head.store(current_head + 1, std::memory_order_release);
+			return true;
+		}
+
+		/**
+		 * @brief 	Method size returns an approximation of the number of elements in the buffer.
+		 * @return 	size_t 	number of elements in the buffer at the time of the call.
+		 */
+		size_t size() const {
+			return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+		}
+
+		/**
+		 * @brief 	Method capacity returns the maximum number of elements the buffer can hold.
+		 * @return 	size_t 	capacity of the buffer.
+		 */
+		size_t capacity() const {
+			return mask + 1;
+		}
+
+	protected:
+		/// Storage for the elements of the buffer.
+		std::vector<T> slots;
+		/// Mask used to wrap indices into the storage.
+		size_t mask;
+
+		/// Index of the next element to pop, written by the consumer.
+		alignas(64) std::atomic<size_t> head{0};
+		/// Consumer's copy of tail, refreshed only when the buffer looks empty.
+		size_t cached_tail = 0;
+
+		/// Index of the next element to push, written by the producer.
+		alignas(64) std::atomic<size_t> tail{0};
+		/// Producer's copy of head, refreshed only when the buffer looks full.
+		size_t cached_head = 0;
+	};
+}
+
+#endif /* RING_BUFFER_HPP */
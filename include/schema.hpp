@@ -0,0 +1,1450 @@
+/**
+ * 	@file 	schema.hpp
+ * 	@brief 	Message schemas whose encoders and decoders are generated at compile time from a list of fields.
+ * 	@author James Horner
+ * 	@date 	2023-04-05
+ */
+
+#ifndef SCHEMA_HPP
+#define SCHEMA_HPP
+
+// Standard System Libraries
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Local Libraries
+#include "byte_order.hpp"
+#include "errors.hpp"
+
+namespace oo_socket
+{
+	/**
+	 *	@namespace	schema
+	 * 	@brief 		A schema lists the members of a struct that are sent and how each is encoded, for example
+	 * 				message<fixed<&position::id>, fixed<&position::coordinates>, zigzag<&position::velocity>>.
+	 * 	@details	Fixed size fields are written first, in declaration order, at offsets computed at compile time, so
+	 * 				they can be read straight out of a receive buffer. Variable size fields (varints, repeated values,
+	 * 				bytes and nested messages) follow in declaration order, with nested messages prefixed by their
+	 * 				length so views can skip them. Multi-byte values are written in network byte order.
+	 */
+	namespace schema
+	{
+		/**************************************************************************************************/
+		/* Type Traits					 																  */
+		/**************************************************************************************************/
+		/**
+		 *	@struct	member_traits
+		 * 	@brief 	Struct member_traits names the struct and member type of a pointer to a data member.
+		 */
+		template <typename T> struct member_traits;
+		template <typename class_t, typename member_t> struct member_traits<member_t class_t::*> {
+			/// Struct containing the member.
+			using class_type = class_t;
+			/// Type of the member.
+			using member_type = member_t;
+		};
+
+		/**
+		 *	@struct	array_traits
+		 * 	@brief 	Struct array_traits describes std::array members, which are encoded as fixed size arrays.
+		 */
+		template <typename T> struct array_traits : std::false_type {};
+		template <typename element_t, size_t length> struct array_traits<std::array<element_t, length>> : std::true_type {
+			/// Type of each element.
+			using element_type = element_t;
+			/// Number of elements.
+			static constexpr size_t size = length;
+		};
+
+		/**
+		 *	@struct	vector_traits
+		 * 	@brief 	Struct vector_traits describes std::vector members, which are encoded as repeated values.
+		 */
+		template <typename T> struct vector_traits : std::false_type {};
+		template <typename element_t> struct vector_traits<std::vector<element_t>> : std::true_type {
+			/// Type of each element.
+			using element_type = element_t;
+		};
+
+		/**
+		 * @brief 	Function is_scalar returns whether a type is encoded as a single value in network byte order.
+		 * @tparam 	T 		type to check.
+		 * @return 	bool 	true for arithmetic and enumeration types.
+		 */
+		template <typename T>
+		constexpr bool is_scalar() {
+			return std::is_arithmetic<T>::value || std::is_enum<T>::value;
+		}
+
+		/**
+		 * @brief 	Function encoded_fixed_size returns the number of bytes a fixed field of a type takes.
+		 * @tparam 	T 		arithmetic, enumeration or std::array type.
+		 * @return 	size_t 	size of the value, or of all elements of an array.
+		 */
+		template <typename T>
+		constexpr size_t encoded_fixed_size() {
+			if constexpr (array_traits<T>::value) {
+				return array_traits<T>::size * sizeof(typename array_traits<T>::element_type);
+			}
+			else {
+				return sizeof(T);
+			}
+		}
+
+		template <typename schema_type> class message_view;
+		template <typename schema_type> class repeated_view;
+
+		/**************************************************************************************************/
+		/* Varint Functions				 																  */
+		/**************************************************************************************************/
+		/**
+		 * @brief 	Function zigzag_encode maps signed values to unsigned ones so small magnitudes stay small.
+		 * @param 	value 		signed value.
+		 * @return 	uint64_t 	0, -1, 1, -2, ... mapped to 0, 1, 2, 3, ...
+		 */
+		constexpr uint64_t zigzag_encode(int64_t value) {
+			return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+		}
+
+		/**
+		 * @brief 	Function zigzag_decode reverses zigzag_encode.
+		 * @param 	value 		zigzag encoded value.
+		 * @return 	int64_t 	signed value.
+		 */
+		constexpr int64_t zigzag_decode(uint64_t value) {
+			return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+		}
+
+		/**
+		 * @brief 	Function varint_size returns the number of bytes a value takes as a varint.
+		 * @param 	value 	value to measure.
+		 * @return 	size_t 	1 to 10 bytes, 7 bits of the value per byte.
+		 */
+		constexpr size_t varint_size(uint64_t value) {
+			size_t size = 1;
+			while (value >= 0x80) {
+				value >>= 7;
+				size++;
+			}
+			return size;
+		}
+
+		/**
+		 * @brief 	Function write_varint writes a value 7 bits at a time, least significant first, with the high bit of
+		 * 			each byte set when more bytes follow.
+		 * @param 	value 			value to write.
+		 * @param 	destination 	buffer of at least varint_size(value) bytes.
+		 * @return 	char* 			position after the varint.
+		 */
+		inline char* write_varint(uint64_t value, char* destination) {
+			while (value >= 0x80) {
+				*destination++ = (char)((value & 0x7f) | 0x80);
+				value >>= 7;
+			}
+			*destination++ = (char)value;
+			return destination;
+		}
+
+		/**
+		 * @brief 	Function read_varint reads a value written by write_varint.
+		 * @param 	position 	position of the varint, advanced past it.
+		 * @param 	end 		end of the buffer.
+		 * @return 	uint64_t 	value read.
+		 * @throws	decode_error if the varint runs past the end of the buffer or is longer than 10 bytes.
+		 */
+		inline uint64_t read_varint(const char*& position, const char* end) {
+			uint64_t value = 0;
+			for (int shift = 0; shift < 64; shift += 7) {
+				if (position >= end) {
+					throw errors::decode_error("Varint runs past the end of the buffer.");
+				}
+				const uint8_t byte = (uint8_t)*position++;
+				value |= (uint64_t)(byte & 0x7f) << shift;
+				if ((byte & 0x80) == 0) {
+					return value;
+				}
+			}
+			throw errors::decode_error("Varint is longer than 10 bytes.");
+		}
+
+		/**
+		 * @brief 	Function read_length reads the varint length of a field and checks the field fits in the buffer.
+		 * @param 	position 	position of the length, advanced past it.
+		 * @param 	end 		end of the buffer.
+		 * @return 	size_t 		length of the field that follows in bytes.
+		 * @throws	decode_error if the length or the field runs past the end of the buffer.
+		 */
+		inline size_t read_length(const char*& position, const char* end) {
+			const uint64_t length = read_varint(position, end);
+			if (length > (uint64_t)(end - position)) {
+				throw errors::decode_error("Field runs past the end of the buffer.");
+			}
+			return (size_t)length;
+		}
+
+		/**************************************************************************************************/
+		/* Array View					 																  */
+		/**************************************************************************************************/
+		/**
+		 *	@class	array_view
+		 * 	@brief 	Class array_view reads the elements of a repeated field straight from the encoded buffer.
+		 * 	@details	The extent of the array is checked against the buffer when the view is created, so elements are
+		 * 				only converted from network byte order when they are read.
+		 * @tparam	T 	arithmetic type of the elements.
+		 */
+		template <typename T>
+		class array_view {
+		public:
+			/**
+			 *	@class	iterator
+			 * 	@brief 	Class iterator reads the elements of the array in order.
+			 */
+			class iterator {
+			public:
+				/**
+				 * @brief 	Constructor for the iterator class.
+				 * @param 	position 	encoded element the iterator points at.
+				 */
+				explicit iterator(const char* position) : position(position) {}
+
+				/**
+				 * @brief 	Operator * reads the element the iterator points at.
+				 * @return 	T 	element in host byte order.
+				 */
+				T operator*() const {
+					return byte_order::read_network<T>(position);
+				}
+
+				/**
+				 * @brief 	Operator ++ moves to the next element.
+				 * @return 	iterator& 	this iterator.
+				 */
+				iterator& operator++() {
+					position += sizeof(T);
+					return *this;
+				}
+
+				/**
+				 * @brief 	Operator != compares the positions of two iterators.
+				 * @param 	other 	iterator to compare with.
+				 * @return 	bool 	true if the iterators point at different elements.
+				 */
+				bool operator!=(const iterator& other) const {
+					return position != other.position;
+				}
+
+			protected:
+				/// Encoded element the iterator points at.
+				const char* position;
+			};
+
+			/**
+			 * @brief 	Constructor for the array_view class.
+			 * @param 	elements 	first encoded element, which the caller has checked is followed by count elements.
+			 * @param 	count 		number of elements.
+			 */
+			array_view(const char* elements = nullptr, size_t count = 0) : elements(elements), count(count) {}
+
+			/**
+			 * @brief 	Method size returns the number of elements.
+			 * @return 	size_t 	number of elements.
+			 */
+			size_t size() const {
+				return count;
+			}
+
+			/**
+			 * @brief 	Method empty returns whether the array has no elements.
+			 * @return 	bool 	true if the array is empty.
+			 */
+			bool empty() const {
+				return count == 0;
+			}
+
+			/**
+			 * @brief 	Operator [] reads an element without checking the index.
+			 * @param 	index 	index of the element, less than size().
+			 * @return 	T 		element in host byte order.
+			 */
+			T operator[](size_t index) const {
+				return byte_order::read_network<T>(elements + index * sizeof(T));
+			}
+
+			/**
+			 * @brief 	Method at reads an element after checking the index.
+			 * @param 	index 	index of the element.
+			 * @return 	T 		element in host byte order.
+			 * @throws	decode_error if the index is past the end of the array.
+			 */
+			T at(size_t index) const {
+				if (index >= count) {
+					throw errors::decode_error("Index " + std::to_string(index) + " is past the end of an array of " + std::to_string(count) + " elements.");
+				}
+				return (*this)[index];
+			}
+
+			/**
+			 * @brief 	Method copy_to converts every element into an array, using vector byte swaps where available.
+			 * @param 	destination 	array of at least size() elements.
+			 */
+			void copy_to(T* destination) const {
+				byte_order::read_network_array(elements, count, destination);
+			}
+
+			/**
+			 * @brief 	Method begin returns an iterator to the first element.
+			 * @return 	iterator 	iterator to the first element.
+			 */
+			iterator begin() const {
+				return iterator(elements);
+			}
+
+			/**
+			 * @brief 	Method end returns an iterator past the last element.
+			 * @return 	iterator 	iterator past the last element.
+			 */
+			iterator end() const {
+				return iterator(elements + count * sizeof(T));
+			}
+
+		protected:
+			/// First encoded element.
+			const char* elements;
+			/// Number of elements.
+			size_t count;
+		};
+
+		/**************************************************************************************************/
+		/* Field Descriptors			 																  */
+		/**************************************************************************************************/
+		/**
+		 *	@struct	fixed
+		 * 	@brief 	Struct fixed encodes an arithmetic or enumeration member, or a std::array of arithmetic values, in
+		 * 			network byte order at a fixed offset.
+		 * @tparam	member 	pointer to the data member.
+		 */
+		template <auto member>
+		struct fixed {
+			/// Struct containing the member.
+			using class_type = typename member_traits<decltype(member)>::class_type;
+			/// Type of the member.
+			using value_type = typename member_traits<decltype(member)>::member_type;
+			static_assert(is_scalar<value_type>() || array_traits<value_type>::value, "Fixed fields must be arithmetic, enumerations or std::arrays of arithmetic values.");
+
+			/// Type returned when the field is read through a view.
+			using view_type = value_type;
+
+			/// Flag for if the field always takes the same number of bytes.
+			static constexpr bool IS_FIXED = true;
+			/// Number of bytes the field takes.
+			static constexpr size_t FIXED_SIZE = encoded_fixed_size<value_type>();
+
+			/**
+			 * @brief 	Method write writes the member at its offset.
+			 * @param 	message 	struct to read the member from.
+			 * @param 	field 		position of the field in the buffer.
+			 */
+			static void write(const class_type& message, char* field) {
+				if constexpr (array_traits<value_type>::value) {
+					byte_order::write_network_array((message.*member).data(), array_traits<value_type>::size, field);
+				}
+				else {
+					byte_order::write_network(message.*member, field);
+				}
+			}
+
+			/**
+			 * @brief 	Method read reads the field without decoding the rest of the message.
+			 * @param 	field 		position of the field in the buffer.
+			 * @return 	value_type 	value of the field.
+			 */
+			static value_type read(const char* field) {
+				value_type value;
+				if constexpr (array_traits<value_type>::value) {
+					byte_order::read_network_array(field, array_traits<value_type>::size, value.data());
+				}
+				else {
+					value = byte_order::read_network<value_type>(field);
+				}
+				return value;
+			}
+
+			/**
+			 * @brief 	Method read_into reads the field into the member.
+			 * @param 	field 		position of the field in the buffer.
+			 * @param 	message 	struct to store the member in.
+			 */
+			static void read_into(const char* field, class_type& message) {
+				if constexpr (array_traits<value_type>::value) {
+					byte_order::read_network_array(field, array_traits<value_type>::size, (message.*member).data());
+				}
+				else {
+					message.*member = byte_order::read_network<value_type>(field);
+				}
+			}
+		};
+
+		/**
+		 *	@struct	varint
+		 * 	@brief 	Struct varint encodes an unsigned integer member in as few bytes as its value needs.
+		 * @tparam	member 	pointer to the data member.
+		 */
+		template <auto member>
+		struct varint {
+			/// Struct containing the member.
+			using class_type = typename member_traits<decltype(member)>::class_type;
+			/// Type of the member.
+			using value_type = typename member_traits<decltype(member)>::member_type;
+			static_assert(std::is_integral<value_type>::value && std::is_unsigned<value_type>::value, "Varint fields must be unsigned integers, use zigzag for signed integers.");
+			/// Type returned when the field is read through a view.
+			using view_type = value_type;
+
+			/// Flag for if the field always takes the same number of bytes.
+			static constexpr bool IS_FIXED = false;
+			/// Number of bytes the field takes when fixed.
+			static constexpr size_t FIXED_SIZE = 0;
+
+			/**
+			 * @brief 	Method size returns the number of bytes the member takes.
+			 * @param 	message 	struct to read the member from.
+			 * @return 	size_t 		encoded size of the member.
+			 */
+			static size_t size(const class_type& message) {
+				return varint_size(message.*member);
+			}
+
+			/**
+			 * @brief 	Method write writes the member.
+			 * @param 	message 	struct to read the member from.
+			 * @param 	position 	position to write at.
+			 * @return 	char* 		position after the field.
+			 */
+			static char* write(const class_type& message, char* position) {
+				return write_varint(message.*member, position);
+			}
+
+			/**
+			 * @brief 	Method read_into reads the field into the member.
+			 * @param 	position 	position of the field, advanced past it.
+			 * @param 	end 		end of the buffer.
+			 * @param 	message 	struct to store the member in.
+			 * @throws	decode_error if the field is truncated or too large for the member.
+			 */
+			static void read_into(const char*& position, const char* end, class_type& message) {
+				message.*member = take(position, end);
+			}
+
+			/**
+			 * @brief 	Method view reads the field from the buffer.
+			 * @param 	position 	position of the field.
+			 * @param 	end 		end of the buffer.
+			 * @return 	view_type 	value of the field.
+			 * @throws	decode_error if the field is truncated or too large for the member.
+			 */
+			static view_type view(const char* position, const char* end) {
+				return take(position, end);
+			}
+
+			/**
+			 * @brief 	Method skip steps over the field without decoding it.
+			 * @param 	position 	position of the field.
+			 * @param 	end 		end of the buffer.
+			 * @return 	const char* position after the field.
+			 * @throws	decode_error if the field is truncated.
+			 */
+			static const char* skip(const char* position, const char* end) {
+				take(position, end);
+				return position;
+			}
+
+		protected:
+			/**
+			 * @brief 	Method take reads the field and advances past it.
+			 * @param 	position 	position of the field, advanced past it.
+			 * @param 	end 		end of the buffer.
+			 * @return 	view_type 	value of the field.
+			 * @throws	decode_error if the field is truncated or too large for the member.
+			 */
+			static view_type take(const char*& position, const char* end) {
+				const uint64_t value = read_varint(position, end);
+				if (value > std::numeric_limits<value_type>::max()) {
+					throw errors::decode_error("Varint is too large for its field.");
+				}
+				return (value_type)value;
+			}
+		};
+
+		/**
+		 *	@struct	zigzag
+		 * 	@brief 	Struct zigzag encodes a signed integer member as a zigzag varint, so values near zero are small.
+		 * @tparam	member 	pointer to the data member.
+		 */
+		template <auto member>
+		struct zigzag {
+			/// Struct containing the member.
+			using class_type = typename member_traits<decltype(member)>::class_type;
+			/// Type of the member.
+			using value_type = typename member_traits<decltype(member)>::member_type;
+			static_assert(std::is_integral<value_type>::value && std::is_signed<value_type>::value, "Zigzag fields must be signed integers.");
+			/// Type returned when the field is read through a view.
+			using view_type = value_type;
+
+			/// Flag for if the field always takes the same number of bytes.
+			static constexpr bool IS_FIXED = false;
+			/// Number of bytes the field takes when fixed.
+			static constexpr size_t FIXED_SIZE = 0;
+
+			/**
+			 * @brief 	Method size returns the number of bytes the member takes.
+			 * @param 	message 	struct to read the member from.
+			 * @return 	size_t 		encoded size of the member.
+			 */
+			static size_t size(const class_type& message) {
+				return varint_size(zigzag_encode(message.*member));
+			}
+
+			/**
+			 * @brief 	Method write writes the member.
+			 * @param 	message 	struct to read the member from.
+			 * @param 	position 	position to write at.
+			 * @return 	char* 		position after the field.
+			 */
+			static char* write(const class_type& message, char* position) {
+				return write_varint(zigzag_encode(message.*member), position);
+			}
+
+			/**
+			 * @brief 	Method read_into reads the field into the member.
+			 * @param 	position 	position of the field, advanced past it.
+			 * @param 	end 		end of the buffer.
+			 * @param 	message 	struct to store the member in.
+			 * @throws	decode_error if the field is truncated or too large for the member.
+			 */
+			static void read_into(const char*& position, const char* end, class_type& message) {
+				message.*member = take(position, end);
+			}
+
+			/**
+			 * @brief 	Method view reads the field from the buffer.
+			 * @param 	position 	position of the field.
+			 * @param 	end 		end of the buffer.
+			 * @return 	view_type 	value of the field.
+			 * @throws	decode_error if the field is truncated or too large for the member.
+			 */
+			static view_type view(const char* position, const char* end) {
+				return take(position, end);
+			}
+
+			/**
+			 * @brief 	Method skip steps over the field without decoding it.
+			 * @param 	position 	position of the field.
+			 * @param 	end 		end of the buffer.
+			 * @return 	const char* position after the field.
+			 * @throws	decode_error if the field is truncated.
+			 */
+			static const char* skip(const char* position, const char* end) {
+				take(position, end);
+				return position;
+			}
+
+		protected:
+			/**
+			 * @brief 	Method take reads the field and advances past it.
+			 * @param 	position 	position of the field, advanced past it.
+			 * @param 	end 		end of the buffer.
+			 * @return 	view_type 	value of the field.
+			 * @throws	decode_error if the field is truncated or too large for the member.
+			 */
+			static view_type take(const char*& position, const char* end) {
+				const int64_t value = zigzag_decode(read_varint(position, end));
+				if (value < std::numeric_limits<value_type>::min() || value > std::numeric_limits<value_type>::max()) {
+					throw errors::decode_error("Zigzag varint is too large for its field.");
+				}
+				return (value_type)value;
+			}
+		};
+
+		/**
+		 *	@struct	repeated
+		 * 	@brief 	Struct repeated encodes a std::vector of nested messages as a varint length of the whole field, a
+		 * 			varint count and then each message prefixed by its length, so views can skip the field or an element.
+		 * @tparam	member 			pointer to the data member.
+		 * @tparam	element_schema 	message schema of the elements, or void for arithmetic elements.
+		 */
+		template <auto member, typename element_schema = void>
+		struct repeated {
+			/// Struct containing the member.
+			using class_type = typename member_traits<decltype(member)>::class_type;
+			/// Type of the member.
+			using value_type = typename member_traits<decltype(member)>::member_type;
+			static_assert(vector_traits<value_type>::value, "Repeated fields must be std::vectors.");
+			static_assert(std::is_same<typename vector_traits<value_type>::element_type, typename element_schema::value_type>::value, "Repeated messages must be the struct of their schema.");
+			/// Type returned when the field is read through a view.
+			using view_type = repeated_view<element_schema>;
+
+			/// Flag for if the field always takes the same number of bytes.
+			static constexpr bool IS_FIXED = false;
+			/// Number of bytes the field takes when fixed.
+			static constexpr size_t FIXED_SIZE = 0;
+
+			/**
+			 * @brief 	Method size returns the number of bytes the member takes.
+			 * @param 	message 	struct to read the member from.
+			 * @return 	size_t 		encoded size of the member.
+			 */
+			static size_t size(const class_type& message) {
+				const size_t content = content_size(message.*member);
+				return varint_size(content) + content;
+			}
+
+			/**
+			 * @brief 	Method write writes the member.
+			 * @param 	message 	struct to read the member from.
+			 * @param 	position 	position to write at.
+			 * @return 	char* 		position after the field.
+			 */
+			static char* write(const class_type& message, char* position) {
+				const value_type& values = message.*member;
+				position = write_varint(content_size(values), position);
+				position = write_varint(values.size(), position);
+				for (const auto& value : values) {
+					const size_t length = element_schema::encoded_size(value);
+					position = write_varint(length, position);
+					position += element_schema::encode(value, position, length);
+				}
+				return position;
+			}
+
+			/**
+			 * @brief 	Method read_into reads the field into the member, reusing the elements already in the vector.
+			 * @param 	position 	position of the field, advanced past it.
+			 * @param 	end 		end of the buffer.
+			 * @param 	message 	struct to store the member in.
+			 * @throws	decode_error if the field or an element is truncated.
+			 */
+			static void read_into(const char*& position, const char* end, class_type& message) {
+				const size_t content_length = read_length(position, end);
+				const char* content_end = position + content_length;
+				const uint64_t count = read_varint(position, content_end);
+				// Every element takes at least its length byte, so a corrupt count cannot allocate.
+				if (count > (uint64_t)(content_end - position)) {
+					throw errors::decode_error("Repeated field runs past the end of the buffer.");
+				}
+				value_type& values = message.*member;
+				values.resize((size_t)count);
+				for (auto& value : values) {
+					const size_t length = read_length(position, content_end);
+					element_schema::decode(position, length, value);
+					position += length;
+				}
+				position = content_end;
+			}
+
+			/**
+			 * @brief 	Method view reads the field from the buffer.
+			 * @param 	position 	position of the field.
+			 * @param 	end 		end of the buffer.
+			 * @return 	view_type 	view of the elements, which are checked as they are read.
+			 * @throws	decode_error if the field is truncated.
+			 */
+			static view_type view(const char* position, const char* end) {
+				const size_t content_length = read_length(position, end);
+				const char* content_end = position + content_length;
+				const uint64_t count = read_varint(position, content_end);
+				return view_type(position, content_end, (size_t)count);
+			}
+
+			/**
+			 * @brief 	Method skip steps over the field without decoding it.
+			 * @param 	position 	position of the field.
+			 * @param 	end 		end of the buffer.
+			 * @return 	const char* position after the field.
+			 * @throws	decode_error if the field is truncated.
+			 */
+			static const char* skip(const char* position, const char* end) {
+				const size_t length = read_length(position, end);
+				return position + length;
+			}
+
+		protected:
+			/**
+			 * @brief 	Method content_size returns the size of the count and the length prefixed elements.
+			 * @param 	values 		elements to measure.
+			 * @return 	size_t 		size of the field after its length.
+			 */
+			static size_t content_size(const value_type& values) {
+				size_t size = varint_size(values.size());
+				for (const auto& value : values) {
+					const size_t length = element_schema::encoded_size(value);
+					size += varint_size(length) + length;
+				}
+				return size;
+			}
+		};
+
+		/**
+		 *	@struct	repeated
+		 * 	@brief 	Struct repeated encodes a std::vector of arithmetic values as a varint count followed by the values
+		 * 			in network byte order.
+		 * @tparam	member 	pointer to the data member.
+		 */
+		template <auto member>
+		struct repeated<member, void> {
+			/// Struct containing the member.
+			using class_type = typename member_traits<decltype(member)>::class_type;
+			/// Type of the member.
+			using value_type = typename member_traits<decltype(member)>::member_type;
+			static_assert(vector_traits<value_type>::value, "Repeated fields must be std::vectors.");
+			/// Type of each element.
+			using element_type = typename vector_traits<value_type>::element_type;
+			static_assert(std::is_arithmetic<element_type>::value && !std::is_same<element_type, bool>::value, "Repeated fields without a schema must hold arithmetic values.");
+			/// Type returned when the field is read through a view.
+			using view_type = array_view<element_type>;
+
+			/// Flag for if the field always takes the same number of bytes.
+			static constexpr bool IS_FIXED = false;
+			/// Number of bytes the field takes when fixed.
+			static constexpr size_t FIXED_SIZE = 0;
+
+			/**
+			 * @brief 	Method size returns the number of bytes the member takes.
+			 * @param 	message 	struct to read the member from.
+			 * @return 	size_t 		encoded size of the member.
+			 */
+			static size_t size(const class_type& message) {
+				const size_t count = (message.*member).size();
+				return varint_size(count) + count * sizeof(element_type);
+			}
+
+			/**
+			 * @brief 	Method write writes the member.
+			 * @param 	message 	struct to read the member from.
+			 * @param 	position 	position to write at.
+			 * @return 	char* 		position after the field.
+			 */
+			static char* write(const class_type& message, char* position) {
+				const value_type& values = message.*member;
+				position = write_varint(values.size(), position);
+				byte_order::write_network_array(values.data(), values.size(), position);
+				return position + values.size() * sizeof(element_type);
+			}
+
+			/**
+			 * @brief 	Method read_into reads the field into the member, reusing the capacity of the vector.
+			 * @param 	position 	position of the field, advanced past it.
+			 * @param 	end 		end of the buffer.
+			 * @param 	message 	struct to store the member in.
+			 * @throws	decode_error if the field is truncated.
+			 */
+			static void read_into(const char*& position, const char* end, class_type& message) {
+				// The count is checked against the buffer before resizing so a corrupt count cannot allocate.
+				const view_type values = take(position, end);
+				(message.*member).resize(values.size());
+				values.copy_to((message.*member).data());
+			}
+
+			/**
+			 * @brief 	Method view reads the field from the buffer.
+			 * @param 	position 	position of the field.
+			 * @param 	end 		end of the buffer.
+			 * @return 	view_type 	view of the elements.
+			 * @throws	decode_error if the field is truncated.
+			 */
+			static view_type view(const char* position, const char* end) {
+				return take(position, end);
+			}
+
+			/**
+			 * @brief 	Method skip steps over the field without decoding it.
+			 * @param 	position 	position of the field.
+			 * @param 	end 		end of the buffer.
+			 * @return 	const char* position after the field.
+			 * @throws	decode_error if the field is truncated.
+			 */
+			static const char* skip(const char* position, const char* end) {
+				take(position, end);
+				return position;
+			}
+
+		protected:
+			/**
+			 * @brief 	Method take reads the field and advances past it.
+			 * @param 	position 	position of the field, advanced past it.
+			 * @param 	end 		end of the buffer.
+			 * @return 	view_type 	view of the elements.
+			 * @throws	decode_error if the field is truncated.
+			 */
+			static view_type take(const char*& position, const char* end) {
+				const uint64_t count = read_varint(position, end);
+				if (count > (uint64_t)(end - position) / sizeof(element_type)) {
+					throw errors::decode_error("Repeated field runs past the end of the buffer.");
+				}
+				const view_type values(position, (size_t)count);
+				position += count * sizeof(element_type);
+				return values;
+			}
+		};
+
+		/**
+		 *	@struct	bytes
+		 * 	@brief 	Struct bytes encodes a std::string member as a varint length followed by its characters.
+		 * @tparam	member 	pointer to the data member.
+		 */
+		template <auto member>
+		struct bytes {
+			/// Struct containing the member.
+			using class_type = typename member_traits<decltype(member)>::class_type;
+			/// Type of the member.
+			using value_type = typename member_traits<decltype(member)>::member_type;
+			static_assert(std::is_same<value_type, std::string>::value, "Bytes fields must be std::strings.");
+			/// Type returned when the field is read through a view.
+			using view_type = std::string_view;
+
+			/// Flag for if the field always takes the same number of bytes.
+			static constexpr bool IS_FIXED = false;
+			/// Number of bytes the field takes when fixed.
+			static constexpr size_t FIXED_SIZE = 0;
+
+			/**
+			 * @brief 	Method size returns the number of bytes the member takes.
+			 * @param 	message 	struct to read the member from.
+			 * @return 	size_t 		encoded size of the member.
+			 */
+			static size_t size(const class_type& message) {
+				return varint_size((message.*member).size()) + (message.*member).size();
+			}
+
+			/**
+			 * @brief 	Method write writes the member.
+			 * @param 	message 	struct to read the member from.
+			 * @param 	position 	position to write at.
+			 * @return 	char* 		position after the field.
+			 */
+			static char* write(const class_type& message, char* position) {
+				const std::string& value = message.*member;
+				position = write_varint(value.size(), position);
+				::memcpy(position, value.data(), value.size());
+				return position + value.size();
+			}
+
+			/**
+			 * @brief 	Method read_into reads the field into the member, reusing the capacity of the string.
+			 * @param 	position 	position of the field, advanced past it.
+			 * @param 	end 		end of the buffer.
+			 * @param 	message 	struct to store the member in.
+			 * @throws	decode_error if the field is truncated.
+			 */
+			static void read_into(const char*& position, const char* end, class_type& message) {
+				const size_t length = read_length(position, end);
+				(message.*member).assign(position, length);
+				position += length;
+			}
+
+			/**
+			 * @brief 	Method view reads the field from the buffer.
+			 * @param 	position 	position of the field.
+			 * @param 	end 		end of the buffer.
+			 * @return 	view_type 	characters of the field, pointing into the buffer.
+			 * @throws	decode_error if the field is truncated.
+			 */
+			static view_type view(const char* position, const char* end) {
+				const size_t length = read_length(position, end);
+				return std::string_view(position, length);
+			}
+
+			/**
+			 * @brief 	Method skip steps over the field without decoding it.
+			 * @param 	position 	position of the field.
+			 * @param 	end 		end of the buffer.
+			 * @return 	const char* position after the field.
+			 * @throws	decode_error if the field is truncated.
+			 */
+			static const char* skip(const char* position, const char* end) {
+				const size_t length = read_length(position, end);
+				return position + length;
+			}
+		};
+
+		/**
+		 *	@struct	nested
+		 * 	@brief 	Struct nested encodes a struct member with its own schema, prefixed by its varint length so views
+		 * 			can skip it and decoders ignore fields appended to it by newer senders.
+		 * @tparam	member 			pointer to the data member.
+		 * @tparam	nested_schema 	message schema of the member.
+		 */
+		template <auto member, typename nested_schema>
+		struct nested {
+			/// Struct containing the member.
+			using class_type = typename member_traits<decltype(member)>::class_type;
+			/// Type of the member.
+			using value_type = typename member_traits<decltype(member)>::member_type;
+			static_assert(std::is_same<value_type, typename nested_schema::value_type>::value, "Nested messages must be the struct of their schema.");
+			/// Type returned when the field is read through a view.
+			using view_type = message_view<nested_schema>;
+
+			/// Flag for if the field always takes the same number of bytes.
+			static constexpr bool IS_FIXED = false;
+			/// Number of bytes the field takes when fixed.
+			static constexpr size_t FIXED_SIZE = 0;
+
+			/**
+			 * @brief 	Method size returns the number of bytes the member takes.
+			 * @param 	message 	struct to read the member from.
+			 * @return 	size_t 		encoded size of the member.
+			 */
+			static size_t size(const class_type& message) {
+				const size_t length = nested_schema::encoded_size(message.*member);
+				return varint_size(length) + length;
+			}
+
+			/**
+			 * @brief 	Method write writes the member.
+			 * @param 	message 	struct to read the member from.
+			 * @param 	position 	position to write at.
+			 * @return 	char* 		position after the field.
+			 */
+			static char* write(const class_type& message, char* position) {
+				const size_t length = nested_schema::encoded_size(message.*member);
+				position = write_varint(length, position);
+				return position + nested_schema::encode(message.*member, position, length);
+			}
+
+			/**
+			 * @brief 	Method read_into reads the field into the member.
+			 * @param 	position 	position of the field, advanced past it.
+			 * @param 	end 		end of the buffer.
+			 * @param 	message 	struct to store the member in.
+			 * @throws	decode_error if the field is truncated or malformed.
+			 */
+			static void read_into(const char*& position, const char* end, class_type& message) {
+				const size_t length = read_length(position, end);
+				nested_schema::decode(position, length, message.*member);
+				position += length;
+			}
+
+			/**
+			 * @brief 	Method view reads the field from the buffer.
+			 * @param 	position 	position of the field.
+			 * @param 	end 		end of the buffer.
+			 * @return 	view_type 	view of the nested message.
+			 * @throws	decode_error if the field is truncated.
+			 */
+			static view_type view(const char* position, const char* end) {
+				const size_t length = read_length(position, end);
+				return view_type(position, length);
+			}
+
+			/**
+			 * @brief 	Method skip steps over the field without decoding it.
+			 * @param 	position 	position of the field.
+			 * @param 	end 		end of the buffer.
+			 * @return 	const char* position after the field.
+			 * @throws	decode_error if the field is truncated.
+			 */
+			static const char* skip(const char* position, const char* end) {
+				const size_t length = read_length(position, end);
+				return position + length;
+			}
+		};
+
+		/**************************************************************************************************/
+		/* Message						 																  */
+		/**************************************************************************************************/
+		/**
+		 *	@class	message
+		 * 	@brief 	Class message generates the encoder and decoder of a struct from its list of fields.
+		 * 	@details	Encoding writes straight from the struct into the send buffer and decoding writes straight from the
+		 * 				receive buffer into the struct, without building any intermediate objects. Handlers that only
+		 * 				need some fields can read them through view instead.
+		 * @tparam	fields 	field descriptors, all for members of the same struct.
+		 */
+		template <typename... fields>
+		class message {
+		public:
+			static_assert(sizeof...(fields) > 0, "A message needs at least one field.");
+
+			/// Struct the message is encoded from and decoded into.
+			using value_type = typename std::tuple_element<0, std::tuple<fields...>>::type::class_type;
+			static_assert((std::is_same<value_type, typename fields::class_type>::value && ...), "All fields of a message must be members of the same struct.");
+
+			/// Number of fields in the message.
+			static constexpr size_t FIELD_COUNT = sizeof...(fields);
+			/// Number of bytes taken by the fixed fields, which come first in the encoding.
+			static constexpr size_t FIXED_SIZE = (fields::FIXED_SIZE + ... + 0);
+			/// Flag for if every field is fixed, so every encoding takes FIXED_SIZE bytes.
+			static constexpr bool IS_FIXED = (fields::IS_FIXED && ...);
+
+			/// Field descriptor at an index.
+			template <size_t index>
+			using field = typename std::tuple_element<index, std::tuple<fields...>>::type;
+
+			/**
+			 * @brief 	Method offset returns the offset of a fixed field from the start of the encoding.
+			 * @tparam 	index 	index of the field in the schema.
+			 * @return 	size_t 	offset in bytes.
+			 */
+			template <size_t index>
+			static constexpr size_t offset() {
+				static_assert(field<index>::IS_FIXED, "Only fixed fields have a fixed offset.");
+				constexpr size_t sizes[] = {fields::FIXED_SIZE...};
+				size_t result = 0;
+				for (size_t i = 0; i < index; i++) {
+					result += sizes[i];
+				}
+				return result;
+			}
+
+			/**
+			 * @brief 	Method encoded_size returns the number of bytes a struct takes when encoded.
+			 * @param 	value 	struct to measure.
+			 * @return 	size_t 	encoded size in bytes.
+			 */
+			static size_t encoded_size(const value_type& value) {
+				if constexpr (IS_FIXED) {
+					return FIXED_SIZE;
+				}
+				else {
+					return FIXED_SIZE + (variable_size<fields>(value) + ...);
+				}
+			}
+
+			/**
+			 * @brief 	Method encode writes a struct into a buffer.
+			 * @param 	value 		struct to encode.
+			 * @param 	buffer 		buffer to write into, e.g. a send buffer.
+			 * @param 	capacity 	size of the buffer in bytes.
+			 * @return 	size_t 		number of bytes written.
+			 * @throws	encode_error if the buffer is too small.
+			 */
+			static size_t encode(const value_type& value, char* buffer, size_t capacity) {
+				const size_t size = encoded_size(value);
+				if (size > capacity) {
+					throw errors::encode_error("Message needs " + std::to_string(size) + " bytes but the buffer holds " + std::to_string(capacity) + ".");
+				}
+				write_fields(value, buffer, std::index_sequence_for<fields...>{});
+				return size;
+			}
+
+			/**
+			 * @brief 	Method encode writes a struct into a vector, resizing it to the encoded size so its capacity is
+			 * 			reused when the same vector is encoded into for every send.
+			 * @param 	value 		struct to encode.
+			 * @param 	buffer 		vector to write into.
+			 * @return 	size_t 		number of bytes written.
+			 */
+			static size_t encode(const value_type& value, std::vector<char>& buffer) {
+				const size_t size = encoded_size(value);
+				buffer.resize(size);
+				write_fields(value, buffer.data(), std::index_sequence_for<fields...>{});
+				return size;
+			}
+
+			/**
+			 * @brief 	Method decode reads a struct from a buffer.
+			 * @param 	buffer 		buffer to read from, e.g. a receive buffer.
+			 * @param 	size 		number of bytes in the buffer.
+			 * @param 	value 		struct to store the fields in.
+			 * @return 	size_t 		number of bytes read.
+			 * @throws	decode_error if the buffer is truncated or a field does not fit its member.
+			 */
+			static size_t decode(const char* buffer, size_t size, value_type& value) {
+				if (size < FIXED_SIZE) {
+					throw errors::decode_error("Message needs at least " + std::to_string(FIXED_SIZE) + " bytes but the buffer holds " + std::to_string(size) + ".");
+				}
+				const char* position = buffer + FIXED_SIZE;
+				read_fields(buffer, position, buffer + size, value, std::index_sequence_for<fields...>{});
+				return (size_t)(position - buffer);
+			}
+
+			/**
+			 * @brief 	Method decode reads a struct from a vector.
+			 * @param 	buffer 		vector to read from.
+			 * @param 	value 		struct to store the fields in.
+			 * @return 	size_t 		number of bytes read.
+			 * @throws	decode_error if the buffer is truncated or a field does not fit its member.
+			 */
+			static size_t decode(const std::vector<char>& buffer, value_type& value) {
+				return decode(buffer.data(), buffer.size(), value);
+			}
+
+			/**
+			 * @brief 	Method read reads a single fixed field from an encoded buffer without decoding the rest.
+			 * @tparam 	index 	index of the field in the schema.
+			 * @param 	buffer 	buffer to read from.
+			 * @param 	size 	number of bytes in the buffer.
+			 * @return 	value_type 	value of the field.
+			 * @throws	decode_error if the buffer is too short to hold the fixed fields.
+			 */
+			template <size_t index>
+			static typename field<index>::value_type read(const char* buffer, size_t size) {
+				if (size < FIXED_SIZE) {
+					throw errors::decode_error("Message needs at least " + std::to_string(FIXED_SIZE) + " bytes but the buffer holds " + std::to_string(size) + ".");
+				}
+				return field<index>::read(buffer + offset<index>());
+			}
+
+			/**
+			 * @brief 	Method view wraps an encoded buffer so each field is only decoded when it is read.
+			 * @param 	buffer 					buffer to read from, which must outlive the view.
+			 * @param 	size 					number of bytes in the buffer.
+			 * @return 	message_view<message> 	view of the message.
+			 * @throws	decode_error if the buffer is too short to hold the fixed fields.
+			 */
+			static message_view<message> view(const char* buffer, size_t size) {
+				return message_view<message>(buffer, size);
+			}
+
+			/**
+			 * @brief 	Method view wraps an encoded vector so each field is only decoded when it is read.
+			 * @param 	buffer 					vector to read from, which must outlive the view and not be resized.
+			 * @return 	message_view<message> 	view of the message.
+			 * @throws	decode_error if the buffer is too short to hold the fixed fields.
+			 */
+			static message_view<message> view(const std::vector<char>& buffer) {
+				return message_view<message>(buffer.data(), buffer.size());
+			}
+
+		protected:
+			/**
+			 * @brief 	Method variable_size returns the size of a variable field, or 0 for a fixed one.
+			 * @param 	value 	struct to measure.
+			 * @return 	size_t 	encoded size of the field outside the fixed block.
+			 */
+			template <typename field_type>
+			static size_t variable_size(const value_type& value) {
+				if constexpr (field_type::IS_FIXED) {
+					return 0;
+				}
+				else {
+					return field_type::size(value);
+				}
+			}
+
+			/**
+			 * @brief 	Method write_fields writes the fixed fields at their offsets and the variable fields after them.
+			 * @param 	value 	struct to encode.
+			 * @param 	buffer 	buffer large enough for the encoding.
+			 */
+			template <size_t... indices>
+			static void write_fields(const value_type& value, char* buffer, std::index_sequence<indices...>) {
+				char* position = buffer + FIXED_SIZE;
+				(write_field<indices>(value, buffer, position), ...);
+			}
+
+			/**
+			 * @brief 	Method write_field writes a single field.
+			 * @param 	value 		struct to encode.
+			 * @param 	buffer 		start of the encoding.
+			 * @param 	position 	position of the next variable field, advanced past a variable field.
+			 */
+			template <size_t index>
+			static void write_field(const value_type& value, char* buffer, char*& position) {
+				if constexpr (field<index>::IS_FIXED) {
+					field<index>::write(value, buffer + offset<index>());
+				}
+				else {
+					position = field<index>::write(value, position);
+				}
+			}
+
+			/**
+			 * @brief 	Method read_fields reads the fixed fields from their offsets and the variable fields after them.
+			 * @param 	buffer 		start of the encoding, holding at least FIXED_SIZE bytes.
+			 * @param 	position 	position of the first variable field, advanced past the last one.
+			 * @param 	end 		end of the buffer.
+			 * @param 	value 		struct to store the fields in.
+			 */
+			template <size_t... indices>
+			static void read_fields(const char* buffer, const char*& position, const char* end, value_type& value, std::index_sequence<indices...>) {
+				(read_field<indices>(buffer, position, end, value), ...);
+			}
+
+			/**
+			 * @brief 	Method read_field reads a single field.
+			 * @param 	buffer 		start of the encoding.
+			 * @param 	position 	position of the next variable field, advanced past a variable field.
+			 * @param 	end 		end of the buffer.
+			 * @param 	value 		struct to store the field in.
+			 */
+			template <size_t index>
+			static void read_field(const char* buffer, const char*& position, const char* end, value_type& value) {
+				if constexpr (field<index>::IS_FIXED) {
+					field<index>::read_into(buffer + offset<index>(), value);
+				}
+				else {
+					field<index>::read_into(position, end, value);
+				}
+			}
+		};
+
+		/**************************************************************************************************/
+		/* Message Views				 																  */
+		/**************************************************************************************************/
+		/**
+		 *	@class	message_view
+		 * 	@brief 	Class message_view reads the fields of an encoded message straight from the buffer it was received
+		 * 			into, decoding only the fields that are read.
+		 * 	@details	Fixed fields are read from their compile time offsets. A variable field is found by skipping the
+		 * 				variable fields before it, which only reads their lengths, and the positions found are kept so
+		 * 				later reads do not skip them again. Every read is checked against the end of the buffer. Views
+		 * 				point into the buffer, so the buffer must outlive them, and a view must not be shared between
+		 * 				threads because reads update the positions it keeps.
+		 * @tparam	schema_type 	message schema of the encoded message.
+		 */
+		template <typename schema_type>
+		class message_view {
+		public:
+			/// Struct the message decodes into.
+			using value_type = typename schema_type::value_type;
+
+			/**
+			 * @brief 	Constructor for the message_view class.
+			 * @param 	buffer 	encoded message.
+			 * @param 	size 	number of bytes in the buffer.
+			 * @throws	decode_error if the buffer is too short to hold the fixed fields.
+			 */
+			message_view(const char* buffer, size_t size) : buffer(buffer), limit(buffer + size) {
+				if (size < schema_type::FIXED_SIZE) {
+					throw errors::decode_error("Message needs at least " + std::to_string(schema_type::FIXED_SIZE) + " bytes but the buffer holds " + std::to_string(size) + ".");
+				}
+				positions[0] = buffer + schema_type::FIXED_SIZE;
+			}
+
+			/**
+			 * @brief 	Method get reads a single field.
+			 * @tparam 	index 		index of the field in the schema.
+			 * @return 	view_type 	value of a fixed, varint or zigzag field, a std::string_view for bytes, an
+			 * 						array_view for repeated values and a message_view or repeated_view for nested messages.
+			 * @throws	decode_error if the field or a variable field before it is truncated.
+			 */
+			template <size_t index>
+			typename schema_type::template field<index>::view_type get() const {
+				using field_type = typename schema_type::template field<index>;
+				if constexpr (field_type::IS_FIXED) {
+					return field_type::read(buffer + schema_type::template offset<index>());
+				}
+				else {
+					return field_type::view(locate(index), limit);
+				}
+			}
+
+			/**
+			 * @brief 	Method decode decodes every field into a struct.
+			 * @param 	value 	struct to store the fields in.
+			 * @throws	decode_error if the message is truncated or malformed.
+			 */
+			void decode(value_type& value) const {
+				schema_type::decode(buffer, size(), value);
+			}
+
+			/**
+			 * @brief 	Method data returns the encoded message.
+			 * @return 	const char* 	start of the encoded message.
+			 */
+			const char* data() const {
+				return buffer;
+			}
+
+			/**
+			 * @brief 	Method size returns the number of bytes in the buffer of the view.
+			 * @return 	size_t 	size of the buffer.
+			 */
+			size_t size() const {
+				return (size_t)(limit - buffer);
+			}
+
+		protected:
+			/// Function stepping over a field.
+			using skip_function = const char* (*)(const char*, const char*);
+
+			/// Encoded message.
+			const char* buffer;
+			/// End of the buffer.
+			const char* limit;
+			/// Position of the variable data at each field, valid up to the located index.
+			mutable std::array<const char*, schema_type::FIELD_COUNT> positions;
+			/// Index of the last field whose position is known.
+			mutable size_t located = 0;
+
+			/**
+			 * @brief 	Method skip_field steps over a variable field, or over nothing for a fixed field.
+			 * @param 	position 	position of the variable data at the field.
+			 * @param 	end 		end of the buffer.
+			 * @return 	const char* position of the variable data after the field.
+			 */
+			template <size_t index>
+			static const char* skip_field(const char* position, const char* end) {
+				if constexpr (schema_type::template field<index>::IS_FIXED) {
+					return position;
+				}
+				else {
+					return schema_type::template field<index>::skip(position, end);
+				}
+			}
+
+			/**
+			 * @brief 	Method skip_functions returns the function stepping over each field.
+			 * @return 	std::array<skip_function, FIELD_COUNT> 	skip function of each field.
+			 */
+			template <size_t... indices>
+			static constexpr std::array<skip_function, schema_type::FIELD_COUNT> skip_functions(std::index_sequence<indices...>) {
+				return {&skip_field<indices>...};
+			}
+
+			/**
+			 * @brief 	Method locate finds the position of a variable field, skipping the fields before it once.
+			 * @param 	index 			index of the field.
+			 * @return 	const char* 	position of the field.
+			 * @throws	decode_error if a field before it is truncated.
+			 */
+			const char* locate(size_t index) const {
+				static constexpr std::array<skip_function, schema_type::FIELD_COUNT> skips = skip_functions(std::make_index_sequence<schema_type::FIELD_COUNT>{});
+				while (located < index) {
+					positions[located + 1] = skips[located](positions[located], limit);
+					located++;
+				}
+				return positions[index];
+			}
+		};
+
+		/**
+		 *	@class	repeated_view
+		 * 	@brief 	Class repeated_view iterates over the nested messages of a repeated field without decoding them.
+		 * @tparam	schema_type 	message schema of the elements.
+		 */
+		template <typename schema_type>
+		class repeated_view {
+		public:
+			/**
+			 *	@class	iterator
+			 * 	@brief 	Class iterator steps over the length prefixed elements in order.
+			 */
+			class iterator {
+			public:
+				/**
+				 * @brief 	Constructor for the iterator class.
+				 * @param 	position 	length of the element the iterator points at.
+				 * @param 	limit 		end of the repeated field.
+				 * @param 	remaining 	number of elements from this one to the end.
+				 */
+				iterator(const char* position, const char* limit, size_t remaining) : position(position), limit(limit), remaining(remaining) {}
+
+				/**
+				 * @brief 	Operator * views the element the iterator points at.
+				 * @return 	message_view<schema_type> 	view of the element.
+				 * @throws	decode_error if the element runs past the end of the field.
+				 */
+				message_view<schema_type> operator*() const {
+					const char* element = position;
+					const size_t length = read_length(element, limit);
+					return message_view<schema_type>(element, length);
+				}
+
+				/**
+				 * @brief 	Operator ++ moves to the next element.
+				 * @return 	iterator& 	this iterator.
+				 * @throws	decode_error if the element runs past the end of the field.
+				 */
+				iterator& operator++() {
+					const size_t length = read_length(position, limit);
+					position += length;
+					remaining--;
+					return *this;
+				}
+
+				/**
+				 * @brief 	Operator != compares the number of elements left by two iterators.
+				 * @param 	other 	iterator to compare with.
+				 * @return 	bool 	true if the iterators point at different elements.
+				 */
+				bool operator!=(const iterator& other) const {
+					return remaining != other.remaining;
+				}
+
+			protected:
+				/// Length of the element the iterator points at.
+				const char* position;
+				/// End of the repeated field.
+				const char* limit;
+				/// Number of elements from this one to the end.
+				size_t remaining;
+			};
+
+			/**
+			 * @brief 	Constructor for the repeated_view class.
+			 * @param 	elements 	length of the first element.
+			 * @param 	limit 		end of the repeated field.
+			 * @param 	count 		number of elements.
+			 */
+			repeated_view(const char* elements = nullptr, const char* limit = nullptr, size_t count = 0) : elements(elements), limit(limit), count(count) {}
+
+			/**
+			 * @brief 	Method size returns the number of elements.
+			 * @return 	size_t 	number of elements.
+			 */
+			size_t size() const {
+				return count;
+			}
+
+			/**
+			 * @brief 	Method empty returns whether the field has no elements.
+			 * @return 	bool 	true if the field is empty.
+			 */
+			bool empty() const {
+				return count == 0;
+			}
+
+			/**
+			 * @brief 	Method at views an element, stepping over the elements before it.
+			 * @param 	index 						index of the element.
+			 * @return 	message_view<schema_type> 	view of the element.
+			 * @throws	decode_error if the index is past the end or an element is truncated.
+			 */
+			message_view<schema_type> at(size_t index) const {
+				if (index >= count) {
+					throw errors::decode_error("Index " + std::to_string(index) + " is past the end of a field of " + std::to_string(count) + " messages.");
+				}
+				iterator element = begin();
+				for (size_t i = 0; i < index; i++) {
+					++element;
+				}
+				return *element;
+			}
+
+			/**
+			 * @brief 	Method begin returns an iterator to the first element.
+			 * @return 	iterator 	iterator to the first element.
+			 */
+			iterator begin() const {
+				return iterator(elements, limit, count);
+			}
+
+			/**
+			 * @brief 	Method end returns an iterator past the last element.
+			 * @return 	iterator 	iterator past the last element.
+			 */
+			iterator end() const {
+				return iterator(limit, limit, 0);
+			}
+
+		protected:
+			/// Length of the first element.
+			const char* elements;
+			/// End of the repeated field.
+			const char* limit;
+			/// Number of elements.
+			size_t count;
+		};
+	}
+}
+
+#endif /* SCHEMA_HPP */
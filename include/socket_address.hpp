@@ -0,0 +1,357 @@
+/**
+ * 	@file 	socket_address.hpp
+ * 	@brief 	Class socket_address holds an IPv4 or IPv6 address and port in a sockaddr_storage.
+ * 	@author James Horner
+ * 	@date 	2023-04-05
+ */
+
+#ifndef SOCKET_ADDRESS_HPP
+#define SOCKET_ADDRESS_HPP
+
+// Standard System Libraries
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+
+// Platform Specific System Libraries
+#ifdef _WIN32
+#include <winsock2.h>
+#include <WS2tcpip.h>
+#else
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#endif
+
+// Local Libraries
+#include "endpoint.hpp"
+#include "errors.hpp"
+
+namespace oo_socket
+{
+	/**
+	 *	@enum	address_family
+	 * 	@brief 	Enum address_family selects the addresses a socket sends to and receives from.
+	 */
+	enum class address_family : uint8_t {
+		/// IPv4 only (AF_INET).
+		IPV4,
+		/// IPv6 only (AF_INET6 with IPV6_V6ONLY set).
+		IPV6,
+		/// IPv6 and IPv4 through one socket (AF_INET6 with IPV6_V6ONLY cleared), IPv4 peers appear as plain IPv4 addresses.
+		DUAL_STACK
+	};
+
+	/**
+	 *	@class	socket_address
+	 * 	@brief 	Class socket_address holds an IPv4 or IPv6 address and port in a sockaddr_storage.
+	 * 	@details	Addresses are kept in network byte order ready to be passed to the socket system calls. An empty
+	 * 				address has the family AF_UNSPEC.
+	 */
+	class socket_address {
+	public:
+#ifdef _WIN32
+		/// Type used by the platform for the length of socket addresses.
+		using address_length = int;
+#else
+		/// Type used by the platform for the length of socket addresses.
+		using address_length = socklen_t;
+#endif
+
+		/**
+		 * @brief 	Constructor for an empty socket_address.
+		 */
+		socket_address() {
+			::memset(&storage, 0, sizeof(storage));
+			storage.ss_family = AF_UNSPEC;
+		}
+
+		/**
+		 * @brief 	Constructor for a socket_address copied from a socket address structure.
+		 * @param 	address 	pointer to a sockaddr_in or sockaddr_in6.
+		 * @param 	length 		length of the structure in bytes.
+		 */
+		socket_address(const sockaddr* address, address_length length) : socket_address() {
+			if (address != nullptr && length > 0 && (size_t)length <= sizeof(storage)) {
+				::memcpy(&storage, address, (size_t)length);
+				storage_length = length;
+			}
+		}
+
+		/**
+		 * @brief 	Constructor for a socket_address from a pre-parsed IPv4 endpoint.
+		 * @param 	endpoint 	endpoint to convert.
+		 */
+		socket_address(const ipv4_endpoint& endpoint) : socket_address() {
+			sockaddr_in& address = ipv4();
+			address.sin_family = AF_INET;
+			address.sin_port = htons(endpoint.port);
+			address.sin_addr.s_addr = htonl(endpoint.address);
+			storage_length = sizeof(sockaddr_in);
+		}
+
+		/**
+		 * @brief 	Method parse parses a textual IPv4 or IPv6 address.
+		 * @param 	address 		dotted decimal IPv4 or colon separated IPv6 address, without brackets.
+		 * @param 	port 			port in host byte order.
+		 * @return 	socket_address 	parsed address.
+		 * @throws	configuration_error if the address is invalid.
+		 */
+		static socket_address parse(const std::string& address, uint16_t port) {
+			socket_address parsed;
+			if (address.find(':') == std::string::npos) {
+				sockaddr_in& ipv4_address = parsed.ipv4();
+				if (::inet_pton(AF_INET, address.c_str(), &ipv4_address.sin_addr) != 1) {
+					throw errors::configuration_error("Provided address was invalid.");
+				}
+				ipv4_address.sin_family = AF_INET;
+				ipv4_address.sin_port = htons(port);
+				parsed.storage_length = sizeof(sockaddr_in);
+			}
+			else {
+				sockaddr_in6& ipv6_address = parsed.ipv6();
+				if (::inet_pton(AF_INET6, address.c_str(), &ipv6_address.sin6_addr) != 1) {
+					throw errors::configuration_error("Provided address was invalid.");
+				}
+				ipv6_address.sin6_family = AF_INET6;
+				ipv6_address.sin6_port = htons(port);
+				parsed.storage_length = sizeof(sockaddr_in6);
+			}
+			return parsed;
+		}
+
+		/**
+		 * @brief 	Method any returns the wildcard address of a family.
+		 * @param 	family 			AF_INET or AF_INET6.
+		 * @param 	port 			port in host byte order.
+		 * @return 	socket_address 	0.0.0.0 or :: with the port.
+		 */
+		static socket_address any(int family, uint16_t port) {
+			socket_address wildcard;
+			if (family == AF_INET6) {
+				wildcard.ipv6().sin6_family = AF_INET6;
+				wildcard.ipv6().sin6_addr = in6addr_any;
+				wildcard.ipv6().sin6_port = htons(port);
+				wildcard.storage_length = sizeof(sockaddr_in6);
+			}
+			else {
+				wildcard.ipv4().sin_family = AF_INET;
+				wildcard.ipv4().sin_addr.s_addr = htonl(INADDR_ANY);
+				wildcard.ipv4().sin_port = htons(port);
+				wildcard.storage_length = sizeof(sockaddr_in);
+			}
+			return wildcard;
+		}
+
+		/**
+		 * @brief 	Method family returns the address family.
+		 * @return 	int 	AF_INET, AF_INET6 or AF_UNSPEC for an empty address.
+		 */
+		int family() const {
+			return storage.ss_family;
+		}
+
+		/**
+		 * @brief 	Method port returns the port.
+		 * @return 	uint16_t 	port in host byte order, 0 for an empty address.
+		 */
+		uint16_t port() const {
+			if (family() == AF_INET) {
+				return ntohs(ipv4().sin_port);
+			}
+			if (family() == AF_INET6) {
+				return ntohs(ipv6().sin6_port);
+			}
+			return 0;
+		}
+
+		/**
+		 * @brief 	Method is_ipv4_mapped returns whether the address is an IPv4 address mapped into IPv6 (::ffff:a.b.c.d).
+		 * @return 	bool 	true for IPv4 mapped IPv6 addresses.
+		 */
+		bool is_ipv4_mapped() const {
+			static const uint8_t prefix[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff};
+			return family() == AF_INET6 && ::memcmp(&ipv6().sin6_addr, prefix, sizeof(prefix)) == 0;
+		}
+
+		/**
+		 * @brief 	Method to_ipv6_mapped converts an IPv4 address into its IPv4 mapped IPv6 form for dual stack sockets.
+		 * @return 	socket_address 	mapped address, or a copy if the address is not IPv4.
+		 */
+		socket_address to_ipv6_mapped() const {
+			if (family() != AF_INET) {
+				return *this;
+			}
+			socket_address mapped;
+			sockaddr_in6& address = mapped.ipv6();
+			address.sin6_family = AF_INET6;
+			address.sin6_port = ipv4().sin_port;
+			uint8_t* bytes = (uint8_t*)&address.sin6_addr;
+			bytes[10] = 0xff;
+			bytes[11] = 0xff;
+			::memcpy(bytes + 12, &ipv4().sin_addr, 4);
+			mapped.storage_length = sizeof(sockaddr_in6);
+			return mapped;
+		}
+
+		/**
+		 * @brief 	Method to_ipv4 converts an IPv4 mapped IPv6 address back into an IPv4 address.
+		 * @return 	socket_address 	plain IPv4 address, or a copy if the address is not IPv4 mapped.
+		 */
+		socket_address to_ipv4() const {
+			if (!is_ipv4_mapped()) {
+				return *this;
+			}
+			socket_address plain;
+			sockaddr_in& address = plain.ipv4();
+			address.sin_family = AF_INET;
+			address.sin_port = ipv6().sin6_port;
+			::memcpy(&address.sin_addr, (const uint8_t*)&ipv6().sin6_addr + 12, 4);
+			plain.storage_length = sizeof(sockaddr_in);
+			return plain;
+		}
+
+		/**
+		 * @brief 	Method address_string formats the address without the port.
+		 * @return 	std::string 	dotted decimal or colon separated address, IPv4 mapped addresses are shown as IPv4.
+		 */
+		std::string address_string() const {
+			char buffer[INET6_ADDRSTRLEN] = {};
+			if (is_ipv4_mapped()) {
+				return to_ipv4().address_string();
+			}
+			if (family() == AF_INET) {
+				::inet_ntop(AF_INET, (void*)&ipv4().sin_addr, buffer, sizeof(buffer));
+			}
+			else if (family() == AF_INET6) {
+				::inet_ntop(AF_INET6, (void*)&ipv6().sin6_addr, buffer, sizeof(buffer));
+			}
+			return std::string(buffer);
+		}
+
+		/**
+		 * @brief 	Method to_string formats the address and port.
+		 * @return 	std::string 	"a.b.c.d:port" or "[v6 address]:port".
+		 */
+		std::string to_string() const {
+			if (family() == AF_INET6 && !is_ipv4_mapped()) {
+				return "[" + address_string() + "]:" + std::to_string(port());
+			}
+			return address_string() + ":" + std::to_string(port());
+		}
+
+		/**
+		 * @brief 	Method data returns the address for passing to the socket system calls.
+		 * @return 	const sockaddr* 	pointer to the stored address.
+		 */
+		const sockaddr* data() const {
+			return (const sockaddr*)&storage;
+		}
+
+		/**
+		 * @brief 	Method length returns the length of the stored address.
+		 * @return 	address_length 	size of the sockaddr_in or sockaddr_in6, 0 for an empty address.
+		 */
+		address_length length() const {
+			return storage_length;
+		}
+
+		/**
+		 * @brief 	Operator == compares the family, address and port of two addresses.
+		 * @param 	other 	address to compare with.
+		 * @return 	bool 	true if the addresses are equal.
+		 */
+		bool operator==(const socket_address& other) const {
+			if (family() != other.family() || port() != other.port()) {
+				return false;
+			}
+			if (family() == AF_INET) {
+				return ipv4().sin_addr.s_addr == other.ipv4().sin_addr.s_addr;
+			}
+			if (family() == AF_INET6) {
+				return ::memcmp(&ipv6().sin6_addr, &other.ipv6().sin6_addr, sizeof(in6_addr)) == 0 && ipv6().sin6_scope_id == other.ipv6().sin6_scope_id;
+			}
+			return true;
+		}
+
+		/**
+		 * @brief 	Operator != compares the family, address and port of two addresses.
+		 * @param 	other 	address to compare with.
+		 * @return 	bool 	true if the addresses differ.
+		 */
+		bool operator!=(const socket_address& other) const {
+			return !(*this == other);
+		}
+
+		/**
+		 *	@struct	hash
+		 * 	@brief 	Struct hash hashes the family, address and port so addresses can key unordered containers.
+		 */
+		struct hash {
+			/**
+			 * @brief 	Operator () hashes an address.
+			 * @param 	address 	address to hash.
+			 * @return 	size_t 		FNV-1a hash of the address bytes and port.
+			 */
+			size_t operator()(const socket_address& address) const {
+				uint64_t value = 14695981039346656037ull;
+				auto mix = [&value](const void* bytes, size_t size) {
+					for (size_t i = 0; i < size; i++) {
+						value = (value ^ ((const uint8_t*)bytes)[i]) * 1099511628211ull;
+					}
+				};
+				const uint16_t port = address.port();
+				mix(&port, sizeof(port));
+				if (address.family() == AF_INET) {
+					mix(&address.ipv4().sin_addr, sizeof(in_addr));
+				}
+				else if (address.family() == AF_INET6) {
+					mix(&address.ipv6().sin6_addr, sizeof(in6_addr));
+				}
+				return (size_t)value;
+			}
+		};
+
+		/**
+		 * @brief 	Method ipv4 returns the stored address as an IPv4 address, only valid when the family is AF_INET.
+		 * @return 	sockaddr_in& 	reference into the storage.
+		 */
+		sockaddr_in& ipv4() {
+			return *(sockaddr_in*)&storage;
+		}
+
+		/**
+		 * @brief 	Method ipv4 returns the stored address as an IPv4 address, only valid when the family is AF_INET.
+		 * @return 	const sockaddr_in& 	reference into the storage.
+		 */
+		const sockaddr_in& ipv4() const {
+			return *(const sockaddr_in*)&storage;
+		}
+
+		/**
+		 * @brief 	Method ipv6 returns the stored address as an IPv6 address, only valid when the family is AF_INET6.
+		 * @return 	sockaddr_in6& 	reference into the storage.
+		 */
+		sockaddr_in6& ipv6() {
+			return *(sockaddr_in6*)&storage;
+		}
+
+		/**
+		 * @brief 	Method ipv6 returns the stored address as an IPv6 address, only valid when the family is AF_INET6.
+		 * @return 	const sockaddr_in6& 	reference into the storage.
+		 */
+		const sockaddr_in6& ipv6() const {
+			return *(const sockaddr_in6*)&storage;
+		}
+
+	protected:
+		/// Storage large enough for any address family.
+		sockaddr_storage storage;
+		/// Length of the stored address in bytes.
+		address_length storage_length = 0;
+	};
+}
+
+#endif /* SOCKET_ADDRESS_HPP */
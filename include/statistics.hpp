@@ -0,0 +1,154 @@
+/**
+ * 	@file 	statistics.hpp
+ * 	@brief 	Counters and histograms describing the traffic handled by a socket.
+ * 	@author James Horner
+ * 	@date 	2023-04-05
+ */
+
+#ifndef STATISTICS_HPP
+#define STATISTICS_HPP
+
+// Standard System Libraries
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace oo_socket
+{
+	namespace statistics
+	{
+		/**
+		 *	@class	histogram
+		 * 	@brief 	Class histogram counts observations into power of two buckets using relaxed atomics.
+		 * 	@details	Bucket i counts values in the range (2^(i-1), 2^i], with bucket 0 counting values of 0 and 1 and
+		 * 				the last bucket counting everything larger. Observing never locks so it is safe on the hot path,
+		 * 				and readers see each bucket consistently but not necessarily the whole histogram at one instant.
+		 */
+		class histogram {
+		public:
+			/// Number of buckets in the histogram, the last of which is unbounded.
+			static constexpr size_t BUCKET_COUNT = 40;
+
+			/**
+			 * @brief 	Method observe adds a value to the histogram.
+			 * @param 	value 	value to add.
+			 */
+			void observe(uint64_t value) {
+				buckets[bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+				sum.fetch_add(value, std::memory_order_relaxed);
+				count.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			/**
+			 * @brief 	Method bucket_count returns the number of observations in a single bucket.
+			 * @param 	index 		index of the bucket.
+			 * @return 	uint64_t 	number of observations in the bucket.
+			 */
+			uint64_t bucket_count(size_t index) const {
+				return buckets[index].load(std::memory_order_relaxed);
+			}
+
+			/**
+			 * @brief 	Method bucket_upper_bound returns the inclusive upper bound of a bucket.
+			 * @param 	index 		index of the bucket, must be less than BUCKET_COUNT - 1.
+			 * @return 	uint64_t 	largest value counted by the bucket.
+			 */
+			static uint64_t bucket_upper_bound(size_t index) {
+				return (uint64_t)1 << index;
+			}
+
+			/**
+			 * @brief 	Method get_sum returns the sum of all observed values.
+			 * @return 	uint64_t 	sum of the observations.
+			 */
+			uint64_t get_sum() const {
+				return sum.load(std::memory_order_relaxed);
+			}
+
+			/**
+			 * @brief 	Method get_count returns the number of observed values.
+			 * @return 	uint64_t 	number of observations.
+			 */
+			uint64_t get_count() const {
+				return count.load(std::memory_order_relaxed);
+			}
+
+		protected:
+			/// Number of observations in each bucket.
+			std::atomic<uint64_t> buckets[BUCKET_COUNT] = {};
+			/// Sum of all observed values.
+			std::atomic<uint64_t> sum{0};
+			/// Number of observed values.
+			std::atomic<uint64_t> count{0};
+
+			/**
+			 * @brief 	Method bucket_index returns the bucket a value belongs in.
+			 * @param 	value 	value to place.
+			 * @return 	size_t 	index of the smallest bucket whose upper bound is at least the value.
+			 */
+			static size_t bucket_index(uint64_t value) {
+				size_t index = 0;
+				// Find the number of bits needed to hold value - 1, which is the log2 of the bucket bound.
+				for (uint64_t remaining = value > 0 ? value - 1 : 0; remaining != 0; remaining >>= 1) {
+					index++;
+				}
+				return index < BUCKET_COUNT ? index : BUCKET_COUNT - 1;
+			}
+		};
+
+		/**
+		 *	@struct	socket_statistics
+		 * 	@brief 	Struct socket_statistics holds the user space counters and histograms of a single socket.
+		 * 	@details	All members are updated with relaxed atomics by the socket and may be read from any thread.
+		 */
+		struct socket_statistics {
+			/// Number of datagrams sent successfully.
+			std::atomic<uint64_t> packets_sent{0};
+			/// Number of bytes sent successfully.
+			std::atomic<uint64_t> bytes_sent{0};
+			/// Number of send calls that failed.
+			std::atomic<uint64_t> send_errors{0};
+			/// Number of datagrams received.
+			std::atomic<uint64_t> packets_received{0};
+			/// Number of bytes received.
+			std::atomic<uint64_t> bytes_received{0};
+			/// Number of receive calls that timed out without data.
+			std::atomic<uint64_t> receive_timeouts{0};
+			/// Number of receive calls that failed.
+			std::atomic<uint64_t> receive_errors{0};
+
+			/// Sizes of sent datagrams in bytes.
+			histogram send_size_bytes;
+			/// Sizes of received datagrams in bytes.
+			histogram receive_size_bytes;
+			/// Durations of send calls in nanoseconds, only recorded when timing is enabled on the socket.
+			histogram send_duration_ns;
+			/// Durations of receive calls that returned data in nanoseconds, only recorded when timing is enabled on the socket.
+			histogram receive_duration_ns;
+
+			/// Total datagrams the kernel dropped because the receive buffer was full, from SO_RXQ_OVFL on the last receive.
+			std::atomic<uint64_t> kernel_receive_queue_overflows{0};
+			/// Number of ICMP errors read from the socket error queue.
+			std::atomic<uint64_t> icmp_errors{0};
+			/// Number of datagrams received with an ECN capable codepoint (ECT(0), ECT(1) or CE), only counted when ECN is enabled.
+			std::atomic<uint64_t> ecn_capable_received{0};
+			/// Number of datagrams received marked Congestion Experienced by a router, only counted when ECN is enabled.
+			std::atomic<uint64_t> ecn_congestion_experienced{0};
+
+			/// Bytes waiting in the kernel receive queue when the kernel diagnostics were last read.
+			std::atomic<uint64_t> kernel_receive_queue_bytes{0};
+			/// Size of the kernel receive buffer when the kernel diagnostics were last read.
+			std::atomic<uint64_t> kernel_receive_buffer_bytes{0};
+			/// Bytes waiting in the kernel send queue when the kernel diagnostics were last read.
+			std::atomic<uint64_t> kernel_send_queue_bytes{0};
+			/// Size of the kernel send buffer when the kernel diagnostics were last read.
+			std::atomic<uint64_t> kernel_send_buffer_bytes{0};
+			/// Bytes in the socket backlog when the kernel diagnostics were last read.
+			std::atomic<uint64_t> kernel_backlog_bytes{0};
+			/// Total datagrams dropped by the kernel for any reason when the kernel diagnostics were last read.
+			std::atomic<uint64_t> kernel_drops{0};
+		};
+	}
+}
+
+#endif /* STATISTICS_HPP */
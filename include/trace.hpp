@@ -0,0 +1,401 @@
+/**
+ * 	@file 	trace.hpp
+ * 	@brief 	Class tracer records socket operations into per-thread ring buffers and exports them for timeline viewers.
+ * 	@author James Horner
+ * 	@date 	2023-04-05
+ */
+
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+// Standard System Libraries
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ring_buffer.hpp"
+
+/// Macro for the number of tracers whose buffers each thread remembers before it forgets them all.
+#define TRACE_THREAD_CACHE_SIZE 64
+
+namespace oo_socket
+{
+	namespace trace
+	{
+		/// Types of socket operation that can be recorded by the tracer.
+		enum class event_type : uint8_t
+		{
+			SEND = 0,
+			RECEIVE,
+			SEND_BATCH,
+			RECEIVE_BATCH,
+			WAIT,
+			SEND_FAILURE,
+			RECEIVE_FAILURE,
+		};
+
+		/**
+		 * @brief 	Function event_name returns the display name of an event type.
+		 * @param 	type 		type of the event.
+		 * @return 	const char*	name used for the event in exported traces.
+		 */
+		inline const char* event_name(event_type type) {
+			switch (type) {
+				case event_type::SEND: 			return "send";
+				case event_type::RECEIVE: 		return "receive";
+				case event_type::SEND_BATCH: 	return "send_batch";
+				case event_type::RECEIVE_BATCH: return "receive_batch";
+				case event_type::WAIT: 			return "wait";
+				case event_type::SEND_FAILURE: 	return "send_error";
+				case event_type::RECEIVE_FAILURE: return "receive_error";
+			}
+			return "unknown";
+		}
+
+		/**
+		 * @brief 	Function is_failure returns whether an event type records a failed operation.
+		 * @param 	type 	type of the event.
+		 * @return 	bool 	true for send and receive failures.
+		 */
+		inline bool is_failure(event_type type) {
+			return type == event_type::SEND_FAILURE || type == event_type::RECEIVE_FAILURE;
+		}
+
+		/**
+		 *	@struct	event
+		 * 	@brief 	Struct event holds a single recorded socket operation.
+		 */
+		struct event {
+			/// Type of the operation.
+			event_type type;
+			/// Start of the operation in nanoseconds on the steady clock.
+			uint64_t start_ns;
+			/// Duration of the operation in nanoseconds.
+			uint64_t duration_ns;
+			/// Number of bytes transferred by the operation.
+			int64_t bytes;
+			/// Number of datagrams in the operation (1 unless batched).
+			uint32_t count;
+			/// Network error code for error events, 0 otherwise.
+			int32_t error;
+			/// File descriptor of the socket that performed the operation.
+			uint64_t socket;
+		};
+
+		/**
+		 * @brief 	Function now_ns returns the current time of the steady clock used for event timestamps.
+		 * @return 	uint64_t 	nanoseconds since the steady clock epoch.
+		 */
+		inline uint64_t now_ns() {
+			return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		/**
+		 *	@class	tracer
+		 * 	@brief 	Class tracer records socket operations into per-thread ring buffers and exports them for timeline viewers.
+		 * 	@details	Each thread that records an event is given its own single producer ring buffer the first time it
+		 * 				records, so recording never takes a lock. Writing a trace drains every buffer, so events are only
+		 * 				exported once. When a buffer is full new events are dropped and counted rather than blocking.
+		 */
+		class tracer {
+		public:
+			/**
+			 * @brief 	Constructor for the tracer class.
+			 * @param 	events_per_thread 	capacity of the ring buffer allocated for each recording thread (default 65536).
+			 */
+			explicit tracer(size_t events_per_thread = 65536) :
+				buffer_capacity(events_per_thread),
+				tracer_id(next_tracer_id().fetch_add(1, std::memory_order_relaxed))
+			{}
+
+			/**
+			 * @brief 	Method record adds an event to the calling thread's ring buffer.
+			 * @param 	recorded_event 	event to record.
+			 */
+			void record(const event& recorded_event) {
+				thread_buffer* buffer = get_thread_buffer();
+				if (!buffer->events.push(recorded_event)) {
+					buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+				}
+			}
+
+			/**
+			 * @brief 	Method dropped_events returns the number of events dropped because a ring buffer was full.
+			 * @return 	uint64_t 	total number of dropped events across all threads.
+			 */
+			uint64_t dropped_events() {
+				std::unique_lock<std::mutex> registry_lock(registry_mutex);
+				uint64_t total = 0;
+				for (auto& buffer : buffers) {
+					total += buffer->dropped.load(std::memory_order_relaxed);
+				}
+				return total;
+			}
+
+			/**
+			 * @brief 	Method write_chrome_json drains all recorded events and writes them in the Chrome trace event
+			 * 			JSON format, which can be opened by chrome://tracing and the Perfetto UI.
+			 * @param 	output 	stream to write the trace to.
+			 */
+			void write_chrome_json(std::ostream& output) {
+				std::unique_lock<std::mutex> registry_lock(registry_mutex);
+				output << "{\"traceEvents\":[";
+				bool first = true;
+				for (auto& buffer : buffers) {
+					// Name the thread so viewers show a readable track label.
+					output << (first ? "" : ",")
+						<< "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->thread_id
+						<< ",\"args\":{\"name\":\"socket thread " << buffer->thread_id << "\"}}";
+					first = false;
+
+					event current;
+					while (buffer->events.pop(current)) {
+						// Errors have no duration so they are written as instant events.
+						if (is_failure(current.type)) {
+							output << ",{\"name\":\"" << event_name(current.type) << "\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":" << buffer->thread_id
+								<< ",\"ts\":" << format_microseconds(current.start_ns);
+						}
+						else {
+							output << ",{\"name\":\"" << event_name(current.type) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->thread_id
+								<< ",\"ts\":" << format_microseconds(current.start_ns)
+								<< ",\"dur\":" << format_microseconds(current.duration_ns);
+						}
+						output << ",\"args\":{\"socket\":" << current.socket
+							<< ",\"bytes\":" << current.bytes
+							<< ",\"count\":" << current.count
+							<< ",\"error\":" << current.error << "}}";
+					}
+				}
+				output << "],\"displayTimeUnit\":\"ns\"}";
+			}
+
+			/**
+			 * @brief 	Method write_perfetto drains all recorded events and writes them as a binary Perfetto trace
+			 * 			(a serialized perfetto.protos.Trace message of track events).
+			 * @param 	output 	stream to write the trace to.
+			 */
+			void write_perfetto(std::ostream& output) {
+				std::unique_lock<std::mutex> registry_lock(registry_mutex);
+				std::string packet;
+				std::string message;
+				std::string nested;
+				for (auto& buffer : buffers) {
+					const uint64_t track_uuid = ((uint64_t)tracer_id << 32) | buffer->thread_id;
+					const uint32_t sequence_id = buffer->thread_id + 1;
+
+					// TracePacket { track_descriptor { uuid, thread { pid, tid, thread_name } } }
+					nested.clear();
+					append_varint_field(nested, 1, 1);
+					append_varint_field(nested, 2, buffer->thread_id + 1);
+					append_string_field(nested, 5, "socket thread " + std::to_string(buffer->thread_id));
+					message.clear();
+					append_varint_field(message, 1, track_uuid);
+					append_bytes_field(message, 4, nested);
+					packet.clear();
+					append_bytes_field(packet, 60, message);
+					append_varint_field(packet, 10, sequence_id);
+					write_packet(output, packet);
+
+					event current;
+					while (buffer->events.pop(current)) {
+						if (is_failure(current.type)) {
+							write_track_event(output, current.start_ns, 3, track_uuid, sequence_id, event_name(current.type));
+						}
+						else {
+							write_track_event(output, current.start_ns, 1, track_uuid, sequence_id, event_name(current.type));
+							write_track_event(output, current.start_ns + current.duration_ns, 2, track_uuid, sequence_id, nullptr);
+						}
+					}
+				}
+			}
+
+		protected:
+			/**
+			 *	@struct	thread_buffer
+			 * 	@brief 	Struct thread_buffer holds the events recorded by a single thread.
+			 */
+			struct thread_buffer {
+				thread_buffer(size_t capacity, uint32_t id) : events(capacity), thread_id(id), owner(current_thread()) {}
+				/// Events recorded by the thread that have not been exported yet.
+				ring_buffer<event> events;
+				/// Number of events dropped because the buffer was full.
+				std::atomic<uint64_t> dropped{0};
+				/// Sequential identifier of the thread within this tracer.
+				uint32_t thread_id;
+				/// Serial number of the thread that records into the buffer, from current_thread().
+				uint64_t owner;
+			};
+
+			/// Capacity of each thread's ring buffer.
+			size_t buffer_capacity;
+			/// Unique identifier of the tracer, used so cached buffers are never confused between tracers.
+			uint64_t tracer_id;
+			/// Buffers of every thread that has recorded an event, owned by the tracer so they outlive their threads.
+			std::vector<std::unique_ptr<thread_buffer>> buffers;
+			/// Mutex to control access to the list of buffers.
+			std::mutex registry_mutex;
+
+			/**
+			 * @brief 	Method next_tracer_id returns the counter used to assign tracer identifiers.
+			 * @return 	std::atomic<uint64_t>& 	counter of tracers created by the process.
+			 */
+			static std::atomic<uint64_t>& next_tracer_id() {
+				static std::atomic<uint64_t> counter{1};
+				return counter;
+			}
+
+			/**
+			 * @brief 	Method current_thread returns a serial number of the calling thread, which unlike a
+			 * 			std::thread::id is never reused by a later thread.
+			 * @return 	uint64_t 	serial number of the thread.
+			 */
+			static uint64_t current_thread() {
+				static std::atomic<uint64_t> counter{1};
+				thread_local const uint64_t serial = counter.fetch_add(1, std::memory_order_relaxed);
+				return serial;
+			}
+
+			/**
+			 * @brief 	Method get_thread_buffer returns the calling thread's buffer, registering a new one if needed.
+			 * @return 	thread_buffer* 	buffer for the calling thread.
+			 */
+			thread_buffer* get_thread_buffer() {
+				// Most threads record with a single tracer so the last buffer used is checked first, and the rest are
+				// cached by tracer so a thread alternating between tracers never takes the lock once it has used each
+				// of them. Tracer identifiers are never reused, so an entry cannot point at another tracer's buffer.
+				thread_local uint64_t last_tracer_id = 0;
+				thread_local thread_buffer* last_buffer = nullptr;
+				if (last_tracer_id == tracer_id) {
+					return last_buffer;
+				}
+				thread_local std::unordered_map<uint64_t, thread_buffer*> cache;
+				auto cached = cache.find(tracer_id);
+				if (cached != cache.end()) {
+					last_tracer_id = tracer_id;
+					last_buffer = cached->second;
+					return last_buffer;
+				}
+				// Entries of destroyed tracers are never removed, so the cache is cleared when it grows too large and
+				// refilled from the registries.
+				if (cache.size() >= TRACE_THREAD_CACHE_SIZE) {
+					cache.clear();
+				}
+				std::unique_lock<std::mutex> registry_lock(registry_mutex);
+				thread_buffer* buffer = nullptr;
+				for (auto& registered : buffers) {
+					if (registered->owner == current_thread()) {
+						buffer = registered.get();
+						break;
+					}
+				}
+				if (buffer == nullptr) {
+					buffers.emplace_back(new thread_buffer(buffer_capacity, (uint32_t)buffers.size()));
+					buffer = buffers.back().get();
+				}
+				cache[tracer_id] = buffer;
+				last_tracer_id = tracer_id;
+				last_buffer = buffer;
+				return buffer;
+			}
+
+			/**
+			 * @brief 	Method format_microseconds converts nanoseconds to the fractional microseconds used by Chrome traces.
+			 * @param 	nanoseconds 	time in nanoseconds.
+			 * @return 	std::string 	time in microseconds with three decimal places.
+			 */
+			static std::string format_microseconds(uint64_t nanoseconds) {
+				std::string fraction = std::to_string(nanoseconds % 1000);
+				return std::to_string(nanoseconds / 1000) + "." + std::string(3 - fraction.size(), '0') + fraction;
+			}
+
+			/**
+			 * @brief 	Method write_track_event writes a TracePacket containing a single TrackEvent.
+			 * @param 	output 			stream to write the packet to.
+			 * @param 	timestamp_ns 	timestamp of the event in nanoseconds.
+			 * @param 	type 			TrackEvent.Type value (1 slice begin, 2 slice end, 3 instant).
+			 * @param 	track_uuid 		uuid of the thread track the event belongs to.
+			 * @param 	sequence_id 	trusted packet sequence identifier of the writing thread.
+			 * @param 	name 			name of the event, nullptr for slice ends.
+			 */
+			static void write_track_event(std::ostream& output, uint64_t timestamp_ns, uint64_t type, uint64_t track_uuid, uint32_t sequence_id, const char* name) {
+				std::string message;
+				append_varint_field(message, 9, type);
+				append_varint_field(message, 11, track_uuid);
+				if (name != nullptr) {
+					append_string_field(message, 23, name);
+				}
+				std::string packet;
+				append_varint_field(packet, 8, timestamp_ns);
+				append_varint_field(packet, 10, sequence_id);
+				append_bytes_field(packet, 11, message);
+				write_packet(output, packet);
+			}
+
+			/**
+			 * @brief 	Method write_packet writes a packet as field 1 of the top level Trace message.
+			 * @param 	output 	stream to write the packet to.
+			 * @param 	packet 	serialized TracePacket.
+			 */
+			static void write_packet(std::ostream& output, const std::string& packet) {
+				std::string field;
+				append_bytes_field(field, 1, packet);
+				output.write(field.data(), (std::streamsize)field.size());
+			}
+
+			/**
+			 * @brief 	Method append_varint appends a protobuf base 128 varint.
+			 * @param 	output 	string to append to.
+			 * @param 	value 	value to encode.
+			 */
+			static void append_varint(std::string& output, uint64_t value) {
+				while (value >= 0x80) {
+					output.push_back((char)((value & 0x7F) | 0x80));
+					value >>= 7;
+				}
+				output.push_back((char)value);
+			}
+
+			/**
+			 * @brief 	Method append_varint_field appends a protobuf varint field.
+			 * @param 	output 	string to append to.
+			 * @param 	field 	field number.
+			 * @param 	value 	value of the field.
+			 */
+			static void append_varint_field(std::string& output, uint32_t field, uint64_t value) {
+				append_varint(output, ((uint64_t)field << 3) | 0);
+				append_varint(output, value);
+			}
+
+			/**
+			 * @brief 	Method append_bytes_field appends a length delimited protobuf field.
+			 * @param 	output 	string to append to.
+			 * @param 	field 	field number.
+			 * @param 	value 	bytes of the field.
+			 */
+			static void append_bytes_field(std::string& output, uint32_t field, const std::string& value) {
+				append_varint(output, ((uint64_t)field << 3) | 2);
+				append_varint(output, value.size());
+				output.append(value);
+			}
+
+			/**
+			 * @brief 	Method append_string_field appends a protobuf string field.
+			 * @param 	output 	string to append to.
+			 * @param 	field 	field number.
+			 * @param 	value 	string value of the field.
+			 */
+			static void append_string_field(std::string& output, uint32_t field, const std::string& value) {
+				append_bytes_field(output, field, value);
+			}
+		};
+	}
+}
+
+#endif /* TRACE_HPP */
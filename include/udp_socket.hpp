@@ -9,8 +9,13 @@
 #define UDP_SOCKET_HPP
 
 // Standard System Libraries
+#include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <functional>
+#include <memory>
 #include <mutex>
+#include <unordered_map>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -26,14 +31,32 @@
 #include <sys/socket.h>
 #include <sys/time.h>
 #include <arpa/inet.h>
+#include <netinet/in.h>
 #include <unistd.h>
 #endif
 
+#ifdef __linux__
+#include <linux/errqueue.h>
+#include <linux/filter.h>
+#include <linux/sock_diag.h>
+#endif
+
+#include "array_codec.hpp"
+#include "datagram.hpp"
+#include "endpoint.hpp"
 #include "errors.hpp"
+#include "icmp_error.hpp"
+#include "kernel_diagnostics.hpp"
+#include "socket_address.hpp"
+#include "statistics.hpp"
+#include "trace.hpp"
 
 /// Macro for the maximum buffer when receiving data.
 #define MAX_RECEIVE_BUFFER_SIZE 1500
 
+/// Macro for the size of the buffer used to receive control messages.
+#define CONTROL_BUFFER_SIZE 256
+
 namespace oo_socket
 {
 	namespace udp
@@ -54,8 +77,11 @@ namespace oo_socket
 			 * 			before binding.
 			 * @param 	port 	unsigned short port number to bind the socket to (default 0).
 			 * @param 	address string address to bind the socket to (default "").
+			 * @param 	family 	addresses the socket uses, an IPv6 bind address selects IPv6 automatically (default IPv4).
+			 * @param 	share_port 	true to set SO_REUSEPORT so connect_peer can bind peer sockets to the same local port,
+			 * 						which only shared sockets can do (default false). SO_REUSEADDR is set either way.
 			 */
-			socket(unsigned short port = 0, std::string address = "") : local_port(port) {
+			socket(unsigned short port = 0, std::string address = "", address_family family = address_family::IPV4, bool share_port = false) : local_port(port), port_shared(share_port) {
 				// Before doing anything make sure winsock is started.
 #ifdef _WIN32
 				initialize_windows_sockets();
@@ -63,33 +89,32 @@ namespace oo_socket
 				// Initialize the remote address flag to false.
 				remote_address_set = false;
 
-				// Specify address family of the socket.
-				local_address.sin_family = AF_INET;
-				
-				// Set the port of the socket.
-#ifdef __APPLE__
-				// Special case for apple as they define htons as a macro instead of a function.
-				local_address.sin_port = htons(port);
-#else
-				local_address.sin_port = ::htons(port);
-#endif /* __APPLE__ */
+				// An IPv6 bind address implies an IPv6 socket.
+				if (family == address_family::IPV4 && address.find(':') != std::string::npos) {
+					family = address_family::IPV6;
+				}
+				socket_family = family == address_family::IPV4 ? AF_INET : AF_INET6;
+				dual_stack = family == address_family::DUAL_STACK;
 
 				// If no address is provided, just set the local address as any,
 				if (address.compare("") == 0) {
-					local_address.sin_addr.s_addr = INADDR_ANY;
+					local_address = socket_address::any(socket_family, port);
 				}
 				// If an address is provided, try to parse the string into a network representation.
 				else {
-					if (::inet_pton(AF_INET, address.c_str(), (void *)&local_address.sin_addr.s_addr) != 1) {
+					try {
+						local_address = prepare_destination(socket_address::parse(address, port));
+					}
+					catch (const errors::socket_error&) {
 						throw errors::initialization_error("Provided address was invalid.");
 					}
 				}
 
 				// Get a socket file descriptor and store it in the class member.
 #ifdef _WIN32
-				socket_file_descriptor = ::WSASocket(AF_INET, SOCK_DGRAM, 0, NULL, 0, WSA_FLAG_OVERLAPPED);
+				socket_file_descriptor = ::WSASocket(socket_family, SOCK_DGRAM, 0, NULL, 0, WSA_FLAG_OVERLAPPED);
 #else
-				socket_file_descriptor = ::socket(AF_INET, SOCK_DGRAM, 0);
+				socket_file_descriptor = ::socket(socket_family, SOCK_DGRAM, 0);
 #endif
 
 				// If there is an error getting the socket descriptor, throw an error.
@@ -110,10 +135,31 @@ namespace oo_socket
 					throw errors::initialization_error("Could not create socket, failed with error: " + std::to_string(get_last_network_error()));
 				}
 
-				// Set the reuse address option for the socket and allow the socket to broadcast.
+				// Allow the socket to reuse the address so a port can be bound again straight after it is closed, and
+				// allow the socket to broadcast.
 				int on = 1;
 				::setsockopt(socket_file_descriptor, SOL_SOCKET, SO_REUSEADDR, (char *)&on, sizeof(on));
+#ifdef SO_REUSEPORT
+				// Only shared sockets reuse the port, which lets connected peer sockets share it, see connect_peer.
+				if (port_shared) {
+					::setsockopt(socket_file_descriptor, SOL_SOCKET, SO_REUSEPORT, (char *)&on, sizeof(on));
+				}
+#endif
 				::setsockopt(socket_file_descriptor, SOL_SOCKET, SO_BROADCAST, (char *)&on, sizeof(on));
+
+				// IPv6 sockets either accept IPv4 peers through mapped addresses or only IPv6 peers.
+				if (socket_family == AF_INET6) {
+					int v6_only = dual_stack ? 0 : 1;
+					if (::setsockopt(socket_file_descriptor, IPPROTO_IPV6, IPV6_V6ONLY, (char *)&v6_only, sizeof(v6_only))) {
+						int error_code = get_last_network_error();
+#ifdef _WIN32
+						::closesocket(socket_file_descriptor);
+#else
+						::close(socket_file_descriptor);
+#endif
+						throw errors::initialization_error("Could not configure IPV6_V6ONLY, failed with error: " + std::to_string(error_code));
+					}
+				}
 				
 				set_socket_receive_timeout(0);
 
@@ -125,7 +171,7 @@ namespace oo_socket
 #endif
 
 				// Bind socket to local address provided earlier.
-				int return_code = ::bind(socket_file_descriptor, (struct sockaddr *) &local_address, sizeof(struct sockaddr_in));
+				int return_code = ::bind(socket_file_descriptor, local_address.data(), local_address.length());
 				if (return_code) {
 					// Close the socket file descriptor before throwing an error.
 #ifdef _WIN32
@@ -164,6 +210,8 @@ namespace oo_socket
 			 * @param 	flags[in] 					any flags that the packet should be received with (default 0).
 			 * @return 	std::vector<T>				bytes that were received from the network, empty if the receive timed out.
 			 * @throws	receive_error if an error occurred while receiving the data.
+			 * @throws	decode_error if array encoding is enabled, T is int32_t, uint32_t, float or double and the datagram
+			 * 			is not an encoded array of T.
 			 * @note	If source_address or source_port are nullptr the method acts as a regular recv call, otherwise it 
 			 * 			acts as a recvfrom call.
 			 */
@@ -182,54 +230,36 @@ namespace oo_socket
 				::memset(buffer, 0, buffer_size);
 
 				int receive_size;
-				if (source_address == nullptr || source_port == nullptr) {
-					// Receive the packet.
-					receive_size = ::recv(socket_file_descriptor, buffer, buffer_size, flags);
+				try {
+					receive_size = receive_datagram(buffer, buffer_size, source_address, source_port, flags);
 				}
-				else {
-					// Declare variables to store the source of the packet.
-					sockaddr_in from;
-#ifdef _WIN32
-					int from_size = sizeof(from);
-#else
-					socklen_t from_size = sizeof(from);
-#endif
-					char source_address_buffer[INET_ADDRSTRLEN];
-
-					// Receive the packet and store the source address.
-					receive_size = ::recvfrom(socket_file_descriptor, buffer, buffer_size, flags, (sockaddr*)(&from), &from_size);
-
-					// Convert the source information from network order back into something readable.
-					::inet_ntop(AF_INET, &(from.sin_addr), source_address_buffer, INET_ADDRSTRLEN);
-					*source_address = std::string(source_address_buffer);
-#ifdef __APPLE__
-					// Special case for apple as they define htons as a macro instead of a function.
-					*source_port = htons(from.sin_port);
-#else
-					*source_port = ::htons(from.sin_port);
-#endif /* __APPLE__ */
+				catch (errors::receive_error&) {
+					::free(buffer);
+					throw;
 				}
 
-				// If an error occurs, throw an error.
-				if (receive_size == -1) {
-					int error_code = get_last_network_error();
-#ifdef _WIN32
-					if (error_code == WSAETIMEDOUT)
-#else
-					if (error_code == EAGAIN || error_code == EWOULDBLOCK)
-#endif
-					{
-						::free(buffer);
-						return std::vector<T>();
-					}
-					else {
+				// If the receive timed out, return an empty vector.
+				if (receive_size < 0) {
+					::free(buffer);
+					return std::vector<T>();
+				}
+				// Decode arrays sent by a socket with array encoding enabled.
+				if constexpr (array_codec::is_supported<T>::value) {
+					if (array_encoding_enabled) {
+						std::vector<T> data{};
+						try {
+							array_codec::decode(buffer, (size_t)receive_size, data);
+						}
+						catch (errors::decode_error&) {
+							::free(buffer);
+							throw;
+						}
 						::free(buffer);
-						throw errors::receive_error(std::to_string(error_code));
-						return std::vector<T>();
+						return data;
 					}
 				}
 				// Else, preallocate a vector based on the number of bytes actually received, copy the contents, then return it.
-				else {
+				{
 					std::vector<T> data{};
 					data.resize((size_t)std::ceil(receive_size / sizeof(T)));
 					::memcpy(data.data(), buffer, receive_size);
@@ -260,54 +290,8 @@ namespace oo_socket
 				// Lock the mutex so the socket to prevent race conditions.
 				std::unique_lock<std::mutex> receive_lock(receive_mutex);
 
-				int receive_size;
-				if (source_address == nullptr || source_port == nullptr) {
-					// Receive the packet.
-					receive_size = ::recv(socket_file_descriptor, buffer, buffer_size, flags);
-				}
-				else {
-					// Declare variables to store the source of the packet.
-					sockaddr_in from;
-#ifdef _WIN32
-					int from_size = sizeof(from);
-#else
-					socklen_t from_size = sizeof(from);
-#endif
-					char source_address_buffer[INET_ADDRSTRLEN];
-
-					// Receive the packet and store the source address.
-					receive_size = ::recvfrom(socket_file_descriptor, buffer, buffer_size, flags, (sockaddr*)(&from), &from_size);
-
-					// Convert the source information from network order back into something readable.
-					::inet_ntop(AF_INET, &(from.sin_addr), source_address_buffer, INET_ADDRSTRLEN);
-					*source_address = std::string(source_address_buffer);
-#ifdef __APPLE__
-					// Special case for apple as they define htons as a macro instead of a function.
-					*source_port = htons(from.sin_port);
-#else
-					*source_port = ::htons(from.sin_port);
-#endif /* __APPLE__ */
-				}
-
-				// If an error occurs, throw an error.
-				if (receive_size == -1) {
-					int error_code = get_last_network_error();
-#ifdef _WIN32
-					if (error_code == WSAETIMEDOUT)
-#else
-					if (error_code == EAGAIN || error_code == EWOULDBLOCK)
-#endif
-					{
-						return 0;
-					}
-					else {
-						throw errors::receive_error(std::to_string(error_code));
-					}
-				}
-				// Else, preallocate a vector based on the number of bytes actually received, copy the contents, then return it.
-				else {
-					return receive_size;
-				}
+				int receive_size = receive_datagram(buffer, buffer_size, source_address, source_port, flags);
+				return receive_size < 0 ? 0 : receive_size;
 			}
 
 			/**
@@ -320,40 +304,11 @@ namespace oo_socket
 			 * @throws	send_error if the address of the remote host is invalid or if an error occurred while sending the data.
 			 */
 			template <typename T>
-			int send_to(const std::vector<T> buffer, const unsigned short port, const std::string address = "127.0.0.1", const int flags = 0) {
-				// Lock the mutex so the socket to prevent race conditions.
-				std::unique_lock<std::mutex> send_lock(send_mutex);
-
-				// Populate a temporary struct to hold the destination address.
-				sockaddr_in address_struct;
-				address_struct.sin_family = AF_INET;
-#ifdef __APPLE__
-				// Special case for apple as they define htons as a macro instead of a function.
-				address_struct.sin_port = htons(port);
-#else
-				address_struct.sin_port = ::htons(port);
-#endif /* __APPLE__ */
-
-				if (::inet_pton(AF_INET, address.c_str(), &address_struct.sin_addr) != 1) {
-					throw errors::send_error("Provided address was invalid.");
-				}
-				
-				// Send the contents of the string buffer using sendto.
-#ifdef _WIN32				
-				int result = ::sendto(socket_file_descriptor, reinterpret_cast<const char*>(buffer.data()), (int)(buffer.size() * sizeof(T)), flags, (const struct sockaddr *)&address_struct, sizeof(address_struct));
-#else
-				int result = ::sendto(socket_file_descriptor, reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(T), flags, (const struct sockaddr *)&address_struct, sizeof(address_struct));
-#endif				
-				// If an error occurs, throw an error.
-				if (result == -1) {
-					throw errors::send_error(std::to_string(get_last_network_error()));
-					return -1;
-				}
-				// Else return the number of bytes sent.
-				else {
-					return result;
+			int send_to(const std::vector<T>& buffer, const unsigned short port, const std::string address = "127.0.0.1", const int flags = 0) {
+				if (const std::vector<char>* encoded = encode_array(buffer)) {
+					return send_to(encoded->data(), encoded->size(), port, address, flags);
 				}
-
+				return send_to(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(T), port, address, flags);
 			}
 
 			/**
@@ -364,32 +319,11 @@ namespace oo_socket
 			 * @throws	send_error if the remote host has not been pre-configured or if an error occurred while sending the data.
 			 */
 			template <typename T>
-			int send(const std::vector<T> buffer, const int flags = 0) {
-				// Lock the mutex so the socket to prevent race conditions.
-				std::unique_lock<std::mutex> access_lock(member_mutex);
-				std::unique_lock<std::mutex> send_lock(send_mutex);
-
-				if (remote_address_set) {
-					// Send the contents of the string buffer to the pre-configured remote host.
-#ifdef _WIN32				
-					int result = ::sendto(socket_file_descriptor, reinterpret_cast<const char*>(buffer.data()), (int)(buffer.size() * sizeof(T)), flags, (const struct sockaddr *)&remote_address, sizeof(remote_address));
-#else
-					int result = ::sendto(socket_file_descriptor, reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(T), flags, (const struct sockaddr *)&remote_address, sizeof(remote_address));
-#endif
-					// If an error occurs, throw an error.
-					if (result == -1) {
-						throw errors::send_error(std::to_string(get_last_network_error()));
-						return -1;
-					}
-					// Else return the number of bytes sent.
-					else {
-						return result;
-					}
-				}
-				else {
-					throw errors::send_error("Remote host address and port has not been set.");
-					return -1;
+			int send(const std::vector<T>& buffer, const int flags = 0) {
+				if (const std::vector<char>* encoded = encode_array(buffer)) {
+					return send(encoded->data(), encoded->size(), flags);
 				}
+				return send(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(T), flags);
 			}
 
 			/**
@@ -407,29 +341,11 @@ namespace oo_socket
 				std::unique_lock<std::mutex> send_lock(send_mutex);
 
 				// Populate a temporary struct to hold the destination address.
-				sockaddr_in address_struct;
-				address_struct.sin_family = AF_INET;
-				address_struct.sin_port = htons(port);
-				if (::inet_pton(AF_INET, address.c_str(), &address_struct.sin_addr) != 1) {
-					throw errors::send_error("Provided address was invalid.");
-				}
+				const socket_address destination = parse_destination(address, port);
+				check_destination(destination);
 
 				// Send the contents of the string buffer using sendto.
-#ifdef _WIN32				
-				int result = ::sendto(socket_file_descriptor, buffer, (int)buffer_size, flags, (const struct sockaddr *)&address_struct, sizeof(address_struct));
-#else
-				int result = ::sendto(socket_file_descriptor, buffer, buffer_size, flags, (const struct sockaddr *)&address_struct, sizeof(address_struct));
-#endif
-				// If an error occurs, throw an error.
-				if (result == -1) {
-					throw errors::send_error(std::to_string(get_last_network_error()));
-					return -1;
-				}
-				// Else return the number of bytes sent.
-				else {
-					return result;
-				}
-
+				return send_datagram(buffer, buffer_size, flags, destination);
 			}
 
 			/**
@@ -445,21 +361,10 @@ namespace oo_socket
 				std::unique_lock<std::mutex> send_lock(send_mutex);
 
 				if (remote_address_set) {
+					check_destination(remote_address);
+
 					// Send the contents of the string buffer to the pre-configured remote host.
-#ifdef _WIN32
-					int result = ::sendto(socket_file_descriptor, buffer, (int)buffer_size, flags, (const struct sockaddr *)&remote_address, sizeof(remote_address));
-#else
-					int result = ::sendto(socket_file_descriptor, buffer, buffer_size, flags, (const struct sockaddr *)&remote_address, sizeof(remote_address));
-#endif
-					// If an error occurs, throw an error.
-					if (result == -1) {
-						throw errors::send_error(std::to_string(get_last_network_error()));
-						return -1;
-					}
-					// Else return the number of bytes sent.
-					else {
-						return result;
-					}
+					return send_datagram(buffer, buffer_size, flags, remote_address);
 				}
 				else {
 					throw errors::send_error("Remote host address and port has not been set.");
@@ -467,114 +372,923 @@ namespace oo_socket
 				}
 			}
 
+			/**
+			 * @brief 	Method send_to sends a string buffer of bytes to a pre-parsed endpoint, skipping address parsing.
+			 * @param 	buffer		pointer to buffer of bytes to send to the remote host.
+			 * @param 	buffer_size	size of buffer in bytes.
+			 * @param 	destination	endpoint to send the packet to, e.g. "127.0.0.1:5000"_ep.
+			 * @param 	flags 		any flags that the packet should be sent with (default 0).
+			 * @return 	int 		number of bytes sent.
+			 * @throws	send_error if an error occurred while sending the data.
+			 */
+			int send_to(const char* buffer, const size_t buffer_size, const ipv4_endpoint& destination, const int flags = 0) {
+				// Lock the mutex so the socket to prevent race conditions.
+				std::unique_lock<std::mutex> send_lock(send_mutex);
+
+				const socket_address address_struct = prepare_destination<errors::send_error>(socket_address(destination));
+				check_destination(address_struct);
+				return send_datagram(buffer, buffer_size, flags, address_struct);
+			}
 
-			/**************************************************************************************************/
-			/* Configuration Methods		 																  */
-			/**************************************************************************************************/
 			/**
-			 * @brief 	Method getSocketFileDescriptor returns the socket file descriptor for use in additional lower level configuration.
-			 * @return 	unsigned long long file descriptor of the socket.
+			 * @brief 	Method send_to sends a vector of bytes to a pre-parsed endpoint, skipping address parsing.
+			 * @param 	buffer		vector of bytes to send to the remote host.
+			 * @param 	destination	endpoint to send the packet to, e.g. "127.0.0.1:5000"_ep.
+			 * @param 	flags 		any flags that the packet should be sent with (default 0).
+			 * @return 	int 		number of bytes sent.
+			 * @throws	send_error if an error occurred while sending the data.
 			 */
-			unsigned long long get_socket_file_descriptor() {
-				return socket_file_descriptor;
+			template <typename T>
+			int send_to(const std::vector<T>& buffer, const ipv4_endpoint& destination, const int flags = 0) {
+				if (const std::vector<char>* encoded = encode_array(buffer)) {
+					return send_to(encoded->data(), encoded->size(), destination, flags);
+				}
+				return send_to(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(T), destination, flags);
 			}
 
 			/**
-			 * @brief 	Method configure_remote_address is used to configure a remote host to which packets
-			 * 			can be sent without having to provide the destination each time.
-			 * @param 	port 	unsigned short port number of the remote host.
-			 * @param 	address	string representation of the address of the remote host (default loopback).
-			 * @throws	configuration_error if the provided address is invalid.
+			 * @brief 	Method send_to sends a string buffer of bytes to a pre-parsed IPv4 or IPv6 address.
+			 * @param 	buffer		pointer to buffer of bytes to send to the remote host.
+			 * @param 	buffer_size	size of buffer in bytes.
+			 * @param 	destination	address to send the packet to.
+			 * @param 	flags 		any flags that the packet should be sent with (default 0).
+			 * @return 	int 		number of bytes sent.
+			 * @throws	send_error if the address does not fit the socket's family or if an error occurred while sending the data.
 			 */
-			void configure_remote_host(unsigned short port, std::string address = "127.0.0.1") {
+			int send_to(const char* buffer, const size_t buffer_size, const socket_address& destination, const int flags = 0) {
 				// Lock the mutex so the socket to prevent race conditions.
-				std::unique_lock<std::mutex> access_lock(member_mutex);
+				std::unique_lock<std::mutex> send_lock(send_mutex);
 
-				// Specify address family of the destination.
-				remote_address.sin_family = AF_INET;
-				
-				// Set the port of the socket.
-#ifdef __APPLE__
-				// Special case for apple as they define htons as a macro instead of a function.
-				remote_address.sin_port = htons(port);
-#else
-				remote_address.sin_port = ::htons(port);
-#endif /* __APPLE__ */
+				const socket_address address_struct = prepare_destination<errors::send_error>(destination);
+				check_destination(address_struct);
+				return send_datagram(buffer, buffer_size, flags, address_struct);
+			}
+
+			/**
+			 * @brief 	Method send_to sends a vector of bytes to a pre-parsed IPv4 or IPv6 address.
+			 * @param 	buffer		vector of bytes to send to the remote host.
+			 * @param 	destination	address to send the packet to.
+			 * @param 	flags 		any flags that the packet should be sent with (default 0).
+			 * @return 	int 		number of bytes sent.
+			 * @throws	send_error if the address does not fit the socket's family or if an error occurred while sending the data.
+			 */
+			template <typename T>
+			int send_to(const std::vector<T>& buffer, const socket_address& destination, const int flags = 0) {
+				if (const std::vector<char>* encoded = encode_array(buffer)) {
+					return send_to(encoded->data(), encoded->size(), destination, flags);
+				}
+				return send_to(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(T), destination, flags);
+			}
+
+			/**
+			 * @brief 	Method send_to sends a datagram in its own traffic class, set through IP_TOS or IPV6_TCLASS and
+			 * 			SO_PRIORITY control messages so other datagrams keep the socket's class. Only supported on Linux.
+			 * @details	The ECN codepoint chosen with enable_ecn is kept. As with the socket options, a DSCP without a
+			 * 			priority sets the priority the kernel derives from the TOS. Priorities per datagram need Linux 6.13 or later.
+			 * @param 	buffer			pointer to buffer of bytes to send to the remote host.
+			 * @param 	buffer_size		size of buffer in bytes.
+			 * @param 	destination		address to send the packet to.
+			 * @param 	message_class	DSCP and priority of the datagram, e.g. traffic_classes::LOW_LATENCY.
+			 * @param 	flags 			any flags that the packet should be sent with (default 0).
+			 * @return 	int 			number of bytes sent.
+			 * @throws	send_error if the class is invalid, the address does not fit the socket's family or an error occurred while sending the data.
+			 */
+			int send_to(const char* buffer, const size_t buffer_size, const socket_address& destination, const traffic_class& message_class, const int flags = 0) {
+				check_traffic_class<errors::send_error>(message_class);
+				// Lock the mutex so the socket to prevent race conditions.
+				std::unique_lock<std::mutex> send_lock(send_mutex);
 
+				const socket_address address_struct = prepare_destination<errors::send_error>(destination);
+				check_destination(address_struct);
+				return send_datagram_from(buffer, buffer_size, flags, address_struct, socket_address(), 0, &message_class);
+			}
 
-				// If an address is provided, try to parse the string into a network representation.
-				if (::inet_pton(AF_INET, address.c_str(), (void *)&remote_address.sin_addr.s_addr) != 1) {
-					throw errors::configuration_error("Provided address was invalid.");
+			/**
+			 * @brief 	Method send_to sends a vector of bytes in its own traffic class. Only supported on Linux.
+			 * @param 	buffer			vector of bytes to send to the remote host.
+			 * @param 	destination		address to send the packet to.
+			 * @param 	message_class	DSCP and priority of the datagram, e.g. traffic_classes::LOW_LATENCY.
+			 * @param 	flags 			any flags that the packet should be sent with (default 0).
+			 * @return 	int 			number of bytes sent.
+			 * @throws	send_error if the class is invalid, the address does not fit the socket's family or an error occurred while sending the data.
+			 */
+			template <typename T>
+			int send_to(const std::vector<T>& buffer, const socket_address& destination, const traffic_class& message_class, const int flags = 0) {
+				if (const std::vector<char>* encoded = encode_array(buffer)) {
+					return send_to(encoded->data(), encoded->size(), destination, message_class, flags);
 				}
+				return send_to(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(T), destination, message_class, flags);
+			}
 
-				remote_address_set = true;
+			/**
+			 * @brief 	Method send_from sends a datagram with a chosen source address and outgoing interface, so a socket
+			 * 			bound to the wildcard address can reply from the address a request arrived on. Only supported on Linux.
+			 * @param 	buffer 			pointer to buffer of bytes to send.
+			 * @param 	buffer_size 	size of buffer in bytes.
+			 * @param 	destination 	address to send the datagram to.
+			 * @param 	source 			local address to send the datagram from, empty to let the kernel choose.
+			 * @param 	interface_index index of the interface to send through, 0 to let the kernel choose (default 0).
+			 * @param 	flags 			any flags that the packet should be sent with (default 0).
+			 * @return 	int 			number of bytes sent.
+			 * @throws	send_error if an error occurred while sending the data.
+			 */
+			int send_from(const char* buffer, const size_t buffer_size, const socket_address& destination, const socket_address& source, const uint32_t interface_index = 0, const int flags = 0) {
+				// Lock the mutex so the socket to prevent race conditions.
+				std::unique_lock<std::mutex> send_lock(send_mutex);
+
+				const socket_address address_struct = prepare_destination<errors::send_error>(destination);
+				check_destination(address_struct);
+				return send_datagram_from(buffer, buffer_size, flags, address_struct, source, interface_index);
 			}
 
 			/**
-			 * @brief 	Method set_socket_receive_timeout is used to configure the socket to time out on 
-			 * 			receive calls after the specified number of milliseconds.
-			 * @param 	timeout_ms 	unsigned int number of milliseconds before calls to receive time out.
-			 * @throws	configuration_error if the timeout could not be set. 
+			 * @brief 	Method send_from sends a datagram with a chosen source address and outgoing interface.
+			 * @param 	buffer 			pointer to buffer of bytes to send.
+			 * @param 	buffer_size 	size of buffer in bytes.
+			 * @param 	port 			port number to send the datagram to.
+			 * @param 	address 		address to send the datagram to.
+			 * @param 	source_address 	local address to send the datagram from, "" to let the kernel choose.
+			 * @param 	interface_index index of the interface to send through, 0 to let the kernel choose (default 0).
+			 * @param 	flags 			any flags that the packet should be sent with (default 0).
+			 * @return 	int 			number of bytes sent.
+			 * @throws	send_error if an error occurred while sending the data.
 			 */
-			void set_socket_receive_timeout(unsigned int timeout_ms) {
-#ifdef _WIN32
-				// windows wants timeouts as DWORD in ms
-				DWORD timeout_ms_long = (DWORD)(timeout_ms);
-				if (::setsockopt(socket_file_descriptor, SOL_SOCKET, SO_RCVTIMEO, (char*)&timeout_ms_long, sizeof(timeout_ms_long))) {
-					throw errors::configuration_error("An error occurred while setting the receive timeout: " + std::to_string(get_last_network_error()));
+			int send_from(const char* buffer, const size_t buffer_size, const unsigned short port, const std::string& address, const std::string& source_address, const uint32_t interface_index = 0, const int flags = 0) {
+				socket_address source;
+				if (!source_address.empty()) {
+					try {
+						source = socket_address::parse(source_address, 0);
+					}
+					catch (const errors::configuration_error&) {
+						throw errors::send_error("Provided source address was invalid.");
+					}
 				}
-#else
-				struct timeval timeout_struct;
-				// Get the equivalent number of seconds from the milliseconds.
-				timeout_struct.tv_sec = (int)(timeout_ms / 1000.0);
-				// Set the remaining number of microseconds.
-				// Remaining microseconds = ((total milliseconds) - (seconds * 1000)) * 1000
-				timeout_struct.tv_usec = (int)(timeout_ms - (timeout_struct.tv_sec * 1000.0)) * 1000;
-				if (::setsockopt(socket_file_descriptor, SOL_SOCKET, SO_RCVTIMEO, &timeout_struct, sizeof(timeout_struct))) {
-					throw errors::configuration_error("An error occurred while setting the receive timeout: " + std::to_string(get_last_network_error()));
+				return send_from(buffer, buffer_size, parse_destination(address, port), source, interface_index, flags);
+			}
+
+			/**
+			 * @brief 	Method send_from sends a vector of bytes with a chosen source address and outgoing interface.
+			 * @param 	buffer 			vector of bytes to send.
+			 * @param 	port 			port number to send the datagram to.
+			 * @param 	address 		address to send the datagram to.
+			 * @param 	source_address 	local address to send the datagram from, "" to let the kernel choose.
+			 * @param 	interface_index index of the interface to send through, 0 to let the kernel choose (default 0).
+			 * @param 	flags 			any flags that the packet should be sent with (default 0).
+			 * @return 	int 			number of bytes sent.
+			 * @throws	send_error if an error occurred while sending the data.
+			 */
+			template <typename T>
+			int send_from(const std::vector<T>& buffer, const unsigned short port, const std::string& address, const std::string& source_address, const uint32_t interface_index = 0, const int flags = 0) {
+				if (const std::vector<char>* encoded = encode_array(buffer)) {
+					return send_from(encoded->data(), encoded->size(), port, address, source_address, interface_index, flags);
 				}
-#endif   
+				return send_from(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(T), port, address, source_address, interface_index, flags);
 			}
 
-		protected:
-			/**************************************************************************************************/
-			/* Non-Static Members			 																  */
-			/**************************************************************************************************/
-			/// File descriptor of the socket that the class uses.
-			unsigned long long socket_file_descriptor;
 
-			/// The local port number of the socket. 
-			unsigned short local_port;
-			/// Struct holding the local address of the socket. 
-			sockaddr_in local_address;
+			/**
+			 * @brief 	Method send_batch_to sends several datagrams to a specified remote host, using a single system call
+			 * 			for up to MAX_BATCH_SIZE datagrams where the platform supports it (sendmmsg on Linux).
+			 * @param 	datagrams	pointer to the datagrams to send.
+			 * @param 	count		number of datagrams to send.
+			 * @param 	port 		unsigned short port number to send the datagrams to.
+			 * @param 	address 	string representation of the address of the remote host (default loopback).
+			 * @param 	flags 		any flags that the datagrams should be sent with (default 0).
+			 * @return 	int 		number of datagrams sent, which is less than count if a later datagram failed.
+			 * @throws	send_error if the address of the remote host is invalid or if no datagram could be sent.
+			 */
+			int send_batch_to(const outgoing_datagram* datagrams, const size_t count, const unsigned short port, const std::string address = "127.0.0.1", const int flags = 0) {
+				// Lock the mutex so the socket to prevent race conditions.
+				std::unique_lock<std::mutex> send_lock(send_mutex);
 
-			/// Struct holding the pre-configured remote address of the destination. 
-			sockaddr_in remote_address;
-			/// Flag for if the remote address has been pre-configured.  
-			bool remote_address_set;
+				// Populate a temporary struct to hold the destination address.
+				const socket_address address_struct = parse_destination(address, port);
+				check_destination(address_struct);
 
-			/// Mutex to control ability to access private variables in the socket.
-			std::mutex member_mutex;
+				return send_batch_datagrams(datagrams, count, flags, address_struct);
+			}
 
-			/// Mutex to control ability to send using the socket.
-			std::mutex send_mutex;
+			/**
+			 * @brief 	Method send_batch_to sends several datagrams to a specified remote host.
+			 * @param 	datagrams	vector of datagrams to send.
+			 * @param 	port 		unsigned short port number to send the datagrams to.
+			 * @param 	address 	string representation of the address of the remote host (default loopback).
+			 * @param 	flags 		any flags that the datagrams should be sent with (default 0).
+			 * @return 	int 		number of datagrams sent.
+			 * @throws	send_error if the address of the remote host is invalid or if no datagram could be sent.
+			 */
+			int send_batch_to(const std::vector<outgoing_datagram>& datagrams, const unsigned short port, const std::string address = "127.0.0.1", const int flags = 0) {
+				return send_batch_to(datagrams.data(), datagrams.size(), port, address, flags);
+			}
 
-			/// Mutex to control ability to receive using the socket.
-			std::mutex receive_mutex;
+			/**
+			 * @brief 	Method send_batch_to sends several datagrams to a pre-parsed endpoint, skipping address parsing.
+			 * @param 	datagrams	pointer to the datagrams to send.
+			 * @param 	count		number of datagrams to send.
+			 * @param 	destination	endpoint to send the datagrams to, e.g. "127.0.0.1:5000"_ep.
+			 * @param 	flags 		any flags that the datagrams should be sent with (default 0).
+			 * @return 	int 		number of datagrams sent.
+			 * @throws	send_error if no datagram could be sent.
+			 */
+			int send_batch_to(const outgoing_datagram* datagrams, const size_t count, const ipv4_endpoint& destination, const int flags = 0) {
+				// Lock the mutex so the socket to prevent race conditions.
+				std::unique_lock<std::mutex> send_lock(send_mutex);
 
+				const socket_address address_struct = prepare_destination<errors::send_error>(socket_address(destination));
+				check_destination(address_struct);
+				return send_batch_datagrams(datagrams, count, flags, address_struct);
+			}
 
-			/**************************************************************************************************/
-			/* Non-Static Methods			 																  */
-			/**************************************************************************************************/
 			/**
-			 * 	@brief	Method initialize_windows_sockets starts WSA in preparation for using sockets in Windows.
-			 * 	@throws	initialization_error if WSA fails to start.
-			*/
-			void initialize_windows_sockets(void) {
-#ifdef _WIN32
-				WORD wVersionRequested;
-				WSADATA wsaData;
-				int err;
+			 * @brief 	Method send_batch_to sends several datagrams to a pre-parsed endpoint, skipping address parsing.
+			 * @param 	datagrams	vector of datagrams to send.
+			 * @param 	destination	endpoint to send the datagrams to, e.g. "127.0.0.1:5000"_ep.
+			 * @param 	flags 		any flags that the datagrams should be sent with (default 0).
+			 * @return 	int 		number of datagrams sent.
+			 * @throws	send_error if no datagram could be sent.
+			 */
+			int send_batch_to(const std::vector<outgoing_datagram>& datagrams, const ipv4_endpoint& destination, const int flags = 0) {
+				return send_batch_to(datagrams.data(), datagrams.size(), destination, flags);
+			}
+
+			/**
+			 * @brief 	Method send_batch_to sends several datagrams to a pre-parsed IPv4 or IPv6 address.
+			 * @param 	datagrams	pointer to the datagrams to send.
+			 * @param 	count		number of datagrams to send.
+			 * @param 	destination	address to send the datagrams to.
+			 * @param 	flags 		any flags that the datagrams should be sent with (default 0).
+			 * @return 	int 		number of datagrams sent.
+			 * @throws	send_error if the address does not fit the socket's family or if no datagram could be sent.
+			 */
+			int send_batch_to(const outgoing_datagram* datagrams, const size_t count, const socket_address& destination, const int flags = 0) {
+				// Lock the mutex so the socket to prevent race conditions.
+				std::unique_lock<std::mutex> send_lock(send_mutex);
+
+				const socket_address address_struct = prepare_destination<errors::send_error>(destination);
+				check_destination(address_struct);
+				return send_batch_datagrams(datagrams, count, flags, address_struct);
+			}
+
+			/**
+			 * @brief 	Method send_batch_to sends several datagrams to a pre-parsed IPv4 or IPv6 address.
+			 * @param 	datagrams	vector of datagrams to send.
+			 * @param 	destination	address to send the datagrams to.
+			 * @param 	flags 		any flags that the datagrams should be sent with (default 0).
+			 * @return 	int 		number of datagrams sent.
+			 * @throws	send_error if the address does not fit the socket's family or if no datagram could be sent.
+			 */
+			int send_batch_to(const std::vector<outgoing_datagram>& datagrams, const socket_address& destination, const int flags = 0) {
+				return send_batch_to(datagrams.data(), datagrams.size(), destination, flags);
+			}
+
+			/**
+			 * @brief 	Method send_batch sends several datagrams to the remote host pre-configured using configure_remote_host.
+			 * @param 	datagrams	pointer to the datagrams to send.
+			 * @param 	count		number of datagrams to send.
+			 * @param 	flags 		any flags that the datagrams should be sent with (default 0).
+			 * @return 	int 		number of datagrams sent.
+			 * @throws	send_error if the remote host has not been pre-configured or if no datagram could be sent.
+			 */
+			int send_batch(const outgoing_datagram* datagrams, const size_t count, const int flags = 0) {
+				// Lock the mutex so the socket to prevent race conditions.
+				std::unique_lock<std::mutex> access_lock(member_mutex);
+				std::unique_lock<std::mutex> send_lock(send_mutex);
+
+				if (!remote_address_set) {
+					throw errors::send_error("Remote host address and port has not been set.");
+				}
+				check_destination(remote_address);
+				return send_batch_datagrams(datagrams, count, flags, remote_address);
+			}
+
+			/**
+			 * @brief 	Method send_batch sends several datagrams to the remote host pre-configured using configure_remote_host.
+			 * @param 	datagrams	vector of datagrams to send.
+			 * @param 	flags 		any flags that the datagrams should be sent with (default 0).
+			 * @return 	int 		number of datagrams sent.
+			 * @throws	send_error if the remote host has not been pre-configured or if no datagram could be sent.
+			 */
+			int send_batch(const std::vector<outgoing_datagram>& datagrams, const int flags = 0) {
+				return send_batch(datagrams.data(), datagrams.size(), flags);
+			}
+
+			/**
+			 * @brief 	Method receive_batch receives up to count datagrams, waiting only for the first one and taking the
+			 * 			rest if they are already queued, using recvmmsg on Linux.
+			 * @param 	datagrams[in,out]	buffers to receive into, the size and source of each received datagram are set.
+			 * @param 	count[in]			number of buffers.
+			 * @param 	with_source[in]		true to set the source address and port of each datagram (default false).
+			 * @param 	flags[in]			any flags that the datagrams should be received with (default 0).
+			 * @return 	int					number of datagrams received, 0 if the receive timed out.
+			 * @throws	receive_error if an error occurred while receiving the data.
+			 */
+			int receive_batch(incoming_datagram* datagrams, const size_t count, const bool with_source = false, const int flags = 0) {
+				// Lock the mutex so the socket to prevent race conditions.
+				std::unique_lock<std::mutex> receive_lock(receive_mutex);
+				return receive_batch_datagrams(datagrams, count, with_source, flags);
+			}
+
+			/**
+			 * @brief 	Method receive_batch receives up to datagrams.size() datagrams.
+			 * @param 	datagrams[in,out]	buffers to receive into, the size and source of each received datagram are set.
+			 * @param 	with_source[in]		true to set the source address and port of each datagram (default false).
+			 * @param 	flags[in]			any flags that the datagrams should be received with (default 0).
+			 * @return 	int					number of datagrams received, 0 if the receive timed out.
+			 * @throws	receive_error if an error occurred while receiving the data.
+			 */
+			int receive_batch(std::vector<incoming_datagram>& datagrams, const bool with_source = false, const int flags = 0) {
+				return receive_batch(datagrams.data(), datagrams.size(), with_source, flags);
+			}
+
+
+			/**************************************************************************************************/
+			/* Configuration Methods		 																  */
+			/**************************************************************************************************/
+			/**
+			 * @brief 	Method getSocketFileDescriptor returns the socket file descriptor for use in additional lower level configuration.
+			 * @return 	unsigned long long file descriptor of the socket.
+			 */
+			unsigned long long get_socket_file_descriptor() {
+				return socket_file_descriptor;
+			}
+
+			/**
+			 * @brief 	Method configure_remote_address is used to configure a remote host to which packets
+			 * 			can be sent without having to provide the destination each time.
+			 * @param 	port 	unsigned short port number of the remote host.
+			 * @param 	address	string representation of the address of the remote host (default loopback).
+			 * @throws	configuration_error if the provided address is invalid.
+			 */
+			void configure_remote_host(unsigned short port, std::string address = "127.0.0.1") {
+				// Lock the mutex so the socket to prevent race conditions.
+				std::unique_lock<std::mutex> access_lock(member_mutex);
+
+				// Parse the address and convert it to the family of the socket.
+				remote_address = prepare_destination(socket_address::parse(address, port));
+				remote_address_set = true;
+			}
+
+			/**
+			 * @brief 	Method configure_remote_host configures a pre-parsed endpoint as the remote host.
+			 * @param 	destination	endpoint of the remote host, e.g. "127.0.0.1:5000"_ep.
+			 * @throws	configuration_error if the socket is IPv6 only.
+			 */
+			void configure_remote_host(const ipv4_endpoint& destination) {
+				// Lock the mutex so the socket to prevent race conditions.
+				std::unique_lock<std::mutex> access_lock(member_mutex);
+
+				remote_address = prepare_destination(socket_address(destination));
+				remote_address_set = true;
+			}
+
+			/**
+			 * @brief 	Method configure_remote_host configures a pre-parsed IPv4 or IPv6 address as the remote host.
+			 * @param 	destination	address of the remote host.
+			 * @throws	configuration_error if the address does not fit the socket's family.
+			 */
+			void configure_remote_host(const socket_address& destination) {
+				// Lock the mutex so the socket to prevent race conditions.
+				std::unique_lock<std::mutex> access_lock(member_mutex);
+
+				remote_address = prepare_destination(destination);
+				remote_address_set = true;
+			}
+
+			/**
+			 * @brief 	Method connect_peer creates a socket bound to the same local address and port as this one and
+			 * 			connected to a single peer, so the kernel delivers that peer's datagrams to the new socket.
+			 * @details	A server receives from every peer through one socket until a peer is established, then gives the
+			 * 			peer its own socket which can be served by its own thread without dispatching in user space.
+			 * 			The kernel prefers the connected socket for the peer's datagrams, and on Linux a reuse port
+			 * 			program is attached to this socket so datagrams from other peers keep arriving here, including
+			 * 			while a new peer socket is bound but not yet connected. Datagrams from the peer queued before the call
+			 * 			are still received by this socket, and destroying the peer socket returns the peer to it. This
+			 * 			socket must have been created with share_port.
+			 * @param 	peer 						address and port of the peer.
+			 * @return 	std::shared_ptr<socket> 	socket connected to the peer, with the peer as its remote host.
+			 * @throws	configuration_error if the socket does not share its port, the address does not fit the socket's
+			 * 			family or the socket could not be connected.
+			 * @throws	initialization_error if the socket could not be created or bound.
+			 */
+			std::shared_ptr<socket> connect_peer(const socket_address& peer) {
+				if (!port_shared) {
+					throw errors::configuration_error("Peers can only be connected from a socket created with share_port.");
+				}
+				const socket_address destination = prepare_destination(peer);
+				const socket_address bound = get_local_address();
+				attach_peer_steering();
+
+				// Bind to exactly the same address and port, which reuse port allows for sockets of the same user.
+				std::shared_ptr<socket> peer_socket = std::make_shared<socket>(bound.port(), bound.address_string(), get_address_family(), true);
+				if (::connect(peer_socket->socket_file_descriptor, destination.data(), destination.length())) {
+					throw errors::configuration_error("An error occurred while connecting to the peer: " + std::to_string(get_last_network_error()));
+				}
+				peer_socket->configure_remote_host(destination);
+				return peer_socket;
+			}
+
+			/**
+			 * @brief 	Method connect_peer creates a socket sharing this socket's local port that is connected to a single peer.
+			 * @param 	port 						port of the peer.
+			 * @param 	address 					address of the peer (default "127.0.0.1").
+			 * @return 	std::shared_ptr<socket> 	socket connected to the peer, with the peer as its remote host.
+			 * @throws	configuration_error if the address is invalid or the socket could not be connected.
+			 * @throws	initialization_error if the socket could not be created or bound.
+			 */
+			std::shared_ptr<socket> connect_peer(unsigned short port, std::string address = "127.0.0.1") {
+				return connect_peer(socket_address::parse(address, port));
+			}
+
+			/**
+			 * @brief 	Method get_address_family returns the addresses the socket was created for.
+			 * @return 	address_family 	IPv4, IPv6 only or dual stack.
+			 */
+			address_family get_address_family() const {
+				if (socket_family == AF_INET) {
+					return address_family::IPV4;
+				}
+				return dual_stack ? address_family::DUAL_STACK : address_family::IPV6;
+			}
+
+			/**
+			 * @brief 	Method get_local_address returns the address the socket is bound to, including the port chosen by
+			 * 			the operating system when the socket was bound to port 0.
+			 * @return 	socket_address 	bound address.
+			 * @throws	configuration_error if the address could not be read.
+			 */
+			socket_address get_local_address() {
+				sockaddr_storage bound{};
+				address_length bound_size = sizeof(bound);
+				if (::getsockname(socket_file_descriptor, (sockaddr*)&bound, &bound_size)) {
+					throw errors::configuration_error("An error occurred while reading the local address: " + std::to_string(get_last_network_error()));
+				}
+				return socket_address((const sockaddr*)&bound, bound_size);
+			}
+
+			/**
+			 * @brief 	Method set_socket_receive_timeout is used to configure the socket to time out on 
+			 * 			receive calls after the specified number of milliseconds.
+			 * @param 	timeout_ms 	unsigned int number of milliseconds before calls to receive time out.
+			 * @throws	configuration_error if the timeout could not be set. 
+			 */
+			void set_socket_receive_timeout(unsigned int timeout_ms) {
+#ifdef _WIN32
+				// windows wants timeouts as DWORD in ms
+				DWORD timeout_ms_long = (DWORD)(timeout_ms);
+				if (::setsockopt(socket_file_descriptor, SOL_SOCKET, SO_RCVTIMEO, (char*)&timeout_ms_long, sizeof(timeout_ms_long))) {
+					throw errors::configuration_error("An error occurred while setting the receive timeout: " + std::to_string(get_last_network_error()));
+				}
+#else
+				struct timeval timeout_struct;
+				// Get the equivalent number of seconds from the milliseconds.
+				timeout_struct.tv_sec = (int)(timeout_ms / 1000.0);
+				// Set the remaining number of microseconds.
+				// Remaining microseconds = ((total milliseconds) - (seconds * 1000)) * 1000
+				timeout_struct.tv_usec = (int)(timeout_ms - (timeout_struct.tv_sec * 1000.0)) * 1000;
+				if (::setsockopt(socket_file_descriptor, SOL_SOCKET, SO_RCVTIMEO, &timeout_struct, sizeof(timeout_struct))) {
+					throw errors::configuration_error("An error occurred while setting the receive timeout: " + std::to_string(get_last_network_error()));
+				}
+#endif   
+			}
+
+			/**
+			 * @brief 	Method set_tracer attaches an event tracer that records every send and receive made by the socket.
+			 * @param 	new_tracer 	shared pointer to the tracer to record into, nullptr to stop tracing.
+			 */
+			void set_tracer(std::shared_ptr<trace::tracer> new_tracer) {
+				// Lock all of the mutexes so no send or receive is using the tracer while it is replaced.
+				std::unique_lock<std::mutex> access_lock(member_mutex);
+				std::unique_lock<std::mutex> send_lock(send_mutex);
+				std::unique_lock<std::mutex> receive_lock(receive_mutex);
+				event_tracer = new_tracer;
+			}
+
+			/**
+			 * @brief 	Method set_timing_enabled configures whether the duration of each send and receive call is
+			 * 			recorded in the socket statistics, which costs two clock reads per call.
+			 * @param 	enabled 	true to record call durations.
+			 */
+			void set_timing_enabled(bool enabled) {
+				// Lock all of the mutexes so no send or receive is reading the flag while it is changed.
+				std::unique_lock<std::mutex> access_lock(member_mutex);
+				std::unique_lock<std::mutex> send_lock(send_mutex);
+				std::unique_lock<std::mutex> receive_lock(receive_mutex);
+				timing_enabled = enabled;
+			}
+
+			/**
+			 * @brief 	Method enable_kernel_diagnostics asks the kernel to report the drops and errors of the socket.
+			 * @details	On Linux this enables SO_RXQ_OVFL, so every received datagram carries the number of datagrams the
+			 * 			kernel has dropped because the receive buffer was full, and IP_RECVERR, so ICMP errors are queued
+			 * 			on the socket's error queue instead of being discarded. Other platforms do not support these
+			 * 			options so only the buffer sizes are reported.
+			 * @throws	configuration_error if the options could not be set.
+			 */
+			void enable_kernel_diagnostics() {
+				// Lock the mutexes so no receive is running while the receive path changes.
+				std::unique_lock<std::mutex> access_lock(member_mutex);
+				std::unique_lock<std::mutex> receive_lock(receive_mutex);
+#ifdef __linux__
+				int on = 1;
+				if (::setsockopt(socket_file_descriptor, SOL_SOCKET, SO_RXQ_OVFL, &on, sizeof(on))) {
+					throw errors::configuration_error("An error occurred while enabling SO_RXQ_OVFL: " + std::to_string(get_last_network_error()));
+				}
+				control_messages_enabled = true;
+#endif
+				enable_error_queue_locked();
+			}
+
+			/**
+			 * @brief 	Method enable_error_queue asks the kernel to queue ICMP errors for datagrams sent by the socket
+			 * 			(IP_RECVERR) so they can be read with read_error_queue. Only supported on Linux.
+			 * @throws	configuration_error if the option could not be set.
+			 */
+			void enable_error_queue() {
+				// Lock the mutexes so no receive is running while the receive path changes.
+				std::unique_lock<std::mutex> access_lock(member_mutex);
+				std::unique_lock<std::mutex> receive_lock(receive_mutex);
+				enable_error_queue_locked();
+			}
+
+			/**
+			 * @brief 	Method enable_packet_info asks the kernel to report the local address and interface each datagram
+			 * 			arrived on (IP_PKTINFO and IPV6_RECVPKTINFO), which batch receives store in the destination_address
+			 * 			and interface_index of each datagram. Only supported on Linux.
+			 * @details	Together with send_from this lets one socket bound to the wildcard address serve every local
+			 * 			address of a multi-homed host, replying from the address each request was sent to.
+			 * @throws	configuration_error if the options could not be set.
+			 */
+			void enable_packet_info() {
+				// Lock the mutexes so no receive is running while the receive path changes.
+				std::unique_lock<std::mutex> access_lock(member_mutex);
+				std::unique_lock<std::mutex> receive_lock(receive_mutex);
+#ifdef __linux__
+				int on = 1;
+				// IPv4 traffic, including IPv4 peers of a dual stack socket, reports IP_PKTINFO.
+				if ((socket_family == AF_INET || dual_stack) && ::setsockopt(socket_file_descriptor, IPPROTO_IP, IP_PKTINFO, &on, sizeof(on))) {
+					throw errors::configuration_error("An error occurred while enabling IP_PKTINFO: " + std::to_string(get_last_network_error()));
+				}
+				if (socket_family == AF_INET6 && ::setsockopt(socket_file_descriptor, IPPROTO_IPV6, IPV6_RECVPKTINFO, &on, sizeof(on))) {
+					throw errors::configuration_error("An error occurred while enabling IPV6_RECVPKTINFO: " + std::to_string(get_last_network_error()));
+				}
+				control_messages_enabled = true;
+				packet_info_enabled = true;
+#endif
+			}
+
+			/**
+			 * @brief 	Method enable_receive_timestamps makes the kernel record when each datagram arrived (SO_TIMESTAMPNS),
+			 * 			which receive_batch reports in the receive_timestamp_ns of each datagram.
+			 * @details	The timestamp is taken from the system clock as the datagram enters the network stack, so it leaves
+			 * 			out the time spent queued on the socket and waiting for the receiving thread. On platforms without
+			 * 			SO_TIMESTAMPNS the method does nothing and datagrams report a timestamp of 0.
+			 * @throws	configuration_error if the option could not be set.
+			 */
+			void enable_receive_timestamps() {
+				// Lock the mutexes so no receive is running while the receive path changes.
+				std::unique_lock<std::mutex> access_lock(member_mutex);
+				std::unique_lock<std::mutex> receive_lock(receive_mutex);
+#ifdef __linux__
+				int on = 1;
+				if (::setsockopt(socket_file_descriptor, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on))) {
+					throw errors::configuration_error("An error occurred while enabling SO_TIMESTAMPNS: " + std::to_string(get_last_network_error()));
+				}
+				control_messages_enabled = true;
+				receive_timestamps_enabled = true;
+#endif
+			}
+
+			/**
+			 * @brief 	Method enable_ecn marks every sent datagram with an ECN codepoint (IP_TOS or IPV6_TCLASS) and reads
+			 * 			the codepoint of every received datagram (IP_RECVTOS or IPV6_RECVTCLASS).
+			 * @details	Routers with active queue management mark ECN capable datagrams Congestion Experienced instead of
+			 * 			dropping them when their queues build. Received codepoints are counted in the ecn_capable_received
+			 * 			and ecn_congestion_experienced statistics and reported in the ecn of each datagram from receive_batch,
+			 * 			so a receiver can echo the marks to the sender, which should slow down as it would for a loss.
+			 * 			The DSCP bits of the traffic class are kept. On platforms other than Linux the method does nothing.
+			 * @param 	codepoint 	codepoint of sent datagrams (default ECT_0), NOT_ECT to only read received codepoints.
+			 * @throws	configuration_error if the options could not be set.
+			 */
+			void enable_ecn(ecn_codepoint codepoint = ECT_0) {
+				// Lock the mutexes so no receive is running while the receive path changes.
+				std::unique_lock<std::mutex> access_lock(member_mutex);
+				std::unique_lock<std::mutex> receive_lock(receive_mutex);
+#ifdef __linux__
+				int on = 1;
+				// IPv4 traffic, including IPv4 peers of a dual stack socket, uses the IPv4 options.
+				if (socket_family == AF_INET || dual_stack) {
+					set_traffic_class_bits(IPPROTO_IP, IP_TOS, "IP_TOS", 0x03, codepoint);
+					if (::setsockopt(socket_file_descriptor, IPPROTO_IP, IP_RECVTOS, &on, sizeof(on))) {
+						throw errors::configuration_error("An error occurred while enabling IP_RECVTOS: " + std::to_string(get_last_network_error()));
+					}
+				}
+				if (socket_family == AF_INET6) {
+					set_traffic_class_bits(IPPROTO_IPV6, IPV6_TCLASS, "IPV6_TCLASS", 0x03, codepoint);
+					if (::setsockopt(socket_file_descriptor, IPPROTO_IPV6, IPV6_RECVTCLASS, &on, sizeof(on))) {
+						throw errors::configuration_error("An error occurred while enabling IPV6_RECVTCLASS: " + std::to_string(get_last_network_error()));
+					}
+				}
+				control_messages_enabled = true;
+				ecn_enabled = true;
+				sent_ecn = codepoint;
+#else
+				(void)codepoint;
+#endif
+			}
+
+			/**
+			 * @brief 	Method set_traffic_class sets the DSCP (IP_TOS or IPV6_TCLASS) and priority (SO_PRIORITY) of every
+			 * 			datagram sent by the socket, so latency critical traffic is queued ahead of bulk traffic from the
+			 * 			host's queueing discipline onward. Only supported on Linux.
+			 * @details	The ECN bits of the traffic class are kept. Setting the DSCP also makes the kernel derive a priority
+			 * 			from the TOS, so the priority is set after it. Individual datagrams can be sent in another class
+			 * 			with the send_to overload taking a traffic_class.
+			 * @param 	socket_class 	DSCP and priority of the socket, e.g. traffic_classes::BULK. Fields of -1 are left unchanged.
+			 * @throws	configuration_error if the class is invalid or the options could not be set, e.g. a priority above
+			 * 			6 without CAP_NET_ADMIN.
+			 */
+			void set_traffic_class(const traffic_class& socket_class) {
+				check_traffic_class<errors::configuration_error>(socket_class);
+				std::unique_lock<std::mutex> access_lock(member_mutex);
+#ifdef __linux__
+				if (socket_class.dscp >= 0) {
+					if (socket_family == AF_INET || dual_stack) {
+						set_traffic_class_bits(IPPROTO_IP, IP_TOS, "IP_TOS", 0xfc, socket_class.dscp << 2);
+					}
+					if (socket_family == AF_INET6) {
+						set_traffic_class_bits(IPPROTO_IPV6, IPV6_TCLASS, "IPV6_TCLASS", 0xfc, socket_class.dscp << 2);
+					}
+				}
+				if (socket_class.priority >= 0 && ::setsockopt(socket_file_descriptor, SOL_SOCKET, SO_PRIORITY, &socket_class.priority, sizeof(socket_class.priority))) {
+					throw errors::configuration_error("An error occurred while setting SO_PRIORITY: " + std::to_string(get_last_network_error()));
+				}
+#else
+				throw errors::configuration_error("Setting the traffic class of a socket is only supported on Linux.");
+#endif
+			}
+
+			/**
+			 * @brief 	Method enable_array_encoding makes the vector overloads of send, send_to and send_from encode int32_t,
+			 * 			uint32_t, float and double vectors with array_codec, and receive<T>() decode them again.
+			 * @details	Both ends must enable it, but only the sender's methods matter since every encoded array records
+			 * 			how it was encoded. Configure the socket before sending or receiving, the settings are not
+			 * 			synchronised with sends and receives that are already running.
+			 * @param 	encoding 	methods used for integer and floating point vectors (default frame-of-reference and XOR).
+			 * @throws	configuration_error if the quantization step is not a positive finite number.
+			 */
+			void enable_array_encoding(const array_codec::array_encoding& encoding = array_codec::array_encoding()) {
+				std::unique_lock<std::mutex> access_lock(member_mutex);
+				if (encoding.floating_method == array_codec::QUANTIZED && !(encoding.quantization_step > 0 && std::isfinite(encoding.quantization_step))) {
+					throw errors::configuration_error("Quantization step must be a positive finite number.");
+				}
+				array_encoding_settings = encoding;
+				array_encoding_enabled = true;
+			}
+
+			/**
+			 * @brief 	Method disable_array_encoding sends and receives vectors as their raw bytes again.
+			 */
+			void disable_array_encoding() {
+				std::unique_lock<std::mutex> access_lock(member_mutex);
+				array_encoding_enabled = false;
+			}
+
+			/**
+			 * @brief 	Method read_error_queue reads every queued ICMP error without blocking.
+			 * @details	Each error updates the health of the destination it was reported for and is passed to the error
+			 * 			handler if one is set. Receives consume queued errors automatically, so sockets that only send
+			 * 			should call this periodically (it costs a single system call when the queue is empty).
+			 * @return 	std::vector<icmp_error> 	errors read from the queue, oldest first.
+			 */
+			std::vector<icmp_error> read_error_queue() {
+				std::vector<icmp_error> errors_read;
+#ifdef __linux__
+				drain_error_queue(&errors_read);
+#endif
+				return errors_read;
+			}
+
+			/**
+			 * @brief 	Method set_icmp_error_handler sets a function that is called for every ICMP error read from the
+			 * 			error queue, on the thread that read it.
+			 * @param 	handler 	function to call, or an empty function to remove the handler.
+			 */
+			void set_icmp_error_handler(std::function<void(const icmp_error&)> handler) {
+				std::unique_lock<std::mutex> error_lock(error_mutex);
+				icmp_error_handler = std::move(handler);
+			}
+
+			/**
+			 * @brief 	Method set_fail_fast configures whether sends to a destination that has been reported unreachable
+			 * 			throw immediately instead of sending into the void.
+			 * @param 	enabled 	true to fail sends to unreachable destinations.
+			 * @note	Call clear_destination_health once a destination is expected to be reachable again.
+			 */
+			void set_fail_fast(bool enabled) {
+				std::unique_lock<std::mutex> error_lock(error_mutex);
+				fail_fast_enabled = enabled;
+				fail_fast_active = fail_fast_enabled && !destination_errors.empty();
+			}
+
+			/**
+			 * @brief 	Method get_destination_health returns the errors reported for a destination.
+			 * @param 	port 	port of the destination.
+			 * @param 	address	string representation of the address of the destination (default loopback).
+			 * @return 	destination_health 	summary of the errors, with an error count of 0 if none were reported.
+			 * @throws	configuration_error if the provided address is invalid.
+			 */
+			destination_health get_destination_health(unsigned short port, const std::string& address = "127.0.0.1") {
+				const socket_address key = socket_address::parse(address, port).to_ipv4();
+				std::unique_lock<std::mutex> error_lock(error_mutex);
+				auto found = destination_errors.find(key);
+				return found != destination_errors.end() ? found->second : destination_health{};
+			}
+
+			/**
+			 * @brief 	Method clear_destination_health forgets the errors reported for a destination.
+			 * @param 	port 	port of the destination.
+			 * @param 	address	string representation of the address of the destination (default loopback).
+			 * @throws	configuration_error if the provided address is invalid.
+			 */
+			void clear_destination_health(unsigned short port, const std::string& address = "127.0.0.1") {
+				const socket_address key = socket_address::parse(address, port).to_ipv4();
+				std::unique_lock<std::mutex> error_lock(error_mutex);
+				destination_errors.erase(key);
+				fail_fast_active = fail_fast_enabled && !destination_errors.empty();
+			}
+
+			/**
+			 * @brief 	Method get_kernel_diagnostics returns the kernel's view of the socket's memory use and drops.
+			 * @details	The snapshot is also stored in the socket statistics so it is exported alongside the user space
+			 * 			counters. This method does not take the send or receive mutexes so it can be called while
+			 * 			other threads are using the socket.
+			 * @return 	kernel_diagnostics 	snapshot of the kernel counters.
+			 */
+			kernel_diagnostics get_kernel_diagnostics() {
+				kernel_diagnostics diagnostics{};
+
+				// Buffer sizes are available on every platform.
+				int buffer_size = 0;
+				address_length option_size = sizeof(buffer_size);
+				if (::getsockopt(socket_file_descriptor, SOL_SOCKET, SO_RCVBUF, (char *)&buffer_size, &option_size) == 0) {
+					diagnostics.receive_buffer_bytes = (uint32_t)buffer_size;
+				}
+				option_size = sizeof(buffer_size);
+				if (::getsockopt(socket_file_descriptor, SOL_SOCKET, SO_SNDBUF, (char *)&buffer_size, &option_size) == 0) {
+					diagnostics.send_buffer_bytes = (uint32_t)buffer_size;
+				}
+
+#ifdef __linux__
+				uint32_t memory_information[SK_MEMINFO_VARS] = {};
+				option_size = sizeof(memory_information);
+				if (::getsockopt(socket_file_descriptor, SOL_SOCKET, SO_MEMINFO, memory_information, &option_size) == 0) {
+					diagnostics.memory_information_available = true;
+					diagnostics.receive_queue_bytes = memory_information[SK_MEMINFO_RMEM_ALLOC];
+					diagnostics.receive_buffer_bytes = memory_information[SK_MEMINFO_RCVBUF];
+					diagnostics.send_queue_bytes = memory_information[SK_MEMINFO_WMEM_ALLOC];
+					diagnostics.send_buffer_bytes = memory_information[SK_MEMINFO_SNDBUF];
+					diagnostics.forward_allocated_bytes = memory_information[SK_MEMINFO_FWD_ALLOC];
+					diagnostics.option_memory_bytes = memory_information[SK_MEMINFO_OPTMEM];
+					diagnostics.backlog_bytes = memory_information[SK_MEMINFO_BACKLOG];
+					diagnostics.drops = memory_information[SK_MEMINFO_DROPS];
+				}
+#endif
+				diagnostics.receive_queue_overflows = traffic_statistics->kernel_receive_queue_overflows.load(std::memory_order_relaxed);
+				diagnostics.icmp_errors = traffic_statistics->icmp_errors.load(std::memory_order_relaxed);
+
+				// Store the snapshot so exporters report it alongside the user space counters.
+				traffic_statistics->kernel_receive_queue_bytes.store(diagnostics.receive_queue_bytes, std::memory_order_relaxed);
+				traffic_statistics->kernel_receive_buffer_bytes.store(diagnostics.receive_buffer_bytes, std::memory_order_relaxed);
+				traffic_statistics->kernel_send_queue_bytes.store(diagnostics.send_queue_bytes, std::memory_order_relaxed);
+				traffic_statistics->kernel_send_buffer_bytes.store(diagnostics.send_buffer_bytes, std::memory_order_relaxed);
+				traffic_statistics->kernel_backlog_bytes.store(diagnostics.backlog_bytes, std::memory_order_relaxed);
+				traffic_statistics->kernel_drops.store(diagnostics.drops, std::memory_order_relaxed);
+				return diagnostics;
+			}
+
+			/**
+			 * @brief 	Method get_statistics returns the counters and histograms of the socket.
+			 * @return 	std::shared_ptr<const statistics::socket_statistics> 	statistics that remain valid after the socket is destroyed.
+			 */
+			std::shared_ptr<const statistics::socket_statistics> get_statistics() {
+				return traffic_statistics;
+			}
+
+		protected:
+#ifdef _WIN32
+			/// Type used by the platform for the length of socket addresses and options.
+			using address_length = int;
+#else
+			/// Type used by the platform for the length of socket addresses and options.
+			using address_length = socklen_t;
+#endif
+
+			/**************************************************************************************************/
+			/* Non-Static Members			 																  */
+			/**************************************************************************************************/
+			/// File descriptor of the socket that the class uses.
+			unsigned long long socket_file_descriptor;
+
+			/// The local port number of the socket. 
+			unsigned short local_port;
+			/// Struct holding the local address of the socket. 
+			socket_address local_address;
+			/// Address family of the socket, AF_INET or AF_INET6.
+			int socket_family = AF_INET;
+			/// Flag for if an IPv6 socket also sends to and receives from IPv4 peers.
+			bool dual_stack = false;
+			/// Flag for if the socket was created with SO_REUSEPORT so connect_peer can bind peers to its port.
+			bool port_shared = false;
+
+			/// Struct holding the pre-configured remote address of the destination. 
+			socket_address remote_address;
+			/// Flag for if the remote address has been pre-configured.  
+			bool remote_address_set;
+
+			/// Mutex to control ability to access private variables in the socket.
+			std::mutex member_mutex;
+
+			/// Mutex to control ability to send using the socket.
+			std::mutex send_mutex;
+
+			/// Mutex to control ability to receive using the socket.
+			std::mutex receive_mutex;
+
+			/// Optional tracer that socket operations are recorded into.
+			std::shared_ptr<trace::tracer> event_tracer;
+
+			/// Counters and histograms of the traffic handled by the socket.
+			std::shared_ptr<statistics::socket_statistics> traffic_statistics = std::make_shared<statistics::socket_statistics>();
+			/// Flag for if send and receive calls are timed for the duration histograms.
+			bool timing_enabled = false;
+
+			/// Flag for if receives must use recvmsg to collect control messages.
+			bool control_messages_enabled = false;
+			/// Flag for if ICMP errors are queued on the socket error queue (IP_RECVERR).
+			bool error_queue_enabled = false;
+			/// Flag for if received datagrams carry their local address and interface (IP_PKTINFO).
+			bool packet_info_enabled = false;
+			/// Flag for if received datagrams carry the time the kernel received them (SO_TIMESTAMPNS).
+			bool receive_timestamps_enabled = false;
+			/// Flag for if the ECN codepoints of received datagrams are read (IP_RECVTOS).
+			bool ecn_enabled = false;
+			/// ECN codepoint set on sent datagrams, kept when a datagram is sent in its own traffic class.
+			uint8_t sent_ecn = NOT_ECT;
+			/// Flag for if the reuse port program keeping unconnected traffic on this socket has been attached.
+			bool peer_steering_attached = false;
+			/// Flag for if int32_t, uint32_t, float and double vectors are encoded when sent and decoded when received.
+			bool array_encoding_enabled = false;
+			/// Methods used to encode vectors when array encoding is enabled.
+			array_codec::array_encoding array_encoding_settings;
+
+			/// Mutex to control access to the destination errors and the error handler.
+			std::mutex error_mutex;
+			/// Errors reported for each destination, with IPv4 mapped destinations stored as plain IPv4.
+			std::unordered_map<socket_address, destination_health, socket_address::hash> destination_errors;
+			/// Function called for every ICMP error read from the error queue.
+			std::function<void(const icmp_error&)> icmp_error_handler;
+			/// Flag for if sends to unreachable destinations should fail immediately.
+			bool fail_fast_enabled = false;
+			/// Flag read by sends without the error mutex, true when fail fast is enabled and a destination has errors.
+			std::atomic<bool> fail_fast_active{false};
+
+
+			/**************************************************************************************************/
+			/* Non-Static Methods			 																  */
+			/**************************************************************************************************/
+			/**
+			 * @brief 	Method encode_array encodes a vector for sending if array encoding is enabled for its element type.
+			 * @param 	buffer 		vector about to be sent.
+			 * @return 	const std::vector<char>* 	encoded array, held in a buffer reused by each thread, or nullptr if the
+			 * 										vector should be sent as its raw bytes.
+			 * @throws	send_error if a value cannot be quantized with the configured step.
+			 */
+			template <typename T>
+			const std::vector<char>* encode_array(const std::vector<T>& buffer) {
+				if constexpr (array_codec::is_supported<T>::value) {
+					if (array_encoding_enabled) {
+						thread_local std::vector<char> encoded;
+						try {
+							array_codec::encode(buffer, array_encoding_settings, encoded);
+						}
+						catch (errors::encode_error& error) {
+							throw errors::send_error(error.what());
+						}
+						return &encoded;
+					}
+				}
+				return nullptr;
+			}
+
+			/**
+			 * 	@brief	Method initialize_windows_sockets starts WSA in preparation for using sockets in Windows.
+			 * 	@throws	initialization_error if WSA fails to start.
+			*/
+			void initialize_windows_sockets(void) {
+#ifdef _WIN32
+				WORD wVersionRequested;
+				WSADATA wsaData;
+				int err;
 				/* Use the MAKEWORD(lowbyte, highbyte) macro declared in Windef.h */
 				wVersionRequested = MAKEWORD(2, 2);	// We'll ask for ver 2.2
 				err = ::WSAStartup(wVersionRequested, &wsaData);
@@ -586,6 +1300,870 @@ namespace oo_socket
 #endif
 			}
 
+			/**
+			 *	@brief	Method receive_datagram receives a single datagram, records it and converts its source address.
+			 *	@param	buffer[out]				buffer that will store the incoming packet.
+			 *	@param	buffer_size[in]			size of the buffer.
+			 *	@param	source_address[out]		pointer to string to store the source address, or nullptr.
+			 *	@param	source_port[out]		pointer to uint16_t to store the source port, or nullptr.
+			 *	@param	flags[in]				any flags that the packet should be received with.
+			 *	@return	int						number of bytes received, -1 if the receive timed out.
+			 *	@throws	receive_error if an error occurred while receiving the data.
+			 *	@note	The caller must hold the receive mutex.
+			 */
+			int receive_datagram(char* buffer, const size_t buffer_size, std::string* source_address, uint16_t* source_port, const int flags) {
+				const uint64_t start_ns = operation_start();
+				const bool want_source = source_address != nullptr && source_port != nullptr;
+
+				// Declare variables to store the source of the packet.
+				sockaddr_storage from;
+				address_length from_size = sizeof(from);
+
+				int receive_size;
+				while (true) {
+					receive_size = receive_system_call(buffer, buffer_size, flags, want_source ? &from : nullptr, &from_size);
+					if (receive_size != -1) {
+						break;
+					}
+
+					// If the receive timed out, record the wait and let the caller return nothing.
+					int error_code = get_last_network_error();
+#ifdef _WIN32
+					if (error_code == WSAETIMEDOUT)
+#else
+					if (error_code == EAGAIN || error_code == EWOULDBLOCK)
+#endif
+					{
+						record_event(trace::event_type::WAIT, start_ns, 0);
+						return -1;
+					}
+#ifdef __linux__
+					// With IP_RECVERR an ICMP error is also reported by the next receive, so consume the queued
+					// error and keep waiting for data rather than failing the receive.
+					if (error_queue_enabled && is_icmp_error(error_code)) {
+						drain_error_queue();
+						continue;
+					}
+#endif
+					record_event(trace::event_type::RECEIVE_FAILURE, start_ns, 0, error_code);
+					throw errors::receive_error(std::to_string(error_code));
+				}
+
+				if (want_source) {
+					// Convert the source information from network order back into something readable.
+					const socket_address source((const sockaddr*)&from, from_size);
+					*source_address = source.address_string();
+					*source_port = source.port();
+				}
+
+				record_event(trace::event_type::RECEIVE, start_ns, receive_size);
+				return receive_size;
+			}
+
+			/**
+			 *	@brief	Method send_datagram sends a single datagram and records it.
+			 *	@param	buffer			pointer to buffer of bytes to send.
+			 *	@param	buffer_size		size of buffer in bytes.
+			 *	@param	flags			any flags that the packet should be sent with.
+			 *	@param	destination		address to send the datagram to.
+			 *	@return	int				number of bytes sent.
+			 *	@throws	send_error if an error occurred while sending the data.
+			 *	@note	The caller must hold the send mutex.
+			 */
+			int send_datagram(const char* buffer, const size_t buffer_size, const int flags, const socket_address& destination) {
+				const uint64_t start_ns = operation_start();
+#ifdef _WIN32
+				int result = ::sendto(socket_file_descriptor, buffer, (int)buffer_size, flags, destination.data(), destination.length());
+#else
+				int result = ::sendto(socket_file_descriptor, buffer, buffer_size, flags, destination.data(), destination.length());
+#endif
+#ifdef __linux__
+				// With IP_RECVERR an ICMP error caused by an earlier datagram is reported by the next send, so
+				// record the queued error and retry unless it shows this destination is unreachable.
+				if (result == -1 && error_queue_enabled && is_icmp_error(get_last_network_error())) {
+					drain_error_queue();
+					check_destination(destination);
+					result = ::sendto(socket_file_descriptor, buffer, buffer_size, flags, destination.data(), destination.length());
+				}
+#endif
+				// If an error occurs, throw an error.
+				if (result == -1) {
+					int error_code = get_last_network_error();
+					record_event(trace::event_type::SEND_FAILURE, start_ns, 0, error_code);
+					throw errors::send_error(std::to_string(error_code));
+				}
+				// Else return the number of bytes sent.
+				record_event(trace::event_type::SEND, start_ns, result);
+				return result;
+			}
+
+			/**
+			 *	@brief	Method send_datagram_from sends a single datagram with its source set through IP_PKTINFO or
+			 *			IPV6_PKTINFO and records it.
+			 *	@param	buffer			pointer to buffer of bytes to send.
+			 *	@param	buffer_size		size of buffer in bytes.
+			 *	@param	flags			any flags that the packet should be sent with.
+			 *	@param	destination		address to send the datagram to, already in the family of the socket.
+			 *	@param	source			local address to send from, empty to let the kernel choose.
+			 *	@param	interface_index	index of the interface to send through, 0 to let the kernel choose.
+			 *	@param	message_class	traffic class of the datagram, or nullptr to use the socket's (default nullptr).
+			 *	@return	int				number of bytes sent.
+			 *	@throws	send_error if an error occurred while sending the data or the platform does not support it.
+			 *	@note	The caller must hold the send mutex.
+			 */
+			int send_datagram_from(const char* buffer, const size_t buffer_size, const int flags, const socket_address& destination, const socket_address& source, const uint32_t interface_index, const traffic_class* message_class = nullptr) {
+#ifdef __linux__
+				const uint64_t start_ns = operation_start();
+				alignas(cmsghdr) char control[CONTROL_BUFFER_SIZE] = {};
+				iovec data_vector;
+				data_vector.iov_base = const_cast<char*>(buffer);
+				data_vector.iov_len = buffer_size;
+				msghdr message{};
+				message.msg_name = const_cast<sockaddr*>(destination.data());
+				message.msg_namelen = destination.length();
+				message.msg_iov = &data_vector;
+				message.msg_iovlen = 1;
+				message.msg_control = control;
+
+				cmsghdr* header = (cmsghdr*)control;
+				if (socket_family == AF_INET) {
+					in_pktinfo info{};
+					info.ipi_ifindex = (int)interface_index;
+					if (source.family() != AF_UNSPEC) {
+						info.ipi_spec_dst = prepare_destination<errors::send_error>(source).ipv4().sin_addr;
+					}
+					header->cmsg_level = IPPROTO_IP;
+					header->cmsg_type = IP_PKTINFO;
+					header->cmsg_len = CMSG_LEN(sizeof(info));
+					::memcpy(CMSG_DATA(header), &info, sizeof(info));
+					message.msg_controllen = CMSG_SPACE(sizeof(info));
+				}
+				else {
+					in6_pktinfo info{};
+					info.ipi6_ifindex = interface_index;
+					if (source.family() != AF_UNSPEC) {
+						info.ipi6_addr = prepare_destination<errors::send_error>(source).ipv6().sin6_addr;
+					}
+					else if (destination.is_ipv4_mapped()) {
+						// The kernel only accepts IPv4 mapped sources for IPv4 peers, so leave the choice to it with ::ffff:0.0.0.0.
+						info.ipi6_addr.s6_addr[10] = 0xff;
+						info.ipi6_addr.s6_addr[11] = 0xff;
+					}
+					header->cmsg_level = IPPROTO_IPV6;
+					header->cmsg_type = IPV6_PKTINFO;
+					header->cmsg_len = CMSG_LEN(sizeof(info));
+					::memcpy(CMSG_DATA(header), &info, sizeof(info));
+					message.msg_controllen = CMSG_SPACE(sizeof(info));
+				}
+				if (message_class != nullptr) {
+					// IPv4 mapped destinations are sent as IPv4, which takes IP_TOS even from an IPv6 socket.
+					if (message_class->dscp >= 0) {
+						const int tos = (message_class->dscp << 2) | sent_ecn;
+						if (socket_family == AF_INET || destination.is_ipv4_mapped()) {
+							append_control_message(message, IPPROTO_IP, IP_TOS, tos);
+						}
+						else {
+							append_control_message(message, IPPROTO_IPV6, IPV6_TCLASS, tos);
+						}
+					}
+					// The priority goes last since the kernel derives one from IP_TOS as it reads it.
+					if (message_class->priority >= 0) {
+						append_control_message(message, SOL_SOCKET, SO_PRIORITY, message_class->priority);
+					}
+				}
+
+				int result = (int)::sendmsg(socket_file_descriptor, &message, flags);
+				// Retry once after recording a queued ICMP error, as in send_datagram.
+				if (result == -1 && error_queue_enabled && is_icmp_error(get_last_network_error())) {
+					drain_error_queue();
+					check_destination(destination);
+					result = (int)::sendmsg(socket_file_descriptor, &message, flags);
+				}
+				if (result == -1) {
+					int error_code = get_last_network_error();
+					record_event(trace::event_type::SEND_FAILURE, start_ns, 0, error_code);
+					throw errors::send_error(std::to_string(error_code));
+				}
+				record_event(trace::event_type::SEND, start_ns, result);
+				return result;
+#else
+				throw errors::send_error("Setting the source of a datagram is only supported on Linux.");
+#endif
+			}
+
+			/**
+			 *	@brief	Method send_batch_datagrams sends several datagrams to one destination and records them.
+			 *	@param	datagrams		pointer to the datagrams to send.
+			 *	@param	count			number of datagrams to send.
+			 *	@param	flags			any flags that the datagrams should be sent with.
+			 *	@param	destination		address to send the datagrams to.
+			 *	@return	int				number of datagrams sent.
+			 *	@throws	send_error if no datagram could be sent.
+			 *	@note	The caller must hold the send mutex.
+			 */
+			int send_batch_datagrams(const outgoing_datagram* datagrams, const size_t count, const int flags, const socket_address& destination) {
+				const uint64_t start_ns = operation_start();
+				size_t sent = 0;
+				int64_t bytes = 0;
+#ifdef __linux__
+				mmsghdr messages[MAX_BATCH_SIZE];
+				iovec vectors[MAX_BATCH_SIZE];
+				bool retried = false;
+				while (sent < count) {
+					// Describe the next chunk of datagrams to the kernel.
+					const size_t chunk = std::min(count - sent, (size_t)MAX_BATCH_SIZE);
+					for (size_t i = 0; i < chunk; i++) {
+						vectors[i].iov_base = const_cast<char*>(datagrams[sent + i].buffer);
+						vectors[i].iov_len = datagrams[sent + i].size;
+						messages[i].msg_hdr = msghdr{};
+						messages[i].msg_hdr.msg_name = const_cast<sockaddr*>(destination.data());
+						messages[i].msg_hdr.msg_namelen = destination.length();
+						messages[i].msg_hdr.msg_iov = &vectors[i];
+						messages[i].msg_hdr.msg_iovlen = 1;
+					}
+					int result = ::sendmmsg(socket_file_descriptor, messages, (unsigned int)chunk, flags);
+					if (result == -1) {
+						// An ICMP error for an earlier datagram is reported once, so record it and retry once.
+						if (!retried && error_queue_enabled && is_icmp_error(get_last_network_error())) {
+							retried = true;
+							drain_error_queue();
+							check_destination(destination);
+							continue;
+						}
+						break;
+					}
+					for (int i = 0; i < result; i++) {
+						bytes += (int64_t)messages[i].msg_len;
+						traffic_statistics->send_size_bytes.observe(messages[i].msg_len);
+					}
+					sent += (size_t)result;
+				}
+#else
+				// Without a batch system call send the datagrams one at a time.
+				for (; sent < count; sent++) {
+					int result = ::sendto(socket_file_descriptor, datagrams[sent].buffer, (int)datagrams[sent].size, flags, destination.data(), destination.length());
+					if (result == -1) {
+						break;
+					}
+					bytes += result;
+					traffic_statistics->send_size_bytes.observe((uint64_t)result);
+				}
+#endif
+				// Only fail if nothing was sent, otherwise report the partial batch.
+				if (sent == 0 && count > 0) {
+					int error_code = get_last_network_error();
+					record_event(trace::event_type::SEND_FAILURE, start_ns, 0, error_code);
+					throw errors::send_error(std::to_string(error_code));
+				}
+				record_event(trace::event_type::SEND_BATCH, start_ns, bytes, 0, (uint32_t)sent);
+				return (int)sent;
+			}
+
+			/**
+			 *	@brief	Method receive_batch_datagrams receives up to count datagrams and records them.
+			 *	@param	datagrams[in,out]	buffers to receive into.
+			 *	@param	count[in]			number of buffers.
+			 *	@param	with_source[in]		true to set the source address and port of each datagram.
+			 *	@param	flags[in]			any flags that the datagrams should be received with.
+			 *	@return	int					number of datagrams received, 0 if the receive timed out.
+			 *	@throws	receive_error if an error occurred while receiving the data.
+			 *	@note	The caller must hold the receive mutex.
+			 */
+			int receive_batch_datagrams(incoming_datagram* datagrams, const size_t count, const bool with_source, const int flags) {
+				if (count == 0) {
+					return 0;
+				}
+				const uint64_t start_ns = operation_start();
+				int received = 0;
+				int64_t bytes = 0;
+#ifdef __linux__
+				const size_t chunk = std::min(count, (size_t)MAX_BATCH_SIZE);
+				mmsghdr messages[MAX_BATCH_SIZE];
+				iovec vectors[MAX_BATCH_SIZE];
+				sockaddr_storage sources[MAX_BATCH_SIZE];
+				// The control buffers are always reserved on the stack, but only handed to the kernel when control
+				// messages are enabled so it does not parse ancillary data nobody reads.
+				alignas(cmsghdr) char control[MAX_BATCH_SIZE][CONTROL_BUFFER_SIZE];
+				for (size_t i = 0; i < chunk; i++) {
+					vectors[i].iov_base = datagrams[i].buffer;
+					vectors[i].iov_len = datagrams[i].capacity;
+					messages[i].msg_hdr = msghdr{};
+					messages[i].msg_hdr.msg_name = with_source ? &sources[i] : nullptr;
+					messages[i].msg_hdr.msg_namelen = with_source ? sizeof(sources[i]) : 0;
+					messages[i].msg_hdr.msg_iov = &vectors[i];
+					messages[i].msg_hdr.msg_iovlen = 1;
+					if (control_messages_enabled) {
+						messages[i].msg_hdr.msg_control = control[i];
+						messages[i].msg_hdr.msg_controllen = CONTROL_BUFFER_SIZE;
+					}
+				}
+				while (true) {
+					// Wait for the first datagram only, then take whatever else is already queued.
+					received = ::recvmmsg(socket_file_descriptor, messages, (unsigned int)chunk, flags | MSG_WAITFORONE, nullptr);
+					if (received != -1) {
+						break;
+					}
+					int error_code = get_last_network_error();
+					if (error_code == EAGAIN || error_code == EWOULDBLOCK) {
+						record_event(trace::event_type::WAIT, start_ns, 0);
+						return 0;
+					}
+					if (error_queue_enabled && is_icmp_error(error_code)) {
+						drain_error_queue();
+						continue;
+					}
+					record_event(trace::event_type::RECEIVE_FAILURE, start_ns, 0, error_code);
+					throw errors::receive_error(std::to_string(error_code));
+				}
+				for (int i = 0; i < received; i++) {
+					datagrams[i].size = messages[i].msg_len;
+					if (with_source) {
+						const socket_address source((const sockaddr*)&sources[i], messages[i].msg_hdr.msg_namelen);
+						datagrams[i].source_address = source.address_string();
+						datagrams[i].source_port = source.port();
+					}
+					if (control_messages_enabled) {
+						process_control_messages(messages[i].msg_hdr, packet_info_enabled || receive_timestamps_enabled || ecn_enabled ? &datagrams[i] : nullptr);
+					}
+					bytes += (int64_t)messages[i].msg_len;
+					traffic_statistics->receive_size_bytes.observe(messages[i].msg_len);
+				}
+#else
+				// Without a batch system call wait for the first datagram and then poll for the rest.
+				for (size_t i = 0; i < count; i++) {
+					sockaddr_storage from;
+					address_length from_size = sizeof(from);
+#ifdef _WIN32
+					// Windows has no per call non-blocking flag so only one datagram is received per batch.
+					if (i > 0) {
+						break;
+					}
+					const int call_flags = flags;
+#else
+					const int call_flags = i > 0 ? flags | MSG_DONTWAIT : flags;
+#endif
+					int result = receive_system_call(datagrams[i].buffer, datagrams[i].capacity, call_flags, with_source ? &from : nullptr, &from_size);
+					if (result == -1) {
+						int error_code = get_last_network_error();
+#ifdef _WIN32
+						const bool timed_out = error_code == WSAETIMEDOUT;
+#else
+						const bool timed_out = error_code == EAGAIN || error_code == EWOULDBLOCK;
+#endif
+						if (i > 0 || timed_out) {
+							break;
+						}
+						record_event(trace::event_type::RECEIVE_FAILURE, start_ns, 0, error_code);
+						throw errors::receive_error(std::to_string(error_code));
+					}
+					datagrams[i].size = (size_t)result;
+					if (with_source) {
+						const socket_address source((const sockaddr*)&from, from_size);
+						datagrams[i].source_address = source.address_string();
+						datagrams[i].source_port = source.port();
+					}
+					bytes += result;
+					traffic_statistics->receive_size_bytes.observe((uint64_t)result);
+					received++;
+				}
+				if (received == 0) {
+					record_event(trace::event_type::WAIT, start_ns, 0);
+					return 0;
+				}
+#endif
+				record_event(trace::event_type::RECEIVE_BATCH, start_ns, bytes, 0, (uint32_t)received);
+				return received;
+			}
+
+			/**
+			 *	@brief	Method check_traffic_class checks the fields of a traffic class are in range.
+			 *	@tparam	error_type		error thrown when they are not.
+			 *	@param	checked_class	traffic class to check.
+			 *	@throws	error_type if the DSCP is above 63 or either field is below -1.
+			 */
+			template <typename error_type>
+			static void check_traffic_class(const traffic_class& checked_class) {
+				if (checked_class.dscp < -1 || checked_class.dscp > 63) {
+					throw error_type("DSCP must be between 0 and 63, or -1 to leave it unchanged.");
+				}
+				if (checked_class.priority < -1) {
+					throw error_type("Priority must not be negative, other than -1 to leave it unchanged.");
+				}
+			}
+
+			/**
+			 *	@brief	Method prepare_destination converts an address into the family of the socket.
+			 *	@tparam	error_type		error thrown when the address does not fit the socket (default configuration_error).
+			 *	@param	destination		address to convert.
+			 *	@return	socket_address	the address itself, or its IPv4 mapped form on a dual stack socket.
+			 *	@throws	error_type if the address cannot be reached through the socket's family.
+			 */
+			template <typename error_type = errors::configuration_error>
+			socket_address prepare_destination(const socket_address& destination) const {
+				if (socket_family == AF_INET6 && destination.family() == AF_INET) {
+					if (!dual_stack) {
+						throw error_type("IPv4 address " + destination.address_string() + " cannot be used with an IPv6 only socket.");
+					}
+					return destination.to_ipv6_mapped();
+				}
+				if (socket_family == AF_INET && destination.family() == AF_INET6) {
+					if (!destination.is_ipv4_mapped()) {
+						throw error_type("IPv6 address " + destination.address_string() + " cannot be used with an IPv4 socket.");
+					}
+					return destination.to_ipv4();
+				}
+				return destination;
+			}
+
+			/**
+			 *	@brief	Method parse_destination parses a destination given to a send method.
+			 *	@param	address			string representation of the address.
+			 *	@param	port			port in host order.
+			 *	@return	socket_address	address in the family of the socket.
+			 *	@throws	send_error if the address is invalid or cannot be reached through the socket's family.
+			 */
+			socket_address parse_destination(const std::string& address, unsigned short port) const {
+				socket_address parsed;
+				try {
+					parsed = socket_address::parse(address, port);
+				}
+				catch (const errors::configuration_error&) {
+					throw errors::send_error("Provided address was invalid.");
+				}
+				return prepare_destination<errors::send_error>(parsed);
+			}
+
+			/**
+			 *	@brief	Method attach_peer_steering attaches a reuse port program that always selects the first socket bound
+			 *			to the port, so peer sockets only receive from their own peer. Only needed on Linux, where
+			 *			datagrams that match no connected socket can otherwise be spread across the reuse port group,
+			 *			always on older kernels and on newer ones while a peer socket is bound but not yet connected.
+			 *	@throws	configuration_error if the program could not be attached.
+			 *	@note	The socket must have been the first bound to its port for the program to select it.
+			 */
+			void attach_peer_steering() {
+#if defined(__linux__) && defined(SO_ATTACH_REUSEPORT_CBPF)
+				// Lock the mutex so the socket to prevent race conditions.
+				std::unique_lock<std::mutex> access_lock(member_mutex);
+				if (peer_steering_attached) {
+					return;
+				}
+				// A single instruction returning 0 picks index 0 of the group, the socket bound first.
+				sock_filter code[] = {{BPF_RET | BPF_K, 0, 0, 0}};
+				sock_fprog program = {1, code};
+				if (::setsockopt(socket_file_descriptor, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program, sizeof(program))) {
+					throw errors::configuration_error("An error occurred while attaching the reuse port program: " + std::to_string(get_last_network_error()));
+				}
+				peer_steering_attached = true;
+#endif
+			}
+
+			/**
+			 *	@brief	Method receive_system_call performs the platform receive call for a single datagram.
+			 *	@param	buffer[out]			buffer that will store the incoming packet.
+			 *	@param	buffer_size[in]		size of the buffer.
+			 *	@param	flags[in]			any flags that the packet should be received with.
+			 *	@param	from[out]			address to store the source in, or nullptr if it is not needed.
+			 *	@param	from_size[in,out]	size of the source address structure.
+			 *	@return	int					number of bytes received, -1 on error.
+			 *	@note	When control messages are enabled recvmsg is used and the control messages are processed.
+			 */
+			int receive_system_call(char* buffer, const size_t buffer_size, const int flags, sockaddr_storage* from, address_length* from_size) {
+#ifdef __linux__
+				if (control_messages_enabled) {
+					iovec data_vector;
+					data_vector.iov_base = buffer;
+					data_vector.iov_len = buffer_size;
+
+					alignas(cmsghdr) char control[CONTROL_BUFFER_SIZE];
+					msghdr message{};
+					message.msg_name = from;
+					message.msg_namelen = from != nullptr ? *from_size : 0;
+					message.msg_iov = &data_vector;
+					message.msg_iovlen = 1;
+					message.msg_control = control;
+					message.msg_controllen = sizeof(control);
+
+					int receive_size = (int)::recvmsg(socket_file_descriptor, &message, flags);
+					if (receive_size >= 0) {
+						if (from != nullptr) {
+							*from_size = message.msg_namelen;
+						}
+						process_control_messages(message);
+					}
+					return receive_size;
+				}
+#endif
+				if (from == nullptr) {
+					return ::recv(socket_file_descriptor, buffer, (int)buffer_size, flags);
+				}
+				return ::recvfrom(socket_file_descriptor, buffer, (int)buffer_size, flags, (sockaddr*)from, from_size);
+			}
+
+#ifdef __linux__
+			/**
+			 *	@brief	Method process_control_messages records the ancillary data delivered with a datagram.
+			 *	@param	message		message header returned by recvmsg.
+			 *	@param	datagram	datagram to store the packet info, timestamp and ECN codepoint in, or nullptr if they are not needed (default nullptr).
+			 */
+			void process_control_messages(msghdr& message, incoming_datagram* datagram = nullptr) {
+				if (datagram != nullptr) {
+					datagram->destination_address.clear();
+					datagram->interface_index = 0;
+					datagram->receive_timestamp_ns = 0;
+					datagram->ecn = NOT_ECT;
+				}
+				for (cmsghdr* control = CMSG_FIRSTHDR(&message); control != nullptr; control = CMSG_NXTHDR(&message, control)) {
+					if (control->cmsg_level == SOL_SOCKET && control->cmsg_type == SO_RXQ_OVFL) {
+						// The kernel reports the total number of drops for the socket, not the drops since the last datagram.
+						uint32_t drops;
+						::memcpy(&drops, CMSG_DATA(control), sizeof(drops));
+						traffic_statistics->kernel_receive_queue_overflows.store(drops, std::memory_order_relaxed);
+					}
+					else if ((control->cmsg_level == IPPROTO_IP && control->cmsg_type == IP_TOS) ||
+						(control->cmsg_level == IPPROTO_IPV6 && control->cmsg_type == IPV6_TCLASS)) {
+						// IP_TOS carries a single byte and IPV6_TCLASS an int.
+						int traffic_class = 0;
+						if (control->cmsg_level == IPPROTO_IP) {
+							traffic_class = *(const unsigned char*)CMSG_DATA(control);
+						}
+						else {
+							::memcpy(&traffic_class, CMSG_DATA(control), sizeof(traffic_class));
+						}
+						record_ecn((uint8_t)(traffic_class & 0x03), datagram);
+					}
+					else if (datagram != nullptr && control->cmsg_level == SOL_SOCKET && control->cmsg_type == SCM_TIMESTAMPNS) {
+						timespec timestamp;
+						::memcpy(&timestamp, CMSG_DATA(control), sizeof(timestamp));
+						datagram->receive_timestamp_ns = (uint64_t)timestamp.tv_sec * 1000000000ULL + (uint64_t)timestamp.tv_nsec;
+					}
+					else if (datagram != nullptr && control->cmsg_level == IPPROTO_IP && control->cmsg_type == IP_PKTINFO) {
+						// ipi_addr is the destination in the IP header, which is the address the peer sent to.
+						in_pktinfo info;
+						::memcpy(&info, CMSG_DATA(control), sizeof(info));
+						sockaddr_in destination{};
+						destination.sin_family = AF_INET;
+						destination.sin_addr = info.ipi_addr;
+						datagram->destination_address = socket_address((const sockaddr*)&destination, sizeof(destination)).address_string();
+						datagram->interface_index = (uint32_t)info.ipi_ifindex;
+					}
+					else if (datagram != nullptr && control->cmsg_level == IPPROTO_IPV6 && control->cmsg_type == IPV6_PKTINFO) {
+						in6_pktinfo info;
+						::memcpy(&info, CMSG_DATA(control), sizeof(info));
+						sockaddr_in6 destination{};
+						destination.sin6_family = AF_INET6;
+						destination.sin6_addr = info.ipi6_addr;
+						datagram->destination_address = socket_address((const sockaddr*)&destination, sizeof(destination)).address_string();
+						datagram->interface_index = (uint32_t)info.ipi6_ifindex;
+					}
+				}
+			}
+
+			/**
+			 *	@brief	Method append_control_message adds an integer control message after those already in a message.
+			 *	@param	message	message whose control buffer of CONTROL_BUFFER_SIZE bytes has room for the message.
+			 *	@param	level	level of the control message.
+			 *	@param	type	type of the control message.
+			 *	@param	value	value of the control message.
+			 */
+			static void append_control_message(msghdr& message, int level, int type, int value) {
+				cmsghdr* header = (cmsghdr*)((char*)message.msg_control + message.msg_controllen);
+				header->cmsg_level = level;
+				header->cmsg_type = type;
+				header->cmsg_len = CMSG_LEN(sizeof(value));
+				::memcpy(CMSG_DATA(header), &value, sizeof(value));
+				message.msg_controllen += CMSG_SPACE(sizeof(value));
+			}
+
+			/**
+			 *	@brief	Method record_ecn counts the ECN codepoint of a received datagram.
+			 *	@param	codepoint	codepoint from the traffic class of the datagram.
+			 *	@param	datagram	datagram to store the codepoint in, or nullptr if it is not needed.
+			 */
+			void record_ecn(uint8_t codepoint, incoming_datagram* datagram) {
+				if (datagram != nullptr) {
+					datagram->ecn = codepoint;
+				}
+				if (codepoint != NOT_ECT) {
+					traffic_statistics->ecn_capable_received.fetch_add(1, std::memory_order_relaxed);
+					if (codepoint == CE) {
+						traffic_statistics->ecn_congestion_experienced.fetch_add(1, std::memory_order_relaxed);
+					}
+				}
+			}
+
+			/**
+			 *	@brief	Method set_traffic_class_bits replaces some bits of the IPv4 TOS or IPv6 traffic class of sent datagrams.
+			 *	@param	level	IPPROTO_IP or IPPROTO_IPV6.
+			 *	@param	option	IP_TOS or IPV6_TCLASS.
+			 *	@param	name	name of the option for the error message.
+			 *	@param	mask	bits to replace.
+			 *	@param	bits	new value of the bits, already shifted into place.
+			 *	@throws	configuration_error if the option could not be read or set.
+			 */
+			void set_traffic_class_bits(int level, int option, const char* name, int mask, int bits) {
+				int traffic_class = 0;
+				socklen_t length = sizeof(traffic_class);
+				if (::getsockopt(socket_file_descriptor, level, option, &traffic_class, &length)) {
+					throw errors::configuration_error(std::string("An error occurred while reading ") + name + ": " + std::to_string(get_last_network_error()));
+				}
+				traffic_class = (traffic_class & ~mask & 0xff) | (bits & mask);
+				if (::setsockopt(socket_file_descriptor, level, option, &traffic_class, sizeof(traffic_class))) {
+					throw errors::configuration_error(std::string("An error occurred while setting ") + name + ": " + std::to_string(get_last_network_error()));
+				}
+			}
+
+			/**
+			 *	@brief	Method is_icmp_error returns whether a receive error was caused by a queued ICMP error.
+			 *	@param	error_code	error returned by the receive call.
+			 *	@return	bool		true if the error comes from an ICMP message rather than the socket itself.
+			 */
+			static bool is_icmp_error(int error_code) {
+				return error_code == ECONNREFUSED || error_code == EHOSTUNREACH || error_code == ENETUNREACH ||
+					error_code == EHOSTDOWN || error_code == EMSGSIZE || error_code == EPROTO;
+			}
+
+			/**
+			 *	@brief	Method drain_error_queue reads every queued error from the socket error queue.
+			 *	@param	errors_read[out]	vector to append the parsed errors to, or nullptr to only record them.
+			 *	@return	size_t				number of errors read.
+			 */
+			size_t drain_error_queue(std::vector<icmp_error>* errors_read = nullptr) {
+				size_t error_count = 0;
+				char data[64];
+				alignas(cmsghdr) char control[CONTROL_BUFFER_SIZE];
+				while (true) {
+					sockaddr_storage destination{};
+					iovec data_vector{data, sizeof(data)};
+					msghdr message{};
+					message.msg_name = &destination;
+					message.msg_namelen = sizeof(destination);
+					message.msg_iov = &data_vector;
+					message.msg_iovlen = 1;
+					message.msg_control = control;
+					message.msg_controllen = sizeof(control);
+					if (::recvmsg(socket_file_descriptor, &message, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+						break;
+					}
+					error_count++;
+
+					// IPv6 sockets report errors for both families with IPV6_RECVERR.
+					const socket_address original_destination((const sockaddr*)&destination, message.msg_namelen);
+					for (cmsghdr* header = CMSG_FIRSTHDR(&message); header != nullptr; header = CMSG_NXTHDR(&message, header)) {
+						if ((header->cmsg_level == IPPROTO_IP && header->cmsg_type == IP_RECVERR) ||
+							(header->cmsg_level == IPPROTO_IPV6 && header->cmsg_type == IPV6_RECVERR)) {
+							const sock_extended_err* extended = (const sock_extended_err*)CMSG_DATA(header);
+							icmp_error parsed = parse_extended_error(*extended, original_destination);
+							record_icmp_error(parsed, original_destination);
+							if (errors_read != nullptr) {
+								errors_read->push_back(std::move(parsed));
+							}
+						}
+					}
+				}
+				traffic_statistics->icmp_errors.fetch_add(error_count, std::memory_order_relaxed);
+				return error_count;
+			}
+
+			/**
+			 *	@brief	Method parse_extended_error converts the kernel's description of a queued error.
+			 *	@param	extended		extended error from the IP_RECVERR or IPV6_RECVERR control message.
+			 *	@param	destination		original destination of the failed datagram.
+			 *	@return	icmp_error		parsed error.
+			 */
+			static icmp_error parse_extended_error(const sock_extended_err& extended, const socket_address& destination) {
+				icmp_error parsed{};
+				parsed.error_code = (int)extended.ee_errno;
+				parsed.timestamp_ns = trace::now_ns();
+				parsed.destination_address = destination.address_string();
+				parsed.destination_port = destination.port();
+
+				if (extended.ee_origin == SO_EE_ORIGIN_ICMP || extended.ee_origin == SO_EE_ORIGIN_ICMP6) {
+					parsed.icmp_type = extended.ee_type;
+					parsed.icmp_code = extended.ee_code;
+					const sockaddr* reporter = SO_EE_OFFENDER(&extended);
+					if (reporter->sa_family == AF_INET || reporter->sa_family == AF_INET6) {
+						parsed.reporter_address = socket_address(reporter, reporter->sa_family == AF_INET ? sizeof(sockaddr_in) : sizeof(sockaddr_in6)).address_string();
+					}
+				}
+
+				if (extended.ee_origin == SO_EE_ORIGIN_ICMP6) {
+					// Classify using the ICMPv6 destination unreachable (1), packet too big (2) and time exceeded (3) codes.
+					if (extended.ee_type == 1) {
+						switch (extended.ee_code) {
+							case 0: 	parsed.type = icmp_error_type::NETWORK_UNREACHABLE; break;
+							case 1:
+							case 5:
+							case 6: 	parsed.type = icmp_error_type::ADMINISTRATIVELY_PROHIBITED; break;
+							case 3: 	parsed.type = icmp_error_type::HOST_UNREACHABLE; break;
+							case 4: 	parsed.type = icmp_error_type::PORT_UNREACHABLE; break;
+							default: 	parsed.type = icmp_error_type::OTHER; break;
+						}
+					}
+					else if (extended.ee_type == 2) {
+						parsed.type = icmp_error_type::FRAGMENTATION_NEEDED;
+						parsed.mtu = extended.ee_info;
+					}
+					else if (extended.ee_type == 3) {
+						parsed.type = icmp_error_type::TIME_EXCEEDED;
+					}
+					else {
+						parsed.type = icmp_error_type::OTHER;
+					}
+				}
+				else if (extended.ee_origin == SO_EE_ORIGIN_ICMP) {
+					// Classify using the ICMP destination unreachable (3) and time exceeded (11) codes.
+					if (extended.ee_type == 3) {
+						switch (extended.ee_code) {
+							case 0: 	parsed.type = icmp_error_type::NETWORK_UNREACHABLE; break;
+							case 1: 	parsed.type = icmp_error_type::HOST_UNREACHABLE; break;
+							case 2: 	parsed.type = icmp_error_type::PROTOCOL_UNREACHABLE; break;
+							case 3: 	parsed.type = icmp_error_type::PORT_UNREACHABLE; break;
+							case 4:
+								parsed.type = icmp_error_type::FRAGMENTATION_NEEDED;
+								parsed.mtu = extended.ee_info;
+								break;
+							case 9:
+							case 10:
+							case 13: 	parsed.type = icmp_error_type::ADMINISTRATIVELY_PROHIBITED; break;
+							default: 	parsed.type = icmp_error_type::OTHER; break;
+						}
+					}
+					else if (extended.ee_type == 11) {
+						parsed.type = icmp_error_type::TIME_EXCEEDED;
+					}
+					else {
+						parsed.type = icmp_error_type::OTHER;
+					}
+				}
+				else {
+					// Errors raised locally, such as a datagram larger than the known path MTU.
+					parsed.type = icmp_error_type::LOCAL_ERROR;
+					if (extended.ee_errno == EMSGSIZE) {
+						parsed.mtu = extended.ee_info;
+					}
+				}
+				return parsed;
+			}
+#endif
+
+			/**
+			 *	@brief	Method enable_error_queue_locked sets IP_RECVERR on the socket.
+			 *	@throws	configuration_error if the option could not be set.
+			 *	@note	The caller must hold the member and receive mutexes.
+			 */
+			void enable_error_queue_locked() {
+#ifdef __linux__
+				int on = 1;
+				// IPv4 traffic, including IPv4 peers of a dual stack socket, needs IP_RECVERR.
+				if ((socket_family == AF_INET || dual_stack) && ::setsockopt(socket_file_descriptor, IPPROTO_IP, IP_RECVERR, &on, sizeof(on))) {
+					throw errors::configuration_error("An error occurred while enabling IP_RECVERR: " + std::to_string(get_last_network_error()));
+				}
+				if (socket_family == AF_INET6 && ::setsockopt(socket_file_descriptor, IPPROTO_IPV6, IPV6_RECVERR, &on, sizeof(on))) {
+					throw errors::configuration_error("An error occurred while enabling IPV6_RECVERR: " + std::to_string(get_last_network_error()));
+				}
+				error_queue_enabled = true;
+#endif
+			}
+
+			/**
+			 *	@brief	Method record_icmp_error updates the health of the destination of an error and calls the handler.
+			 *	@param	error		error read from the error queue.
+			 *	@param	destination	original destination of the failed datagram.
+			 */
+			void record_icmp_error(const icmp_error& error, const socket_address& destination) {
+				std::function<void(const icmp_error&)> handler;
+				{
+					std::unique_lock<std::mutex> error_lock(error_mutex);
+					destination_health& health = destination_errors[destination.to_ipv4()];
+					health.error_count++;
+					health.last_error = error;
+					health.unreachable = is_unreachable(error.type);
+					fail_fast_active = fail_fast_enabled;
+					handler = icmp_error_handler;
+				}
+				// Call the handler without the lock so it may use the socket.
+				if (handler) {
+					handler(error);
+				}
+			}
+
+			/**
+			 *	@brief	Method check_destination throws if fail fast is enabled and a destination is unreachable.
+			 *	@param	destination	address the datagram is about to be sent to.
+			 *	@throws	send_error if the destination has been reported unreachable.
+			 */
+			void check_destination(const socket_address& destination) {
+				if (!fail_fast_active.load(std::memory_order_relaxed)) {
+					return;
+				}
+				std::unique_lock<std::mutex> error_lock(error_mutex);
+				auto found = destination_errors.find(destination.to_ipv4());
+				if (found != destination_errors.end() && found->second.unreachable) {
+					traffic_statistics->send_errors.fetch_add(1, std::memory_order_relaxed);
+					throw errors::send_error("Destination " + found->second.last_error.destination_address + ":" +
+						std::to_string(found->second.last_error.destination_port) + " was reported unreachable.");
+				}
+			}
+
+			/**
+			 *	@brief	Method operation_start returns the start time of an operation if it will be timed.
+			 *	@return	uint64_t	time from trace::now_ns if a tracer is attached or timing is enabled, 0 otherwise.
+			 */
+			uint64_t operation_start() {
+				return (event_tracer || timing_enabled) ? trace::now_ns() : 0;
+			}
+
+			/**
+			 *	@brief	Method record_event updates the socket statistics with an operation and records it with the
+			 *			tracer if one is attached.
+			 *	@param	type		type of the operation.
+			 *	@param	start_ns	time the operation started, from operation_start.
+			 *	@param	bytes		number of bytes transferred.
+			 *	@param	error		network error code for failed operations (default 0).
+			 *	@param	count		number of datagrams in the operation (default 1).
+			 *	@note	The caller must hold the send or receive mutex so the tracer cannot be replaced concurrently.
+			 */
+			void record_event(trace::event_type type, uint64_t start_ns, int64_t bytes, int32_t error = 0, uint32_t count = 1) {
+				const uint64_t end_ns = start_ns != 0 ? trace::now_ns() : 0;
+				switch (type) {
+					case trace::event_type::SEND:
+						traffic_statistics->send_size_bytes.observe((uint64_t)bytes);
+						// fall through
+					case trace::event_type::SEND_BATCH:
+						// Batches observe the size of each datagram themselves.
+						traffic_statistics->packets_sent.fetch_add(count, std::memory_order_relaxed);
+						traffic_statistics->bytes_sent.fetch_add((uint64_t)bytes, std::memory_order_relaxed);
+						if (timing_enabled) {
+							traffic_statistics->send_duration_ns.observe(end_ns - start_ns);
+						}
+						break;
+					case trace::event_type::RECEIVE:
+						traffic_statistics->receive_size_bytes.observe((uint64_t)bytes);
+						// fall through
+					case trace::event_type::RECEIVE_BATCH:
+						// Batches observe the size of each datagram themselves.
+						traffic_statistics->packets_received.fetch_add(count, std::memory_order_relaxed);
+						traffic_statistics->bytes_received.fetch_add((uint64_t)bytes, std::memory_order_relaxed);
+						if (timing_enabled) {
+							traffic_statistics->receive_duration_ns.observe(end_ns - start_ns);
+						}
+						break;
+					case trace::event_type::WAIT:
+						traffic_statistics->receive_timeouts.fetch_add(1, std::memory_order_relaxed);
+						break;
+					case trace::event_type::SEND_FAILURE:
+						traffic_statistics->send_errors.fetch_add(1, std::memory_order_relaxed);
+						break;
+					case trace::event_type::RECEIVE_FAILURE:
+						traffic_statistics->receive_errors.fetch_add(1, std::memory_order_relaxed);
+						break;
+				}
+				if (event_tracer) {
+					event_tracer->record(trace::event{type, start_ns, end_ns - start_ns, bytes, count, error, socket_file_descriptor});
+				}
+			}
+
 			/**
 			 *	@brief	Method get_last_network_error retrieves the last networking error.
 			*	@return	int value from WSA or errno.
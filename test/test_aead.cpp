@@ -0,0 +1,261 @@
+#include <string>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark_all.hpp>
+#include <catch2/matchers/catch_matchers_all.hpp>
+
+#include "aead.hpp"
+
+namespace {
+	/**
+	 * @brief 	Function from_hex decodes a string of hexadecimal digits.
+	 * @param 	hex 	digits, two per byte.
+	 * @return 	std::vector<uint8_t> 	the bytes.
+	 */
+	std::vector<uint8_t> from_hex(const std::string& hex) {
+		std::vector<uint8_t> bytes;
+		for (size_t i = 0; i + 1 < hex.size(); i += 2) {
+			bytes.push_back((uint8_t)std::stoul(hex.substr(i, 2), nullptr, 16));
+		}
+		return bytes;
+	}
+
+	/**
+	 * @brief 	Function check_vector seals a test vector and checks the ciphertext and tag, then opens it again, with
+	 * 			both the hardware kernels when the processor has them and the table driven implementation.
+	 * @param 	key 		key in hexadecimal.
+	 * @param 	nonce 		nonce in hexadecimal.
+	 * @param 	plaintext 	plaintext in hexadecimal.
+	 * @param 	aad 		associated data in hexadecimal.
+	 * @param 	ciphertext 	expected ciphertext in hexadecimal.
+	 * @param 	tag 		expected tag in hexadecimal.
+	 */
+	void check_vector(const std::string& key, const std::string& nonce, const std::string& plaintext, const std::string& aad, const std::string& ciphertext, const std::string& tag) {
+		for (bool allow_hardware : {true, false}) {
+			const oo_socket::aead::aes_gcm cipher(from_hex(key), allow_hardware);
+			const std::vector<uint8_t> nonce_bytes = from_hex(nonce);
+			const std::vector<uint8_t> plaintext_bytes = from_hex(plaintext);
+			const std::vector<uint8_t> aad_bytes = from_hex(aad);
+			std::vector<char> sealed(plaintext_bytes.size());
+			char sealed_tag[AEAD_TAG_SIZE];
+			cipher.seal(nonce_bytes.data(), (const char*)aad_bytes.data(), aad_bytes.size(), (const char*)plaintext_bytes.data(), plaintext_bytes.size(), sealed.data(), sealed_tag);
+			REQUIRE(std::vector<uint8_t>(sealed.begin(), sealed.end()) == from_hex(ciphertext));
+			REQUIRE(std::vector<uint8_t>(sealed_tag, sealed_tag + AEAD_TAG_SIZE) == from_hex(tag));
+
+			std::vector<char> opened(plaintext_bytes.size());
+			REQUIRE(cipher.open(nonce_bytes.data(), (const char*)aad_bytes.data(), aad_bytes.size(), sealed.data(), sealed.size(), sealed_tag, opened.data()));
+			REQUIRE(std::vector<uint8_t>(opened.begin(), opened.end()) == plaintext_bytes);
+			sealed_tag[AEAD_TAG_SIZE - 1] ^= 1;
+			REQUIRE_FALSE(cipher.open(nonce_bytes.data(), (const char*)aad_bytes.data(), aad_bytes.size(), sealed.data(), sealed.size(), sealed_tag, opened.data()));
+		}
+	}
+
+	/**
+	 * @brief 	Function make_key returns a session key with every byte of the key set to a value.
+	 * @param 	value 	value of the key bytes and the salt.
+	 * @return 	oo_socket::aead::session_key 	the key.
+	 */
+	oo_socket::aead::session_key make_key(uint8_t value) {
+		return oo_socket::aead::session_key{std::vector<uint8_t>(16, value), {value, value, value, value}};
+	}
+}
+
+TEST_CASE("Check AES-GCM matches the test vectors.", "[aead][test]") {
+	// Test cases 2, 3, 4, 14 and 16 from the GCM specification.
+	check_vector("00000000000000000000000000000000", "000000000000000000000000", "00000000000000000000000000000000", "",
+		"0388dace60b6a392f328c2b971b2fe78", "ab6e47d42cec13bdf53a67b21257bddf");
+	check_vector("feffe9928665731c6d6a8f9467308308", "cafebabefacedbaddecaf888",
+		"d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a721c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b391aafd255", "",
+		"42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091473f5985",
+		"4d5c2af327cd64a62cf35abd2ba6fab4");
+	check_vector("feffe9928665731c6d6a8f9467308308", "cafebabefacedbaddecaf888",
+		"d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a721c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39",
+		"feedfacedeadbeeffeedfacedeadbeefabaddad2",
+		"42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091",
+		"5bc94fbc3221a5db94fae95ae7121a47");
+	check_vector("0000000000000000000000000000000000000000000000000000000000000000", "000000000000000000000000",
+		"00000000000000000000000000000000", "", "cea7403d4d606b6e074ec5d3baf39d18", "d0d1c8a799996bf0265b98b5d48ab919");
+	check_vector("feffe9928665731c6d6a8f9467308308feffe9928665731c6d6a8f9467308308", "cafebabefacedbaddecaf888",
+		"d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a721c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39",
+		"feedfacedeadbeeffeedfacedeadbeefabaddad2",
+		"522dc1f099567d07f47f37a32a84427d643a8cdcbfe5c0c97598a2bd2555d1aa8cb08e48590dbb3da7b08b1056828838c5f61e6393ba7a0abcc9f662",
+		"76fc6ece0f4e1768cddf8853bb2d551b");
+
+	SECTION("Long buffers use the eight block path and can be opened in place.") {
+		std::vector<uint8_t> key(32);
+		uint8_t nonce[AEAD_NONCE_SIZE];
+		for (size_t i = 0; i < key.size(); i++) {
+			key[i] = (uint8_t)i;
+		}
+		for (size_t i = 0; i < AEAD_NONCE_SIZE; i++) {
+			nonce[i] = (uint8_t)i;
+		}
+		std::vector<char> plaintext(1000);
+		for (size_t i = 0; i < plaintext.size(); i++) {
+			plaintext[i] = (char)(i * 7 + 3);
+		}
+		const std::vector<uint8_t> expected_tags[2] = {from_hex("e0f7abcf309a922c8fa3ec93a132e030"), from_hex("aab55cd9f1654f18b89839441c423a65")};
+		for (size_t key_size : {16, 32}) {
+			for (bool allow_hardware : {true, false}) {
+				const oo_socket::aead::aes_gcm cipher(key.data(), key_size, allow_hardware);
+				// Sealed as a channel lays it out, with 8 bytes in front of the ciphertext and the tag after it.
+				std::vector<char> buffer(8 + plaintext.size() + AEAD_TAG_SIZE);
+				cipher.seal(nonce, "oo_socket", 9, plaintext.data(), plaintext.size(), buffer.data() + 8, buffer.data() + 8 + plaintext.size());
+				REQUIRE(std::vector<uint8_t>(buffer.end() - AEAD_TAG_SIZE, buffer.end()) == expected_tags[key_size / 32]);
+				REQUIRE(cipher.open(nonce, "oo_socket", 9, buffer.data() + 8, plaintext.size(), buffer.data() + 8 + plaintext.size(), buffer.data()));
+				REQUIRE(std::vector<char>(buffer.begin(), buffer.begin() + plaintext.size()) == plaintext);
+			}
+		}
+	}
+
+	SECTION("The hardware kernels and the table driven implementation agree on every length.") {
+		const std::vector<uint8_t> key(16, 5);
+		const oo_socket::aead::aes_gcm hardware(key);
+		const oo_socket::aead::aes_gcm tables(key, false);
+		REQUIRE_FALSE(tables.uses_hardware());
+		uint8_t nonce[AEAD_NONCE_SIZE] = {};
+		std::vector<char> plaintext(300);
+		for (size_t i = 0; i < plaintext.size(); i++) {
+			plaintext[i] = (char)(i * 13 + 1);
+		}
+		for (size_t size = 0; size <= plaintext.size(); size++) {
+			nonce[0] = (uint8_t)size;
+			std::vector<char> first(size);
+			std::vector<char> second(size);
+			char first_tag[AEAD_TAG_SIZE];
+			char second_tag[AEAD_TAG_SIZE];
+			hardware.seal(nonce, plaintext.data(), size % 40, plaintext.data(), size, first.data(), first_tag);
+			tables.seal(nonce, plaintext.data(), size % 40, plaintext.data(), size, second.data(), second_tag);
+			REQUIRE(first == second);
+			REQUIRE(std::vector<char>(first_tag, first_tag + AEAD_TAG_SIZE) == std::vector<char>(second_tag, second_tag + AEAD_TAG_SIZE));
+		}
+	}
+
+	SECTION("Keys must be 16 or 32 bytes.") {
+		REQUIRE_THROWS_AS(oo_socket::aead::aes_gcm(std::vector<uint8_t>(24)), oo_socket::errors::configuration_error);
+	}
+}
+
+TEST_CASE("Check the replay window.", "[aead][test]") {
+	oo_socket::aead::replay_window window(128);
+	REQUIRE_FALSE(window.check(0));
+	REQUIRE(window.check(5));
+	window.accept(5);
+	REQUIRE_FALSE(window.check(5));
+	REQUIRE(window.check(3));
+	window.accept(3);
+	REQUIRE_FALSE(window.check(3));
+	REQUIRE(window.get_newest() == 5);
+
+	// Moving far ahead forgets everything older than the window.
+	window.accept(200);
+	REQUIRE(window.check(73));
+	REQUIRE_FALSE(window.check(72));
+	REQUIRE_FALSE(window.check(5));
+	REQUIRE(window.check(199));
+	window.accept(199);
+	REQUIRE_FALSE(window.check(199));
+	window.accept(10000);
+	REQUIRE(window.check(9999));
+	REQUIRE_FALSE(window.check(200));
+	REQUIRE(window.get_newest() == 10000);
+}
+
+TEST_CASE("Check datagrams are sealed and opened over a channel.", "[aead][test]") {
+	oo_socket::udp::socket sender_socket(10110, "127.0.0.1");
+	oo_socket::udp::socket receiver_socket(10111, "127.0.0.1");
+	receiver_socket.set_socket_receive_timeout(200);
+	const oo_socket::socket_address receiver_address = oo_socket::socket_address::parse("127.0.0.1", 10111);
+	oo_socket::aead::channel sender(sender_socket, make_key(1), make_key(2));
+	oo_socket::aead::channel receiver(receiver_socket, make_key(2), make_key(1));
+
+	std::vector<std::string> payloads;
+	std::vector<oo_socket::outgoing_datagram> outgoing;
+	for (size_t i = 0; i < 10; i++) {
+		payloads.push_back("payload " + std::to_string(i) + std::string(i * 30, 'x'));
+	}
+	for (const std::string& payload : payloads) {
+		outgoing.push_back({payload.data(), payload.size()});
+	}
+	REQUIRE(sender.send_batch_to(outgoing, receiver_address) == 10);
+
+	std::vector<std::vector<char>> buffers(16, std::vector<char>(512));
+	std::vector<oo_socket::incoming_datagram> incoming;
+	for (std::vector<char>& buffer : buffers) {
+		oo_socket::incoming_datagram datagram{};
+		datagram.buffer = buffer.data();
+		datagram.capacity = buffer.size();
+		incoming.push_back(datagram);
+	}
+	REQUIRE(receiver.receive_batch(incoming) == 10);
+	for (size_t i = 0; i < 10; i++) {
+		REQUIRE(std::string(incoming[i].buffer, incoming[i].size) == payloads[i]);
+	}
+
+	SECTION("Replayed and forged datagrams are dropped and counted.") {
+		char frame[64];
+		const size_t size = sender.seal("hello", 5, frame);
+		REQUIRE(size == 5 + AEAD_OVERHEAD);
+		REQUIRE(sender_socket.send_to(frame, size, receiver_address) == (int)size);
+		REQUIRE(sender_socket.send_to(frame, size, receiver_address) == (int)size);
+		// A forged frame needs an unseen sequence number to get past the replay window, which is checked first, and
+		// then fails authentication since the sequence number is associated data.
+		frame[AEAD_SEQUENCE_SIZE - 1] ^= 0x10;
+		frame[AEAD_SEQUENCE_SIZE] ^= 1;
+		REQUIRE(sender_socket.send_to(frame, size, receiver_address) == (int)size);
+		REQUIRE(sender_socket.send_to(frame, 3, receiver_address) == 3);
+		REQUIRE(sender.send_to("world", 5, receiver_address) == 5 + AEAD_OVERHEAD);
+
+		int received = 0;
+		std::vector<std::string> opened;
+		while ((received = receiver.receive_batch(incoming)) > 0) {
+			for (int i = 0; i < received; i++) {
+				opened.emplace_back(incoming[i].buffer, incoming[i].size);
+			}
+		}
+		REQUIRE(opened == std::vector<std::string>{"hello", "world"});
+		REQUIRE(receiver.get_replays() == 1);
+		REQUIRE(receiver.get_authentication_failures() == 2);
+
+		// A batch of nothing but forgeries returns 0 rather than waiting for an authentic datagram.
+		REQUIRE(sender_socket.send_to(frame, size, receiver_address) == (int)size);
+		REQUIRE(sender.send_to("again", 5, receiver_address) == 5 + AEAD_OVERHEAD);
+		REQUIRE(receiver.receive_batch(incoming.data(), 1) == 0);
+		REQUIRE(receiver.get_replays() + receiver.get_authentication_failures() == 4);
+		REQUIRE(receiver.receive_batch(incoming.data(), 1) == 1);
+		REQUIRE(std::string(incoming[0].buffer, incoming[0].size) == "again");
+	}
+
+	SECTION("A channel cannot open its own datagrams.") {
+		char frame[64];
+		size_t size = sender.seal("hello", 5, frame);
+		REQUIRE_FALSE(sender.open(frame, size));
+		REQUIRE(sender.get_authentication_failures() == 1);
+	}
+}
+
+TEST_CASE("Benchmarking AES-GCM.", "[aead][benchmark]") {
+	const oo_socket::aead::aes_gcm cipher(std::vector<uint8_t>(16, 7));
+	const uint8_t nonce[AEAD_NONCE_SIZE] = {};
+	std::vector<char> plaintext(1400, 'x');
+	std::vector<char> ciphertext(1400);
+	char tag[AEAD_TAG_SIZE];
+	BENCHMARK("Sealing 1400 bytes.") {
+		cipher.seal(nonce, "sequence", 8, plaintext.data(), plaintext.size(), ciphertext.data(), tag);
+		return tag[0];
+	};
+	cipher.seal(nonce, "sequence", 8, plaintext.data(), plaintext.size(), ciphertext.data(), tag);
+	BENCHMARK("Opening 1400 bytes.") {
+		return cipher.open(nonce, "sequence", 8, ciphertext.data(), ciphertext.size(), tag, plaintext.data());
+	};
+
+	oo_socket::aead::replay_window window;
+	uint64_t sequence = 0;
+	BENCHMARK("Checking and accepting a sequence number.") {
+		sequence++;
+		const bool fresh = window.check(sequence);
+		window.accept(sequence);
+		return fresh;
+	};
+}
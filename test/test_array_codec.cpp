@@ -0,0 +1,192 @@
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark_all.hpp>
+#include <catch2/matchers/catch_matchers_all.hpp>
+
+#include "array_codec.hpp"
+
+namespace {
+	/**
+	 * @brief 	Function sensor_readings simulates a slowly drifting sensor sampled with a little noise.
+	 * @param 	count 		number of readings.
+	 * @return 	std::vector<float> 	readings rounded to hundredths, like a sensor with a fixed resolution.
+	 */
+	std::vector<float> sensor_readings(size_t count) {
+		std::mt19937 generator(9);
+		std::normal_distribution<float> noise(0.0f, 0.05f);
+		std::vector<float> readings(count);
+		for (size_t i = 0; i < count; i++) {
+			readings[i] = std::round((21.5f + 0.5f * std::sin((float)i / 50.0f) + noise(generator)) * 100.0f) / 100.0f;
+		}
+		return readings;
+	}
+}
+
+TEST_CASE("Check integer arrays round trip through frame of reference packing.", "[array_codec][test]") {
+	std::mt19937 generator(1);
+	oo_socket::array_codec::array_encoding encoding;
+	std::vector<char> encoded;
+	// Cover every bit width, whole blocks and the bit stream tail.
+	for (unsigned width = 0; width <= 32; width++) {
+		for (size_t count : {(size_t)0, (size_t)1, (size_t)7, (size_t)255, (size_t)256, (size_t)257, (size_t)700}) {
+			const uint32_t range = width == 32 ? 0xffffffff : (1u << width) - 1;
+			std::vector<int32_t> values(count);
+			for (int32_t& value : values) {
+				value = (int32_t)((uint32_t)-5000 + (range == 0 ? 0 : generator() % range));
+			}
+			oo_socket::array_codec::encode(values, encoding, encoded);
+			REQUIRE(oo_socket::array_codec::decode<int32_t>(encoded.data(), encoded.size()) == values);
+
+			std::vector<uint32_t> unsigned_values(count);
+			for (uint32_t& value : unsigned_values) {
+				value = 7 + (range == 0 ? 0 : generator() % range);
+			}
+			oo_socket::array_codec::encode(unsigned_values, encoding, encoded);
+			std::vector<uint32_t> decoded;
+			REQUIRE(oo_socket::array_codec::decode(encoded.data(), encoded.size(), decoded) == encoded.size());
+			REQUIRE(decoded == unsigned_values);
+			if (width <= 24 && count >= 256) {
+				REQUIRE(encoded[1] == oo_socket::array_codec::FRAME_OF_REFERENCE);
+				REQUIRE(encoded.size() <= 16 + count * width / 8 + 1);
+			}
+		}
+	}
+
+	SECTION("Signed values spanning zero use the smallest width.") {
+		std::vector<int32_t> values = {-3, 4, 0, -1, 2, 3, -2, 1};
+		values.resize(512, 0);
+		oo_socket::array_codec::encode(values, encoding, encoded);
+		REQUIRE(encoded.size() < 3 + 2 + 5 + 512 * 3 / 8 + 1);
+		REQUIRE(oo_socket::array_codec::decode<int32_t>(encoded.data(), encoded.size()) == values);
+
+		const std::vector<int32_t> extremes = {std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::max(), 0};
+		oo_socket::array_codec::encode(extremes, encoding, encoded);
+		REQUIRE(oo_socket::array_codec::decode<int32_t>(encoded.data(), encoded.size()) == extremes);
+	}
+}
+
+TEST_CASE("Check floating point arrays round trip through XOR compression.", "[array_codec][test]") {
+	oo_socket::array_codec::array_encoding encoding;
+	std::vector<char> encoded;
+	std::vector<float> readings = sensor_readings(1000);
+	oo_socket::array_codec::encode(readings, encoding, encoded);
+	REQUIRE(encoded[1] == oo_socket::array_codec::XOR);
+	REQUIRE(encoded.size() < readings.size() * sizeof(float));
+	REQUIRE(oo_socket::array_codec::decode<float>(encoded.data(), encoded.size()) == readings);
+
+	std::vector<double> doubles(readings.begin(), readings.end());
+	oo_socket::array_codec::encode(doubles, encoding, encoded);
+	REQUIRE(encoded.size() < doubles.size() * sizeof(double) / 2);
+	REQUIRE(oo_socket::array_codec::decode<double>(encoded.data(), encoded.size()) == doubles);
+
+	SECTION("Special values keep their exact bits.") {
+		const std::vector<double> special = {0.0, -0.0, std::numeric_limits<double>::infinity(), -1e308,
+			std::numeric_limits<double>::denorm_min(), std::numeric_limits<double>::quiet_NaN(), 1.0, 1.0};
+		oo_socket::array_codec::encode(special, encoding, encoded);
+		const std::vector<double> decoded = oo_socket::array_codec::decode<double>(encoded.data(), encoded.size());
+		REQUIRE(decoded.size() == special.size());
+		REQUIRE(::memcmp(decoded.data(), special.data(), special.size() * sizeof(double)) == 0);
+	}
+
+	SECTION("Arrays that do not shrink are sent raw.") {
+		std::mt19937 generator(2);
+		std::vector<float> noise(100);
+		for (float& value : noise) {
+			uint32_t bits = generator();
+			::memcpy(&value, &bits, sizeof(value));
+		}
+		oo_socket::array_codec::encode(noise, encoding, encoded);
+		REQUIRE(encoded[1] == oo_socket::array_codec::RAW);
+		REQUIRE(encoded.size() == 4 + noise.size() * sizeof(float));
+		const std::vector<float> decoded = oo_socket::array_codec::decode<float>(encoded.data(), encoded.size());
+		REQUIRE(::memcmp(decoded.data(), noise.data(), noise.size() * sizeof(float)) == 0);
+	}
+}
+
+TEST_CASE("Check quantized arrays stay within half a step.", "[array_codec][test]") {
+	oo_socket::array_codec::array_encoding encoding;
+	encoding.floating_method = oo_socket::array_codec::QUANTIZED;
+	encoding.quantization_step = 0.01;
+	std::vector<char> encoded;
+	const std::vector<float> readings = sensor_readings(1000);
+	oo_socket::array_codec::encode(readings, encoding, encoded);
+	REQUIRE(encoded[1] == oo_socket::array_codec::QUANTIZED);
+	REQUIRE(encoded.size() < readings.size() * sizeof(float) / 3);
+	const std::vector<float> decoded = oo_socket::array_codec::decode<float>(encoded.data(), encoded.size());
+	REQUIRE(decoded.size() == readings.size());
+	for (size_t i = 0; i < readings.size(); i++) {
+		REQUIRE(std::abs(decoded[i] - readings[i]) <= 0.005f + 1e-5f);
+	}
+
+	SECTION("Values outside the quantized range are refused.") {
+		const std::vector<double> too_large = {1e12};
+		REQUIRE_THROWS_AS(oo_socket::array_codec::encode(too_large, encoding, encoded), oo_socket::errors::encode_error);
+		const std::vector<double> not_a_number = {std::numeric_limits<double>::quiet_NaN()};
+		REQUIRE_THROWS_AS(oo_socket::array_codec::encode(not_a_number, encoding, encoded), oo_socket::errors::encode_error);
+	}
+}
+
+TEST_CASE("Check malformed arrays are rejected.", "[array_codec][test]") {
+	oo_socket::array_codec::array_encoding encoding;
+	std::vector<char> encoded;
+	std::vector<int32_t> values(300, 5);
+	values[299] = 900;
+	oo_socket::array_codec::encode(values, encoding, encoded);
+
+	REQUIRE_THROWS_AS(oo_socket::array_codec::decode<uint32_t>(encoded.data(), encoded.size()), oo_socket::errors::decode_error);
+	REQUIRE_THROWS_AS(oo_socket::array_codec::decode<int32_t>(encoded.data(), encoded.size() - 1), oo_socket::errors::decode_error);
+	REQUIRE_THROWS_AS(oo_socket::array_codec::decode<int32_t>(encoded.data(), 40), oo_socket::errors::decode_error);
+	encoded[0] = 0;
+	REQUIRE_THROWS_AS(oo_socket::array_codec::decode<int32_t>(encoded.data(), encoded.size()), oo_socket::errors::decode_error);
+
+	const std::vector<float> readings = sensor_readings(50);
+	oo_socket::array_codec::encode(readings, encoding, encoded);
+	for (size_t size = 0; size < encoded.size(); size++) {
+		REQUIRE_THROWS_AS(oo_socket::array_codec::decode<float>(encoded.data(), size), oo_socket::errors::decode_error);
+	}
+}
+
+TEST_CASE("Check array counts are limited.", "[array_codec][test]") {
+	oo_socket::array_codec::array_encoding encoding;
+	std::vector<char> encoded;
+	oo_socket::array_codec::encode(std::vector<int32_t>(300, 5), encoding, encoded);
+	REQUIRE(oo_socket::array_codec::decode<int32_t>(encoded.data(), encoded.size(), 300).size() == 300);
+	REQUIRE_THROWS_AS(oo_socket::array_codec::decode<int32_t>(encoded.data(), encoded.size(), 299), oo_socket::errors::decode_error);
+
+	// A constant array packs to a few bytes whatever its count, so a forged count must not size the vector.
+	const char* position = encoded.data() + 3;
+	oo_socket::schema::read_varint(position, encoded.data() + encoded.size());
+	std::vector<char> forged(encoded.begin(), encoded.begin() + 3);
+	forged.resize(3 + oo_socket::schema::varint_size(16777216));
+	oo_socket::schema::write_varint(16777216, forged.data() + 3);
+	forged.insert(forged.end(), position, (const char*)encoded.data() + encoded.size());
+	REQUIRE(forged.size() < 32);
+	REQUIRE_THROWS_AS(oo_socket::array_codec::decode<int32_t>(forged.data(), forged.size()), oo_socket::errors::decode_error);
+
+	REQUIRE_THROWS_AS(oo_socket::array_codec::encode(std::vector<int32_t>(ARRAY_CODEC_MAX_COUNT + 1, 5), encoding, encoded), oo_socket::errors::encode_error);
+}
+
+TEST_CASE("Benchmarking array codec.", "[array_codec][benchmark]") {
+	oo_socket::array_codec::array_encoding encoding;
+	std::vector<int32_t> counts(1024);
+	for (size_t i = 0; i < counts.size(); i++) {
+		counts[i] = 1000 + (int32_t)(i % 200);
+	}
+	std::vector<char> encoded;
+	BENCHMARK("Packing 1024 integers.") {
+		return oo_socket::array_codec::encode(counts, encoding, encoded);
+	};
+	std::vector<int32_t> decoded;
+	BENCHMARK("Unpacking 1024 integers.") {
+		return oo_socket::array_codec::decode(encoded.data(), encoded.size(), decoded);
+	};
+	const std::vector<float> readings = sensor_readings(1024);
+	BENCHMARK("XOR compressing 1024 floats.") {
+		return oo_socket::array_codec::encode(readings, encoding, encoded);
+	};
+}
@@ -0,0 +1,93 @@
+#include <cstring>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark_all.hpp>
+#include <catch2/matchers/catch_matchers_all.hpp>
+
+#include "byte_order.hpp"
+
+static_assert(oo_socket::byte_order::swap_bytes((uint16_t)0x0102) == 0x0201, "16 bit values are reversed");
+static_assert(oo_socket::byte_order::swap_bytes((uint32_t)0x01020304) == 0x04030201, "32 bit values are reversed");
+static_assert(oo_socket::byte_order::swap_bytes((uint64_t)0x0102030405060708) == 0x0807060504030201, "64 bit values are reversed");
+
+TEST_CASE("Check values are written in network byte order.", "[byte_order][test]") {
+	char buffer[9] = {};
+	oo_socket::byte_order::write_network((uint32_t)0x01020304, buffer + 1);
+	REQUIRE(buffer[1] == 1);
+	REQUIRE(buffer[4] == 4);
+	REQUIRE(oo_socket::byte_order::read_network<uint32_t>(buffer + 1) == 0x01020304);
+
+	oo_socket::byte_order::write_network(-2.5, buffer + 1);
+	REQUIRE(oo_socket::byte_order::read_network<double>(buffer + 1) == -2.5);
+	oo_socket::byte_order::write_network((int16_t)-2, buffer);
+	REQUIRE((uint8_t)buffer[0] == 0xff);
+	REQUIRE((uint8_t)buffer[1] == 0xfe);
+	REQUIRE(oo_socket::byte_order::read_network<int16_t>(buffer) == -2);
+}
+
+TEST_CASE("Check arrays are converted like single values.", "[byte_order][test]") {
+	// Cover every vector width, the scalar tail and unaligned buffers.
+	for (size_t count = 0; count < 80; count++) {
+		std::vector<uint16_t> shorts(count);
+		std::vector<uint32_t> ints(count);
+		std::vector<double> doubles(count);
+		for (size_t i = 0; i < count; i++) {
+			shorts[i] = (uint16_t)(i * 0x0101 + 0x1234);
+			ints[i] = (uint32_t)(i * 0x01010101 + 0x12345678);
+			doubles[i] = (double)i * 1.5 - 7;
+		}
+		std::vector<char> buffer(count * 8 + 1);
+		char* unaligned = buffer.data() + 1;
+
+		oo_socket::byte_order::write_network_array(shorts.data(), count, unaligned);
+		for (size_t i = 0; i < count; i++) {
+			REQUIRE(oo_socket::byte_order::read_network<uint16_t>(unaligned + i * 2) == shorts[i]);
+		}
+		std::vector<uint16_t> shorts_read(count);
+		oo_socket::byte_order::read_network_array(unaligned, count, shorts_read.data());
+		REQUIRE(shorts_read == shorts);
+
+		oo_socket::byte_order::write_network_array(ints.data(), count, unaligned);
+		for (size_t i = 0; i < count; i++) {
+			REQUIRE(oo_socket::byte_order::read_network<uint32_t>(unaligned + i * 4) == ints[i]);
+		}
+		std::vector<uint32_t> ints_read(count);
+		oo_socket::byte_order::read_network_array(unaligned, count, ints_read.data());
+		REQUIRE(ints_read == ints);
+
+		oo_socket::byte_order::write_network_array(doubles.data(), count, unaligned);
+		for (size_t i = 0; i < count; i++) {
+			REQUIRE(oo_socket::byte_order::read_network<double>(unaligned + i * 8) == doubles[i]);
+		}
+		std::vector<double> doubles_read(count);
+		oo_socket::byte_order::read_network_array(unaligned, count, doubles_read.data());
+		REQUIRE(doubles_read == doubles);
+	}
+}
+
+TEST_CASE("Check arrays can be swapped in place.", "[byte_order][test]") {
+	std::vector<uint32_t> values(37);
+	for (size_t i = 0; i < values.size(); i++) {
+		values[i] = (uint32_t)i;
+	}
+	oo_socket::byte_order::swap_array((const char*)values.data(), (char*)values.data(), values.size(), sizeof(uint32_t));
+	for (size_t i = 0; i < values.size(); i++) {
+		REQUIRE(values[i] == oo_socket::byte_order::swap_bytes((uint32_t)i));
+	}
+}
+
+TEST_CASE("Benchmarking byte order.", "[byte_order][benchmark]") {
+	std::vector<float> values(1024, 1.5f);
+	std::vector<char> buffer(values.size() * sizeof(float));
+	BENCHMARK("Writing 1024 floats in network byte order.") {
+		oo_socket::byte_order::write_network_array(values.data(), values.size(), buffer.data());
+		return buffer[0];
+	};
+	BENCHMARK("Writing 1024 floats one at a time.") {
+		for (size_t i = 0; i < values.size(); i++) {
+			oo_socket::byte_order::write_network(values[i], buffer.data() + i * sizeof(float));
+		}
+		return buffer[0];
+	};
+}
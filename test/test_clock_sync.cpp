@@ -0,0 +1,262 @@
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark_all.hpp>
+#include <catch2/matchers/catch_matchers_all.hpp>
+
+#include "clock_sync.hpp"
+
+namespace {
+	/**
+	 *	@struct	simulated_peer
+	 * 	@brief 	Struct simulated_peer is a peer whose clock runs fast by a fixed drift from a fixed offset.
+	 */
+	struct simulated_peer {
+		/// Local time the peer's clock is compared at.
+		uint64_t epoch_ns;
+		/// Peer clock minus local clock at the epoch.
+		int64_t offset_ns;
+		/// Drift in parts per million.
+		double drift_ppm;
+
+		/**
+		 * @brief 	Method remote converts a local time to the peer's clock.
+		 * @param 	local_ns 	local time.
+		 * @return 	uint64_t 	peer time.
+		 */
+		uint64_t remote(uint64_t local_ns) const {
+			return local_ns + offset_ns + (int64_t)((double)(int64_t)(local_ns - epoch_ns) * drift_ppm * 1e-6);
+		}
+
+		/**
+		 * @brief 	Method exchange simulates a request and response with the given one-way delays.
+		 * @param 	estimator 	estimator to add the sample to.
+		 * @param 	sent_ns 	local time the request is sent.
+		 * @param 	outbound_ns delay of the request.
+		 * @param 	inbound_ns 	delay of the response.
+		 */
+		void exchange(oo_socket::clock_sync::clock_estimator& estimator, uint64_t sent_ns, uint64_t outbound_ns, uint64_t inbound_ns) const {
+			const uint64_t received_ns = sent_ns + outbound_ns;
+			const uint64_t replied_ns = received_ns + 5000;
+			estimator.add_sample(sent_ns, remote(received_ns), remote(replied_ns), replied_ns + inbound_ns);
+		}
+	};
+}
+
+TEST_CASE("Check synchronization packets round trip.", "[clock_sync][test]") {
+	char request[CLOCK_SYNC_REQUEST_SIZE];
+	oo_socket::clock_sync::write_request(1700000000123456789ULL, request);
+	uint64_t sent_ns = 0;
+	REQUIRE(oo_socket::clock_sync::read_request(request, sizeof(request), sent_ns));
+	REQUIRE(sent_ns == 1700000000123456789ULL);
+	REQUIRE_FALSE(oo_socket::clock_sync::read_request(request, sizeof(request) - 1, sent_ns));
+
+	char response[CLOCK_SYNC_RESPONSE_SIZE];
+	oo_socket::clock_sync::write_response(1, 2, 3, response);
+	uint64_t t1 = 0, t2 = 0, t3 = 0;
+	REQUIRE_FALSE(oo_socket::clock_sync::read_request(response, sizeof(response), sent_ns));
+	REQUIRE(oo_socket::clock_sync::read_response(response, sizeof(response), t1, t2, t3));
+	REQUIRE((t1 == 1 && t2 == 2 && t3 == 3));
+	response[0] = (char)oo_socket::clock_sync::REQUEST;
+	REQUIRE_FALSE(oo_socket::clock_sync::read_response(response, sizeof(response), t1, t2, t3));
+
+	char stamp[CLOCK_SYNC_STAMP_SIZE];
+	oo_socket::clock_sync::write_stamp(stamp, 42);
+	REQUIRE(oo_socket::clock_sync::read_stamp(stamp) == 42);
+}
+
+TEST_CASE("Check the estimator follows a drifting clock.", "[clock_sync][test]") {
+	std::mt19937 generator(7);
+	const uint64_t start_ns = 1700000000000000000ULL;
+	const simulated_peer peer{start_ns, -3000000, 80.0};
+	oo_socket::clock_sync::clock_estimator estimator;
+	REQUIRE_FALSE(estimator.is_synchronized());
+
+	SECTION("A single exchange gives the offset but no drift.") {
+		peer.exchange(estimator, start_ns, 40000, 40000);
+		REQUIRE(estimator.is_synchronized());
+		REQUIRE(std::llabs(estimator.offset_ns(start_ns) - peer.offset_ns) < 100);
+		REQUIRE(estimator.delay_ns() == 80000);
+		REQUIRE(estimator.drift_ppm() == 0);
+	}
+
+	SECTION("Exchanges over time give the drift, and queued exchanges are ignored.") {
+		// One exchange a second with 40 us minimum delays, a little jitter and every fourth exchange queued for milliseconds.
+		std::uniform_int_distribution<uint64_t> jitter(0, 2000);
+		for (int i = 0; i < 20; i++) {
+			const uint64_t sent_ns = start_ns + (uint64_t)i * 1000000000ULL;
+			const uint64_t queued_ns = i % 4 == 3 ? 5000000 : 0;
+			peer.exchange(estimator, sent_ns, 40000 + queued_ns + jitter(generator), 40000 + jitter(generator));
+		}
+		REQUIRE(estimator.sample_count() == 16);
+		REQUIRE(std::abs(estimator.drift_ppm() - 80.0) < 2.0);
+		const uint64_t now_ns = start_ns + 20000000000ULL;
+		REQUIRE(std::llabs(estimator.offset_ns(now_ns) - (int64_t)(peer.remote(now_ns) - now_ns)) < 2000);
+		REQUIRE(std::llabs((int64_t)(estimator.to_local(peer.remote(now_ns)) - now_ns)) < 2000);
+		REQUIRE(estimator.delay_ns() >= 80000);
+		REQUIRE(estimator.delay_ns() < 85000);
+	}
+
+	SECTION("Drift beyond what clocks are believed to do is clamped.") {
+		const simulated_peer broken{start_ns, 0, 5000.0};
+		for (int i = 0; i < 4; i++) {
+			broken.exchange(estimator, start_ns + (uint64_t)i * 1000000000ULL, 40000, 40000);
+		}
+		REQUIRE(std::abs(estimator.drift_ppm() - CLOCK_SYNC_MAX_DRIFT_PPM) < 1e-6);
+	}
+}
+
+TEST_CASE("Check one-way latency between sockets.", "[clock_sync][test]") {
+	oo_socket::udp::socket first(16666, "127.0.0.1");
+	oo_socket::udp::socket second(16667, "127.0.0.1");
+	REQUIRE_NOTHROW(first.enable_receive_timestamps());
+	REQUIRE_NOTHROW(second.enable_receive_timestamps());
+	first.set_socket_receive_timeout(1000);
+	second.set_socket_receive_timeout(1000);
+	const oo_socket::socket_address first_address = oo_socket::socket_address::parse("127.0.0.1", 16666);
+	const oo_socket::socket_address second_address = oo_socket::socket_address::parse("127.0.0.1", 16667);
+	oo_socket::clock_sync::synchronizer first_sync(first);
+	oo_socket::clock_sync::synchronizer second_sync(second);
+	// The second end only answers, so it answers sources it has not sent requests to.
+	second_sync.enable_responder(100, 4);
+
+	std::vector<char> buffer(64);
+	std::vector<oo_socket::incoming_datagram> incoming(1);
+	incoming[0].buffer = buffer.data();
+	incoming[0].capacity = buffer.size();
+	for (int i = 0; i < 4; i++) {
+		first_sync.request(second_address);
+		REQUIRE(second.receive_batch(incoming, true) == 1);
+		REQUIRE(second_sync.handle(incoming[0]));
+		REQUIRE(first.receive_batch(incoming, true) == 1);
+		REQUIRE(first_sync.handle(incoming[0]));
+	}
+	// Both ends share a clock, so the offset is within the timestamping error.
+	const oo_socket::clock_sync::clock_estimator estimator = first_sync.get_estimator(second_address);
+	REQUIRE(estimator.sample_count() == 4);
+	REQUIRE(std::llabs(estimator.offset_ns()) < 1000000);
+	REQUIRE(estimator.delay_ns() < 1000000000);
+	REQUIRE_FALSE(second_sync.get_estimator(first_address).is_synchronized());
+
+	// Messages from a synchronized peer are recorded, application datagrams are not consumed by handle.
+	char message[32] = {};
+	oo_socket::clock_sync::write_stamp(message);
+	REQUIRE(second.send_to(message, sizeof(message), first_address) == (int)sizeof(message));
+	REQUIRE(first.receive_batch(incoming, true) == 1);
+	REQUIRE(incoming[0].receive_timestamp_ns != 0);
+	REQUIRE_FALSE(first_sync.handle(incoming[0]));
+	const int64_t latency = first_sync.observe(incoming[0]);
+	REQUIRE(latency > -1000000);
+	REQUIRE(latency < 1000000000);
+	REQUIRE(first_sync.get_latency(second_address)->get_count() == 1);
+
+	// Messages from a peer that was never sent a request are returned uncorrected and do not add the peer.
+	first.send_to(message, sizeof(message), second_address);
+	REQUIRE(second.receive_batch(incoming, true) == 1);
+	second_sync.observe(incoming[0]);
+	REQUIRE(second_sync.get_latency(first_address) == nullptr);
+
+	incoming[0].size = 4;
+	REQUIRE_THROWS_AS(first_sync.observe(incoming[0]), oo_socket::errors::decode_error);
+}
+
+TEST_CASE("Check responses are only used when they answer a request.", "[clock_sync][test]") {
+	oo_socket::udp::socket inner(16666, "127.0.0.1");
+	oo_socket::udp::socket peer(16667, "127.0.0.1");
+	peer.set_socket_receive_timeout(1000);
+	const oo_socket::socket_address peer_address = oo_socket::socket_address::parse("127.0.0.1", 16667);
+	const oo_socket::socket_address stranger_address = oo_socket::socket_address::parse("127.0.0.1", 16668);
+	oo_socket::clock_sync::synchronizer sync(inner);
+	const uint64_t now_ns = oo_socket::clock_sync::wall_clock_ns();
+	char response[CLOCK_SYNC_RESPONSE_SIZE];
+
+	// A response from a source that was never sent a request is consumed without tracking the source.
+	oo_socket::clock_sync::write_response(now_ns, now_ns, now_ns, response);
+	REQUIRE(sync.handle(response, sizeof(response), stranger_address, now_ns));
+	REQUIRE(sync.get_latency(stranger_address) == nullptr);
+	REQUIRE(sync.get_rejected() == 1);
+
+	// A response echoing a send time that was never requested is dropped.
+	sync.request(peer_address);
+	char request[CLOCK_SYNC_REQUEST_SIZE];
+	REQUIRE(peer.receive(request, sizeof(request)) == CLOCK_SYNC_REQUEST_SIZE);
+	uint64_t request_sent_ns = 0;
+	REQUIRE(oo_socket::clock_sync::read_request(request, sizeof(request), request_sent_ns));
+	oo_socket::clock_sync::write_response(request_sent_ns + 1, now_ns, now_ns, response);
+	REQUIRE(sync.handle(response, sizeof(response), peer_address, now_ns));
+	REQUIRE(sync.get_estimator(peer_address).sample_count() == 0);
+	REQUIRE(sync.get_rejected() == 2);
+
+	// The matching response is used once, and replaying it is dropped.
+	oo_socket::clock_sync::write_response(request_sent_ns, request_sent_ns + 1000, request_sent_ns + 2000, response);
+	REQUIRE(sync.handle(response, sizeof(response), peer_address, request_sent_ns + 3000));
+	REQUIRE(sync.get_estimator(peer_address).sample_count() == 1);
+	REQUIRE(sync.handle(response, sizeof(response), peer_address, request_sent_ns + 3000));
+	REQUIRE(sync.get_estimator(peer_address).sample_count() == 1);
+	REQUIRE(sync.get_rejected() == 3);
+}
+
+TEST_CASE("Benchmarking clock synchronization.", "[clock_sync][benchmark]") {
+	const uint64_t start_ns = 1700000000000000000ULL;
+	const simulated_peer peer{start_ns, 250000, 20.0};
+	oo_socket::clock_sync::clock_estimator estimator;
+	uint64_t sent_ns = start_ns;
+	BENCHMARK("Adding a sample to a full window.") {
+		sent_ns += 1000000000ULL;
+		peer.exchange(estimator, sent_ns, 40000, 45000);
+		return estimator.offset_ns(sent_ns);
+	};
+	BENCHMARK("Converting a peer time to local time.") {
+		return estimator.to_local(sent_ns);
+	};
+}
+
+TEST_CASE("Check requests are only answered for peers or within the responder rate.", "[clock_sync][test]") {
+	oo_socket::udp::socket inner(16666, "127.0.0.1");
+	oo_socket::udp::socket peer(16667, "127.0.0.1");
+	peer.set_socket_receive_timeout(200);
+	const oo_socket::socket_address peer_address = oo_socket::socket_address::parse("127.0.0.1", 16667);
+	oo_socket::clock_sync::synchronizer sync(inner);
+	const uint64_t now_ns = oo_socket::clock_sync::wall_clock_ns();
+	char request[CLOCK_SYNC_REQUEST_SIZE];
+	oo_socket::clock_sync::write_request(now_ns, request);
+	char response[CLOCK_SYNC_RESPONSE_SIZE];
+
+	// A request from a source that is not a tracked peer is consumed without a response.
+	REQUIRE(sync.handle(request, sizeof(request), peer_address, now_ns));
+	REQUIRE(peer.receive(response, sizeof(response)) == 0);
+	REQUIRE(sync.get_unanswered() == 1);
+
+	// Once a request has been sent to the peer its requests are answered.
+	sync.request(peer_address);
+	REQUIRE(peer.receive(response, sizeof(response)) == CLOCK_SYNC_REQUEST_SIZE);
+	for (int i = 0; i < 3; i++) {
+		REQUIRE(sync.handle(request, sizeof(request), peer_address, now_ns));
+		REQUIRE(peer.receive(response, sizeof(response)) == CLOCK_SYNC_RESPONSE_SIZE);
+	}
+	REQUIRE(sync.get_unanswered() == 1);
+
+	SECTION("The responder answers other sources up to its burst.") {
+		REQUIRE_THROWS_AS(sync.enable_responder(0, 1), oo_socket::errors::configuration_error);
+		sync.remove(peer_address);
+		sync.enable_responder(0.001, 2);
+		for (int i = 0; i < 4; i++) {
+			REQUIRE(sync.handle(request, sizeof(request), peer_address, now_ns));
+		}
+		REQUIRE(peer.receive(response, sizeof(response)) == CLOCK_SYNC_RESPONSE_SIZE);
+		REQUIRE(peer.receive(response, sizeof(response)) == CLOCK_SYNC_RESPONSE_SIZE);
+		REQUIRE(peer.receive(response, sizeof(response)) == 0);
+		REQUIRE(sync.get_unanswered() == 3);
+	}
+
+	SECTION("Responses that cannot be sent are counted rather than thrown.") {
+		sync.enable_responder(1000, 10);
+		const oo_socket::socket_address unreachable = oo_socket::socket_address::parse("::1", 16667);
+		REQUIRE_NOTHROW(sync.handle(request, sizeof(request), unreachable, now_ns));
+		REQUIRE(sync.get_failed_responses() == 1);
+	}
+}
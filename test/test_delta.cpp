@@ -0,0 +1,231 @@
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark_all.hpp>
+#include <catch2/matchers/catch_matchers_all.hpp>
+
+#include "delta.hpp"
+
+namespace {
+	/**
+	 * @brief 	Function move_entities changes the position of some entities of a state frame, like a game tick.
+	 * @param 	frame 		frame of 32 byte entities whose first word is a position.
+	 * @param 	generator 	random number generator choosing the entities.
+	 * @param 	moving 		number of entities to move.
+	 */
+	void move_entities(std::vector<char>& frame, std::mt19937& generator, size_t moving) {
+		const size_t entities = frame.size() / 32;
+		for (size_t i = 0; i < moving; i++) {
+			const size_t entity = generator() % entities;
+			uint32_t position;
+			::memcpy(&position, frame.data() + entity * 32, sizeof(position));
+			position += 1 + generator() % 7;
+			::memcpy(frame.data() + entity * 32, &position, sizeof(position));
+		}
+	}
+}
+
+TEST_CASE("Check deltas rebuild the new frame.", "[delta][test]") {
+	std::mt19937 generator(3);
+	// Cover every SIMD width, partial last words and runs touching either end of the frame.
+	for (size_t size = 0; size < 150; size++) {
+		for (int changes = 0; changes < 6; changes++) {
+			std::vector<char> base(size);
+			for (char& byte : base) {
+				byte = (char)generator();
+			}
+			std::vector<char> frame = base;
+			for (int i = 0; i < changes && size > 0; i++) {
+				frame[generator() % size] ^= (char)(1 + generator() % 255);
+			}
+			std::vector<char> delta(size * 2 + 32);
+			size_t written = 0;
+			REQUIRE(oo_socket::delta::encode_delta(base.data(), frame.data(), size, delta.data(), delta.size(), written));
+			if (frame == base) {
+				REQUIRE(written == 0);
+			}
+			std::vector<char> rebuilt = base;
+			oo_socket::delta::apply_delta(delta.data(), written, rebuilt.data(), rebuilt.size());
+			REQUIRE(rebuilt == frame);
+		}
+	}
+
+	SECTION("Deltas larger than the buffer are refused.") {
+		std::vector<char> base(64, 0);
+		std::vector<char> frame(64, 1);
+		std::vector<char> delta(64);
+		size_t written = 0;
+		REQUIRE_FALSE(oo_socket::delta::encode_delta(base.data(), frame.data(), frame.size(), delta.data(), delta.size(), written));
+	}
+
+	SECTION("Runs outside the frame are rejected.") {
+		std::vector<char> frame(16, 0);
+		const char past_end[] = {3, 2, 1, 1, 1, 1, 1, 1, 1, 1};
+		REQUIRE_THROWS_AS(oo_socket::delta::apply_delta(past_end, sizeof(past_end), frame.data(), frame.size()), oo_socket::errors::decode_error);
+		const char truncated[] = {0, 2, 1, 1, 1};
+		REQUIRE_THROWS_AS(oo_socket::delta::apply_delta(truncated, sizeof(truncated), frame.data(), frame.size()), oo_socket::errors::decode_error);
+	}
+}
+
+TEST_CASE("Check receivers are sent deltas against their acknowledged frame.", "[delta][test]") {
+	const oo_socket::socket_address receiver = oo_socket::socket_address::parse("127.0.0.1", 16666);
+	oo_socket::delta::encoder encoder(8, 0);
+	oo_socket::delta::decoder decoder(8);
+	std::vector<char> frame(1024, 0);
+	std::vector<char> packet;
+
+	REQUIRE_THROWS_AS(encoder.encode(receiver, packet), oo_socket::errors::encode_error);
+
+	encoder.update(frame);
+	encoder.encode(receiver, packet);
+	REQUIRE((uint8_t)packet[0] == oo_socket::delta::KEYFRAME);
+	REQUIRE(packet.size() == DELTA_HEADER_SIZE + frame.size());
+	REQUIRE(decoder.decode(packet));
+	REQUIRE(decoder.frame() == frame);
+
+	SECTION("Unacknowledged receivers keep getting keyframes.") {
+		frame[100] = 1;
+		encoder.update(frame);
+		encoder.encode(receiver, packet);
+		REQUIRE((uint8_t)packet[0] == oo_socket::delta::KEYFRAME);
+	}
+
+	SECTION("Acknowledged receivers get deltas.") {
+		const std::vector<char> ack = decoder.acknowledgement();
+		REQUIRE(encoder.handle_ack(receiver, ack.data(), ack.size()));
+		REQUIRE_FALSE(encoder.handle_ack(receiver, packet.data(), packet.size()));
+
+		frame[100] = 1;
+		frame[1023] = 2;
+		REQUIRE(encoder.update(frame) == 1);
+		encoder.encode(receiver, packet);
+		REQUIRE((uint8_t)packet[0] == oo_socket::delta::DELTA);
+		REQUIRE(packet.size() < DELTA_HEADER_SIZE + 16);
+		REQUIRE(decoder.decode(packet));
+		REQUIRE(decoder.get_sequence() == 1);
+		REQUIRE(decoder.frame() == frame);
+
+		// Without a newer acknowledgement the next frame is still based on frame 0.
+		frame[500] = 3;
+		encoder.update(frame);
+		encoder.encode(receiver, packet);
+		REQUIRE((uint8_t)packet[0] == oo_socket::delta::DELTA);
+		REQUIRE(decoder.decode(packet));
+		REQUIRE(decoder.frame() == frame);
+
+		// Replayed packets are ignored.
+		REQUIRE_FALSE(decoder.decode(packet));
+
+		// A frame of a new size is sent whole.
+		frame.resize(2000);
+		encoder.update(frame);
+		encoder.encode(receiver, packet);
+		REQUIRE((uint8_t)packet[0] == oo_socket::delta::KEYFRAME);
+		REQUIRE(decoder.decode(packet));
+		REQUIRE(decoder.frame() == frame);
+	}
+
+	SECTION("Receivers whose base left the history get keyframes.") {
+		encoder.acknowledge(receiver, 0);
+		for (int i = 0; i < 8; i++) {
+			frame[i] = 1;
+			encoder.update(frame);
+		}
+		encoder.encode(receiver, packet);
+		REQUIRE((uint8_t)packet[0] == oo_socket::delta::KEYFRAME);
+	}
+
+	SECTION("Malformed packets are rejected.") {
+		REQUIRE_THROWS_AS(decoder.decode(packet.data(), 5), oo_socket::errors::decode_error);
+		packet.pop_back();
+		packet[4] = 9;
+		REQUIRE_THROWS_AS(decoder.decode(packet), oo_socket::errors::decode_error);
+	}
+}
+
+TEST_CASE("Check streams recover from lost packets and acknowledgements.", "[delta][test]") {
+	std::mt19937 generator(11);
+	std::bernoulli_distribution lost(0.3);
+	const oo_socket::socket_address first = oo_socket::socket_address::parse("127.0.0.1", 16666);
+	const oo_socket::socket_address second = oo_socket::socket_address::parse("::1", 16667);
+	oo_socket::delta::encoder encoder(16, 20);
+	oo_socket::delta::decoder first_decoder(16);
+	oo_socket::delta::decoder second_decoder(4);
+	std::vector<char> frame(32 * 64, 0);
+	std::vector<char> packet;
+	int first_frames = 0;
+	int second_frames = 0;
+
+	for (int tick = 0; tick < 500; tick++) {
+		move_entities(frame, generator, 6);
+		encoder.update(frame);
+		for (int receiver = 0; receiver < 2; receiver++) {
+			const oo_socket::socket_address& address = receiver == 0 ? first : second;
+			oo_socket::delta::decoder& decoder = receiver == 0 ? first_decoder : second_decoder;
+			encoder.encode(address, packet);
+			if (lost(generator)) {
+				continue;
+			}
+			if (decoder.decode(packet)) {
+				REQUIRE(decoder.frame() == frame);
+				(receiver == 0 ? first_frames : second_frames)++;
+				const std::vector<char> ack = decoder.acknowledgement();
+				if (!lost(generator)) {
+					encoder.handle_ack(address, ack.data(), ack.size());
+				}
+			}
+		}
+	}
+	REQUIRE(first_frames > 250);
+	REQUIRE(second_frames > 250);
+	const oo_socket::delta::delta_statistics statistics = encoder.get_statistics();
+	REQUIRE(statistics.keyframes + statistics.deltas == 1000);
+	REQUIRE(statistics.deltas > statistics.keyframes);
+}
+
+TEST_CASE("Check deltas shrink a typical state stream several times.", "[delta][test]") {
+	std::mt19937 generator(5);
+	const oo_socket::socket_address receiver = oo_socket::socket_address::parse("127.0.0.1", 16666);
+	oo_socket::delta::encoder encoder;
+	oo_socket::delta::decoder decoder;
+	// 256 entities of 32 bytes where a tenth of them move each tick.
+	std::vector<char> frame(32 * 256);
+	for (char& byte : frame) {
+		byte = (char)generator();
+	}
+	std::vector<char> packet;
+	for (int tick = 0; tick < 200; tick++) {
+		move_entities(frame, generator, 25);
+		encoder.update(frame);
+		encoder.encode(receiver, packet);
+		REQUIRE(decoder.decode(packet));
+		encoder.acknowledge(receiver, decoder.get_sequence());
+	}
+	REQUIRE(decoder.frame() == frame);
+	const oo_socket::delta::delta_statistics statistics = encoder.get_statistics();
+	REQUIRE(statistics.keyframes == 4);
+	REQUIRE(statistics.frame_bytes > statistics.packet_bytes * 4);
+}
+
+TEST_CASE("Benchmarking delta encoding.", "[delta][benchmark]") {
+	std::mt19937 generator(5);
+	std::vector<char> base(32 * 256);
+	for (char& byte : base) {
+		byte = (char)generator();
+	}
+	std::vector<char> frame = base;
+	move_entities(frame, generator, 25);
+	std::vector<char> delta(frame.size());
+	size_t written = 0;
+	BENCHMARK("Encoding an 8 KiB frame with 25 changed words.") {
+		oo_socket::delta::encode_delta(base.data(), frame.data(), frame.size(), delta.data(), delta.size(), written);
+		return written;
+	};
+	std::vector<char> rebuilt = base;
+	BENCHMARK("Applying a delta with 25 changed words.") {
+		oo_socket::delta::apply_delta(delta.data(), written, rebuilt.data(), rebuilt.size());
+		return rebuilt[0];
+	};
+}
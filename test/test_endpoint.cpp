@@ -0,0 +1,34 @@
+#include <string>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark_all.hpp>
+#include <catch2/matchers/catch_matchers_all.hpp>
+
+#include "endpoint.hpp"
+
+using namespace oo_socket::literals;
+
+// Endpoint literals are parsed entirely at compile time.
+static_assert("10.0.0.1:5000"_ep.address == 0x0a000001, "address is encoded in host byte order");
+static_assert("10.0.0.1:5000"_ep.port == 5000, "port is encoded in host byte order");
+static_assert("255.255.255.255:65535"_ep == oo_socket::ipv4_endpoint{0xffffffff, 65535}, "largest endpoint parses");
+
+TEST_CASE("Check endpoint literals.", "[endpoint][test]") {
+	constexpr oo_socket::ipv4_endpoint endpoint = "127.0.0.1:16666"_ep;
+	REQUIRE(endpoint.address == 0x7f000001);
+	REQUIRE(endpoint.port == 16666);
+	REQUIRE(endpoint.address_string() == "127.0.0.1");
+	REQUIRE(endpoint.to_string() == "127.0.0.1:16666");
+	REQUIRE(endpoint != "127.0.0.1:16667"_ep);
+}
+
+TEST_CASE("Check invalid endpoints throw at run time.", "[endpoint][test]") {
+	const std::string invalid[] = {
+		"", "10.0.0.1", "10.0.0:5000", "10.0.0.256:5000", "10.0.0.1:0", "10.0.0.1:65536",
+		"10.0.0.1:5000x", "10..0.1:5000", "1000.0.0.1:5000", "10.0.0.1:", "a.b.c.d:1"
+	};
+	for (const std::string& text : invalid) {
+		REQUIRE_THROWS_AS(oo_socket::ipv4_endpoint::parse(text.data(), text.size()), oo_socket::errors::configuration_error);
+	}
+	REQUIRE_NOTHROW(oo_socket::ipv4_endpoint::parse("0.0.0.0:1", 9));
+}
@@ -0,0 +1,157 @@
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark_all.hpp>
+#include <catch2/matchers/catch_matchers_all.hpp>
+
+#include "header_filter.hpp"
+
+namespace {
+	/**
+	 *	@struct	datagram_batch
+	 * 	@brief 	Struct datagram_batch is a batch of received datagrams with buffers it owns.
+	 */
+	struct datagram_batch {
+		/// Buffers of the datagrams.
+		std::vector<std::vector<char>> buffers;
+		/// Datagrams pointing into the buffers.
+		std::vector<oo_socket::incoming_datagram> datagrams;
+
+		/**
+		 * @brief 	Method add appends a datagram, pointing the datagrams at the buffers again as they may have moved.
+		 * @param 	bytes 		contents of the datagram.
+		 * @param 	capacity 	size of the buffer holding it, at least the size of the contents.
+		 */
+		void add(const std::vector<char>& bytes, size_t capacity) {
+			buffers.emplace_back(bytes);
+			buffers.back().resize(capacity);
+			oo_socket::incoming_datagram datagram{};
+			datagram.buffer = nullptr;
+			datagram.capacity = capacity;
+			datagrams.push_back(datagram);
+			datagrams.back().size = bytes.size();
+			for (size_t i = 0; i < buffers.size(); i++) {
+				datagrams[i].buffer = buffers[i].data();
+			}
+		}
+	};
+
+	/**
+	 * @brief 	Function protocol_filter returns a filter for a protocol with a 4 byte magic, a version and a type.
+	 * @return 	oo_socket::header_filter 	filter accepting version 2 of types 1, 3 and 200.
+	 */
+	oo_socket::header_filter protocol_filter() {
+		oo_socket::header_filter filter;
+		filter.match_value<uint32_t>(0, 0x4F4F5350).match_value<uint8_t>(4, 2).match_types(5, {1, 3, 200});
+		return filter;
+	}
+
+	/**
+	 * @brief 	Function protocol_header returns a datagram of the protocol.
+	 * @param 	version 	version byte.
+	 * @param 	type 		type byte.
+	 * @param 	size 		size of the datagram, at least 6.
+	 * @return 	std::vector<char> 	bytes of the datagram.
+	 */
+	std::vector<char> protocol_header(uint8_t version, uint8_t type, size_t size) {
+		std::vector<char> bytes(size, 'x');
+		const char magic[4] = {0x4F, 0x4F, 0x53, 0x50};
+		std::memcpy(bytes.data(), magic, sizeof(magic));
+		bytes[4] = (char)version;
+		bytes[5] = (char)type;
+		return bytes;
+	}
+}
+
+TEST_CASE("Check headers are matched.", "[header_filter][test]") {
+	const oo_socket::header_filter filter = protocol_filter();
+	REQUIRE(filter.accepts(protocol_header(2, 1, 64).data(), 64));
+	REQUIRE(filter.accepts(protocol_header(2, 200, 6).data(), 6));
+	REQUIRE_FALSE(filter.accepts(protocol_header(2, 200, 6).data(), 5));
+	REQUIRE_FALSE(filter.accepts(protocol_header(3, 1, 64).data(), 64));
+	REQUIRE_FALSE(filter.accepts(protocol_header(2, 2, 64).data(), 64));
+	std::vector<char> wrong_magic = protocol_header(2, 1, 64);
+	wrong_magic[3] = 0;
+	REQUIRE_FALSE(filter.accepts(wrong_magic.data(), 64));
+
+	SECTION("An empty filter accepts everything.") {
+		const oo_socket::header_filter empty;
+		REQUIRE(empty.accepts("", 0));
+		REQUIRE(empty.accepts(wrong_magic.data(), 64));
+	}
+
+	SECTION("Masks match only some bits and the minimum size is enforced.") {
+		oo_socket::header_filter flags;
+		const char bit = 0x40;
+		flags.match(15, &bit, 1, &bit).set_minimum_size(20);
+		std::vector<char> bytes(20, 0);
+		bytes[15] = (char)0x4F;
+		REQUIRE(flags.accepts(bytes.data(), bytes.size()));
+		REQUIRE_FALSE(flags.accepts(bytes.data(), 19));
+		bytes[15] = (char)0x3F;
+		REQUIRE_FALSE(flags.accepts(bytes.data(), bytes.size()));
+	}
+
+	SECTION("Rules past the header are refused.") {
+		oo_socket::header_filter invalid;
+		REQUIRE_THROWS_AS(invalid.match_value<uint32_t>(13, 1), oo_socket::errors::configuration_error);
+		REQUIRE_THROWS_AS(invalid.match_types(16, {1}), oo_socket::errors::configuration_error);
+	}
+}
+
+TEST_CASE("Check batches are filtered like single datagrams.", "[header_filter][test]") {
+	std::mt19937 generator(5);
+	const oo_socket::header_filter filter = protocol_filter();
+	datagram_batch batch;
+	for (size_t i = 0; i < 301; i++) {
+		const size_t size = generator() % 40;
+		std::vector<char> bytes = protocol_header((uint8_t)(1 + generator() % 2), (uint8_t)(generator() % 4), 6);
+		bytes.resize(size, 'y');
+		if (size > 0 && generator() % 8 == 0) {
+			// Corrupt one byte of the magic.
+			bytes[generator() % (size < 4 ? size : 4)] ^= 0x10;
+		}
+		// Some buffers are too small to load a whole header from.
+		batch.add(bytes, generator() % 3 == 0 ? size : size + 16);
+	}
+
+	std::vector<uint32_t> accepted;
+	const size_t kept = filter.filter(batch.datagrams, batch.datagrams.size(), accepted);
+	std::vector<uint32_t> expected;
+	for (size_t i = 0; i < batch.datagrams.size(); i++) {
+		if (filter.accepts(batch.datagrams[i].buffer, batch.datagrams[i].size)) {
+			expected.push_back((uint32_t)i);
+		}
+	}
+	REQUIRE(kept == expected.size());
+	REQUIRE(accepted == expected);
+	REQUIRE(kept > 0);
+	REQUIRE(kept < batch.datagrams.size());
+
+	// Only the received part of the batch is filtered.
+	REQUIRE(filter.filter(batch.datagrams, 1, accepted) <= 1);
+	REQUIRE(filter.filter(batch.datagrams, 0, accepted) == 0);
+	REQUIRE(accepted.empty());
+}
+
+TEST_CASE("Benchmarking header filter.", "[header_filter][benchmark]") {
+	const oo_socket::header_filter filter = protocol_filter();
+	datagram_batch batch;
+	for (size_t i = 0; i < 64; i++) {
+		batch.add(protocol_header(2, (uint8_t)(i % 4), 512), 1500);
+	}
+	std::vector<uint32_t> accepted(64);
+	BENCHMARK("Filtering a batch of 64 datagrams.") {
+		return filter.filter(batch.datagrams.data(), batch.datagrams.size(), accepted.data());
+	};
+	BENCHMARK("Checking 64 datagrams one at a time.") {
+		size_t kept = 0;
+		for (const oo_socket::incoming_datagram& datagram : batch.datagrams) {
+			kept += filter.accepts(datagram.buffer, datagram.size) ? 1 : 0;
+		}
+		return kept;
+	};
+}
@@ -0,0 +1,157 @@
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "impairment.hpp"
+#include "udp_socket.hpp"
+
+TEST_CASE("Check impairments on sent datagrams.", "[impaired_socket][test]") {
+	oo_socket::udp::socket receiver(16666);
+	oo_socket::udp::socket sender;
+	receiver.set_socket_receive_timeout(200);
+	std::vector<char> buffer(100, 'T');
+
+	SECTION("Datagrams are dropped.") {
+		oo_socket::impairment_profile profile;
+		profile.loss_probability = 1.0;
+		oo_socket::impaired_socket impaired(sender, profile, oo_socket::impairment_profile());
+		for (int i = 0; i < 10; i++) {
+			REQUIRE(impaired.send_to(buffer, 16666) == 100);
+		}
+		REQUIRE(receiver.receive().size() == 0);
+		REQUIRE(impaired.get_send_statistics().packets == 10);
+		REQUIRE(impaired.get_send_statistics().dropped == 10);
+	}
+
+	SECTION("Datagrams are delayed.") {
+		oo_socket::impairment_profile profile;
+		profile.delay_us = 50000;
+		oo_socket::impaired_socket impaired(sender, profile, oo_socket::impairment_profile());
+		auto start = std::chrono::steady_clock::now();
+		impaired.send_to(buffer, 16666);
+		REQUIRE(receiver.receive().size() == 100);
+		REQUIRE(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(50));
+		REQUIRE(impaired.get_send_statistics().delayed == 1);
+	}
+
+	SECTION("Datagrams are duplicated.") {
+		oo_socket::impairment_profile profile;
+		profile.duplicate_probability = 1.0;
+		oo_socket::impaired_socket impaired(sender, profile, oo_socket::impairment_profile());
+		impaired.send_to(buffer, 16666);
+		REQUIRE(receiver.receive().size() == 100);
+		REQUIRE(receiver.receive().size() == 100);
+		REQUIRE(impaired.get_send_statistics().duplicated == 1);
+	}
+
+	SECTION("Bandwidth is capped.") {
+		oo_socket::impairment_profile profile;
+		// 1000 byte datagrams take 10 ms each at 800 kbit/s.
+		profile.bandwidth_bps = 800000;
+		oo_socket::impaired_socket impaired(sender, profile, oo_socket::impairment_profile());
+		std::vector<char> large(1000, 'T');
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < 8; i++) {
+			impaired.send_to(large, 16666);
+		}
+		impaired.flush();
+		REQUIRE(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(70));
+		for (int i = 0; i < 8; i++) {
+			REQUIRE(receiver.receive().size() == 1000);
+		}
+	}
+
+	SECTION("Held datagrams are bounded.") {
+		oo_socket::impairment_profile profile;
+		profile.delay_us = 20000;
+		profile.queue_limit = 4;
+		oo_socket::impaired_socket impaired(sender, profile, oo_socket::impairment_profile());
+		for (int i = 0; i < 10; i++) {
+			REQUIRE(impaired.send_to(buffer, 16666) == 100);
+		}
+		impaired.flush();
+		for (int i = 0; i < 4; i++) {
+			REQUIRE(receiver.receive().size() == 100);
+		}
+		REQUIRE(receiver.receive().size() == 0);
+		REQUIRE(impaired.get_send_statistics().overflowed == 6);
+	}
+}
+
+TEST_CASE("Check impairments are reproducible.", "[impaired_socket][test]") {
+	oo_socket::udp::socket sender;
+	std::vector<char> buffer(16, 'T');
+
+	oo_socket::impairment_profile bernoulli;
+	bernoulli.loss_probability = 0.5;
+	oo_socket::impairment_profile bursty;
+	bursty.gilbert_elliott = true;
+	bursty.good_to_bad_probability = 0.05;
+	bursty.bad_to_good_probability = 0.25;
+
+	for (const oo_socket::impairment_profile& profile : {bernoulli, bursty}) {
+		oo_socket::impaired_socket first(sender, profile, oo_socket::impairment_profile(), 42);
+		oo_socket::impaired_socket second(sender, profile, oo_socket::impairment_profile(), 42);
+		oo_socket::impaired_socket other_seed(sender, profile, oo_socket::impairment_profile(), 43);
+		for (int i = 0; i < 1000; i++) {
+			first.send_to(buffer, 16667);
+			second.send_to(buffer, 16667);
+			other_seed.send_to(buffer, 16667);
+		}
+		REQUIRE(first.get_send_statistics().dropped == second.get_send_statistics().dropped);
+		REQUIRE(first.get_send_statistics().dropped != other_seed.get_send_statistics().dropped);
+		REQUIRE(first.get_send_statistics().dropped > 100);
+		REQUIRE(first.get_send_statistics().dropped < 900);
+	}
+}
+
+TEST_CASE("Check impairments on received datagrams.", "[impaired_socket][test]") {
+	oo_socket::udp::socket receiver(16666);
+	oo_socket::udp::socket sender;
+	receiver.set_socket_receive_timeout(200);
+
+	oo_socket::impairment_profile profile;
+	profile.reorder_probability = 0.3;
+	profile.reorder_delay_us = 5000;
+	oo_socket::impaired_socket impaired(receiver, oo_socket::impairment_profile(), profile, 7);
+
+	std::thread send_thread([&sender]() {
+		for (uint32_t i = 0; i < 50; i++) {
+			std::vector<uint32_t> sequence = {i};
+			sender.send_to(sequence, 16666);
+		}
+	});
+
+	std::vector<uint32_t> received;
+	std::string source_address;
+	uint16_t source_port;
+	for (int i = 0; i < 50; i++) {
+		std::vector<uint32_t> data = impaired.receive<uint32_t>(&source_address, &source_port);
+		REQUIRE(data.size() == 1);
+		received.push_back(data[0]);
+	}
+	send_thread.join();
+
+	// Every datagram arrives once but not in the order they were sent.
+	REQUIRE(std::set<uint32_t>(received.begin(), received.end()).size() == 50);
+	REQUIRE_FALSE(std::is_sorted(received.begin(), received.end()));
+	REQUIRE(impaired.get_receive_statistics().reordered > 0);
+	REQUIRE(source_address == "127.0.0.1");
+}
+
+TEST_CASE("Check received datagrams that are not a whole number of elements are rejected.", "[impaired_socket][test]") {
+	oo_socket::udp::socket receiver(16666);
+	oo_socket::udp::socket sender;
+	receiver.set_socket_receive_timeout(200);
+	oo_socket::impaired_socket impaired(receiver, oo_socket::impairment_profile(), oo_socket::impairment_profile());
+
+	sender.send_to("abcdef", 6, 16666);
+	REQUIRE_THROWS_AS(impaired.receive<uint32_t>(), oo_socket::errors::receive_error);
+	sender.send_to("abcdefgh", 8, 16666);
+	REQUIRE(impaired.receive<uint32_t>().size() == 2);
+}
@@ -0,0 +1,419 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark_all.hpp>
+#include <catch2/matchers/catch_matchers_all.hpp>
+
+#include "journal.hpp"
+
+namespace {
+	/**
+	 *	@struct	temporary_directory
+	 * 	@brief 	Struct temporary_directory removes a directory under the system temporary directory when destroyed.
+	 */
+	struct temporary_directory {
+		/// Path of the directory.
+		std::filesystem::path path;
+
+		/**
+		 * @brief 	Constructor for the temporary_directory struct which starts from an empty directory.
+		 * @param 	name 	name of the directory.
+		 */
+		explicit temporary_directory(const std::string& name) :
+			path(std::filesystem::temp_directory_path() / ("oo_socket_" + name))
+		{
+			std::filesystem::remove_all(path);
+		}
+
+		/**
+		 * 	@brief 	Destructor for the temporary_directory struct.
+		 */
+		~temporary_directory() {
+			std::error_code error;
+			std::filesystem::remove_all(path, error);
+		}
+	};
+
+	/**
+	 * @brief 	Function message returns the payload used for a sequence number, of a length that varies with it.
+	 * @param 	sequence 	sequence number of the message.
+	 * @return 	std::string payload of the message.
+	 */
+	std::string message(uint64_t sequence) {
+		return "message " + std::to_string(sequence) + std::string(sequence % 37, '.');
+	}
+
+	/**
+	 * @brief 	Function read_all returns every record of a log from a sequence number onwards.
+	 * @param 	log 			log to read.
+	 * @param 	from_sequence 	first sequence number to read.
+	 * @return 	std::vector<std::pair<uint64_t, std::string>> sequence numbers and payloads in order.
+	 */
+	std::vector<std::pair<uint64_t, std::string>> read_all(oo_socket::journal::segmented_log& log, uint64_t from_sequence = 1) {
+		std::vector<std::pair<uint64_t, std::string>> records;
+		log.for_each(from_sequence, [&](const oo_socket::journal::record& stored) {
+			REQUIRE(oo_socket::journal::read_sequence(stored.frame()) == stored.sequence);
+			records.emplace_back(stored.sequence, std::string(stored.payload, stored.size));
+			return true;
+		});
+		return records;
+	}
+}
+
+TEST_CASE("Check records round trip across segments.", "[journal][test]") {
+	temporary_directory directory("journal_round_trip");
+	oo_socket::journal::journal_options options;
+	options.segment_size = 4096;
+	options.sync_bytes = 1000;
+	oo_socket::journal::segmented_log log(directory.path.string(), options);
+	REQUIRE(log.next_sequence() == 1);
+	for (uint64_t sequence = 1; sequence <= 300; sequence++) {
+		const std::string payload = message(sequence);
+		const char* frame = nullptr;
+		REQUIRE(log.append(payload.data(), payload.size(), &frame) == sequence);
+		REQUIRE(oo_socket::journal::read_sequence(frame) == sequence);
+		REQUIRE(std::memcmp(frame + JOURNAL_SEQUENCE_SIZE, payload.data(), payload.size()) == 0);
+	}
+	REQUIRE(log.segment_count() > 1);
+	REQUIRE(log.next_sequence() == 301);
+
+	std::vector<std::pair<uint64_t, std::string>> records = read_all(log);
+	REQUIRE(records.size() == 300);
+	for (uint64_t sequence = 1; sequence <= 300; sequence++) {
+		REQUIRE(records[sequence - 1].first == sequence);
+		REQUIRE(records[sequence - 1].second == message(sequence));
+	}
+	REQUIRE(read_all(log, 250).size() == 51);
+	REQUIRE(read_all(log, 301).empty());
+
+	SECTION("Visiting stops when asked to.") {
+		size_t visited = 0;
+		REQUIRE(log.for_each(10, [&](const oo_socket::journal::record&) { return ++visited < 5; }) == 15);
+		REQUIRE(visited == 5);
+	}
+
+	SECTION("Empty records are kept.") {
+		REQUIRE(log.append("", 0) == 301);
+		REQUIRE(read_all(log, 301) == std::vector<std::pair<uint64_t, std::string>>{{301, ""}});
+	}
+
+	SECTION("Records larger than a segment are refused.") {
+		const std::vector<char> large(4096, 'x');
+		REQUIRE_THROWS_AS(log.append(large.data(), large.size()), oo_socket::errors::journal_error);
+		REQUIRE(log.next_sequence() == 301);
+	}
+}
+
+TEST_CASE("Check logs are recovered when reopened.", "[journal][test]") {
+	temporary_directory directory("journal_recovery");
+	oo_socket::journal::journal_options options;
+	options.segment_size = 4096;
+	{
+		oo_socket::journal::segmented_log log(directory.path.string(), options);
+		for (uint64_t sequence = 1; sequence <= 100; sequence++) {
+			const std::string payload = message(sequence);
+			log.append(payload.data(), payload.size());
+		}
+	}
+
+	SECTION("Every record is read back and appends continue the sequence.") {
+		oo_socket::journal::segmented_log log(directory.path.string(), options);
+		REQUIRE(log.next_sequence() == 101);
+		REQUIRE(read_all(log).size() == 100);
+		REQUIRE(log.append("next", 4) == 101);
+		REQUIRE(read_all(log, 100).size() == 2);
+	}
+
+	SECTION("A torn record ends the log and is overwritten.") {
+		std::vector<std::filesystem::path> files;
+		for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(directory.path)) {
+			files.push_back(entry.path());
+		}
+		std::sort(files.begin(), files.end());
+		// Corrupt the payload of the last record of the newest segment, as if it was only partly written back.
+		std::string newest;
+		{
+			std::FILE* file = std::fopen(files.back().c_str(), "rb");
+			newest.resize(4096);
+			REQUIRE(std::fread(&newest[0], 1, newest.size(), file) == newest.size());
+			std::fclose(file);
+		}
+		const uint64_t base = std::stoull(files.back().stem().string());
+		size_t offset = JOURNAL_SEGMENT_HEADER_SIZE;
+		size_t last = offset;
+		for (uint64_t sequence = base; sequence <= 100; sequence++) {
+			last = offset;
+			offset += oo_socket::journal::record_size(message(sequence).size());
+		}
+		newest[last + JOURNAL_RECORD_HEADER_SIZE] ^= 0x55;
+		{
+			std::FILE* file = std::fopen(files.back().c_str(), "r+b");
+			REQUIRE(std::fwrite(newest.data(), 1, newest.size(), file) == newest.size());
+			std::fclose(file);
+		}
+
+		oo_socket::journal::segmented_log log(directory.path.string(), options);
+		REQUIRE(log.next_sequence() == 100);
+		REQUIRE(read_all(log).size() == 99);
+		REQUIRE(log.append("replacement", 11) == 100);
+		REQUIRE(read_all(log, 100) == std::vector<std::pair<uint64_t, std::string>>{{100, "replacement"}});
+	}
+
+	SECTION("Files that are not segments are refused.") {
+		std::FILE* file = std::fopen((directory.path / "00000000000000000001.journal").c_str(), "r+b");
+		std::fputs("not a journal", file);
+		std::fclose(file);
+		REQUIRE_THROWS_AS(oo_socket::journal::segmented_log(directory.path.string(), options), oo_socket::errors::journal_error);
+	}
+}
+
+TEST_CASE("Check concurrent appends get unique sequences.", "[journal][test]") {
+	temporary_directory directory("journal_concurrent");
+	oo_socket::journal::journal_options options;
+	options.segment_size = 16384;
+	options.sync_bytes = 4096;
+	options.synchronous = false;
+	oo_socket::journal::segmented_log log(directory.path.string(), options);
+	const size_t threads = 4;
+	const size_t per_thread = 2000;
+	std::vector<std::thread> appenders;
+	for (size_t thread = 0; thread < threads; thread++) {
+		appenders.emplace_back([&log, thread]() {
+			for (size_t i = 0; i < per_thread; i++) {
+				const std::string payload = std::to_string(thread) + ":" + std::to_string(i);
+				log.append(payload.data(), payload.size());
+			}
+		});
+	}
+	for (std::thread& appender : appenders) {
+		appender.join();
+	}
+	log.sync();
+
+	// Each thread's records appear once each, in the order that thread appended them.
+	const std::vector<std::pair<uint64_t, std::string>> records = read_all(log);
+	REQUIRE(records.size() == threads * per_thread);
+	std::vector<size_t> next(threads, 0);
+	for (size_t i = 0; i < records.size(); i++) {
+		REQUIRE(records[i].first == i + 1);
+		const size_t separator = records[i].second.find(':');
+		const size_t thread = std::stoul(records[i].second.substr(0, separator));
+		REQUIRE(std::stoul(records[i].second.substr(separator + 1)) == next[thread]++);
+	}
+}
+
+TEST_CASE("Check trimming deletes acknowledged segments.", "[journal][test]") {
+	temporary_directory directory("journal_trim");
+	oo_socket::journal::journal_options options;
+	options.segment_size = 4096;
+	oo_socket::journal::segmented_log log(directory.path.string(), options);
+	for (uint64_t sequence = 1; sequence <= 300; sequence++) {
+		const std::string payload = message(sequence);
+		log.append(payload.data(), payload.size());
+	}
+	const size_t segments = log.segment_count();
+	REQUIRE(log.trim(1) == 0);
+	REQUIRE(log.trim(150) > 0);
+	REQUIRE(log.segment_count() < segments);
+	REQUIRE(log.first_sequence() <= 150);
+	REQUIRE(read_all(log).front().first == log.first_sequence());
+	REQUIRE((size_t)std::distance(std::filesystem::directory_iterator(directory.path), std::filesystem::directory_iterator()) == log.segment_count());
+
+	// The active segment is kept even when everything is acknowledged.
+	REQUIRE(log.trim(1000) > 0);
+	REQUIRE(log.segment_count() == 1);
+	REQUIRE(log.append("after", 5) == 301);
+}
+
+TEST_CASE("Check invalid journal options.", "[journal][test]") {
+	temporary_directory directory("journal_options");
+	oo_socket::journal::journal_options options;
+	options.segment_size = 1024;
+	REQUIRE_THROWS_AS(oo_socket::journal::segmented_log(directory.path.string(), options), oo_socket::errors::journal_error);
+	options.segment_size = 0x100000000ULL;
+	REQUIRE_THROWS_AS(oo_socket::journal::segmented_log(directory.path.string(), options), oo_socket::errors::journal_error);
+}
+
+TEST_CASE("Check the outbound journal replays to a returning peer.", "[journal][test]") {
+	temporary_directory directory("journal_outbound");
+	oo_socket::journal::journal_options options;
+	options.segment_size = 4096;
+	oo_socket::udp::socket sender(16667, "127.0.0.1");
+	const oo_socket::socket_address peer = oo_socket::socket_address::parse("127.0.0.1", 16666);
+	oo_socket::journal::outbound_journal journal(sender, peer, directory.path.string(), options);
+
+	// Nothing is listening yet, so the messages are only journaled.
+	for (uint64_t sequence = 1; sequence <= 5; sequence++) {
+		REQUIRE(journal.send(message(sequence).data(), message(sequence).size()) == sequence);
+	}
+
+	oo_socket::udp::socket receiver(16666, "127.0.0.1");
+	receiver.set_socket_receive_timeout(1000);
+	REQUIRE(journal.replay() == 5);
+	char buffer[256];
+	for (uint64_t sequence = 1; sequence <= 5; sequence++) {
+		const int size = receiver.receive(buffer, sizeof(buffer));
+		REQUIRE(oo_socket::journal::read_sequence(buffer) == sequence);
+		REQUIRE(std::string(buffer + JOURNAL_SEQUENCE_SIZE, size - JOURNAL_SEQUENCE_SIZE) == message(sequence));
+	}
+
+	// New messages go straight out, and only unacknowledged ones are replayed.
+	const std::vector<char> live = {'l', 'i', 'v', 'e'};
+	REQUIRE(journal.send(live) == 6);
+	REQUIRE(receiver.receive(buffer, sizeof(buffer)) == 4 + JOURNAL_SEQUENCE_SIZE);
+	REQUIRE(oo_socket::journal::read_sequence(buffer) == 6);
+	journal.acknowledge(4);
+	journal.acknowledge(2);
+	REQUIRE(journal.get_acknowledged() == 4);
+	REQUIRE(journal.replay() == 2);
+	receiver.receive(buffer, sizeof(buffer));
+	REQUIRE(oo_socket::journal::read_sequence(buffer) == 5);
+	receiver.receive(buffer, sizeof(buffer));
+	REQUIRE(oo_socket::journal::read_sequence(buffer) == 6);
+	REQUIRE(journal.replay(6) == 1);
+	receiver.receive(buffer, sizeof(buffer));
+	REQUIRE(oo_socket::journal::read_sequence(buffer) == 6);
+	REQUIRE(journal.get_failed_sends() == 0);
+}
+
+TEST_CASE("Check the inbound journal replays sequence and time ranges.", "[journal][test]") {
+	temporary_directory directory("journal_inbound");
+	oo_socket::journal::journal_options options;
+	options.segment_size = 8192;
+	{
+		oo_socket::journal::inbound_journal journal(directory.path.string(), options, 64, 256, 16);
+		for (uint64_t sequence = 1; sequence <= 1000; sequence++) {
+			const std::string payload = message(sequence);
+			while (!journal.record(payload.data(), payload.size(), 1000000 + sequence * 10)) {
+				// The ring is smaller than the burst, so wait for the writer to catch up.
+				journal.flush();
+			}
+		}
+		// Records retried above while every slot was busy were dropped too.
+		const uint64_t busy = journal.get_dropped();
+		// A receive time earlier than the previous one is raised so the log stays ordered by time.
+		REQUIRE(journal.record("late", 4, 5));
+		const std::vector<char> oversized(257, 'x');
+		REQUIRE_FALSE(journal.record(oversized.data(), oversized.size()));
+		journal.flush();
+		REQUIRE(journal.get_dropped() == busy + 1);
+		REQUIRE(journal.get_index_size() == (1001 + 15) / 16);
+
+		std::vector<oo_socket::journal::inbound_record> records;
+		REQUIRE(journal.replay(100, 200, [&](const oo_socket::journal::inbound_record& received) {
+			records.push_back(received);
+			return true;
+		}) == 101);
+		for (size_t i = 0; i < records.size(); i++) {
+			REQUIRE(records[i].sequence == 100 + i);
+			REQUIRE(records[i].received_ns == 1000000 + (100 + i) * 10);
+			REQUIRE(std::string(records[i].data, records[i].size) == message(100 + i));
+		}
+
+		records.clear();
+		REQUIRE(journal.replay_time(1000000 + 505, 1000000 + 600, [&](const oo_socket::journal::inbound_record& received) {
+			records.push_back(received);
+			return true;
+		}) == 10);
+		REQUIRE(records.front().sequence == 51);
+		REQUIRE(records.back().sequence == 60);
+
+		records.clear();
+		journal.replay(1001, 1001, [&](const oo_socket::journal::inbound_record& received) {
+			records.push_back(received);
+			return true;
+		});
+		REQUIRE(records.size() == 1);
+		REQUIRE(records[0].received_ns == 1000000 + 1000 * 10);
+		REQUIRE(std::string(records[0].data, records[0].size) == "late");
+
+		// Trimmed records are gone, and time replays still start at the oldest record kept.
+		REQUIRE(journal.trim(500) > 0);
+		const uint64_t first = journal.get_log().first_sequence();
+		REQUIRE(journal.replay_time(0, 1000000 + 5000, [](const oo_socket::journal::inbound_record&) { return true; }) == 500 - first + 1);
+	}
+
+	SECTION("A late joiner replays the journal read only.") {
+		options.read_only = true;
+		oo_socket::journal::inbound_journal joiner(directory.path.string(), options, 64, 256, 16);
+		const uint64_t first = joiner.get_log().first_sequence();
+		REQUIRE(joiner.replay(0, 2000, [](const oo_socket::journal::inbound_record&) { return true; }) == 1001 - first + 1);
+		REQUIRE(joiner.get_index_size() > 0);
+		REQUIRE_THROWS_AS(joiner.record("x", 1), oo_socket::errors::journal_error);
+		REQUIRE_THROWS_AS(joiner.trim(1000), oo_socket::errors::journal_error);
+	}
+
+	SECTION("Reopening continues the sequence.") {
+		oo_socket::journal::inbound_journal reopened(directory.path.string(), options, 64, 256, 16);
+		REQUIRE(reopened.record("again", 5));
+		reopened.flush();
+		REQUIRE(reopened.get_log().next_sequence() == 1003);
+	}
+}
+
+TEST_CASE("Check the inbound journal records received batches.", "[journal][test]") {
+	temporary_directory directory("journal_inbound_socket");
+	oo_socket::udp::socket receiver(16666, "127.0.0.1");
+	receiver.set_socket_receive_timeout(1000);
+	REQUIRE_NOTHROW(receiver.enable_receive_timestamps());
+	oo_socket::udp::socket sender;
+	const oo_socket::socket_address destination = oo_socket::socket_address::parse("127.0.0.1", 16666);
+	for (uint64_t sequence = 1; sequence <= 4; sequence++) {
+		sender.send_to(message(sequence).data(), message(sequence).size(), destination);
+	}
+
+	oo_socket::journal::inbound_journal journal(directory.path.string());
+	std::vector<std::vector<char>> buffers(8, std::vector<char>(256));
+	std::vector<oo_socket::incoming_datagram> datagrams;
+	for (std::vector<char>& buffer : buffers) {
+		oo_socket::incoming_datagram datagram{};
+		datagram.buffer = buffer.data();
+		datagram.capacity = buffer.size();
+		datagrams.push_back(datagram);
+	}
+	size_t received = 0;
+	while (received < 4) {
+		const size_t count = receiver.receive_batch(datagrams);
+		REQUIRE(count > 0);
+		REQUIRE(journal.record(datagrams, count) == count);
+		received += count;
+	}
+	journal.flush();
+	const uint64_t start_ns = oo_socket::clock_sync::wall_clock_ns() - 60000000000ULL;
+	std::vector<std::string> payloads;
+	REQUIRE(journal.replay_time(start_ns, start_ns + 120000000000ULL, [&](const oo_socket::journal::inbound_record& record) {
+		payloads.emplace_back(record.data, record.size);
+		return true;
+	}) == 4);
+	REQUIRE(payloads == std::vector<std::string>{message(1), message(2), message(3), message(4)});
+}
+
+TEST_CASE("Benchmarking journal.", "[journal][benchmark]") {
+	temporary_directory directory("journal_benchmark");
+	oo_socket::journal::journal_options options;
+	options.sync_bytes = 0;
+	oo_socket::journal::segmented_log log(directory.path.string(), options);
+	const std::vector<char> payload(256, 'x');
+	BENCHMARK("Appending a 256 byte record.") {
+		return log.append(payload.data(), payload.size());
+	};
+	BENCHMARK("Writing back appended records.") {
+		log.append(payload.data(), payload.size());
+		log.sync();
+	};
+
+	temporary_directory inbound_directory("journal_benchmark_inbound");
+	oo_socket::journal::inbound_journal inbound(inbound_directory.path.string(), options);
+	BENCHMARK("Recording a 256 byte datagram.") {
+		if (!inbound.record(payload.data(), payload.size())) {
+			inbound.flush();
+		}
+	};
+}
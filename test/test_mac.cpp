@@ -0,0 +1,226 @@
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark_all.hpp>
+#include <catch2/matchers/catch_matchers_all.hpp>
+
+#include "mac.hpp"
+
+namespace {
+	/**
+	 * @brief 	Function counting_bytes returns the bytes 0, 1, 2 and so on, as used by the SipHash test vectors.
+	 * @param 	size 	number of bytes.
+	 * @return 	std::vector<uint8_t> 	the bytes.
+	 */
+	std::vector<uint8_t> counting_bytes(size_t size) {
+		std::vector<uint8_t> bytes(size);
+		for (size_t i = 0; i < size; i++) {
+			bytes[i] = (uint8_t)i;
+		}
+		return bytes;
+	}
+}
+
+TEST_CASE("Check SipHash-2-4 matches the test vectors.", "[mac][test]") {
+	// Vectors from the SipHash reference implementation, with the key 00 to 0f and the message 00, 01, 02 and so on.
+	const oo_socket::mac::siphash hasher(counting_bytes(MAC_KEY_SIZE));
+	const std::vector<std::pair<size_t, uint64_t>> vectors = {
+		{0, 0x726fdb47dd0e0e31ull}, {1, 0x74f839c593dc67fdull}, {8, 0x93f5f5799a932462ull},
+		{15, 0xa129ca6149be45e5ull}, {63, 0x958a324ceb064572ull}
+	};
+	for (const auto& vector : vectors) {
+		const std::vector<uint8_t> message = counting_bytes(vector.first);
+		REQUIRE(hasher.hash((const char*)message.data(), message.size()) == vector.second);
+	}
+	REQUIRE_THROWS_AS(oo_socket::mac::siphash(std::vector<uint8_t>(32, 0)), oo_socket::errors::configuration_error);
+}
+
+TEST_CASE("Check datagrams are signed and verified.", "[mac][test]") {
+	const oo_socket::mac::siphash signer(std::vector<uint8_t>(MAC_KEY_SIZE, 1));
+	char buffer[64] = "hello world";
+	const size_t signed_size = signer.sign(buffer, 11);
+	REQUIRE(signed_size == 11 + MAC_TAG_SIZE);
+	size_t size = signed_size;
+	REQUIRE(signer.verify(buffer, size));
+	REQUIRE(size == 11);
+
+	// Any flipped bit, a truncated datagram or another key is rejected without changing the size.
+	for (size_t bit = 0; bit < signed_size * 8; bit++) {
+		buffer[bit / 8] ^= (char)(1 << (bit % 8));
+		size = signed_size;
+		REQUIRE_FALSE(signer.verify(buffer, size));
+		REQUIRE(size == signed_size);
+		buffer[bit / 8] ^= (char)(1 << (bit % 8));
+	}
+	size = signed_size - 1;
+	REQUIRE_FALSE(signer.verify(buffer, size));
+	size = 3;
+	REQUIRE_FALSE(signer.verify(buffer, size));
+	size = signed_size;
+	REQUIRE_FALSE(oo_socket::mac::siphash(std::vector<uint8_t>(MAC_KEY_SIZE, 2)).verify(buffer, size));
+
+	// An empty payload still carries a tag.
+	size = signer.sign(buffer, 0);
+	REQUIRE(size == MAC_TAG_SIZE);
+	REQUIRE(signer.verify(buffer, size));
+	REQUIRE(size == 0);
+}
+
+TEST_CASE("Check a batch is verified the same as each datagram on its own.", "[mac][test]") {
+	// Both the AVX2 kernel, where the processor has it, and the scalar loop.
+	const oo_socket::mac::siphash signer(counting_bytes(MAC_KEY_SIZE));
+	const oo_socket::mac::siphash scalar(counting_bytes(MAC_KEY_SIZE), false);
+	REQUIRE_FALSE(scalar.uses_avx2());
+	std::mt19937 generator(125);
+	for (size_t trial = 0; trial < 100; trial++) {
+		const oo_socket::mac::siphash& verifier = trial % 2 == 0 ? signer : scalar;
+		// Random sizes, or one size in half the trials, including ones too short for a tag, with some tags and
+		// payloads corrupted.
+		const size_t count = generator() % 40;
+		const size_t common_size = trial % 4 < 2 ? 0 : 1 + generator() % 100;
+		std::vector<std::vector<char>> buffers(count);
+		std::vector<oo_socket::incoming_datagram> batch;
+		std::vector<bool> expected;
+		for (size_t i = 0; i < count; i++) {
+			size_t payload_size = common_size != 0 ? common_size : 60 + generator() % 40;
+			if (generator() % 8 == 0) {
+				payload_size = generator() % 10;
+			}
+			buffers[i].resize(payload_size + MAC_TAG_SIZE);
+			for (char& byte : buffers[i]) {
+				byte = (char)generator();
+			}
+			size_t size = signer.sign(buffers[i].data(), payload_size);
+			if (generator() % 5 == 0) {
+				buffers[i][generator() % size] ^= 4;
+			}
+			if (generator() % 9 == 0) {
+				size = generator() % MAC_TAG_SIZE;
+			}
+			oo_socket::incoming_datagram datagram{};
+			datagram.buffer = buffers[i].data();
+			datagram.capacity = buffers[i].size();
+			datagram.size = size;
+			batch.push_back(datagram);
+			size_t checked = size;
+			expected.push_back(signer.verify(buffers[i].data(), checked));
+		}
+		std::vector<oo_socket::incoming_datagram> unchanged = batch;
+		bool authentic[64];
+		size_t verified = verifier.verify_batch(batch.data(), batch.size(), authentic);
+		REQUIRE(verified == (size_t)std::count(expected.begin(), expected.end(), true));
+		for (size_t i = 0; i < count; i++) {
+			REQUIRE(authentic[i] == expected[i]);
+			REQUIRE(batch[i].size == (expected[i] ? unchanged[i].size - MAC_TAG_SIZE : unchanged[i].size));
+		}
+	}
+}
+
+TEST_CASE("Check datagrams are verified over a channel.", "[mac][test]") {
+	oo_socket::udp::socket sender_socket(10112, "127.0.0.1");
+	oo_socket::udp::socket receiver_socket(10113, "127.0.0.1");
+	receiver_socket.set_socket_receive_timeout(200);
+	const oo_socket::socket_address sender_address = oo_socket::socket_address::parse("127.0.0.1", 10112);
+	const oo_socket::socket_address receiver_address = oo_socket::socket_address::parse("127.0.0.1", 10113);
+	const std::vector<uint8_t> key(MAC_KEY_SIZE, 9);
+	oo_socket::mac::channel sender(sender_socket, key);
+	oo_socket::mac::channel receiver(receiver_socket, key);
+
+	std::vector<std::string> payloads;
+	std::vector<oo_socket::outgoing_datagram> outgoing;
+	for (size_t i = 0; i < 10; i++) {
+		payloads.push_back("payload " + std::to_string(i) + std::string(i * 30, 'x'));
+	}
+	for (const std::string& payload : payloads) {
+		outgoing.push_back({payload.data(), payload.size()});
+	}
+	REQUIRE(sender.send_batch_to(outgoing, receiver_address) == 10);
+
+	std::vector<std::vector<char>> buffers(16, std::vector<char>(512));
+	std::vector<oo_socket::incoming_datagram> incoming;
+	for (std::vector<char>& buffer : buffers) {
+		oo_socket::incoming_datagram datagram{};
+		datagram.buffer = buffer.data();
+		datagram.capacity = buffer.size();
+		incoming.push_back(datagram);
+	}
+	REQUIRE(receiver.receive_batch(incoming) == 10);
+	for (size_t i = 0; i < 10; i++) {
+		REQUIRE(std::string(incoming[i].buffer, incoming[i].size) == payloads[i]);
+	}
+
+	SECTION("Unsigned and corrupt datagrams are dropped and counted for their source address.") {
+		oo_socket::udp::socket spoofer_socket(10114, "127.0.0.1");
+		REQUIRE(sender_socket.send_to("spoofed", 7, receiver_address) == 7);
+		REQUIRE(spoofer_socket.send_to("spoofed", 7, receiver_address) == 7);
+		char frame[64] = "corrupt";
+		const size_t size = oo_socket::mac::siphash(key).sign(frame, 7);
+		frame[0] ^= 1;
+		REQUIRE(sender_socket.send_to(frame, size, receiver_address) == (int)size);
+		REQUIRE(sender.send_to("hello", 5, receiver_address) == 5 + MAC_TAG_SIZE);
+
+		int received = 0;
+		std::vector<std::string> verified;
+		while ((received = receiver.receive_batch(incoming)) > 0) {
+			for (int i = 0; i < received; i++) {
+				verified.emplace_back(incoming[i].buffer, incoming[i].size);
+			}
+		}
+		REQUIRE(verified == std::vector<std::string>{"hello"});
+		// Every port of the address shares one count.
+		REQUIRE(receiver.get_failures() == 3);
+		REQUIRE(receiver.get_failures(sender_address) == 3);
+		REQUIRE(receiver.get_failures(receiver_address) == 3);
+		REQUIRE(receiver.get_failures(oo_socket::socket_address::parse("127.0.0.2", 10112)) == 0);
+		REQUIRE(receiver.get_failure_sources().size() == 1);
+
+		// A batch of nothing but forgeries returns 0 rather than waiting for an authentic datagram.
+		REQUIRE(sender_socket.send_to("spoofed", 7, receiver_address) == 7);
+		REQUIRE(sender.send_to("again", 5, receiver_address) == 5 + MAC_TAG_SIZE);
+		REQUIRE(receiver.receive_batch(incoming.data(), 1) == 0);
+		REQUIRE(receiver.get_failures() == 4);
+		REQUIRE(receiver.receive_batch(incoming.data(), 1) == 1);
+		REQUIRE(std::string(incoming[0].buffer, incoming[0].size) == "again");
+	}
+
+	SECTION("Failures without a source are counted under an empty address.") {
+		REQUIRE(sender_socket.send_to("spoofed", 7, receiver_address) == 7);
+		REQUIRE(sender.send_to("hello", 5, receiver_address) == 5 + MAC_TAG_SIZE);
+		REQUIRE(receiver.receive_batch(incoming, false) == 1);
+		REQUIRE(std::string(incoming[0].buffer, incoming[0].size) == "hello");
+		REQUIRE(receiver.get_failures() == 1);
+		REQUIRE(receiver.get_failures(oo_socket::socket_address()) == 1);
+	}
+}
+
+TEST_CASE("Benchmarking SipHash.", "[mac][benchmark]") {
+	const oo_socket::mac::siphash signer(std::vector<uint8_t>(MAC_KEY_SIZE, 7));
+	for (size_t payload_size : {64, 256, 1400}) {
+		std::vector<char> buffer(payload_size + MAC_TAG_SIZE, 'x');
+		const size_t signed_size = signer.sign(buffer.data(), payload_size);
+		BENCHMARK("Verifying " + std::to_string(payload_size) + " bytes.") {
+			size_t size = signed_size;
+			return signer.verify(buffer.data(), size);
+		};
+	}
+
+	std::vector<std::vector<char>> buffers(MAX_BATCH_SIZE, std::vector<char>(256 + MAC_TAG_SIZE, 'x'));
+	std::vector<oo_socket::incoming_datagram> batch;
+	for (std::vector<char>& buffer : buffers) {
+		oo_socket::incoming_datagram datagram{};
+		datagram.buffer = buffer.data();
+		datagram.capacity = buffer.size();
+		datagram.size = signer.sign(buffer.data(), 256);
+		batch.push_back(datagram);
+	}
+	bool authentic[MAX_BATCH_SIZE];
+	BENCHMARK("Verifying a batch of 64 datagrams of 256 bytes.") {
+		for (oo_socket::incoming_datagram& datagram : batch) {
+			datagram.size = 256 + MAC_TAG_SIZE;
+		}
+		return signer.verify_batch(batch.data(), batch.size(), authentic);
+	};
+}
@@ -0,0 +1,180 @@
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "prometheus.hpp"
+#include "statistics.hpp"
+#include "udp_socket.hpp"
+
+namespace {
+	/**
+	 * @brief 	Function connect_client opens a TCP connection to a local port.
+	 * @param 	port 	port to connect to.
+	 * @return 	int 	descriptor of the connection.
+	 */
+	int connect_client(unsigned short port) {
+		int client = ::socket(AF_INET, SOCK_STREAM, 0);
+		sockaddr_in address{};
+		address.sin_family = AF_INET;
+		address.sin_port = htons(port);
+		::inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+		REQUIRE(::connect(client, (sockaddr*)&address, sizeof(address)) == 0);
+		return client;
+	}
+
+	/**
+	 * @brief 	Function close_client closes a TCP connection.
+	 * @param 	client 	descriptor of the connection.
+	 */
+	void close_client(int client) {
+#ifdef _WIN32
+		::closesocket(client);
+#else
+		::close(client);
+#endif
+	}
+
+	/**
+	 * @brief 	Function fetch_metrics requests the metrics path and reads the whole response.
+	 * @param 	port 	port the exporter listens on.
+	 * @return 	std::string 	response including the status line and headers.
+	 */
+	std::string fetch_metrics(unsigned short port) {
+		int client = connect_client(port);
+		const char request[] = "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n";
+		REQUIRE(::send(client, request, sizeof(request) - 1, 0) > 0);
+		std::string response;
+		char chunk[4096];
+		int received;
+		while ((received = ::recv(client, chunk, sizeof(chunk), 0)) > 0) {
+			response.append(chunk, received);
+		}
+		close_client(client);
+		return response;
+	}
+}
+
+TEST_CASE("Check histogram buckets.", "[statistics::histogram][test]") {
+	oo_socket::statistics::histogram histogram;
+	histogram.observe(0);
+	histogram.observe(1);
+	histogram.observe(2);
+	histogram.observe(3);
+	histogram.observe(1500);
+
+	REQUIRE(histogram.get_count() == 5);
+	REQUIRE(histogram.get_sum() == 1506);
+	REQUIRE(histogram.bucket_count(0) == 2);
+	REQUIRE(histogram.bucket_count(1) == 1);
+	REQUIRE(histogram.bucket_count(2) == 1);
+	// 1500 is in (1024, 2048].
+	REQUIRE(histogram.bucket_count(11) == 1);
+}
+
+TEST_CASE("Check socket statistics are counted and rendered.", "[prometheus::exporter][test]") {
+	oo_socket::udp::socket s1(16666);
+	oo_socket::udp::socket s2;
+	s1.set_socket_receive_timeout(100);
+	s1.set_timing_enabled(true);
+
+	std::vector<char> buffer(100, 'T');
+	REQUIRE(s2.send_to(buffer, 16666) == 100);
+	REQUIRE(s1.receive().size() == 100);
+	REQUIRE(s1.receive().size() == 0);
+
+	auto statistics = s1.get_statistics();
+	REQUIRE(statistics->packets_received == 1);
+	REQUIRE(statistics->bytes_received == 100);
+	REQUIRE(statistics->receive_timeouts == 1);
+	REQUIRE(statistics->receive_duration_ns.get_count() == 1);
+	REQUIRE(s2.get_statistics()->packets_sent == 1);
+
+	oo_socket::prometheus::exporter exporter;
+	exporter.add_socket("receiver", s1);
+	exporter.add_socket("sender \"2\"", s2);
+
+	std::string output;
+	exporter.render(output);
+	REQUIRE(output.find("# TYPE oo_socket_packets_received_total counter") != std::string::npos);
+	REQUIRE(output.find("oo_socket_packets_received_total{socket=\"receiver\"} 1\n") != std::string::npos);
+	REQUIRE(output.find("oo_socket_bytes_sent_total{socket=\"sender \\\"2\\\"\"} 100\n") != std::string::npos);
+	REQUIRE(output.find("oo_socket_receive_size_bytes_bucket{socket=\"receiver\",le=\"128\"} 1\n") != std::string::npos);
+	REQUIRE(output.find("oo_socket_receive_size_bytes_bucket{socket=\"receiver\",le=\"+Inf\"} 1\n") != std::string::npos);
+	REQUIRE(output.find("oo_socket_receive_size_bytes_count{socket=\"receiver\"} 1\n") != std::string::npos);
+
+	exporter.remove_socket("receiver");
+	exporter.render(output);
+	REQUIRE(output.find("socket=\"receiver\"") == std::string::npos);
+}
+
+TEST_CASE("Check metrics are written to a file and served over HTTP.", "[prometheus::exporter][test]") {
+	oo_socket::udp::socket s1;
+	oo_socket::prometheus::exporter exporter;
+	exporter.add_socket("s1", s1);
+
+	SECTION("Write the metrics file.") {
+		exporter.write_file("test_metrics.prom");
+		std::ifstream file("test_metrics.prom");
+		std::stringstream contents;
+		contents << file.rdbuf();
+		REQUIRE(contents.str() == exporter.render());
+		std::remove("test_metrics.prom");
+	}
+
+	SECTION("Serve the metrics over HTTP.") {
+		unsigned short port = exporter.start_http_listener(0);
+		REQUIRE(port != 0);
+
+		const std::string response = fetch_metrics(port);
+		REQUIRE(response.rfind("HTTP/1.1 200 OK", 0) == 0);
+		REQUIRE(response.find("oo_socket_packets_sent_total{socket=\"s1\"} 0") != std::string::npos);
+		exporter.stop();
+	}
+
+	SECTION("A client that never sends a request is dropped.") {
+		unsigned short port = exporter.start_http_listener(0);
+		int silent = connect_client(port);
+		const auto start = std::chrono::steady_clock::now();
+		REQUIRE(fetch_metrics(port).rfind("HTTP/1.1 200 OK", 0) == 0);
+		exporter.stop();
+		REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(PROMETHEUS_CLIENT_TIMEOUT_MS * 3));
+		close_client(silent);
+	}
+
+	SECTION("Rewriting the metrics file replaces it in place.") {
+		exporter.write_file("test_metrics.prom");
+		s1.send_to("x", 1, 10000);
+		exporter.write_file("test_metrics.prom");
+		std::ifstream file("test_metrics.prom");
+		std::stringstream contents;
+		contents << file.rdbuf();
+		REQUIRE(contents.str().find("oo_socket_packets_sent_total{socket=\"s1\"} 1") != std::string::npos);
+		std::ifstream temporary("test_metrics.prom.tmp");
+		REQUIRE_FALSE(temporary.good());
+		std::remove("test_metrics.prom");
+	}
+}
+
+TEST_CASE("Check kernel diagnostics are exported for shared sockets.", "[prometheus::exporter][test]") {
+	auto s1 = std::make_shared<oo_socket::udp::socket>();
+	oo_socket::prometheus::exporter exporter;
+	exporter.add_socket("shared", s1);
+
+	// The receive buffer size is read from the kernel during rendering.
+	std::string output = exporter.render();
+	REQUIRE(output.find("# TYPE oo_socket_kernel_receive_buffer_bytes gauge") != std::string::npos);
+	REQUIRE(output.find("oo_socket_kernel_receive_buffer_bytes{socket=\"shared\"} 0\n") == std::string::npos);
+	REQUIRE(output.find("oo_socket_kernel_drops_total{socket=\"shared\"} 0\n") != std::string::npos);
+
+	// Destroying the socket leaves the last values exported.
+	s1.reset();
+	REQUIRE_NOTHROW(exporter.render());
+}
@@ -0,0 +1,47 @@
+#include <chrono>
+#include <thread>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark_all.hpp>
+#include <catch2/matchers/catch_matchers_all.hpp>
+
+#include "rate_limiter.hpp"
+
+TEST_CASE("Check token bucket bursts and refills.", "[rate_limiter::token_bucket][test]") {
+	oo_socket::token_bucket bucket(1000, 10);
+
+	SECTION("The bucket starts full and empties after the burst.") {
+		for (int i = 0; i < 10; i++) {
+			REQUIRE(bucket.try_consume());
+		}
+		REQUIRE_FALSE(bucket.try_consume());
+		REQUIRE(bucket.wait_time_ns() > 0);
+		REQUIRE(bucket.wait_time_ns() <= 1000000 + 1);
+	}
+
+	SECTION("The bucket refills at the configured rate.") {
+		REQUIRE(bucket.try_consume(10));
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		REQUIRE(bucket.try_consume(4));
+	}
+
+	SECTION("A rate of zero disables limiting.") {
+		bucket.set_rate(0);
+		for (int i = 0; i < 100; i++) {
+			REQUIRE(bucket.try_consume());
+		}
+		REQUIRE(bucket.wait_time_ns(1000) == 0);
+	}
+}
+
+TEST_CASE("Check token bucket paces blocking consumers.", "[rate_limiter::token_bucket][test]") {
+	oo_socket::token_bucket bucket(10000, 1);
+	const auto start = std::chrono::steady_clock::now();
+	// The first token is in the bucket, the other 100 take 10 ms to refill.
+	for (int i = 0; i < 101; i++) {
+		bucket.consume();
+	}
+	const double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	REQUIRE(elapsed_ms >= 9.5);
+	REQUIRE(elapsed_ms < 100);
+}
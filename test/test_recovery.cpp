@@ -0,0 +1,272 @@
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark_all.hpp>
+#include <catch2/matchers/catch_matchers_all.hpp>
+
+#include "recovery.hpp"
+
+namespace {
+	/**
+	 *	@struct	temporary_directory
+	 * 	@brief 	Struct temporary_directory removes a directory under the system temporary directory when destroyed.
+	 */
+	struct temporary_directory {
+		/// Path of the directory.
+		std::filesystem::path path;
+
+		/**
+		 * @brief 	Constructor for the temporary_directory struct which starts from an empty directory.
+		 * @param 	name 	name of the directory.
+		 */
+		explicit temporary_directory(const std::string& name) :
+			path(std::filesystem::temp_directory_path() / ("oo_socket_" + name))
+		{
+			std::filesystem::remove_all(path);
+		}
+
+		/**
+		 * 	@brief 	Destructor for the temporary_directory struct.
+		 */
+		~temporary_directory() {
+			std::error_code error;
+			std::filesystem::remove_all(path, error);
+		}
+	};
+
+	/**
+	 * @brief 	Function receive_all receives datagrams until the socket times out.
+	 * @param 	receiver 	socket to receive on, with a receive timeout set.
+	 * @param 	client 		client that tracks the datagrams.
+	 * @return 	std::vector<std::string> 	payloads the client accepted.
+	 */
+	std::vector<std::string> receive_all(oo_socket::udp::socket& receiver, oo_socket::recovery::recovery_client& client) {
+		std::vector<std::string> payloads;
+		char buffer[256];
+		int size;
+		while ((size = receiver.receive(buffer, sizeof(buffer))) > 0) {
+			if (client.accept(buffer, (size_t)size)) {
+				payloads.emplace_back(buffer + JOURNAL_SEQUENCE_SIZE, size - JOURNAL_SEQUENCE_SIZE);
+			}
+		}
+		return payloads;
+	}
+}
+
+TEST_CASE("Check gaps are tracked.", "[recovery][test]") {
+	oo_socket::recovery::gap_tracker tracker;
+	REQUIRE(tracker.observe(1));
+	REQUIRE(tracker.observe(2));
+	REQUIRE(tracker.observe(6));
+	REQUIRE(tracker.observe(10));
+	REQUIRE_FALSE(tracker.observe(6));
+	REQUIRE_FALSE(tracker.observe(0));
+	REQUIRE(tracker.missing() == std::vector<oo_socket::recovery::sequence_range>{{3, 5}, {7, 9}});
+	REQUIRE(tracker.missing_count() == 6);
+	REQUIRE(tracker.get_contiguous() == 2);
+
+	REQUIRE(tracker.observe(4));
+	REQUIRE_FALSE(tracker.observe(4));
+	REQUIRE(tracker.missing() == std::vector<oo_socket::recovery::sequence_range>{{3, 3}, {5, 5}, {7, 9}});
+	REQUIRE(tracker.observe(3));
+	REQUIRE(tracker.get_contiguous() == 4);
+	REQUIRE(tracker.missing(1) == std::vector<oo_socket::recovery::sequence_range>{{5, 5}});
+
+	SECTION("Giving up on a range closes the gaps in it.") {
+		REQUIRE(tracker.give_up({1, 8}) == 3);
+		REQUIRE(tracker.missing() == std::vector<oo_socket::recovery::sequence_range>{{9, 9}});
+		REQUIRE_FALSE(tracker.observe(7));
+		REQUIRE(tracker.get_given_up() == 3);
+		REQUIRE(tracker.get_contiguous() == 8);
+	}
+
+	SECTION("A tracker can start part way through a stream.") {
+		oo_socket::recovery::gap_tracker late(100);
+		REQUIRE_FALSE(late.observe(50));
+		REQUIRE(late.observe(102));
+		REQUIRE(late.missing() == std::vector<oo_socket::recovery::sequence_range>{{100, 101}});
+		REQUIRE(late.get_contiguous() == 99);
+	}
+}
+
+TEST_CASE("Check recovery messages round trip.", "[recovery][test]") {
+	const std::vector<oo_socket::recovery::sequence_range> ranges = {{1, 1}, {5, 90}, {1ULL << 40, (1ULL << 40) + 3}};
+	char buffer[RECOVERY_REQUEST_HEADER_SIZE + RECOVERY_MAX_RANGES * RECOVERY_RANGE_SIZE];
+	const size_t size = oo_socket::recovery::write_request(ranges.data(), ranges.size(), buffer);
+	REQUIRE(size == RECOVERY_REQUEST_HEADER_SIZE + 3 * RECOVERY_RANGE_SIZE);
+	std::vector<oo_socket::recovery::sequence_range> decoded;
+	REQUIRE(oo_socket::recovery::read_request(buffer, size, decoded));
+	REQUIRE(decoded == ranges);
+	REQUIRE_FALSE(oo_socket::recovery::read_request(buffer, size - 1, decoded));
+	buffer[0] = 0;
+	REQUIRE_FALSE(oo_socket::recovery::read_request(buffer, size, decoded));
+
+	// Backwards ranges and sequence 0 are never valid.
+	const std::vector<oo_socket::recovery::sequence_range> backwards = {{9, 3}};
+	oo_socket::recovery::write_request(backwards.data(), backwards.size(), buffer);
+	REQUIRE_FALSE(oo_socket::recovery::read_request(buffer, RECOVERY_REQUEST_HEADER_SIZE + RECOVERY_RANGE_SIZE, decoded));
+	const std::vector<oo_socket::recovery::sequence_range> too_many(RECOVERY_MAX_RANGES + 1, {1, 1});
+	REQUIRE_THROWS_AS(oo_socket::recovery::write_request(too_many.data(), too_many.size(), buffer), oo_socket::errors::encode_error);
+
+	char notice[RECOVERY_NOTICE_SIZE];
+	oo_socket::recovery::write_notice({3, 7}, notice);
+	oo_socket::recovery::sequence_range unavailable{0, 0};
+	REQUIRE(oo_socket::recovery::read_notice(notice, sizeof(notice), unavailable));
+	REQUIRE(unavailable == oo_socket::recovery::sequence_range{3, 7});
+	REQUIRE_FALSE(oo_socket::recovery::read_notice(notice, sizeof(notice) - 1, unavailable));
+}
+
+TEST_CASE("Check lost datagrams are recovered from the journal.", "[recovery][test]") {
+	temporary_directory directory("recovery");
+	oo_socket::journal::journal_options options;
+	options.segment_size = 4096;
+
+	// Live stream from 16667 to 16666, recovery between 16668 and 16669.
+	oo_socket::udp::socket live_sender(16667, "127.0.0.1");
+	oo_socket::udp::socket live_receiver(16666, "127.0.0.1");
+	oo_socket::udp::socket server_socket(16668, "127.0.0.1");
+	oo_socket::udp::socket client_socket(16669, "127.0.0.1");
+	live_receiver.set_socket_receive_timeout(200);
+	server_socket.set_socket_receive_timeout(200);
+	client_socket.set_socket_receive_timeout(200);
+	const oo_socket::socket_address live_address = oo_socket::socket_address::parse("127.0.0.1", 16666);
+	const oo_socket::socket_address server_address = oo_socket::socket_address::parse("127.0.0.1", 16668);
+	const oo_socket::socket_address client_address = oo_socket::socket_address::parse("127.0.0.1", 16669);
+
+	oo_socket::journal::outbound_journal journal(live_sender, live_address, directory.path.string(), options);
+	oo_socket::recovery::recovery_client client(client_socket, server_address);
+	// Two datagrams a second with a burst of three, so one service call sends at most three datagrams.
+	oo_socket::recovery::recovery_server server(server_socket, journal.get_log(), 2, 3);
+
+	// Send 1 to 20 but lose 5 to 8 and 12 on the way.
+	for (uint64_t sequence = 1; sequence <= 20; sequence++) {
+		const std::string payload = "payload " + std::to_string(sequence);
+		if ((sequence >= 5 && sequence <= 8) || sequence == 12) {
+			// Journaled but never sent, as if lost.
+			journal.get_log().append(payload.data(), payload.size());
+			continue;
+		}
+		journal.send(payload.data(), payload.size());
+	}
+	REQUIRE(receive_all(live_receiver, client).size() == 15);
+	REQUIRE(client.get_tracker().missing_count() == 5);
+
+	// The request arrives at the server, which sends a rate limited batch per call.
+	REQUIRE(client.request() == 2);
+	std::vector<char> buffer(512);
+	std::vector<oo_socket::incoming_datagram> incoming(1);
+	incoming[0].buffer = buffer.data();
+	incoming[0].capacity = buffer.size();
+	REQUIRE(server_socket.receive_batch(incoming, true) == 1);
+	REQUIRE(server.handle(incoming[0]));
+	REQUIRE(server.get_pending() == 2);
+	REQUIRE(server.service() == 3);
+	std::vector<std::string> recovered = receive_all(client_socket, client);
+	REQUIRE(recovered == std::vector<std::string>{"payload 5", "payload 6", "payload 7"});
+	REQUIRE(server.service() == 0);
+
+	// A repeated request overlapping what is pending is merged rather than sent twice.
+	client.request();
+	REQUIRE(server_socket.receive_batch(incoming, true) == 1);
+	REQUIRE(server.handle(incoming[0]));
+	REQUIRE(server.get_pending() == 2);
+	for (int attempt = 0; attempt < 50 && client.get_tracker().missing_count() > 0; attempt++) {
+		server.service();
+		for (const std::string& payload : receive_all(client_socket, client)) {
+			recovered.push_back(payload);
+		}
+	}
+	// The unfinished range 5 to 8 went behind 12 after its first turn, so 12 is sent before 8.
+	REQUIRE(recovered == std::vector<std::string>{"payload 5", "payload 6", "payload 7", "payload 12", "payload 8"});
+	REQUIRE(server.get_retransmitted() == 5);
+	REQUIRE(server.get_pending() == 0);
+	REQUIRE(client.get_tracker().get_contiguous() == 20);
+
+	SECTION("Ranges no longer journaled are given up on.") {
+		// Fill more segments so acknowledging deletes the oldest one.
+		for (uint64_t sequence = 21; sequence <= 300; sequence++) {
+			journal.get_log().append("filler", 6);
+		}
+		journal.acknowledge(250);
+		const uint64_t first_kept = journal.get_log().first_sequence();
+		REQUIRE(first_kept > 1);
+		REQUIRE(first_kept <= 251);
+
+		oo_socket::recovery::recovery_server unlimited(server_socket, journal.get_log(), 0, 1);
+		const std::vector<oo_socket::recovery::sequence_range> old = {{1, first_kept + 1}};
+		char request[RECOVERY_REQUEST_HEADER_SIZE + RECOVERY_RANGE_SIZE];
+		REQUIRE(unlimited.handle(request, oo_socket::recovery::write_request(old.data(), old.size(), request), client_address));
+		REQUIRE(unlimited.service() == 3);
+		oo_socket::recovery::recovery_client fresh(client_socket, server_address);
+		REQUIRE(receive_all(client_socket, fresh) == std::vector<std::string>{"filler", "filler"});
+		REQUIRE(unlimited.get_unavailable() == 1);
+		REQUIRE(unlimited.get_pending() == 0);
+		REQUIRE(fresh.get_tracker().get_given_up() == first_kept - 1);
+		REQUIRE(fresh.get_tracker().get_contiguous() == first_kept + 1);
+	}
+
+	SECTION("Datagrams that are not requests are ignored.") {
+		REQUIRE_FALSE(server.handle("hello", 5, client_address));
+		REQUIRE(server.get_pending() == 0);
+	}
+}
+
+TEST_CASE("Check a range larger than a batch is recovered in order.", "[recovery][test]") {
+	temporary_directory directory("recovery_batches");
+	oo_socket::journal::journal_options options;
+	options.segment_size = 1 << 20;
+	oo_socket::journal::segmented_log log(directory.path.string(), options);
+	for (uint64_t sequence = 1; sequence <= 300; sequence++) {
+		const std::string payload = "payload " + std::to_string(sequence);
+		log.append(payload.data(), payload.size());
+	}
+
+	oo_socket::udp::socket server_socket(16670, "127.0.0.1");
+	oo_socket::udp::socket client_socket(16671, "127.0.0.1");
+	client_socket.set_socket_receive_timeout(200);
+	const oo_socket::socket_address client_address = oo_socket::socket_address::parse("127.0.0.1", 16671);
+	oo_socket::recovery::recovery_server server(server_socket, log, 0, 1);
+
+	// 20 to 280 takes five batches, each continuing in the segment where the one before stopped.
+	const std::vector<oo_socket::recovery::sequence_range> ranges = {{20, 280}};
+	char request[RECOVERY_REQUEST_HEADER_SIZE + RECOVERY_RANGE_SIZE];
+	REQUIRE(server.handle(request, oo_socket::recovery::write_request(ranges.data(), ranges.size(), request), client_address));
+	std::vector<uint64_t> sequences;
+	char buffer[256];
+	for (size_t batch = 0; batch < 5; batch++) {
+		REQUIRE(server.service() == std::min<size_t>(MAX_BATCH_SIZE, 281 - sequences.size() - 20));
+		int size;
+		while ((size = client_socket.receive(buffer, sizeof(buffer))) > 0) {
+			const uint64_t sequence = oo_socket::byte_order::read_network<uint64_t>(buffer);
+			REQUIRE(std::string(buffer + JOURNAL_SEQUENCE_SIZE, size - JOURNAL_SEQUENCE_SIZE) == "payload " + std::to_string(sequence));
+			sequences.push_back(sequence);
+		}
+	}
+	std::vector<uint64_t> expected;
+	for (uint64_t sequence = 20; sequence <= 280; sequence++) {
+		expected.push_back(sequence);
+	}
+	REQUIRE(sequences == expected);
+	REQUIRE(server.get_retransmitted() == 261);
+	REQUIRE(server.get_pending() == 0);
+	REQUIRE(server.service() == 0);
+}
+
+TEST_CASE("Benchmarking recovery.", "[recovery][benchmark]") {
+	oo_socket::recovery::gap_tracker tracker;
+	uint64_t sequence = 0;
+	BENCHMARK("Tracking an in order sequence number.") {
+		return tracker.observe(++sequence);
+	};
+	oo_socket::recovery::gap_tracker gaps;
+	uint64_t filled = 0;
+	BENCHMARK("Opening and filling a gap.") {
+		gaps.observe(filled + 2);
+		gaps.observe(filled + 1);
+		filled += 2;
+		return gaps.missing_count();
+	};
+}
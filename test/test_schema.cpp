@@ -0,0 +1,291 @@
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark_all.hpp>
+#include <catch2/matchers/catch_matchers_all.hpp>
+
+#include "schema.hpp"
+#include "udp_socket.hpp"
+
+namespace
+{
+	enum class vehicle_state : uint8_t {PARKED, DRIVING, FAULT};
+
+	struct vehicle_update {
+		uint32_t id;
+		uint64_t sequence;
+		int32_t velocity;
+		vehicle_state state;
+		std::array<float, 3> position;
+		std::vector<int16_t> samples;
+		std::string name;
+		double heading;
+	};
+
+	using vehicle_schema = oo_socket::schema::message<
+		oo_socket::schema::fixed<&vehicle_update::id>,
+		oo_socket::schema::varint<&vehicle_update::sequence>,
+		oo_socket::schema::zigzag<&vehicle_update::velocity>,
+		oo_socket::schema::fixed<&vehicle_update::state>,
+		oo_socket::schema::fixed<&vehicle_update::position>,
+		oo_socket::schema::repeated<&vehicle_update::samples>,
+		oo_socket::schema::bytes<&vehicle_update::name>,
+		oo_socket::schema::fixed<&vehicle_update::heading>
+	>;
+
+	struct heartbeat {
+		uint16_t node;
+		uint32_t uptime;
+	};
+
+	using heartbeat_schema = oo_socket::schema::message<
+		oo_socket::schema::fixed<&heartbeat::node>,
+		oo_socket::schema::fixed<&heartbeat::uptime>
+	>;
+
+	struct wheel {
+		uint8_t index;
+		float pressure;
+		std::vector<uint16_t> temperatures;
+	};
+
+	using wheel_schema = oo_socket::schema::message<
+		oo_socket::schema::fixed<&wheel::index>,
+		oo_socket::schema::fixed<&wheel::pressure>,
+		oo_socket::schema::repeated<&wheel::temperatures>
+	>;
+
+	struct fleet_report {
+		uint32_t fleet;
+		vehicle_update lead;
+		std::vector<wheel> wheels;
+		std::string note;
+	};
+
+	using fleet_schema = oo_socket::schema::message<
+		oo_socket::schema::fixed<&fleet_report::fleet>,
+		oo_socket::schema::nested<&fleet_report::lead, vehicle_schema>,
+		oo_socket::schema::repeated<&fleet_report::wheels, wheel_schema>,
+		oo_socket::schema::bytes<&fleet_report::note>
+	>;
+
+	fleet_report make_report() {
+		fleet_report report{9, {7, 300, -5, vehicle_state::DRIVING, {1, 2, 3}, {4, 5}, "lead", 12.5}, {}, "all good"};
+		for (uint8_t i = 0; i < 4; i++) {
+			report.wheels.push_back({i, 2.0f + i, std::vector<uint16_t>(i + 1, (uint16_t)(70 + i))});
+		}
+		return report;
+	}
+}
+
+// Fixed fields are packed first, so their offsets skip the variable fields declared between them.
+static_assert(vehicle_schema::FIXED_SIZE == 4 + 1 + 12 + 8, "fixed block holds every fixed field");
+static_assert(vehicle_schema::offset<0>() == 0, "first fixed field starts the encoding");
+static_assert(vehicle_schema::offset<3>() == 4, "state follows id");
+static_assert(vehicle_schema::offset<4>() == 5, "position follows state");
+static_assert(vehicle_schema::offset<7>() == 17, "heading follows position");
+static_assert(!vehicle_schema::IS_FIXED, "varints make the message variable");
+static_assert(heartbeat_schema::IS_FIXED && heartbeat_schema::FIXED_SIZE == 6, "fixed messages have a constant size");
+
+static_assert(oo_socket::schema::zigzag_encode(-1) == 1 && oo_socket::schema::zigzag_encode(1) == 2, "zigzag interleaves signs");
+static_assert(oo_socket::schema::zigzag_decode(oo_socket::schema::zigzag_encode(-123456789)) == -123456789, "zigzag round trips");
+static_assert(oo_socket::schema::varint_size(127) == 1 && oo_socket::schema::varint_size(128) == 2, "varints hold 7 bits per byte");
+static_assert(oo_socket::schema::varint_size(UINT64_MAX) == 10, "largest varint is 10 bytes");
+
+TEST_CASE("Check messages round trip through a schema.", "[schema][test]") {
+	vehicle_update update{7, 300, -5, vehicle_state::DRIVING, {1.5f, -2.25f, 1e6f}, {1, -1, 32767, -32768}, "truck", 270.5};
+
+	std::vector<char> buffer;
+	const size_t size = vehicle_schema::encode(update, buffer);
+	// Fixed block, 2 byte varint, 1 byte zigzag, 1 byte count and 4 samples, 1 byte length and 5 characters.
+	REQUIRE(size == vehicle_schema::FIXED_SIZE + 2 + 1 + 1 + 8 + 1 + 5);
+	REQUIRE(size == vehicle_schema::encoded_size(update));
+	REQUIRE(buffer.size() == size);
+
+	// The id is written in network byte order at offset 0.
+	REQUIRE(buffer[3] == 7);
+	REQUIRE(vehicle_schema::read<0>(buffer.data(), buffer.size()) == 7);
+	REQUIRE(vehicle_schema::read<7>(buffer.data(), buffer.size()) == 270.5);
+
+	vehicle_update decoded{};
+	decoded.samples = {9, 9, 9, 9, 9, 9};
+	REQUIRE(vehicle_schema::decode(buffer, decoded) == size);
+	REQUIRE(decoded.id == update.id);
+	REQUIRE(decoded.sequence == update.sequence);
+	REQUIRE(decoded.velocity == update.velocity);
+	REQUIRE(decoded.state == update.state);
+	REQUIRE(decoded.position == update.position);
+	REQUIRE(decoded.samples == update.samples);
+	REQUIRE(decoded.name == update.name);
+	REQUIRE(decoded.heading == update.heading);
+}
+
+TEST_CASE("Check fixed messages encode into caller buffers.", "[schema][test]") {
+	heartbeat beat{0x0102, 0x03040506};
+	char buffer[heartbeat_schema::FIXED_SIZE];
+	REQUIRE(heartbeat_schema::encode(beat, buffer, sizeof(buffer)) == 6);
+	const char expected[] = {1, 2, 3, 4, 5, 6};
+	REQUIRE(::memcmp(buffer, expected, sizeof(expected)) == 0);
+	REQUIRE_THROWS_AS(heartbeat_schema::encode(beat, buffer, 5), oo_socket::errors::encode_error);
+
+	heartbeat decoded{};
+	REQUIRE(heartbeat_schema::decode(buffer, sizeof(buffer), decoded) == 6);
+	REQUIRE(decoded.node == beat.node);
+	REQUIRE(decoded.uptime == beat.uptime);
+}
+
+TEST_CASE("Check malformed messages are rejected.", "[schema][test]") {
+	vehicle_update update{1, UINT64_MAX, INT32_MIN, vehicle_state::FAULT, {}, std::vector<int16_t>(100, 3), std::string(200, 'x'), 0};
+	std::vector<char> buffer;
+	const size_t size = vehicle_schema::encode(update, buffer);
+
+	// Every truncation of the message must be detected rather than read past the end.
+	vehicle_update decoded{};
+	for (size_t length = 0; length < size; length++) {
+		REQUIRE_THROWS_AS(vehicle_schema::decode(buffer.data(), length, decoded), oo_socket::errors::decode_error);
+	}
+	REQUIRE(vehicle_schema::decode(buffer, decoded) == size);
+	REQUIRE(decoded.sequence == UINT64_MAX);
+	REQUIRE(decoded.velocity == INT32_MIN);
+
+	// A count larger than the buffer must not allocate.
+	std::vector<char> corrupt(buffer.begin(), buffer.begin() + vehicle_schema::FIXED_SIZE + 10 + 5);
+	corrupt.insert(corrupt.end(), {(char)0xff, (char)0xff, (char)0xff, (char)0xff, 0x0f});
+	REQUIRE_THROWS_AS(vehicle_schema::decode(corrupt, decoded), oo_socket::errors::decode_error);
+
+	// A varint larger than its member is rejected.
+	struct small {
+		uint8_t value;
+	};
+	using small_schema = oo_socket::schema::message<oo_socket::schema::varint<&small::value>>;
+	const char large[] = {(char)0x80, 0x02};
+	small decoded_small{};
+	REQUIRE_THROWS_AS(small_schema::decode(large, sizeof(large), decoded_small), oo_socket::errors::decode_error);
+}
+
+TEST_CASE("Check messages are sent and received through a socket.", "[schema][test]") {
+	std::shared_ptr<oo_socket::udp::socket> s1;
+	std::shared_ptr<oo_socket::udp::socket> s2;
+	REQUIRE_NOTHROW(s1 = std::make_shared<oo_socket::udp::socket>(16666));
+	REQUIRE_NOTHROW(s2 = std::make_shared<oo_socket::udp::socket>());
+	REQUIRE_NOTHROW(s1->set_socket_receive_timeout(1000));
+
+	vehicle_update update{42, 1, 3, vehicle_state::PARKED, {0, 1, 2}, {5}, "car", 90};
+	std::vector<char> send_buffer;
+	vehicle_schema::encode(update, send_buffer);
+	REQUIRE(s2->send_to(send_buffer, 16666) == (int)send_buffer.size());
+
+	std::vector<char> receive_buffer = s1->receive();
+	vehicle_update decoded{};
+	REQUIRE(vehicle_schema::decode(receive_buffer, decoded) == send_buffer.size());
+	REQUIRE(decoded.id == 42);
+	REQUIRE(decoded.name == "car");
+}
+
+TEST_CASE("Check nested messages round trip through a schema.", "[schema][test]") {
+	const fleet_report report = make_report();
+	std::vector<char> buffer;
+	REQUIRE(fleet_schema::encode(report, buffer) == fleet_schema::encoded_size(report));
+
+	fleet_report decoded{};
+	REQUIRE(fleet_schema::decode(buffer, decoded) == buffer.size());
+	REQUIRE(decoded.fleet == 9);
+	REQUIRE(decoded.lead.name == "lead");
+	REQUIRE(decoded.lead.samples == report.lead.samples);
+	REQUIRE(decoded.wheels.size() == 4);
+	for (size_t i = 0; i < decoded.wheels.size(); i++) {
+		REQUIRE(decoded.wheels[i].index == report.wheels[i].index);
+		REQUIRE(decoded.wheels[i].pressure == report.wheels[i].pressure);
+		REQUIRE(decoded.wheels[i].temperatures == report.wheels[i].temperatures);
+	}
+	REQUIRE(decoded.note == "all good");
+}
+
+TEST_CASE("Check fields are read lazily through views.", "[schema][test][view]") {
+	const fleet_report report = make_report();
+	std::vector<char> buffer;
+	fleet_schema::encode(report, buffer);
+
+	SECTION("Reading single fields.") {
+		auto view = fleet_schema::view(buffer);
+		REQUIRE(view.get<0>() == 9);
+		// The note is found by skipping the nested message and the wheels using their lengths.
+		REQUIRE(view.get<3>() == "all good");
+
+		auto lead = view.get<1>();
+		REQUIRE(lead.get<0>() == 7);
+		REQUIRE(lead.get<2>() == -5);
+		REQUIRE(lead.get<6>() == "lead");
+		REQUIRE(lead.get<7>() == 12.5);
+		oo_socket::schema::array_view<int16_t> samples = lead.get<5>();
+		REQUIRE(samples.size() == 2);
+		REQUIRE(samples[1] == 5);
+		REQUIRE_THROWS_AS(samples.at(2), oo_socket::errors::decode_error);
+	}
+
+	SECTION("Iterating over repeated nested messages.") {
+		auto wheels = fleet_schema::view(buffer).get<2>();
+		REQUIRE(wheels.size() == 4);
+		size_t index = 0;
+		for (auto wheel_view : wheels) {
+			REQUIRE(wheel_view.get<0>() == index);
+			REQUIRE(wheel_view.get<1>() == 2.0f + index);
+			oo_socket::schema::array_view<uint16_t> temperatures = wheel_view.get<2>();
+			REQUIRE(temperatures.size() == index + 1);
+			for (uint16_t temperature : temperatures) {
+				REQUIRE(temperature == 70 + index);
+			}
+			index++;
+		}
+		REQUIRE(index == 4);
+		REQUIRE(wheels.at(3).get<1>() == 5.0f);
+		REQUIRE_THROWS_AS(wheels.at(4), oo_socket::errors::decode_error);
+
+		wheel decoded{};
+		wheels.at(2).decode(decoded);
+		REQUIRE(decoded.temperatures == report.wheels[2].temperatures);
+	}
+
+	SECTION("Reading truncated messages.") {
+		// Every read from a truncated buffer either succeeds or throws, and never reads past the end.
+		for (size_t length = 0; length < buffer.size(); length++) {
+			std::vector<char> truncated(buffer.begin(), buffer.begin() + length);
+			try {
+				auto view = fleet_schema::view(truncated);
+				REQUIRE(view.get<0>() == 9);
+				REQUIRE(view.get<1>().get<6>() == "lead");
+				for (auto wheel_view : view.get<2>()) {
+					wheel_view.get<2>().at(0);
+				}
+				REQUIRE(view.get<3>().size() <= 8);
+			}
+			catch (const oo_socket::errors::decode_error&) {
+			}
+		}
+		REQUIRE_THROWS_AS(fleet_schema::view(buffer.data(), 3), oo_socket::errors::decode_error);
+	}
+}
+
+TEST_CASE("Benchmarking schema.", "[schema][benchmark]") {
+	vehicle_update update{7, 300, -5, vehicle_state::DRIVING, {1.5f, -2.25f, 1e6f}, std::vector<int16_t>(64, 3), "truck", 270.5};
+	std::vector<char> buffer;
+	vehicle_schema::encode(update, buffer);
+	vehicle_update decoded{};
+
+	BENCHMARK("Encoding a message with 64 samples.") {
+		return vehicle_schema::encode(update, buffer);
+	};
+	BENCHMARK("Decoding a message with 64 samples.") {
+		return vehicle_schema::decode(buffer, decoded);
+	};
+	BENCHMARK("Reading one fixed field.") {
+		return vehicle_schema::read<7>(buffer.data(), buffer.size());
+	};
+	BENCHMARK("Reading one variable field through a view.") {
+		return vehicle_schema::view(buffer).get<6>().size();
+	};
+}
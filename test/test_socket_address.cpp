@@ -0,0 +1,46 @@
+#include <string>
+#include <unordered_set>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark_all.hpp>
+#include <catch2/matchers/catch_matchers_all.hpp>
+
+#include "socket_address.hpp"
+
+TEST_CASE("Check parsing and formatting socket addresses.", "[socket_address][test]") {
+	oo_socket::socket_address ipv4 = oo_socket::socket_address::parse("10.0.0.1", 5000);
+	REQUIRE(ipv4.family() == AF_INET);
+	REQUIRE(ipv4.port() == 5000);
+	REQUIRE(ipv4.length() == sizeof(sockaddr_in));
+	REQUIRE(ipv4.to_string() == "10.0.0.1:5000");
+
+	oo_socket::socket_address ipv6 = oo_socket::socket_address::parse("2001:db8::1", 5000);
+	REQUIRE(ipv6.family() == AF_INET6);
+	REQUIRE(ipv6.port() == 5000);
+	REQUIRE(ipv6.length() == sizeof(sockaddr_in6));
+	REQUIRE(ipv6.to_string() == "[2001:db8::1]:5000");
+
+	REQUIRE_THROWS_AS(oo_socket::socket_address::parse("10.0.0.256", 5000), oo_socket::errors::configuration_error);
+	REQUIRE_THROWS_AS(oo_socket::socket_address::parse("2001:db8::g", 5000), oo_socket::errors::configuration_error);
+
+	using namespace oo_socket::literals;
+	REQUIRE(oo_socket::socket_address("10.0.0.1:5000"_ep) == ipv4);
+}
+
+TEST_CASE("Check IPv4 mapped socket addresses.", "[socket_address][test]") {
+	oo_socket::socket_address ipv4 = oo_socket::socket_address::parse("192.168.1.2", 80);
+	oo_socket::socket_address mapped = ipv4.to_ipv6_mapped();
+	REQUIRE(mapped.family() == AF_INET6);
+	REQUIRE(mapped.is_ipv4_mapped());
+	REQUIRE(mapped.port() == 80);
+	REQUIRE(mapped.address_string() == "192.168.1.2");
+	REQUIRE(mapped == oo_socket::socket_address::parse("::ffff:192.168.1.2", 80));
+	REQUIRE(mapped.to_ipv4() == ipv4);
+	REQUIRE_FALSE(oo_socket::socket_address::parse("::1", 80).is_ipv4_mapped());
+
+	// Mapped and plain forms hash to the same bucket once normalised.
+	std::unordered_set<oo_socket::socket_address, oo_socket::socket_address::hash> addresses;
+	addresses.insert(ipv4);
+	REQUIRE(addresses.count(mapped.to_ipv4()) == 1);
+	REQUIRE(addresses.count(oo_socket::socket_address::parse("192.168.1.2", 81)) == 0);
+}
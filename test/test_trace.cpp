@@ -0,0 +1,136 @@
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "ring_buffer.hpp"
+#include "trace.hpp"
+#include "udp_socket.hpp"
+
+TEST_CASE("Check ring buffer push and pop.", "[ring_buffer][test]") {
+	oo_socket::ring_buffer<int> buffer(3);
+	int value;
+
+	// Capacity is rounded up to a power of two.
+	REQUIRE(buffer.capacity() == 4);
+	REQUIRE_FALSE(buffer.pop(value));
+
+	for (int i = 0; i < 4; i++) {
+		REQUIRE(buffer.push(i));
+	}
+	REQUIRE_FALSE(buffer.push(4));
+	REQUIRE(buffer.size() == 4);
+
+	// Elements come out in order and indices wrap around the storage.
+	for (int round = 0; round < 3; round++) {
+		REQUIRE(buffer.pop(value));
+		REQUIRE(value == round);
+		REQUIRE(buffer.push(4 + round));
+	}
+	for (int expected = 3; expected < 7; expected++) {
+		REQUIRE(buffer.pop(value));
+		REQUIRE(value == expected);
+	}
+	REQUIRE_FALSE(buffer.pop(value));
+}
+
+TEST_CASE("Check tracer records events from multiple threads.", "[trace::tracer][test]") {
+	oo_socket::trace::tracer tracer(4);
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 2; t++) {
+		threads.emplace_back([&tracer]() {
+			for (int i = 0; i < 5; i++) {
+				tracer.record(oo_socket::trace::event{oo_socket::trace::event_type::SEND, oo_socket::trace::now_ns(), 10, 256, 1, 0, 3});
+			}
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+
+	// Each thread has a buffer of four so one event per thread is dropped.
+	REQUIRE(tracer.dropped_events() == 2);
+
+	std::stringstream json;
+	tracer.write_chrome_json(json);
+	std::string output = json.str();
+	REQUIRE(output.find("\"traceEvents\"") != std::string::npos);
+	REQUIRE(output.find("\"tid\":1") != std::string::npos);
+
+	size_t send_events = 0;
+	for (size_t position = output.find("\"name\":\"send\""); position != std::string::npos; position = output.find("\"name\":\"send\"", position + 1)) {
+		send_events++;
+	}
+	REQUIRE(send_events == 8);
+
+	// Writing drains the buffers so a second trace has no events.
+	std::stringstream empty;
+	tracer.write_chrome_json(empty);
+	REQUIRE(empty.str().find("\"name\":\"send\"") == std::string::npos);
+}
+
+TEST_CASE("Check a thread keeps one buffer per tracer when it alternates between tracers.", "[trace::tracer][test]") {
+	oo_socket::trace::tracer first(16);
+	oo_socket::trace::tracer second(16);
+	for (int i = 0; i < 10; i++) {
+		first.record(oo_socket::trace::event{oo_socket::trace::event_type::SEND, oo_socket::trace::now_ns(), 10, 256, 1, 0, 3});
+		second.record(oo_socket::trace::event{oo_socket::trace::event_type::RECEIVE, oo_socket::trace::now_ns(), 10, 256, 1, 0, 3});
+		// Enough other tracers to overflow the thread's cache, so the buffers are also found again through the registry.
+		if (i == 5) {
+			for (int other = 0; other < TRACE_THREAD_CACHE_SIZE; other++) {
+				oo_socket::trace::tracer(1).record(oo_socket::trace::event{oo_socket::trace::event_type::SEND, 0, 0, 0, 0, 0, 0});
+			}
+		}
+	}
+	REQUIRE(first.dropped_events() == 0);
+	REQUIRE(second.dropped_events() == 0);
+
+	for (oo_socket::trace::tracer* checked : {&first, &second}) {
+		std::stringstream json;
+		checked->write_chrome_json(json);
+		const std::string output = json.str();
+		size_t threads = 0;
+		for (size_t position = output.find("thread_name"); position != std::string::npos; position = output.find("thread_name", position + 1)) {
+			threads++;
+		}
+		size_t events = 0;
+		for (size_t position = output.find("\"ph\":\"X\""); position != std::string::npos; position = output.find("\"ph\":\"X\"", position + 1)) {
+			events++;
+		}
+		REQUIRE(threads == 1);
+		REQUIRE(events == 10);
+	}
+}
+
+TEST_CASE("Check socket operations are traced.", "[socket::udp::socket][trace::tracer][test]") {
+	auto tracer = std::make_shared<oo_socket::trace::tracer>();
+	oo_socket::udp::socket s1(16666);
+	oo_socket::udp::socket s2;
+	s1.set_tracer(tracer);
+	s2.set_tracer(tracer);
+	s1.set_socket_receive_timeout(100);
+
+	std::vector<char> buffer(64, 'T');
+	REQUIRE(s2.send_to(buffer, 16666) == 64);
+	REQUIRE(s1.receive().size() == 64);
+	REQUIRE(s1.receive().size() == 0);
+
+	std::stringstream json;
+	tracer->write_chrome_json(json);
+	REQUIRE(json.str().find("\"name\":\"send\"") != std::string::npos);
+	REQUIRE(json.str().find("\"name\":\"receive\"") != std::string::npos);
+	REQUIRE(json.str().find("\"name\":\"wait\"") != std::string::npos);
+
+	s1.set_socket_receive_timeout(0);
+	REQUIRE(s2.send_to(buffer, 16666) == 64);
+	REQUIRE(s1.receive().size() == 64);
+
+	std::stringstream perfetto;
+	tracer->write_perfetto(perfetto);
+	REQUIRE(perfetto.str().size() > 0);
+	REQUIRE(perfetto.str().find("receive") != std::string::npos);
+}
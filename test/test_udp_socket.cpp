@@ -132,7 +132,491 @@ TEST_CASE("Check configuring the remote host.", "[socket::udp::socket][test]") {
 		REQUIRE(std::string(s1->receive().data()).compare("hello world!") == 0);
 		send_thread.join();
 	}
+
+	SECTION("Configure the remote host with an endpoint literal.") {
+		using namespace oo_socket::literals;
+		REQUIRE_NOTHROW(s2->configure_remote_host("127.0.0.1:16666"_ep));
+		std::vector<char> buffer = {'h', 'e', 'l', 'l', 'o', ' ', 'w', 'o', 'r', 'l', 'd', '!', '\0'};
+		REQUIRE(s2->send(buffer) == 13);
+		REQUIRE(std::string(s1->receive().data()).compare("hello world!") == 0);
+	}
+
+	SECTION("Send to an endpoint literal.") {
+		using namespace oo_socket::literals;
+		constexpr oo_socket::ipv4_endpoint destination = "127.0.0.1:16666"_ep;
+		char buffer[] = "hello world!";
+		REQUIRE(s2->send_to(buffer, sizeof(buffer), destination) == 13);
+		REQUIRE(std::string(s1->receive().data()).compare("hello world!") == 0);
+		std::vector<oo_socket::outgoing_datagram> batch = {{buffer, sizeof(buffer)}, {buffer, sizeof(buffer)}};
+		REQUIRE(s2->send_batch_to(batch, destination) == 2);
+		REQUIRE(std::string(s1->receive().data()).compare("hello world!") == 0);
+		REQUIRE(std::string(s1->receive().data()).compare("hello world!") == 0);
+	}
+}
+
+TEST_CASE("Check batch send and receive.", "[socket::udp::socket][test][batch]") {
+	std::shared_ptr<oo_socket::udp::socket> s1;
+	std::shared_ptr<oo_socket::udp::socket> s2;
+	REQUIRE_NOTHROW(s1 = std::make_shared<oo_socket::udp::socket>(16666));
+	REQUIRE_NOTHROW(s2 = std::make_shared<oo_socket::udp::socket>());
+	REQUIRE_NOTHROW(s1->set_socket_receive_timeout(1000));
+
+	// More datagrams than fit in a single batch system call.
+	std::vector<std::string> payloads;
+	std::vector<oo_socket::outgoing_datagram> outgoing;
+	for (int i = 0; i < 100; i++) {
+		payloads.push_back("datagram " + std::to_string(i));
+	}
+	for (const std::string& payload : payloads) {
+		outgoing.push_back({payload.data(), payload.size()});
+	}
+
+	std::vector<std::vector<char>> buffers(outgoing.size(), std::vector<char>(256));
+	std::vector<oo_socket::incoming_datagram> incoming;
+	for (std::vector<char>& buffer : buffers) {
+		oo_socket::incoming_datagram datagram{};
+		datagram.buffer = buffer.data();
+		datagram.capacity = buffer.size();
+		incoming.push_back(datagram);
+	}
+
+	SECTION("Sending a batch to an address and receiving with the source.") {
+		REQUIRE(s2->send_batch_to(outgoing, 16666) == 100);
+		int received = 0;
+		while (received < 100) {
+			int result = s1->receive_batch(incoming.data() + received, incoming.size() - received, true);
+			REQUIRE(result > 0);
+			received += result;
+		}
+		for (int i = 0; i < 100; i++) {
+			REQUIRE(std::string(incoming[i].buffer, incoming[i].size) == payloads[i]);
+			REQUIRE(incoming[i].source_address == "127.0.0.1");
+			REQUIRE(incoming[i].source_port != 0);
+		}
+		REQUIRE(s2->get_statistics()->packets_sent == 100);
+		REQUIRE(s1->get_statistics()->packets_received == 100);
+		REQUIRE(s1->get_statistics()->receive_size_bytes.get_count() == 100);
+	}
+
+	SECTION("Sending a batch to the remote host.") {
+		REQUIRE_NOTHROW(s2->configure_remote_host(16666));
+		REQUIRE(s2->send_batch(outgoing.data(), 3) == 3);
+		int received = 0;
+		while (received < 3) {
+			int result = s1->receive_batch(incoming.data() + received, 3 - received);
+			REQUIRE(result > 0);
+			received += result;
+		}
+		REQUIRE(std::string(incoming[2].buffer, incoming[2].size) == payloads[2]);
+	}
+
+	SECTION("Receiving a batch times out.") {
+		REQUIRE(s1->receive_batch(incoming) == 0);
+	}
+}
+
+TEST_CASE("Check IPv6 and dual stack sockets.", "[socket::udp::socket][test][ipv6]") {
+	SECTION("Sending and receiving over IPv6 loopback.") {
+		std::shared_ptr<oo_socket::udp::socket> s1;
+		std::shared_ptr<oo_socket::udp::socket> s2;
+		REQUIRE_NOTHROW(s1 = std::make_shared<oo_socket::udp::socket>(16666, "::1"));
+		REQUIRE_NOTHROW(s2 = std::make_shared<oo_socket::udp::socket>(0, "", oo_socket::address_family::IPV6));
+		REQUIRE(s1->get_address_family() == oo_socket::address_family::IPV6);
+		REQUIRE(s1->get_local_address().to_string() == "[::1]:16666");
+
+		char buffer[] = "hello world!";
+		REQUIRE(s2->send_to(buffer, sizeof(buffer), 16666, "::1") == 13);
+		std::string source_address;
+		uint16_t source_port;
+		REQUIRE(std::string(s1->receive(&source_address, &source_port).data()).compare("hello world!") == 0);
+		REQUIRE(source_address == "::1");
+		REQUIRE(source_port == s2->get_local_address().port());
+
+		// An IPv6 only socket cannot reach IPv4 peers.
+		REQUIRE_THROWS_AS(s2->send_to(buffer, sizeof(buffer), 16666, "127.0.0.1"), oo_socket::errors::send_error);
+	}
+
+	SECTION("Serving IPv4 and IPv6 peers through one dual stack socket.") {
+		std::shared_ptr<oo_socket::udp::socket> server;
+		std::shared_ptr<oo_socket::udp::socket> ipv4_client;
+		std::shared_ptr<oo_socket::udp::socket> ipv6_client;
+		REQUIRE_NOTHROW(server = std::make_shared<oo_socket::udp::socket>(16666, "", oo_socket::address_family::DUAL_STACK));
+		REQUIRE_NOTHROW(ipv4_client = std::make_shared<oo_socket::udp::socket>());
+		REQUIRE_NOTHROW(ipv6_client = std::make_shared<oo_socket::udp::socket>(0, "::1"));
+		REQUIRE_NOTHROW(server->set_socket_receive_timeout(1000));
+		REQUIRE_NOTHROW(ipv4_client->set_socket_receive_timeout(1000));
+
+		char ipv4_buffer[] = "from ipv4";
+		char ipv6_buffer[] = "from ipv6";
+		REQUIRE(ipv4_client->send_to(ipv4_buffer, sizeof(ipv4_buffer), 16666, "127.0.0.1") == 10);
+		REQUIRE(ipv6_client->send_to(ipv6_buffer, sizeof(ipv6_buffer), 16666, "::1") == 10);
+
+		// Both families arrive through one batch receive, with IPv4 peers reported as plain IPv4 addresses.
+		std::vector<std::vector<char>> buffers(2, std::vector<char>(256));
+		std::vector<oo_socket::incoming_datagram> incoming;
+		for (std::vector<char>& buffer : buffers) {
+			oo_socket::incoming_datagram datagram{};
+			datagram.buffer = buffer.data();
+			datagram.capacity = buffer.size();
+			incoming.push_back(datagram);
+		}
+		int received = 0;
+		while (received < 2) {
+			int result = server->receive_batch(incoming.data() + received, incoming.size() - received, true);
+			REQUIRE(result > 0);
+			received += result;
+		}
+		std::string ipv4_source;
+		uint16_t ipv4_source_port = 0;
+		for (const oo_socket::incoming_datagram& datagram : incoming) {
+			if (std::string(datagram.buffer) == "from ipv4") {
+				REQUIRE(datagram.source_address == "127.0.0.1");
+				ipv4_source = datagram.source_address;
+				ipv4_source_port = datagram.source_port;
+			}
+			else {
+				REQUIRE(std::string(datagram.buffer) == "from ipv6");
+				REQUIRE(datagram.source_address == "::1");
+			}
+		}
+
+		// Replies to an IPv4 peer are mapped into IPv6 by the socket.
+		char reply[] = "reply";
+		REQUIRE(server->send_to(reply, sizeof(reply), ipv4_source_port, ipv4_source) == 6);
+		REQUIRE(std::string(ipv4_client->receive().data()).compare("reply") == 0);
+	}
+}
+
+TEST_CASE("Check packet info on a wildcard socket.", "[socket::udp::socket][test][packet_info]") {
+	// Every 127.0.0.0/8 address is local on Linux, so two loopback addresses stand in for a multi-homed host.
+	auto exchange = [](std::shared_ptr<oo_socket::udp::socket> server, std::vector<std::shared_ptr<oo_socket::udp::socket>> clients, std::vector<std::string> addresses) {
+		for (size_t i = 0; i < clients.size(); i++) {
+			REQUIRE(clients[i]->send_to(addresses[i].data(), addresses[i].size() + 1, 16666, addresses[i]) == (int)addresses[i].size() + 1);
+		}
+		std::vector<std::vector<char>> buffers(clients.size(), std::vector<char>(256));
+		std::vector<oo_socket::incoming_datagram> incoming;
+		for (std::vector<char>& buffer : buffers) {
+			oo_socket::incoming_datagram datagram{};
+			datagram.buffer = buffer.data();
+			datagram.capacity = buffer.size();
+			incoming.push_back(datagram);
+		}
+		int received = 0;
+		while (received < (int)clients.size()) {
+			int result = server->receive_batch(incoming.data() + received, incoming.size() - received, true);
+			REQUIRE(result > 0);
+			received += result;
+		}
+
+		// Each datagram reports the address it was sent to, and the reply leaves from that address.
+		for (const oo_socket::incoming_datagram& datagram : incoming) {
+			REQUIRE(datagram.destination_address == std::string(datagram.buffer));
+			REQUIRE(datagram.interface_index > 0);
+			REQUIRE(server->send_from(datagram.buffer, datagram.size, datagram.source_port, datagram.source_address, datagram.destination_address, datagram.interface_index) == (int)datagram.size);
+		}
+		for (size_t i = 0; i < clients.size(); i++) {
+			std::string source_address;
+			uint16_t source_port;
+			REQUIRE(std::string(clients[i]->receive(&source_address, &source_port).data()) == addresses[i]);
+			REQUIRE(source_address == addresses[i]);
+			REQUIRE(source_port == 16666);
+		}
+	};
+
+	SECTION("Replying from the address each IPv4 datagram arrived on.") {
+		std::shared_ptr<oo_socket::udp::socket> server;
+		REQUIRE_NOTHROW(server = std::make_shared<oo_socket::udp::socket>(16666));
+		REQUIRE_NOTHROW(server->enable_packet_info());
+		REQUIRE_NOTHROW(server->set_socket_receive_timeout(1000));
+		std::vector<std::shared_ptr<oo_socket::udp::socket>> clients;
+		for (int i = 0; i < 2; i++) {
+			clients.push_back(std::make_shared<oo_socket::udp::socket>());
+			clients.back()->set_socket_receive_timeout(1000);
+		}
+		exchange(server, clients, {"127.0.0.1", "127.0.0.2"});
+	}
+
+	SECTION("Replying from the address each datagram arrived on through a dual stack socket.") {
+		std::shared_ptr<oo_socket::udp::socket> server;
+		REQUIRE_NOTHROW(server = std::make_shared<oo_socket::udp::socket>(16666, "", oo_socket::address_family::DUAL_STACK));
+		REQUIRE_NOTHROW(server->enable_packet_info());
+		REQUIRE_NOTHROW(server->set_socket_receive_timeout(1000));
+		std::vector<std::shared_ptr<oo_socket::udp::socket>> clients;
+		clients.push_back(std::make_shared<oo_socket::udp::socket>());
+		clients.push_back(std::make_shared<oo_socket::udp::socket>(0, "", oo_socket::address_family::IPV6));
+		for (std::shared_ptr<oo_socket::udp::socket>& client : clients) {
+			client->set_socket_receive_timeout(1000);
+		}
+		exchange(server, clients, {"127.0.0.2", "::1"});
+	}
+
+	SECTION("Sending from an invalid source address fails.") {
+		std::shared_ptr<oo_socket::udp::socket> server;
+		REQUIRE_NOTHROW(server = std::make_shared<oo_socket::udp::socket>(16666));
+		char buffer[] = "hello world!";
+		REQUIRE_THROWS_AS(server->send_from(buffer, sizeof(buffer), 16667, "127.0.0.1", "not an address"), oo_socket::errors::send_error);
+		REQUIRE(server->send_from(buffer, sizeof(buffer), 16667, "127.0.0.1", "") == 13);
+	}
+}
+
+TEST_CASE("Check only sockets that share their port connect peers.", "[socket::udp::socket][test][connect_peer]") {
+	std::shared_ptr<oo_socket::udp::socket> first;
+	REQUIRE_NOTHROW(first = std::make_shared<oo_socket::udp::socket>(16666));
+	REQUIRE_THROWS_AS(first->connect_peer(10000), oo_socket::errors::configuration_error);
+	int option = 0;
+	socklen_t option_size = sizeof(option);
+	REQUIRE(::getsockopt((int)first->get_socket_file_descriptor(), SOL_SOCKET, SO_REUSEADDR, (char*)&option, &option_size) == 0);
+	REQUIRE(option != 0);
+#ifdef SO_REUSEPORT
+	REQUIRE(::getsockopt((int)first->get_socket_file_descriptor(), SOL_SOCKET, SO_REUSEPORT, (char*)&option, &option_size) == 0);
+	REQUIRE(option == 0);
+#endif
+
+	// A closed port can be bound again straight away, and shared sockets reuse the port.
+	first.reset();
+	REQUIRE_NOTHROW(first = std::make_shared<oo_socket::udp::socket>(16666, "", oo_socket::address_family::IPV4, true));
+#ifdef SO_REUSEPORT
+	REQUIRE(::getsockopt((int)first->get_socket_file_descriptor(), SOL_SOCKET, SO_REUSEPORT, (char*)&option, &option_size) == 0);
+	REQUIRE(option != 0);
+#endif
+	REQUIRE_NOTHROW(oo_socket::udp::socket(16666, "", oo_socket::address_family::IPV4, true));
+}
+
+TEST_CASE("Check connected peer sockets.", "[socket::udp::socket][test][connect_peer]") {
+	std::shared_ptr<oo_socket::udp::socket> server;
+	std::shared_ptr<oo_socket::udp::socket> established;
+	REQUIRE_NOTHROW(server = std::make_shared<oo_socket::udp::socket>(16666, "", oo_socket::address_family::IPV4, true));
+	REQUIRE_NOTHROW(established = std::make_shared<oo_socket::udp::socket>(0, "127.0.0.1"));
+	REQUIRE_NOTHROW(server->set_socket_receive_timeout(1000));
+	REQUIRE_NOTHROW(established->set_socket_receive_timeout(1000));
+
+	char hello[] = "hello";
+	REQUIRE(established->send_to(hello, sizeof(hello), 16666) == 6);
+	std::string source_address;
+	uint16_t source_port;
+	REQUIRE(std::string(server->receive(&source_address, &source_port).data()) == "hello");
+
+	std::shared_ptr<oo_socket::udp::socket> peer;
+	REQUIRE_NOTHROW(peer = server->connect_peer(source_port, source_address));
+	REQUIRE_NOTHROW(peer->set_socket_receive_timeout(1000));
+	REQUIRE(peer->get_local_address().port() == 16666);
+
+	SECTION("The established peer is delivered to its own socket and other peers to the server.") {
+		// Several other peers, since the kernel would hash each one to a single socket if they were spread.
+		std::vector<std::shared_ptr<oo_socket::udp::socket>> others;
+		for (int i = 0; i < 8; i++) {
+			others.push_back(std::make_shared<oo_socket::udp::socket>(0, "127.0.0.1"));
+		}
+		char first[] = "first";
+		char second[] = "second";
+		for (std::shared_ptr<oo_socket::udp::socket>& other : others) {
+			REQUIRE(established->send_to(first, sizeof(first), 16666) == 6);
+			REQUIRE(other->send_to(second, sizeof(second), 16666) == 7);
+		}
+		for (size_t i = 0; i < others.size(); i++) {
+			REQUIRE(std::string(peer->receive().data()) == "first");
+			REQUIRE(std::string(server->receive().data()) == "second");
+		}
+
+		// Replies from the peer socket come from the shared server port.
+		char reply[] = "reply";
+		REQUIRE(peer->send(reply, sizeof(reply)) == 6);
+		REQUIRE(std::string(established->receive(&source_address, &source_port).data()) == "reply");
+		REQUIRE(source_port == 16666);
+	}
+
+	SECTION("Destroying the peer socket returns the peer to the server.") {
+		peer.reset();
+		char again[] = "again";
+		REQUIRE(established->send_to(again, sizeof(again), 16666) == 6);
+		REQUIRE(std::string(server->receive().data()) == "again");
+	}
+}
+
+TEST_CASE("Check vectors are encoded when array encoding is enabled.", "[socket::udp::socket][test][array_encoding]") {
+	std::shared_ptr<oo_socket::udp::socket> receiver;
+	std::shared_ptr<oo_socket::udp::socket> sender;
+	REQUIRE_NOTHROW(receiver = std::make_shared<oo_socket::udp::socket>(16666));
+	REQUIRE_NOTHROW(sender = std::make_shared<oo_socket::udp::socket>(0, "127.0.0.1"));
+	REQUIRE_NOTHROW(receiver->set_socket_receive_timeout(1000));
+	REQUIRE_NOTHROW(receiver->enable_array_encoding());
+
+	std::vector<int32_t> counts(300);
+	std::vector<float> samples(300);
+	for (size_t i = 0; i < counts.size(); i++) {
+		counts[i] = 1000 + (int32_t)(i % 13);
+		samples[i] = 20.0f + (float)(i % 4) * 0.25f;
+	}
+
+	SECTION("Encoded vectors are smaller and decode transparently.") {
+		oo_socket::array_codec::array_encoding encoding;
+		encoding.floating_method = oo_socket::array_codec::QUANTIZED;
+		encoding.quantization_step = 0.01;
+		REQUIRE_NOTHROW(sender->enable_array_encoding(encoding));
+		REQUIRE(sender->send_to(counts, 16666) < (int)(counts.size() * sizeof(int32_t)) / 4);
+		REQUIRE(receiver->receive<int32_t>() == counts);
+		REQUIRE(sender->send_to(samples, 16666) < (int)(samples.size() * sizeof(float)) / 4);
+		const std::vector<float> received = receiver->receive<float>();
+		REQUIRE(received.size() == samples.size());
+		for (size_t i = 0; i < samples.size(); i++) {
+			REQUIRE(std::abs(received[i] - samples[i]) <= 0.005f);
+		}
+
+		// Other element types are still sent as raw bytes.
+		std::vector<char> text = {'r', 'a', 'w'};
+		REQUIRE(sender->send_to(text, 16666) == 3);
+		REQUIRE(receiver->receive<char>() == text);
+	}
+
+	SECTION("Raw vectors are rejected by a decoding receiver.") {
+		REQUIRE(sender->send_to(counts, 16666) == (int)(counts.size() * sizeof(int32_t)));
+		REQUIRE_THROWS_AS(receiver->receive<int32_t>(), oo_socket::errors::decode_error);
+	}
+
+	SECTION("Invalid quantization steps are refused.") {
+		oo_socket::array_codec::array_encoding encoding;
+		encoding.floating_method = oo_socket::array_codec::QUANTIZED;
+		encoding.quantization_step = 0;
+		REQUIRE_THROWS_AS(sender->enable_array_encoding(encoding), oo_socket::errors::configuration_error);
+	}
+}
+
+#ifdef __linux__
+TEST_CASE("Check ECN codepoints are sent and received.", "[socket::udp::socket][test][ecn]") {
+	auto exchange = [](std::shared_ptr<oo_socket::udp::socket> receiver, std::shared_ptr<oo_socket::udp::socket> sender, const std::string& address) {
+		REQUIRE_NOTHROW(receiver->enable_ecn());
+		REQUIRE_NOTHROW(receiver->set_socket_receive_timeout(1000));
+		std::vector<char> buffer(64);
+		std::vector<oo_socket::incoming_datagram> incoming(1);
+		incoming[0].buffer = buffer.data();
+		incoming[0].capacity = buffer.size();
+		char message[] = "hello world!";
+
+		// Datagrams from a sender without ECN are not ECN capable.
+		REQUIRE(sender->send_to(message, sizeof(message), 16666, address) == (int)sizeof(message));
+		REQUIRE(receiver->receive_batch(incoming) == 1);
+		REQUIRE(incoming[0].ecn == oo_socket::NOT_ECT);
+
+		REQUIRE_NOTHROW(sender->enable_ecn());
+		REQUIRE(sender->send_to(message, sizeof(message), 16666, address) == (int)sizeof(message));
+		REQUIRE(receiver->receive_batch(incoming) == 1);
+		REQUIRE(incoming[0].ecn == oo_socket::ECT_0);
+
+		// Loopback never marks congestion, so the sender marks its own datagrams as a router would.
+		REQUIRE_NOTHROW(sender->enable_ecn(oo_socket::CE));
+		REQUIRE(sender->send_to(message, sizeof(message), 16666, address) == (int)sizeof(message));
+		REQUIRE(receiver->receive(buffer.data(), buffer.size()) == (int)sizeof(message));
+		REQUIRE(receiver->get_statistics()->ecn_capable_received == 2);
+		REQUIRE(receiver->get_statistics()->ecn_congestion_experienced == 1);
+	};
+
+	SECTION("IPv4 datagrams.") {
+		exchange(std::make_shared<oo_socket::udp::socket>(16666), std::make_shared<oo_socket::udp::socket>(), "127.0.0.1");
+	}
+
+	SECTION("IPv4 datagrams through a dual stack socket.") {
+		exchange(std::make_shared<oo_socket::udp::socket>(16666, "", oo_socket::address_family::DUAL_STACK), std::make_shared<oo_socket::udp::socket>(), "127.0.0.1");
+	}
+
+	SECTION("IPv6 datagrams.") {
+		exchange(std::make_shared<oo_socket::udp::socket>(16666, "", oo_socket::address_family::IPV6), std::make_shared<oo_socket::udp::socket>(0, "", oo_socket::address_family::IPV6), "::1");
+	}
+
+	SECTION("DSCP bits set on the socket are kept.") {
+		std::shared_ptr<oo_socket::udp::socket> sender = std::make_shared<oo_socket::udp::socket>();
+		const int expedited = 46 << 2;
+		REQUIRE_NOTHROW(sender->set_traffic_class(oo_socket::traffic_classes::LOW_LATENCY));
+		REQUIRE_NOTHROW(sender->enable_ecn());
+		int traffic_class = 0;
+		socklen_t length = sizeof(traffic_class);
+		REQUIRE(::getsockopt((int)sender->get_socket_file_descriptor(), IPPROTO_IP, IP_TOS, &traffic_class, &length) == 0);
+		REQUIRE(traffic_class == (expedited | oo_socket::ECT_0));
+	}
+}
+#endif
+
+#ifdef __linux__
+TEST_CASE("Check traffic classes per socket and per datagram.", "[socket::udp::socket][test][traffic_class]") {
+	// Reads the TOS or traffic class of the next datagram straight from the socket.
+	auto receive_traffic_class = [](std::shared_ptr<oo_socket::udp::socket> receiver) {
+		char data[64];
+		iovec data_vector{data, sizeof(data)};
+		alignas(cmsghdr) char control[CONTROL_BUFFER_SIZE];
+		msghdr message{};
+		message.msg_iov = &data_vector;
+		message.msg_iovlen = 1;
+		message.msg_control = control;
+		message.msg_controllen = sizeof(control);
+		REQUIRE(::recvmsg((int)receiver->get_socket_file_descriptor(), &message, 0) > 0);
+		for (cmsghdr* header = CMSG_FIRSTHDR(&message); header != nullptr; header = CMSG_NXTHDR(&message, header)) {
+			if (header->cmsg_level == IPPROTO_IP && header->cmsg_type == IP_TOS) {
+				return (int)*(const unsigned char*)CMSG_DATA(header);
+			}
+			if (header->cmsg_level == IPPROTO_IPV6 && header->cmsg_type == IPV6_TCLASS) {
+				int traffic_class;
+				::memcpy(&traffic_class, CMSG_DATA(header), sizeof(traffic_class));
+				return traffic_class;
+			}
+		}
+		return -1;
+	};
+	auto exchange = [&](std::shared_ptr<oo_socket::udp::socket> receiver, std::shared_ptr<oo_socket::udp::socket> sender, const std::string& address) {
+		const int on = 1;
+		::setsockopt((int)receiver->get_socket_file_descriptor(), IPPROTO_IP, IP_RECVTOS, &on, sizeof(on));
+		::setsockopt((int)receiver->get_socket_file_descriptor(), IPPROTO_IPV6, IPV6_RECVTCLASS, &on, sizeof(on));
+		REQUIRE_NOTHROW(receiver->set_socket_receive_timeout(1000));
+		const oo_socket::socket_address destination = oo_socket::socket_address::parse(address, 16666);
+		char message[] = "hello world!";
+
+		REQUIRE_NOTHROW(sender->set_traffic_class(oo_socket::traffic_classes::BULK));
+		REQUIRE(sender->send_to(message, sizeof(message), destination) == (int)sizeof(message));
+		REQUIRE(receive_traffic_class(receiver) == 8 << 2);
+
+		// A datagram sent in its own class does not change the socket's class.
+		REQUIRE(sender->send_to(message, sizeof(message), destination, oo_socket::traffic_classes::LOW_LATENCY) == (int)sizeof(message));
+		REQUIRE(receive_traffic_class(receiver) == 46 << 2);
+		REQUIRE(sender->send_to(message, sizeof(message), destination) == (int)sizeof(message));
+		REQUIRE(receive_traffic_class(receiver) == 8 << 2);
+
+		// The ECN codepoint of the socket is kept.
+		REQUIRE_NOTHROW(sender->enable_ecn());
+		REQUIRE(sender->send_to(message, sizeof(message), destination, oo_socket::traffic_classes::LOW_LATENCY) == (int)sizeof(message));
+		REQUIRE(receive_traffic_class(receiver) == ((46 << 2) | oo_socket::ECT_0));
+	};
+
+	SECTION("IPv4 datagrams.") {
+		exchange(std::make_shared<oo_socket::udp::socket>(16666), std::make_shared<oo_socket::udp::socket>(), "127.0.0.1");
+	}
+
+	SECTION("IPv4 datagrams from a dual stack socket.") {
+		exchange(std::make_shared<oo_socket::udp::socket>(16666), std::make_shared<oo_socket::udp::socket>(0, "", oo_socket::address_family::DUAL_STACK), "127.0.0.1");
+	}
+
+	SECTION("IPv6 datagrams.") {
+		exchange(std::make_shared<oo_socket::udp::socket>(16666, "", oo_socket::address_family::IPV6), std::make_shared<oo_socket::udp::socket>(0, "", oo_socket::address_family::IPV6), "::1");
+	}
+
+	SECTION("The priority of the socket is set after the DSCP.") {
+		std::shared_ptr<oo_socket::udp::socket> sender = std::make_shared<oo_socket::udp::socket>();
+		REQUIRE_NOTHROW(sender->set_traffic_class(oo_socket::traffic_classes::INTERACTIVE));
+		int priority = -1;
+		socklen_t length = sizeof(priority);
+		REQUIRE(::getsockopt((int)sender->get_socket_file_descriptor(), SOL_SOCKET, SO_PRIORITY, &priority, &length) == 0);
+		REQUIRE(priority == 4);
+		REQUIRE_NOTHROW(sender->set_traffic_class({-1, 1}));
+		REQUIRE(::getsockopt((int)sender->get_socket_file_descriptor(), SOL_SOCKET, SO_PRIORITY, &priority, &length) == 0);
+		REQUIRE(priority == 1);
+	}
+
+	SECTION("Invalid classes are refused.") {
+		std::shared_ptr<oo_socket::udp::socket> sender = std::make_shared<oo_socket::udp::socket>();
+		char message[] = "hello world!";
+		REQUIRE_THROWS_AS(sender->set_traffic_class({64, -1}), oo_socket::errors::configuration_error);
+		REQUIRE_THROWS_AS(sender->set_traffic_class({-1, -2}), oo_socket::errors::configuration_error);
+		REQUIRE_THROWS_AS(sender->send_to(message, sizeof(message), oo_socket::socket_address::parse("127.0.0.1", 16666), {64, -1}), oo_socket::errors::send_error);
+	}
 }
+#endif
 
 TEST_CASE("Benchmarking socket.", "[socket::udp::socket][benchmark]") {
 	BENCHMARK("Benchmark socket constructor/destructor with no port or address.") {
@@ -170,4 +654,198 @@ TEST_CASE("Benchmarking socket.", "[socket::udp::socket][benchmark]") {
 	BENCHMARK("Benchmark socket send localhost with char* of size 256.") {
 		return send_socket_char_remote.send(send_buffer_char, 256);
 	};
+
+	using namespace oo_socket::literals;
+	auto send_socket_endpoint = oo_socket::udp::socket();
+	constexpr oo_socket::ipv4_endpoint endpoint = "127.0.0.1:10104"_ep;
+	BENCHMARK("Benchmark socket send_to endpoint literal with char* of size 256.") {
+		return send_socket_endpoint.send_to(send_buffer_char, 256, endpoint);
+	};
+}
+
+TEST_CASE("Benchmarking socket receive.", "[socket::udp::socket][benchmark]") {
+	// Each benchmark sends to a live receiver and then receives, so every datagram is read rather than dropped.
+	auto receive_socket = oo_socket::udp::socket(10106);
+	receive_socket.set_socket_receive_timeout(1000);
+	auto send_socket = oo_socket::udp::socket();
+	send_socket.configure_remote_host(10106);
+
+	for (size_t size : {64, 512, 1400}) {
+		std::vector<char> send_buffer(size, 'T');
+		std::vector<char> receive_buffer(MAX_RECEIVE_BUFFER_SIZE);
+		std::string source_address;
+		uint16_t source_port;
+
+		BENCHMARK("Benchmark socket receive<char>() from localhost of size " + std::to_string(size) + ".") {
+			send_socket.send(send_buffer);
+			return receive_socket.receive<char>();
+		};
+
+		BENCHMARK("Benchmark socket receive<char>() with source from localhost of size " + std::to_string(size) + ".") {
+			send_socket.send(send_buffer);
+			return receive_socket.receive<char>(&source_address, &source_port);
+		};
+
+		BENCHMARK("Benchmark socket receive(char*) from localhost of size " + std::to_string(size) + ".") {
+			send_socket.send(send_buffer);
+			return receive_socket.receive(receive_buffer.data(), (uint16_t)receive_buffer.size());
+		};
+
+		BENCHMARK("Benchmark socket receive(char*) with source from localhost of size " + std::to_string(size) + ".") {
+			send_socket.send(send_buffer);
+			return receive_socket.receive(receive_buffer.data(), (uint16_t)receive_buffer.size(), &source_address, &source_port);
+		};
+
+		// Batches of 32 datagrams, so each measurement covers 32 datagrams rather than one.
+		std::vector<oo_socket::outgoing_datagram> outgoing(32, oo_socket::outgoing_datagram{send_buffer.data(), send_buffer.size()});
+		std::vector<std::vector<char>> batch_buffers(32, std::vector<char>(MAX_RECEIVE_BUFFER_SIZE));
+		std::vector<oo_socket::incoming_datagram> incoming;
+		for (std::vector<char>& buffer : batch_buffers) {
+			oo_socket::incoming_datagram datagram{};
+			datagram.buffer = buffer.data();
+			datagram.capacity = buffer.size();
+			incoming.push_back(datagram);
+		}
+
+		BENCHMARK("Benchmark socket receive_batch of 32 from localhost of size " + std::to_string(size) + ".") {
+			send_socket.send_batch(outgoing);
+			int received = 0;
+			while (received < 32) {
+				const int result = receive_socket.receive_batch(incoming.data() + received, 32 - received);
+				if (result <= 0) {
+					FAIL("Receive timed out with " << 32 - received << " of 32 datagrams missing.");
+				}
+				received += result;
+			}
+			return received;
+		};
+
+		BENCHMARK("Benchmark socket receive_batch of 32 with source from localhost of size " + std::to_string(size) + ".") {
+			send_socket.send_batch(outgoing);
+			int received = 0;
+			while (received < 32) {
+				const int result = receive_socket.receive_batch(incoming.data() + received, 32 - received, true);
+				if (result <= 0) {
+					FAIL("Receive timed out with " << 32 - received << " of 32 datagrams missing.");
+				}
+				received += result;
+			}
+			return received;
+		};
+	}
+}
+
+#ifdef __linux__
+TEST_CASE("Check kernel diagnostics.", "[socket::udp::socket][test][kernel_diagnostics]") {
+	std::shared_ptr<oo_socket::udp::socket> s1;
+	std::shared_ptr<oo_socket::udp::socket> s2;
+	REQUIRE_NOTHROW(s1 = std::make_shared<oo_socket::udp::socket>(16666));
+	REQUIRE_NOTHROW(s2 = std::make_shared<oo_socket::udp::socket>());
+	REQUIRE_NOTHROW(s1->enable_kernel_diagnostics());
+	REQUIRE_NOTHROW(s2->enable_kernel_diagnostics());
+	s1->set_socket_receive_timeout(100);
+	s2->set_socket_receive_timeout(100);
+
+	SECTION("Receive queue overflows are reported.") {
+		// Shrink the receive buffer so that a burst overflows it.
+		int buffer_size = 4096;
+		::setsockopt(s1->get_socket_file_descriptor(), SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size));
+		std::vector<char> buffer(1000, 'T');
+		for (int i = 0; i < 64; i++) {
+			s2->send_to(buffer, 16666);
+		}
+
+		oo_socket::kernel_diagnostics before = s1->get_kernel_diagnostics();
+		REQUIRE(before.memory_information_available);
+		REQUIRE(before.receive_queue_bytes > 0);
+		REQUIRE(before.drops > 0);
+
+		// Each datagram carries the drop count from when it was queued, so drain the queue and send one more
+		// datagram that is queued after the burst's drops.
+		while (s1->receive().size() > 0) {}
+		s2->send_to(buffer, 16666);
+		REQUIRE(s1->receive().size() == 1000);
+		oo_socket::kernel_diagnostics after = s1->get_kernel_diagnostics();
+		REQUIRE(after.receive_queue_overflows > 0);
+		REQUIRE(after.receive_queue_overflows <= after.drops);
+		REQUIRE(s1->get_statistics()->kernel_drops == after.drops);
+	}
+
+	SECTION("ICMP errors are counted instead of failing receives.") {
+		std::vector<char> buffer(16, 'T');
+		// Nothing is bound to this port so the kernel replies with port unreachable.
+		s2->send_to(buffer, 16667);
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+		REQUIRE_NOTHROW(s2->receive());
+		REQUIRE(s2->get_kernel_diagnostics().icmp_errors == 1);
+	}
+}
+#endif
+
+#ifdef __linux__
+TEST_CASE("Check ICMP errors are read from the error queue.", "[socket::udp::socket][test][error_queue]") {
+	std::shared_ptr<oo_socket::udp::socket> s1;
+	REQUIRE_NOTHROW(s1 = std::make_shared<oo_socket::udp::socket>());
+	REQUIRE_NOTHROW(s1->enable_error_queue());
+
+	std::vector<oo_socket::icmp_error> handled;
+	s1->set_icmp_error_handler([&handled](const oo_socket::icmp_error& error) {
+		handled.push_back(error);
+	});
+
+	// Nothing is bound to this port so the kernel replies with port unreachable.
+	std::vector<char> buffer(16, 'T');
+	REQUIRE(s1->send_to(buffer, 16667) == 16);
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+	std::vector<oo_socket::icmp_error> errors = s1->read_error_queue();
+	REQUIRE(errors.size() == 1);
+	REQUIRE(errors[0].type == oo_socket::icmp_error_type::PORT_UNREACHABLE);
+	REQUIRE(errors[0].icmp_type == 3);
+	REQUIRE(errors[0].icmp_code == 3);
+	REQUIRE(errors[0].error_code == ECONNREFUSED);
+	REQUIRE(errors[0].destination_address == "127.0.0.1");
+	REQUIRE(errors[0].destination_port == 16667);
+	REQUIRE(handled.size() == 1);
+	REQUIRE(s1->read_error_queue().empty());
+
+	oo_socket::destination_health health = s1->get_destination_health(16667);
+	REQUIRE(health.error_count == 1);
+	REQUIRE(health.unreachable);
+	REQUIRE(s1->get_destination_health(16668).error_count == 0);
+
+	SECTION("Sends keep going without fail fast.") {
+		REQUIRE(s1->send_to(buffer, 16667) == 16);
+	}
+
+	SECTION("Sends to unreachable destinations fail fast.") {
+		s1->set_fail_fast(true);
+		REQUIRE_THROWS_AS(s1->send_to(buffer, 16667), oo_socket::errors::send_error);
+		REQUIRE(s1->send_to(buffer, 16668) == 16);
+
+		// Once the destination is cleared it can be sent to again.
+		s1->clear_destination_health(16667);
+		REQUIRE(s1->send_to(buffer, 16667) == 16);
+	}
+}
+
+TEST_CASE("Check ICMPv6 errors are read from the error queue.", "[socket::udp::socket][test][error_queue][ipv6]") {
+	std::shared_ptr<oo_socket::udp::socket> s1;
+	REQUIRE_NOTHROW(s1 = std::make_shared<oo_socket::udp::socket>(0, "", oo_socket::address_family::IPV6));
+	REQUIRE_NOTHROW(s1->enable_error_queue());
+
+	std::vector<char> buffer(16, 'T');
+	REQUIRE(s1->send_to(buffer, 16667, "::1") == 16);
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+	std::vector<oo_socket::icmp_error> errors = s1->read_error_queue();
+	REQUIRE(errors.size() == 1);
+	REQUIRE(errors[0].type == oo_socket::icmp_error_type::PORT_UNREACHABLE);
+	REQUIRE(errors[0].icmp_type == 1);
+	REQUIRE(errors[0].icmp_code == 4);
+	REQUIRE(errors[0].destination_address == "::1");
+	REQUIRE(errors[0].destination_port == 16667);
+	REQUIRE(s1->get_destination_health(16667, "::1").unreachable);
 }
+#endif
@@ -0,0 +1,528 @@
+/**
+ * 	@file 	oo_udp_blast.cpp
+ * 	@brief 	Command line UDP load generator and paired receiver built on udp::socket.
+ * 	@details	In send mode one or more threads each own a socket and send paced batches of datagrams to a set of
+ * 				destinations, reporting the achieved packet and bit rates. In receive mode a socket counts the
+ * 				datagrams from every sender stream and reports loss, reordering and one way latency. Latency uses
+ * 				the system clock so senders on other hosts need synchronised clocks.
+ * 	@author James Horner
+ * 	@date 	2023-04-05
+ */
+
+// Standard System Libraries
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+// Local Libraries
+#include "datagram.hpp"
+#include "errors.hpp"
+#include "rate_limiter.hpp"
+#include "udp_socket.hpp"
+
+/// Magic number at the start of every datagram sent by the tool ("OOBL").
+#define BLAST_MAGIC 0x4f4f424cu
+/// Size of the header at the start of every datagram.
+#define BLAST_HEADER_SIZE 24
+/// Number of latency samples kept for the final report of the receiver.
+#define LATENCY_RESERVOIR_SIZE 1048576
+
+namespace
+{
+	/**
+	 *	@struct	blast_header
+	 * 	@brief 	Struct blast_header is the header written at the start of every datagram, in host byte order.
+	 */
+	struct blast_header {
+		/// Magic number identifying datagrams sent by the tool.
+		uint32_t magic;
+		/// Index of the sending thread, which together with the source address identifies a stream.
+		uint32_t stream;
+		/// Sequence number of the datagram within its stream and destination.
+		uint64_t sequence;
+		/// System clock time the datagram was sent in nanoseconds.
+		uint64_t send_time_ns;
+	};
+	static_assert(sizeof(blast_header) == BLAST_HEADER_SIZE, "blast_header must not be padded");
+
+	/**
+	 *	@struct	destination
+	 * 	@brief 	Struct destination is an address and port to send datagrams to.
+	 */
+	struct destination {
+		/// Address of the receiver.
+		std::string address;
+		/// Port of the receiver.
+		unsigned short port;
+	};
+
+	/**
+	 *	@struct	options
+	 * 	@brief 	Struct options holds the parsed command line options.
+	 */
+	struct options {
+		/// True for send mode, false for receive mode.
+		bool send = true;
+		/// Destinations to send to, round robin per batch.
+		std::vector<destination> destinations;
+		/// Size of each datagram in bytes, including the header.
+		size_t size = 512;
+		/// Total datagrams per second across all threads, 0 for unlimited.
+		double rate = 10000;
+		/// Number of sending threads.
+		unsigned int threads = 1;
+		/// Number of datagrams per batch.
+		size_t batch = 32;
+		/// Seconds to run for, 0 to run until interrupted.
+		double duration = 10;
+		/// Seconds between reports.
+		double interval = 1;
+		/// Port to receive on in receive mode.
+		unsigned short port = 5000;
+		/// Address to bind to in receive mode.
+		std::string bind_address = "0.0.0.0";
+		/// Addresses the sockets use, dual stack lets one socket reach IPv4 and IPv6 peers.
+		oo_socket::address_family family = oo_socket::address_family::IPV4;
+	};
+
+	/// Set by the signal handler to stop the tool.
+	std::atomic<bool> stop_requested{false};
+
+	/**
+	 * @brief 	Function handle_signal requests that the tool stops.
+	 */
+	void handle_signal(int) {
+		stop_requested = true;
+	}
+
+	/**
+	 * @brief 	Function wall_clock_ns returns the system clock time.
+	 * @return 	uint64_t 	nanoseconds since the system clock epoch.
+	 */
+	uint64_t wall_clock_ns() {
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	}
+
+	/**
+	 * @brief 	Function seconds_since returns the seconds elapsed since a steady clock time point.
+	 * @param 	start 	time point to measure from.
+	 * @return 	double 	seconds elapsed.
+	 */
+	double seconds_since(std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	/**
+	 * @brief 	Function format_rate formats a rate with an SI prefix.
+	 * @param 	value 		rate to format.
+	 * @param 	unit 		unit appended after the prefix.
+	 * @return 	std::string formatted rate.
+	 */
+	std::string format_rate(double value, const std::string& unit) {
+		const char* prefixes[] = {"", "k", "M", "G", "T"};
+		size_t prefix = 0;
+		while (value >= 1000 && prefix < 4) {
+			value /= 1000;
+			prefix++;
+		}
+		std::ostringstream stream;
+		stream.setf(std::ios::fixed);
+		stream.precision(2);
+		stream << value << " " << prefixes[prefix] << unit;
+		return stream.str();
+	}
+
+	/**
+	 * @brief 	Function print_usage prints the command line options.
+	 */
+	void print_usage() {
+		std::cerr <<
+			"Usage: oo_udp_blast send --destination ADDRESS:PORT [options]\n"
+			"       oo_udp_blast receive [--port PORT] [--bind ADDRESS] [options]\n"
+			"\n"
+			"Send options:\n"
+			"  --destination ADDRESS:PORT  destination to send to, may be repeated (round robin per batch), IPv6 as [ADDRESS]:PORT\n"
+			"  --size BYTES                datagram size including the 24 byte header (default 512)\n"
+			"  --rate PPS                  total datagrams per second across all threads, 0 for unlimited (default 10000)\n"
+			"  --threads N                 sending threads, each with its own socket (default 1)\n"
+			"  --batch N                   datagrams per batch send (default 32)\n"
+			"Receive options:\n"
+			"  --port PORT                 port to receive on (default 5000)\n"
+			"  --bind ADDRESS              address to bind to (default 0.0.0.0)\n"
+			"Common options:\n"
+			"  --family ipv4|ipv6|dual     address family of the sockets, dual serves both through one socket (default ipv4)\n"
+			"  --duration SECONDS          time to run for, 0 to run until interrupted (default 10)\n"
+			"  --interval SECONDS          time between reports (default 1)\n";
+	}
+
+	/**
+	 * @brief 	Function parse_options parses the command line.
+	 * @param 	argc 		number of arguments.
+	 * @param 	argv 		arguments.
+	 * @param 	parsed[out]	parsed options.
+	 * @return 	bool 		true if the command line was valid.
+	 */
+	bool parse_options(int argc, char** argv, options& parsed) {
+		if (argc < 2) {
+			return false;
+		}
+		const std::string mode = argv[1];
+		if (mode != "send" && mode != "receive") {
+			return false;
+		}
+		parsed.send = mode == "send";
+		try {
+			for (int i = 2; i < argc; i++) {
+				const std::string option = argv[i];
+				if (i + 1 >= argc) {
+					return false;
+				}
+				const std::string value = argv[++i];
+				if (option == "--destination") {
+					const size_t colon = value.rfind(':');
+					if (colon == std::string::npos) {
+						return false;
+					}
+					// IPv6 addresses are written in brackets, e.g. [::1]:5000.
+					std::string address = value.substr(0, colon);
+					if (address.size() > 2 && address.front() == '[' && address.back() == ']') {
+						address = address.substr(1, address.size() - 2);
+					}
+					parsed.destinations.push_back({address, (unsigned short)std::stoul(value.substr(colon + 1))});
+				}
+				else if (option == "--size") {
+					parsed.size = std::stoul(value);
+				}
+				else if (option == "--rate") {
+					parsed.rate = std::stod(value);
+				}
+				else if (option == "--threads") {
+					parsed.threads = (unsigned int)std::stoul(value);
+				}
+				else if (option == "--batch") {
+					parsed.batch = std::stoul(value);
+				}
+				else if (option == "--duration") {
+					parsed.duration = std::stod(value);
+				}
+				else if (option == "--interval") {
+					parsed.interval = std::stod(value);
+				}
+				else if (option == "--port") {
+					parsed.port = (unsigned short)std::stoul(value);
+				}
+				else if (option == "--bind") {
+					parsed.bind_address = value;
+				}
+				else if (option == "--family") {
+					if (value == "ipv4") {
+						parsed.family = oo_socket::address_family::IPV4;
+					}
+					else if (value == "ipv6") {
+						parsed.family = oo_socket::address_family::IPV6;
+					}
+					else if (value == "dual") {
+						parsed.family = oo_socket::address_family::DUAL_STACK;
+					}
+					else {
+						return false;
+					}
+				}
+				else {
+					return false;
+				}
+			}
+		}
+		catch (const std::exception&) {
+			return false;
+		}
+		if (parsed.send && parsed.destinations.empty()) {
+			return false;
+		}
+		if (parsed.size < BLAST_HEADER_SIZE || parsed.size > MAX_RECEIVE_BUFFER_SIZE || parsed.threads == 0 || parsed.batch == 0 || parsed.interval <= 0) {
+			return false;
+		}
+		return true;
+	}
+
+	/**
+	 * @brief 	Function run_sender sends paced batches from several threads and reports the achieved rates.
+	 * @param 	parsed 	parsed options.
+	 * @return 	int 	exit code.
+	 */
+	int run_sender(const options& parsed) {
+		std::atomic<uint64_t> packets_sent{0};
+		std::atomic<uint64_t> bytes_sent{0};
+		std::atomic<uint64_t> send_errors{0};
+
+		std::vector<std::thread> senders;
+		for (unsigned int stream = 0; stream < parsed.threads; stream++) {
+			senders.emplace_back([&, stream]() {
+				try {
+					oo_socket::udp::socket socket(0, "", parsed.family);
+					// Each thread paces its share of the rate, with a burst of one batch.
+					oo_socket::token_bucket pacer(parsed.rate / parsed.threads, (double)parsed.batch);
+					std::vector<char> payload(parsed.size * parsed.batch, 'B');
+					std::vector<oo_socket::outgoing_datagram> batch(parsed.batch);
+					std::vector<uint64_t> sequences(parsed.destinations.size(), 0);
+					for (size_t i = 0; i < parsed.batch; i++) {
+						batch[i] = {payload.data() + i * parsed.size, parsed.size};
+					}
+
+					size_t next_destination = 0;
+					while (!stop_requested) {
+						pacer.consume((double)parsed.batch);
+
+						// Stamp the headers just before sending so latency excludes the pacing delay.
+						const size_t index = next_destination;
+						next_destination = (next_destination + 1) % parsed.destinations.size();
+						const uint64_t send_time_ns = wall_clock_ns();
+						for (size_t i = 0; i < parsed.batch; i++) {
+							blast_header header{BLAST_MAGIC, stream, sequences[index] + i, send_time_ns};
+							::memcpy(payload.data() + i * parsed.size, &header, sizeof(header));
+						}
+
+						try {
+							const int sent = socket.send_batch_to(batch, parsed.destinations[index].port, parsed.destinations[index].address);
+							sequences[index] += (uint64_t)sent;
+							packets_sent.fetch_add((uint64_t)sent, std::memory_order_relaxed);
+							bytes_sent.fetch_add((uint64_t)sent * parsed.size, std::memory_order_relaxed);
+						}
+						catch (const oo_socket::errors::send_error&) {
+							send_errors.fetch_add(1, std::memory_order_relaxed);
+						}
+					}
+				}
+				catch (const std::exception& e) {
+					std::cerr << "Sender " << stream << " failed: " << e.what() << std::endl;
+					stop_requested = true;
+				}
+			});
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		auto last_report = start;
+		uint64_t last_packets = 0;
+		uint64_t last_bytes = 0;
+		while (!stop_requested && (parsed.duration <= 0 || seconds_since(start) < parsed.duration)) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			if (seconds_since(last_report) < parsed.interval) {
+				continue;
+			}
+			const double elapsed = seconds_since(last_report);
+			last_report = std::chrono::steady_clock::now();
+			const uint64_t packets = packets_sent.load();
+			const uint64_t bytes = bytes_sent.load();
+			std::cout << "[" << (int)seconds_since(start) << "s] sent " << format_rate((double)(packets - last_packets) / elapsed, "pps")
+				<< ", " << format_rate((double)(bytes - last_bytes) * 8 / elapsed, "bps")
+				<< ", " << send_errors.load() << " errors" << std::endl;
+			last_packets = packets;
+			last_bytes = bytes;
+		}
+		stop_requested = true;
+		for (std::thread& sender : senders) {
+			sender.join();
+		}
+
+		const double elapsed = seconds_since(start);
+		std::cout << "Total: sent " << packets_sent.load() << " datagrams (" << bytes_sent.load() << " bytes) in " << elapsed << " s, "
+			<< format_rate((double)packets_sent.load() / elapsed, "pps") << ", "
+			<< format_rate((double)bytes_sent.load() * 8 / elapsed, "bps") << ", "
+			<< send_errors.load() << " errors" << std::endl;
+		return 0;
+	}
+
+	/**
+	 *	@struct	stream_state
+	 * 	@brief 	Struct stream_state tracks the datagrams received from one sender stream.
+	 */
+	struct stream_state {
+		/// Number of datagrams received.
+		uint64_t received = 0;
+		/// Highest sequence number seen plus one.
+		uint64_t expected = 0;
+		/// Number of datagrams that arrived after a datagram with a higher sequence number.
+		uint64_t reordered = 0;
+	};
+
+	/**
+	 * @brief 	Function percentile returns a percentile of a sorted sample.
+	 * @param 	sorted 		sorted sample.
+	 * @param 	fraction 	percentile as a fraction between 0 and 1.
+	 * @return 	uint64_t 	value at the percentile, 0 if the sample is empty.
+	 */
+	uint64_t percentile(const std::vector<uint64_t>& sorted, double fraction) {
+		if (sorted.empty()) {
+			return 0;
+		}
+		return sorted[std::min(sorted.size() - 1, (size_t)(fraction * (double)sorted.size()))];
+	}
+
+	/**
+	 * @brief 	Function sample_latencies adds latencies to a fixed size uniform sample of the whole run.
+	 * @param 	reservoir[in,out]	sample of the latencies seen so far.
+	 * @param 	latencies[in]		latencies to add.
+	 * @param 	seen[in,out]		number of latencies seen so far.
+	 * @param 	generator[in,out]	random number generator used to pick the samples to replace.
+	 */
+	void sample_latencies(std::vector<uint64_t>& reservoir, const std::vector<uint64_t>& latencies, uint64_t& seen, std::mt19937_64& generator) {
+		for (uint64_t latency : latencies) {
+			seen++;
+			if (reservoir.size() < LATENCY_RESERVOIR_SIZE) {
+				reservoir.push_back(latency);
+			}
+			else {
+				const uint64_t slot = generator() % seen;
+				if (slot < LATENCY_RESERVOIR_SIZE) {
+					reservoir[slot] = latency;
+				}
+			}
+		}
+	}
+
+	/**
+	 * @brief 	Function print_receive_report prints the loss, reordering and latency of the received datagrams.
+	 * @param 	label 		label at the start of the report.
+	 * @param 	streams 	state of every stream.
+	 * @param 	latencies 	latencies in nanoseconds observed since the last report, sorted by the function.
+	 * @param 	packets 	datagrams received since the last report.
+	 * @param 	bytes 		bytes received since the last report.
+	 * @param 	elapsed 	seconds since the last report.
+	 */
+	void print_receive_report(const std::string& label, const std::map<std::tuple<std::string, uint16_t, uint32_t>, stream_state>& streams,
+			std::vector<uint64_t>& latencies, uint64_t packets, uint64_t bytes, double elapsed) {
+		uint64_t received = 0;
+		uint64_t expected = 0;
+		uint64_t reordered = 0;
+		for (const auto& entry : streams) {
+			received += entry.second.received;
+			expected += entry.second.expected;
+			reordered += entry.second.reordered;
+		}
+		const uint64_t lost = expected > received ? expected - received : 0;
+		std::sort(latencies.begin(), latencies.end());
+
+		std::cout << label << " received " << format_rate((double)packets / elapsed, "pps")
+			<< ", " << format_rate((double)bytes * 8 / elapsed, "bps")
+			<< ", streams " << streams.size()
+			<< ", lost " << lost << " (" << (expected > 0 ? 100.0 * (double)lost / (double)expected : 0.0) << "%)"
+			<< ", reordered " << reordered
+			<< ", latency us p50 " << (double)percentile(latencies, 0.5) / 1000
+			<< " p99 " << (double)percentile(latencies, 0.99) / 1000
+			<< " max " << (double)(latencies.empty() ? 0 : latencies.back()) / 1000 << std::endl;
+	}
+
+	/**
+	 * @brief 	Function run_receiver receives datagrams and reports loss, reordering and latency per interval.
+	 * @param 	parsed 	parsed options.
+	 * @return 	int 	exit code.
+	 */
+	int run_receiver(const options& parsed) {
+		// The IPv4 wildcard default does not fit IPv6 sockets, which bind to the IPv6 wildcard instead.
+		const bool default_bind = parsed.bind_address == "0.0.0.0" && parsed.family != oo_socket::address_family::IPV4;
+		oo_socket::udp::socket socket(parsed.port, default_bind ? "" : parsed.bind_address, parsed.family);
+		// Wake up regularly so that reports are printed while the link is idle.
+		socket.set_socket_receive_timeout(100);
+
+		std::vector<std::vector<char>> buffers(MAX_BATCH_SIZE, std::vector<char>(MAX_RECEIVE_BUFFER_SIZE));
+		std::vector<oo_socket::incoming_datagram> batch;
+		for (std::vector<char>& buffer : buffers) {
+			oo_socket::incoming_datagram datagram{};
+			datagram.buffer = buffer.data();
+			datagram.capacity = buffer.size();
+			batch.push_back(datagram);
+		}
+
+		std::map<std::tuple<std::string, uint16_t, uint32_t>, stream_state> streams;
+		std::vector<uint64_t> interval_latencies;
+		// Keep a bounded sample for the final report so long runs do not grow without limit.
+		std::vector<uint64_t> all_latencies;
+		uint64_t latencies_seen = 0;
+		std::mt19937_64 generator(1);
+		uint64_t interval_packets = 0, interval_bytes = 0, total_packets = 0, total_bytes = 0, foreign = 0;
+
+		const auto start = std::chrono::steady_clock::now();
+		auto last_report = start;
+		while (!stop_requested && (parsed.duration <= 0 || seconds_since(start) < parsed.duration)) {
+			const int received = socket.receive_batch(batch, true);
+			const uint64_t receive_time_ns = wall_clock_ns();
+			for (int i = 0; i < received; i++) {
+				blast_header header;
+				if (batch[i].size < sizeof(header)) {
+					foreign++;
+					continue;
+				}
+				::memcpy(&header, batch[i].buffer, sizeof(header));
+				if (header.magic != BLAST_MAGIC) {
+					foreign++;
+					continue;
+				}
+
+				stream_state& state = streams[std::make_tuple(batch[i].source_address, batch[i].source_port, header.stream)];
+				state.received++;
+				if (header.sequence < state.expected) {
+					state.reordered++;
+				}
+				else {
+					state.expected = header.sequence + 1;
+				}
+				// Clocks on different hosts may disagree, so negative latencies are clamped to zero.
+				const uint64_t latency_ns = receive_time_ns > header.send_time_ns ? receive_time_ns - header.send_time_ns : 0;
+				interval_latencies.push_back(latency_ns);
+				interval_packets++;
+				interval_bytes += batch[i].size;
+			}
+
+			if (seconds_since(last_report) >= parsed.interval) {
+				const double elapsed = seconds_since(last_report);
+				last_report = std::chrono::steady_clock::now();
+				print_receive_report("[" + std::to_string((int)seconds_since(start)) + "s]", streams, interval_latencies, interval_packets, interval_bytes, elapsed);
+				sample_latencies(all_latencies, interval_latencies, latencies_seen, generator);
+				interval_latencies.clear();
+				total_packets += interval_packets;
+				total_bytes += interval_bytes;
+				interval_packets = 0;
+				interval_bytes = 0;
+			}
+		}
+
+		sample_latencies(all_latencies, interval_latencies, latencies_seen, generator);
+		total_packets += interval_packets;
+		total_bytes += interval_bytes;
+		print_receive_report("Total:", streams, all_latencies, total_packets, total_bytes, seconds_since(start));
+		if (foreign > 0) {
+			std::cout << "Ignored " << foreign << " datagrams without the oo_udp_blast header." << std::endl;
+		}
+		return 0;
+	}
+}
+
+int main(int argc, char** argv) {
+	options parsed;
+	if (!parse_options(argc, argv, parsed)) {
+		print_usage();
+		return 1;
+	}
+	std::signal(SIGINT, handle_signal);
+	std::signal(SIGTERM, handle_signal);
+
+	try {
+		return parsed.send ? run_sender(parsed) : run_receiver(parsed);
+	}
+	catch (const std::exception& e) {
+		std::cerr << "oo_udp_blast: " << e.what() << std::endl;
+		return 1;
+	}
+}